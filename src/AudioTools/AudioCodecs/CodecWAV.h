@@ -821,8 +821,10 @@ class WAVDecoder : public AudioDecoder {
     return (int16_t)((u_val & 0x80) ? (0x84 - t) : (t - 0x84));
   }
 
-  /// Decodes the header data: Returns the start pos of the data
+  /// Decodes the header data: Returns the start pos of the data in in_ptr
   int decodeHeader(uint8_t *in_ptr, size_t in_size) {
+    // the header might have been provided by prior writes
+    int buffered = header.available();
     // we expect at least the full header
     header.write(in_ptr, in_size);
     if (!header.isDataComplete()) {
@@ -843,7 +845,8 @@ class WAVDecoder : public AudioDecoder {
       header.dumpHeader();
       return 0;
     }
-    // parse header
+    // parse() clears the header buffer: determine the data pos before
+    int data_pos = header.getDataPos() - buffered;
     if (!header.parse()) {
       LOGE("WAV header parsing failed");
       return 0;
@@ -876,7 +879,7 @@ class WAVDecoder : public AudioDecoder {
       LOGE("WAV format not supported: 0x%04X", (unsigned)format);
       logSupportedFormats();
     }
-    return header.getDataPos();
+    return data_pos;
   }
 
   /// Logs (at error level) the WAV format tags this instance can currently
@@ -117,6 +117,13 @@ class ContainerM4A : public ContainerDecoder {
     return true;
   }
 
+  /**
+   * @brief Defines the sample at which the mdat data continues after a seek:
+   * see SeekIndexM4A.
+   * @param index Sample index.
+   */
+  void setStartSample(size_t index) { demux.setStartSample(index); }
+
   M4AAudioDemuxer& getDemuxer() {
     return demux;
   }
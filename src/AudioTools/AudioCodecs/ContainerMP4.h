@@ -155,6 +155,10 @@ class DemuxerMP4 : public Demuxer {
     total_bytes_received = 0;
     playback_start_set = false;
     quickstart_bytes_remaining = -1;
+    is_random_access_active = false;
+    is_random_access_error = false;
+    random_access_pos = 0;
+    random_access_left = 0;
     parser.begin();
     is_active = true;
     return true;
@@ -234,6 +238,9 @@ class DemuxerMP4 : public Demuxer {
   /// again with the remainder, exactly like the underlying Print contract.
   size_t write(const uint8_t* data, size_t len) override {
     if (!is_active) return 0;
+    // the audio samples are fetched by copyRandomAccess(): the sequential
+    // 'mdat' bytes are not needed any more
+    if (is_random_access_active) return len;
     // After quickStart(), 'moov' still physically trails 'mdat' on disk
     // (only relocated logically) - cap feeding at 'mdat's declared size
     // and discard the trailing, already-parsed 'moov' bytes instead of
@@ -333,6 +340,110 @@ class DemuxerMP4 : public Demuxer {
     return true;
   }
 
+  /// Audio-only extraction for a seekable file (see setSeekSource()): the
+  /// "merge" in advanceChunkIfNeeded() must stream 'mdat' sequentially -
+  /// incl. all video payloads - just to reach the audio samples. When this
+  /// is active (default false) and 'moov' has already been parsed once
+  /// 'mdat' is reached (faststart file or quickStart()), the remaining
+  /// bytes provided via write() are ignored and the audio samples are
+  /// fetched directly by their stco/stsz entries with copyRandomAccess()
+  /// instead. Video is not dispatched in this mode, so the audio is also
+  /// written directly to the output (no VideoAudioSync pacing).
+  /// FileSeekableSource::copy() switches to copyRandomAccess()
+  /// automatically.
+  void setRandomAccess(bool active) { is_random_access = active; }
+
+  /// Max number of bytes of one coalesced read in copyRandomAccess()
+  /// (default 8k): consecutive audio samples and chunks which are
+  /// contiguous in the file are read with a single seek()/readBytes().
+  void setRandomAccessBufferSize(size_t size) { random_access_buffer_size = size; }
+
+  /// True once 'mdat' has been reached with setRandomAccess(true): the audio
+  /// must be requested with copyRandomAccess() from now on.
+  bool isRandomAccessActive() { return is_random_access_active; }
+
+  /// True if the last copyRandomAccess() could not read the samples
+  bool isRandomAccessError() { return is_random_access_error; }
+
+  /// Reads the next contiguous range of audio samples (up to
+  /// setRandomAccessBufferSize() bytes, but at least one sample) from the
+  /// SeekableSource and dispatches them. Returns the number of sample bytes
+  /// which were read: 0 once all audio samples have been processed, if
+  /// random access is not active or if the read failed (see
+  /// isRandomAccessError()): in this case the next call tries to read the
+  /// same samples again.
+  size_t copyRandomAccess() {
+    Track* t = p_audio_track;
+    if (!is_random_access_active || t == nullptr) return 0;
+    // collect the samples which follow each other in the file: the track
+    // is only updated when they could be read
+    uint64_t start = random_access_pos;
+    size_t len = 0;
+    uint32_t sample_index = t->next_sample_index;
+    uint32_t chunk_index = t->next_chunk_index;
+    uint32_t left = random_access_left;
+    random_access_sizes.clear();
+    while (true) {
+      if (left == 0) {
+        if (chunk_index >= t->chunk_offsets->size()) break;
+        uint64_t offset = t->chunk_offsets->get(chunk_index);
+        // a chunk at a different position needs a separate read
+        if (len > 0 && offset != start + len) break;
+        left = samplesInChunk(*t, chunk_index);
+        chunk_index++;
+        if (len == 0) start = offset;
+        continue;
+      }
+      uint32_t size = t->sampleSize(sample_index);
+      if (size == 0) {
+        // no more sizes for this track - stop
+        left = 0;
+        chunk_index = t->chunk_offsets->size();
+        break;
+      }
+      if (len > 0 && len + size > random_access_buffer_size) break;
+      random_access_sizes.push_back(size);
+      len += size;
+      sample_index++;
+      left--;
+    }
+    if (len == 0) {
+      t->next_chunk_index = chunk_index;
+      random_access_left = left;
+      return 0;
+    }
+
+    // one read for all collected samples
+    sample_buffer.resize(len);
+    size_t got = 0;
+    while (got < len) {
+      if (!p_seek_source->seek((size_t)(start + got))) break;
+      size_t n = p_seek_source->readBytes(sample_buffer.data() + got, len - got);
+      if (n == 0) break;
+      got += n;
+    }
+    is_random_access_error = got < len;
+    if (is_random_access_error) {
+      LOGE("DemuxerMP4: could not read %u bytes at %u", (unsigned)len,
+           (unsigned)start);
+      return 0;
+    }
+    t->next_sample_index = sample_index;
+    t->next_chunk_index = chunk_index;
+    random_access_left = left;
+    random_access_pos = start + len;
+
+    size_t pos = 0;
+    for (size_t j = 0; j < random_access_sizes.size(); j++) {
+      uint32_t size = random_access_sizes[j];
+      t->nextPtsTicks();
+      dispatchAudio(*t, sample_buffer.data() + pos, size, false);
+      pos += size;
+      dispatched_sample_count++;
+    }
+    return len;
+  }
+
  protected:
   /// sample-to-chunk table entry (stsc)
   struct StscEntry {
@@ -478,6 +589,17 @@ class DemuxerMP4 : public Demuxer {
   /// begin() default) means no boundary active - see write().
   int64_t quickstart_bytes_remaining = -1;
 
+  // random access to the audio samples - see setRandomAccess()
+  bool is_random_access = false;
+  bool is_random_access_active = false;
+  bool is_random_access_error = false;
+  size_t random_access_buffer_size = 8 * 1024;
+  /// file position of the next audio sample
+  uint64_t random_access_pos = 0;
+  /// audio samples left in the current chunk
+  uint32_t random_access_left = 0;
+  Vector<uint32_t> random_access_sizes;
+
   // Audio/video pacing - see setVideoAudioSync(). VideoAudioBufferedSync
   // (not VideoAudioClockSync, DemuxerAVI's default) because MP4's problem
   // is bursty audio dispatch, which only a buffering sync actually
@@ -1167,7 +1289,14 @@ class DemuxerMP4 : public Demuxer {
     if (!mdat_seen) {
       mdat_seen = true;
       LOGI("DemuxerMP4: mdat reached");
+      // random access is only possible if we already know the sample tables
+      if (is_random_access && p_seek_source != nullptr &&
+          p_audio_track != nullptr && p_audio_track->chunk_offsets->size() > 0) {
+        LOGI("DemuxerMP4: random access to audio samples");
+        is_random_access_active = true;
+      }
     }
+    if (is_random_access_active) return;
     feed(box.data, box.available);
   }
 
@@ -1374,13 +1503,22 @@ class DemuxerMP4 : public Demuxer {
       uint8_t adts[7];
       writeAdtsHeader(adts, t.aacProfile, t.sampleRateIdx, t.channelCfg,
                       (int)size);
-      p_synch->writeAudio(p_output_audio, adts, sizeof(adts));
-      p_synch->writeAudio(p_output_audio, const_cast<uint8_t*>(data), size);
+      writeAudio(adts, sizeof(adts));
+      writeAudio(const_cast<uint8_t*>(data), size);
     } else {
       // ALAC (magic cookie is exposed via audioALACMagicCookie() for the
       // caller to configure their own decoder with) and any other codec:
       // raw payload as-is.
-      p_synch->writeAudio(p_output_audio, const_cast<uint8_t*>(data), size);
+      writeAudio(const_cast<uint8_t*>(data), size);
+    }
+  }
+
+  void writeAudio(uint8_t* data, size_t size) {
+    // without video there is nothing to pace the audio against
+    if (is_random_access_active) {
+      p_output_audio->write(data, size);
+    } else {
+      p_synch->writeAudio(p_output_audio, data, size);
     }
   }
 
@@ -1527,7 +1665,8 @@ class MP4BoxWriter {
  * standard sample rates) or raw PCM (setAudioInfo() with format =
  * AudioFormat::PCM - little-endian signed samples, 'sowt' sample entry, no
  * encoder needed; only 16-bit has been validated). No mfra index / seeking
- * metadata is written (not required for playback). SPS/PPS (needed for H264's
+ * metadata is written (not required for playback) - use a SegmenterMP4 as
+ * output to get HLS/CMAF segments with 'sidx' or a VOD file with 'mfra'. SPS/PPS (needed for H264's
  * 'avcC') are captured automatically from the first video frame(s) that carry
  * them - typical H.264 encoders prepend them to (at least) the first access
  * unit, so no separate setup call is needed; frames arriving before SPS/PPS
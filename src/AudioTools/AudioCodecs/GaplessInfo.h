@@ -0,0 +1,176 @@
+#pragma once
+#include <string.h>
+
+#include "AudioTools/AudioCodecs/HeaderParserMP3.h"
+#include "AudioTools/AudioCodecs/SampleTableStore.h"
+#include "AudioTools/CoreAudio/AudioLogger.h"
+
+namespace audio_tools {
+
+/**
+ * @brief Encoder delay and padding of a track which are needed for gapless
+ * playback: the encoders add silence at the beginning and at the end, which
+ * must be removed from the decoded audio so that consecutive tracks can be
+ * spliced without a gap. We support the iTunSMPB tag (ID3 comment or MP4
+ * metadata) and the LAME tag in the Xing/Info frame of MP3 files.
+ * @ingroup codecs
+ * @author Phil Schatzmann
+ * @copyright GPLv3
+ */
+class GaplessInfo {
+ public:
+  /// Number of frames which need to be skipped at the beginning
+  uint32_t delay = 0;
+  /// Number of frames which were added at the end by the encoder
+  uint32_t padding = 0;
+  /// Number of valid frames: 0 if not known
+  uint64_t samples = 0;
+
+  /// Resets all values
+  void clear() {
+    delay = 0;
+    padding = 0;
+    samples = 0;
+  }
+
+  /// Returns true if there is anything to remove
+  bool isValid() { return delay > 0 || samples > 0; }
+
+  /// Frames which the MP3 decoder adds to the delay of the LAME tag (default
+  /// 529)
+  void setDecoderDelay(int frames) { decoder_delay = frames; }
+
+  /// Max number of bytes at the beginning of the file which are searched for
+  /// the iTunSMPB tag (default 16k)
+  void setScanLimit(size_t bytes) { scan_limit = bytes; }
+
+  /// Determines the values from the beginning of the file
+  bool parse(SeekableSource &src, size_t fileSize) {
+    clear();
+    if (parseITunes(src, fileSize) || parseLAME(src)) {
+      LOGI("GaplessInfo: delay %u, padding %u, samples %u", (unsigned)delay,
+           (unsigned)padding, (unsigned)samples);
+      return true;
+    }
+    return false;
+  }
+
+ protected:
+  int decoder_delay = 529;
+  size_t scan_limit = 16 * 1024;
+
+  static size_t readAt(SeekableSource &src, size_t pos, uint8_t *data,
+                       size_t len) {
+    if (!src.seek(pos)) return 0;
+    size_t result = 0;
+    while (result < len) {
+      size_t n = src.readBytes(data + result, len - result);
+      if (n == 0) break;
+      result += n;
+    }
+    return result;
+  }
+
+  /// Searches the iTunSMPB tag: " 00000000 DDDDDDDD PPPPPPPP SSSSSSSSSSSSSSSS"
+  bool parseITunes(SeekableSource &src, size_t fileSize) {
+    uint8_t data[512];
+    size_t end = min(fileSize, scan_limit);
+    size_t pos = 0;
+    while (pos < end) {
+      size_t len = readAt(src, pos, data, min(sizeof(data), end - pos));
+      if (len < 8) return false;
+      for (size_t j = 0; j + 8 <= len; j++) {
+        if (memcmp(data + j, "iTunSMPB", 8) != 0) continue;
+        // the value follows the name or the header of the MP4 data atom
+        char value[96];
+        size_t n = readAt(src, pos + j + 8, (uint8_t *)value, sizeof(value));
+        for (size_t k = 0; k < n; k++) {
+          if (value[k] == ' ' && parseITunesValue(value + k, n - k))
+            return true;
+        }
+        return false;
+      }
+      if (len < sizeof(data)) return false;
+      // the name might be split
+      pos += len - 7;
+    }
+    return false;
+  }
+
+  bool parseITunesValue(const char *str, size_t len) {
+    static const int digits[] = {8, 8, 8, 16};
+    uint64_t values[4];
+    size_t pos = 0;
+    for (int j = 0; j < 4; j++) {
+      if (pos + 1 + digits[j] > len || str[pos] != ' ') return false;
+      pos++;
+      values[j] = 0;
+      for (int k = 0; k < digits[j]; k++) {
+        int digit = hexValue(str[pos++]);
+        if (digit < 0) return false;
+        values[j] = values[j] << 4 | digit;
+      }
+    }
+    delay = values[1];
+    padding = values[2];
+    samples = values[3];
+    return isValid();
+  }
+
+  static int hexValue(char c) {
+    if (c >= '0' && c <= '9') return c - '0';
+    if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+    if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+    return -1;
+  }
+
+  /// Evaluates the LAME tag which follows the Xing/Info header of the first
+  /// MP3 frame
+  bool parseLAME(SeekableSource &src) {
+    typedef HeaderParserMP3::FrameHeader FrameHeader;
+    uint8_t data[128];
+    // skip ID3v2 tag
+    size_t pos = 0;
+    if (readAt(src, 0, data, 10) == 10 && memcmp(data, "ID3", 3) == 0) {
+      pos = 10 + ((data[6] & 0x7F) << 21 | (data[7] & 0x7F) << 14 |
+                  (data[8] & 0x7F) << 7 | (data[9] & 0x7F));
+      if (data[5] & 0x10) pos += 10;
+    }
+    FrameHeader header;
+    if (readAt(src, pos, data, 4) != 4 ||
+        !FrameHeader::decode(data, header) || !header.isValid())
+      return false;
+    bool mono = header.channelMode == FrameHeader::ChannelModeID::SINGLE;
+    int side_info = header.audioVersion == FrameHeader::MPEGVersionID::MPEG_1
+                        ? (mono ? 17 : 32)
+                        : (mono ? 9 : 17);
+    pos += 4 + side_info;
+    if (readAt(src, pos, data, 8) != 8 ||
+        (memcmp(data, "Xing", 4) != 0 && memcmp(data, "Info", 4) != 0))
+      return false;
+    uint32_t flags = (uint32_t)data[4] << 24 | data[5] << 16 | data[6] << 8 |
+                     data[7];
+    uint32_t frames = 0;
+    if ((flags & 0x1) && readAt(src, pos + 8, data, 4) == 4) {
+      frames = (uint32_t)data[0] << 24 | data[1] << 16 | data[2] << 8 |
+               data[3];
+    }
+    // the LAME tag follows the optional fields
+    pos += 8 + ((flags & 0x1) ? 4 : 0) + ((flags & 0x2) ? 4 : 0) +
+           ((flags & 0x4) ? 100 : 0) + ((flags & 0x8) ? 4 : 0);
+    if (readAt(src, pos, data, 24) != 24) return false;
+    if (memcmp(data, "LAME", 4) != 0 && memcmp(data, "Lavc", 4) != 0 &&
+        memcmp(data, "Lavf", 4) != 0)
+      return false;
+    uint32_t enc_delay = data[21] << 4 | data[22] >> 4;
+    uint32_t enc_padding = (data[22] & 0x0F) << 8 | data[23];
+    delay = enc_delay + decoder_delay;
+    padding = enc_padding;
+    uint64_t total = (uint64_t)frames * header.getSamplesPerFrame();
+    samples = total > enc_delay + enc_padding ? total - enc_delay - enc_padding
+                                              : 0;
+    return true;
+  }
+};
+
+}  // namespace audio_tools
@@ -23,6 +23,7 @@ namespace audio_tools {
  */
 
 class HeaderParserMP3 {
+ public:
   /// @brief MPEG audio frame header fields parsed from 4 serialized bytes
   struct FrameHeader {
     static const unsigned int SERIALIZED_SIZE = 4;
@@ -178,9 +179,27 @@ class HeaderParserMP3 {
           (audioVersion == FrameHeader::MPEGVersionID::MPEG_1) ? 144 : 72;
       return int((value * getBitRate() / sample_rate) + (padding ? 1 : 0));
     }
+
+    /// Number of samples (per channel) in a frame
+    int getSamplesPerFrame() const {
+      switch (layer) {
+        case LayerID::LAYER_1:
+          return 384;
+        case LayerID::LAYER_2:
+          return 1152;
+        default:
+          return audioVersion == MPEGVersionID::MPEG_1 ? 1152 : 576;
+      }
+    }
+
+    /// Checks if the decoded fields describe a supported frame
+    bool isValid() const {
+      return audioVersion != MPEGVersionID::INVALID &&
+             layer != LayerID::INVALID && bitrateIndex > 0 &&
+             bitrateIndex < 15 && sampleRateIndex < 3 && getFrameLength() > 4;
+    }
   };
 
- public:
   /// Default constructor
   HeaderParserMP3() = default;
 
@@ -34,6 +34,7 @@ class M4AAudioDemuxer : public M4ACommonDemuxer {
 
     stsz_processed = false;
     stco_processed = false;
+    sample_count = 0;
 
     // When codec/sampleSizes/callback/ref change, update the extractor:
     parser.begin();
@@ -103,7 +104,9 @@ class M4AAudioDemuxer : public M4ACommonDemuxer {
           M4AAudioDemuxer& self = *static_cast<M4AAudioDemuxer*>(ref);
           // mdat must not be buffered
           LOGI("#%d Box: %s, size: %u of %u bytes", (unsigned) box.seq, box.type,(unsigned) box.available, (unsigned)box.size);
-          if (box.seq == 0) self.sampleExtractor.setMaxSize(box.size);
+          // the first data might only arrive with a later write
+          if (box.seq == 0 || self.sampleExtractor.maxSize() == 0)
+            self.sampleExtractor.setMaxSize(box.size);
           size_t written = self.sampleExtractor.write(box.data, box.available, box.is_complete);
           assert(written == box.available);
         },
@@ -130,6 +130,8 @@ class M4ACommonDemuxer {
       current_size = 0;
       box_pos = 0;
       box_size = 0;
+      last_index = -1;
+      last_size = 0;
     }
 
     /**
@@ -152,8 +154,21 @@ class M4ACommonDemuxer {
      */
     void setMaxSize(size_t size) {
       box_size = size;
+      skipSamples();
     }
 
+    /// Provides the size of the mdat box: 0 if the box has not started yet
+    size_t maxSize() { return box_size; }
+
+    /**
+     * @brief Defines the sample at which the next mdat box starts: the sizes
+     * of the samples before are skipped. This is used after a seek, where the
+     * data is provided from the file position of this sample on. The value
+     * is kept by begin() and is only used once.
+     * @param index Sample index.
+     */
+    void setStartSample(size_t index) { start_sample = index; }
+
     /**
      * @brief Writes data to the extractor, extracting frames as sample sizes
      * are met. Provides the data via the callback.
@@ -173,7 +188,8 @@ class M4ACommonDemuxer {
 
       /// fill buffer up to the current sample size
       for (int j = 0; j < len; j++) {
-        assert(buffer.write(data[j]));
+        bool is_written = buffer.write(data[j]);
+        assert(is_written);
         if (buffer.available() >= currentSize) {
           LOGI("Sample# %zu: size %zu bytes", sampleIndex, currentSize);
           executeCallback(currentSize);
@@ -184,11 +200,11 @@ class M4ACommonDemuxer {
           if (box_pos >= box_size) {
             LOGI("Reached end of box: %s write",
                  is_final ? "final" : "not final");
-            return j;
+            return j + 1;
           }
           if (currentSize == 0) {
             LOGE("No sample size defined, cannot write data");
-            return j;
+            return j + 1;
           }
         }
       }
@@ -290,6 +306,26 @@ class M4ACommonDemuxer {
     size_t current_size = 0;           ///< Current sample size.
     size_t box_size = 0;               ///< Maximum size of the current sample.
     size_t box_pos = 0;                ///< Current position in the box.
+    size_t start_sample = 0;  ///< First sample of the next mdat box.
+    size_t last_index = -1;   ///< Sample index of the cached size.
+    size_t last_size = 0;     ///< Cached size of the sample last_index.
+
+    /**
+     * @brief Skips the sample sizes up to the start sample, so that the
+     * following data is split at the right positions.
+     */
+    void skipSamples() {
+      while (sampleIndex < start_sample) {
+        size_t size = currentSampleSize();
+        if (size == 0) {
+          LOGE("Start sample %u not available", (unsigned)start_sample);
+          break;
+        }
+        box_pos += size;
+        ++sampleIndex;
+      }
+      start_sample = 0;
+    }
 
     /**
      * @brief Executes the callback for a completed frame.
@@ -319,9 +355,6 @@ class M4ACommonDemuxer {
      * @return Size of the current sample.
      */
     size_t currentSampleSize() {
-      static size_t last_index = -1;
-      static size_t last_size = -1;
-
       // Return cached size
       if (sampleIndex == last_index) {
         return last_size;
@@ -388,6 +421,13 @@ class M4ACommonDemuxer {
     sampleExtractor.setChunkOffsetsBuffer(buffer);
   }
 
+  /**
+   * @brief Defines the sample at which the next mdat data starts (e.g. after
+   * a seek to the file position of this sample).
+   * @param index Sample index.
+   */
+  void setStartSample(size_t index) { sampleExtractor.setStartSample(index); }
+
   void begin() {
     stsz_processed = false;
     stco_processed = false;
@@ -633,7 +673,8 @@ class M4ACommonDemuxer {
     int count = 0;
     while (buffer.available() >= 4) {
       stsz_sample_size_t sampleSize = readU32Buffer();
-      assert(sampleSizes.write(sampleSize));
+      bool is_written = sampleSizes.write(sampleSize);
+      assert(is_written);
       count += 4;
     }
     // Remove processed data
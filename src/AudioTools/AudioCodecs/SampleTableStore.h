@@ -37,6 +37,46 @@ callQuickStartIfAvailable(T&) {
 }
 }  // namespace quickstart_detail
 
+/// Same detection for DemuxerMP4's random access mode: see
+/// FileSeekableSource::copy()
+namespace randomaccess_detail {
+template <typename T>
+class HasRandomAccess {
+  template <typename U>
+  static auto test(int)
+      -> decltype(std::declval<U&>().copyRandomAccess(), std::true_type());
+  template <typename U>
+  static std::false_type test(...);
+
+ public:
+  static const bool value = decltype(test<T>(0))::value;
+};
+
+template <typename T>
+typename std::enable_if<HasRandomAccess<T>::value, bool>::type
+isRandomAccessActive(T& writer) {
+  return writer.isRandomAccessActive();
+}
+
+template <typename T>
+typename std::enable_if<!HasRandomAccess<T>::value, bool>::type
+isRandomAccessActive(T&) {
+  return false;
+}
+
+template <typename T>
+typename std::enable_if<HasRandomAccess<T>::value, size_t>::type
+copyRandomAccess(T& writer) {
+  return writer.copyRandomAccess();
+}
+
+template <typename T>
+typename std::enable_if<!HasRandomAccess<T>::value, size_t>::type
+copyRandomAccess(T&) {
+  return 0;
+}
+}  // namespace randomaccess_detail
+
 /// @brief Video vs. audio track classification - lives here (rather than
 /// nested inside DemuxerMP4::Track, where it conceptually belongs) purely
 /// so SpoolStorageFactory can reference it: this header is included
@@ -261,11 +301,19 @@ class FileSeekableSource : public SeekableSource {
   /// writer.quickStart() first - not done in the constructor since it
   /// must run after writer.begin(), which typically hasn't happened yet
   /// at construction time.
+  ///
+  /// Once the writer has switched to random access (e.g.
+  /// DemuxerMP4::setRandomAccess()) it fetches the samples it needs itself
+  /// via seek()/readBytes(), so the rest of the file is not read
+  /// sequentially any more.
   size_t copy() {
     if (quick_start_enabled && !quick_start_done) {
       quick_start_done = true;
       quickstart_detail::callQuickStartIfAvailable(*p_writer);
     }
+    if (randomaccess_detail::isRandomAccessActive(*p_writer)) {
+      return randomaccess_detail::copyRandomAccess(*p_writer);
+    }
     uint8_t buffer[buffer_len];
     size_t to_read = p_file->readBytes((char*)buffer, buffer_len);
     if (to_read == 0) return 0;
@@ -0,0 +1,920 @@
+#pragma once
+#include <string.h>
+
+#include "AudioTools/AudioCodecs/HeaderParserMP3.h"
+#include "AudioTools/AudioCodecs/SampleTableStore.h"
+#include "AudioTools/CoreAudio/AudioBasic/Collections/Vector.h"
+#include "AudioTools/CoreAudio/AudioBasic/Str.h"
+#include "AudioTools/CoreAudio/AudioLogger.h"
+
+namespace audio_tools {
+
+/**
+ * @brief Translates a playback time into a byte position of an encoded file,
+ * so that the AudioPlayer can jump to it without decoding all data before.
+ * The implementations are format specific and read what they need with
+ * seek() and readBytes() from the file: information which is expensive to
+ * determine is cached until reset() is called for the next file.
+ *
+ * After a seek the decoder is restarted: the first headerSize() bytes of the
+ * file are provided to it again before the data at the new position.
+ *
+ * Indexes which need to scan the file can also be built from the played data
+ * (addData()) and can be stored with save() and restored with load() in a
+ * later session. The records are identified by the path, size and
+ * modification time which are defined with setFileKey(), so a stream can
+ * contain the record of a single file (sidecar file) or the records of many
+ * files (central cache).
+ * @ingroup player
+ * @author Phil Schatzmann
+ * @copyright GPLv3
+ */
+class SeekIndex {
+ public:
+  virtual ~SeekIndex() = default;
+
+  /// Forgets the cached information of the actual file
+  virtual void reset() { is_valid = false; }
+
+  /// Determines the byte position for the indicated playback time
+  virtual bool findPosition(SeekableSource &src, size_t fileSize,
+                            uint32_t timeMs, size_t &pos) = 0;
+
+  /// Number of bytes at the beginning of the file which the decoder needs
+  /// before it can decode any data
+  virtual size_t headerSize() { return 0; }
+
+  /// Total playing time in ms: 0 if it can not be determined
+  virtual uint32_t durationMs(SeekableSource &src, size_t fileSize) {
+    return 0;
+  }
+
+  /// Provides the data which was read at the indicated file position, so
+  /// that the index can be extended while the file is playing
+  virtual void addData(size_t pos, const uint8_t *data, size_t len) {}
+
+  /// Defines the file which is described by the index (used by save() and
+  /// load()): the modification time is optional. The key is kept when the
+  /// AudioPlayer opens the file with the same path.
+  void setFileKey(const char *path, size_t size, uint32_t mtime = 0) {
+    updateFileKey(path, size, mtime);
+    is_user_key = true;
+  }
+
+  /// Defines the key of a file which was opened by the AudioPlayer: a key
+  /// which was defined with setFileKey() for the same path is kept
+  void setDefaultFileKey(const char *path, size_t size) {
+    if (is_user_key && key_path.equals(path == nullptr ? "" : path)) return;
+    updateFileKey(path, size, 0);
+    is_user_key = false;
+  }
+
+  /// Writes the index of the actual file as record: the output can be
+  /// appended to an existing cache
+  bool save(Print &out) {
+    if (recordType() == 0) return false;
+    size_t path_len = key_path.length();
+    uint8_t header[kRecordHeaderSize];
+    memcpy(header, "SIDX", 4);
+    header[4] = kVersion;
+    header[5] = recordType();
+    putLE16(header + 6, path_len);
+    putLE32(header + 8, payloadSize());
+    putLE32(header + 12, key_size);
+    putLE32(header + 16, key_mtime);
+    if (out.write(header, sizeof(header)) != sizeof(header)) return false;
+    if (path_len > 0 &&
+        out.write((const uint8_t *)key_path.c_str(), path_len) != path_len)
+      return false;
+    return writePayload(out);
+  }
+
+  /// Searches the record of the actual file (see setFileKey()) in the
+  /// stream which was written by save() and restores the index from it
+  bool load(Stream &in) {
+    if (recordType() == 0) return false;
+    uint8_t header[kRecordHeaderSize];
+    while (readFully(in, header, sizeof(header)) == sizeof(header)) {
+      if (memcmp(header, "SIDX", 4) != 0) {
+        LOGW("SeekIndex: invalid record");
+        return false;
+      }
+      size_t path_len = le16(header + 6);
+      uint32_t len = le32(header + 8);
+      bool match = header[4] == kVersion && header[5] == recordType() &&
+                   le32(header + 12) == key_size &&
+                   le32(header + 16) == key_mtime &&
+                   path_len == key_path.length();
+      // compare the path in small chunks
+      uint8_t tmp[32];
+      size_t done = 0;
+      while (done < path_len) {
+        size_t n = readFully(in, tmp, min(sizeof(tmp), path_len - done));
+        if (n == 0) return false;
+        if (match && memcmp(tmp, key_path.c_str() + done, n) != 0)
+          match = false;
+        done += n;
+      }
+      if (match) return readPayload(in, len);
+      if (skip(in, len) != len) return false;
+    }
+    return false;
+  }
+
+ protected:
+  static const uint8_t kVersion = 1;
+  static const size_t kRecordHeaderSize = 20;
+  bool is_valid = false;
+  Str key_path;
+  size_t key_size = 0;
+  uint32_t key_mtime = 0;
+  bool is_user_key = false;
+
+  void updateFileKey(const char *path, size_t size, uint32_t mtime) {
+    key_path = path == nullptr ? "" : path;
+    key_size = size;
+    key_mtime = mtime;
+  }
+
+  /// Identifies the record of save() and load(): 0 if not supported
+  virtual uint8_t recordType() { return 0; }
+  /// Number of bytes written by writePayload()
+  virtual size_t payloadSize() { return 0; }
+  virtual bool writePayload(Print &out) { return false; }
+  virtual bool readPayload(Stream &in, size_t len) { return false; }
+
+  static size_t readAt(SeekableSource &src, size_t pos, uint8_t *data,
+                       size_t len) {
+    if (!src.seek(pos)) return 0;
+    size_t result = 0;
+    while (result < len) {
+      size_t n = src.readBytes(data + result, len - result);
+      if (n == 0) break;
+      result += n;
+    }
+    return result;
+  }
+
+  static size_t readFully(Stream &in, uint8_t *data, size_t len) {
+    size_t result = 0;
+    while (result < len) {
+      size_t n = in.readBytes(data + result, len - result);
+      if (n == 0) break;
+      result += n;
+    }
+    return result;
+  }
+
+  static size_t skip(Stream &in, size_t len) {
+    uint8_t tmp[64];
+    size_t result = 0;
+    while (result < len) {
+      size_t n = readFully(in, tmp, min(sizeof(tmp), len - result));
+      if (n == 0) break;
+      result += n;
+    }
+    return result;
+  }
+
+  static bool writeLE32(Print &out, uint32_t value) {
+    uint8_t data[4];
+    putLE32(data, value);
+    return out.write(data, 4) == 4;
+  }
+
+  static void putLE16(uint8_t *p, uint16_t value) {
+    p[0] = value & 0xFF;
+    p[1] = value >> 8;
+  }
+  static void putLE32(uint8_t *p, uint32_t value) {
+    putLE16(p, value & 0xFFFF);
+    putLE16(p + 2, value >> 16);
+  }
+  static uint16_t le16(const uint8_t *p) { return p[0] | (p[1] << 8); }
+  static uint32_t le32(const uint8_t *p) {
+    return (uint32_t)le16(p) | ((uint32_t)le16(p + 2) << 16);
+  }
+  static uint64_t le64(const uint8_t *p) {
+    return (uint64_t)le32(p) | ((uint64_t)le32(p + 4) << 32);
+  }
+  static uint16_t be16(const uint8_t *p) { return (p[0] << 8) | p[1]; }
+  static uint32_t be32(const uint8_t *p) {
+    return ((uint32_t)be16(p) << 16) | be16(p + 2);
+  }
+};
+
+/**
+ * @brief SeekIndex for WAV files: the position is calculated from the byte
+ * rate and is aligned to the block size, so that it also works for ADPCM.
+ * @ingroup player
+ * @author Phil Schatzmann
+ * @copyright GPLv3
+ */
+class SeekIndexWAV : public SeekIndex {
+ public:
+  bool findPosition(SeekableSource &src, size_t fileSize, uint32_t timeMs,
+                    size_t &pos) override {
+    if (!is_valid && !parse(src, fileSize)) return false;
+    uint64_t offset = (uint64_t)timeMs * byte_rate / 1000;
+    offset -= offset % block_align;
+    if (offset > data_length) offset = data_length;
+    pos = data_start + offset;
+    return true;
+  }
+
+  size_t headerSize() override { return data_start; }
+
+ protected:
+  size_t data_start = 0;
+  size_t data_length = 0;
+  uint32_t byte_rate = 0;
+  uint16_t block_align = 0;
+
+  /// Walks the RIFF chunks up to the data chunk
+  bool parse(SeekableSource &src, size_t fileSize) {
+    uint8_t header[24];
+    if (readAt(src, 0, header, 12) != 12 || memcmp(header, "RIFF", 4) != 0 ||
+        memcmp(header + 8, "WAVE", 4) != 0) {
+      LOGE("SeekIndexWAV: not a wav file");
+      return false;
+    }
+    size_t pos = 12;
+    byte_rate = 0;
+    while (pos + 8 <= fileSize) {
+      if (readAt(src, pos, header, 8) != 8) break;
+      uint32_t len = le32(header + 4);
+      if (memcmp(header, "fmt ", 4) == 0) {
+        if (readAt(src, pos + 8, header + 8, 16) != 16) break;
+        byte_rate = le32(header + 16);
+        block_align = le16(header + 20);
+      } else if (memcmp(header, "data", 4) == 0) {
+        data_start = pos + 8;
+        data_length = fileSize - data_start;
+        if (len > 0 && len < data_length) data_length = len;
+        is_valid = byte_rate > 0 && block_align > 0;
+        return is_valid;
+      }
+      // chunks are word aligned
+      pos += 8 + len + (len & 1);
+    }
+    LOGE("SeekIndexWAV: no data chunk");
+    return false;
+  }
+};
+
+/**
+ * @brief Common logic for formats which consist of frames with a header
+ * (MP3, AAC ADTS): we build an index with the position of every n-th frame
+ * and collect the bit rate profile. The index is extended on demand by
+ * reading from the file or with the played data (addData()), so the seeking
+ * is exact also for variable bit rates. When the whole file was indexed the
+ * duration is exact as well, otherwise it is estimated from the average bit
+ * rate. The index can be stored with save() and load().
+ * @ingroup player
+ * @author Phil Schatzmann
+ * @copyright GPLv3
+ */
+class SeekIndexFrames : public SeekIndex {
+ public:
+  /// Number of frames between two entries of the frame index (default 32)
+  void setFramesPerEntry(int frames) { frames_per_entry = frames; }
+
+  void reset() override {
+    SeekIndex::reset();
+    frame_index.clear();
+    sample_rate = 0;
+    samples_per_frame = 0;
+    scanned_frames = 0;
+    scanned_bytes = 0;
+    scan_pos = 0;
+    is_scan_complete = false;
+    is_tag_checked = false;
+    bit_rate_min = 0;
+    bit_rate_max = 0;
+    carry_len = 0;
+  }
+
+  bool findPosition(SeekableSource &src, size_t fileSize, uint32_t timeMs,
+                    size_t &pos) override {
+    if (sample_rate == 0) extendIndex(src, fileSize, 0);
+    if (sample_rate == 0) {
+      LOGE("SeekIndex: no valid frame found");
+      return false;
+    }
+    pos = indexPosition(src, fileSize, frameOf(timeMs));
+    return true;
+  }
+
+  uint32_t durationMs(SeekableSource &src, size_t fileSize) override {
+    // we need some frames for an estimate
+    if (!is_scan_complete && scanned_frames < kEstimateFrames) {
+      extendIndex(src, fileSize, kEstimateFrames / frames_per_entry);
+    }
+    if (scanned_frames == 0 || scanned_bytes == 0) return 0;
+    uint32_t ms = indexedMs();
+    if (is_scan_complete) return ms;
+    return (uint64_t)(fileSize - frame_index[0]) * ms / scanned_bytes;
+  }
+
+  void addData(size_t pos, const uint8_t *data, size_t len) override {
+    if (is_scan_complete || len == 0) return;
+    // complete the header which was split by the last data
+    if (carry_len > 0 && pos == scan_pos + carry_len) {
+      size_t n = min(len, (size_t)(headerLen() - carry_len));
+      memcpy(carry + carry_len, data, n);
+      if (carry_len + n < (size_t)headerLen()) {
+        carry_len += n;
+        return;
+      }
+      Frame frame;
+      if (decodeFrame(carry, frame)) {
+        addFrame(scan_pos, frame);
+        scan_pos += frame.len;
+      } else {
+        // resync in the new data
+        scan_pos = pos;
+      }
+    }
+    carry_len = 0;
+    // we can only process contiguous data
+    if (scan_pos < pos || scan_pos >= pos + len) return;
+    scanFrames(pos, data, len, SIZE_MAX);
+    if (key_size > 0 && scan_pos + headerLen() > key_size) {
+      is_scan_complete = true;
+    } else if (scan_pos < pos + len) {
+      carry_len = pos + len - scan_pos;
+      memcpy(carry, data + (scan_pos - pos), carry_len);
+    }
+  }
+
+  /// Number of indexed frames
+  uint32_t frameCount() { return scanned_frames; }
+
+  /// Returns true if all frames of the file have been indexed
+  bool isComplete() { return is_scan_complete; }
+
+  /// Lowest bit rate of the indexed frames in bits per second
+  uint32_t bitRateMin() { return bit_rate_min; }
+
+  /// Highest bit rate of the indexed frames in bits per second
+  uint32_t bitRateMax() { return bit_rate_max; }
+
+  /// Average bit rate of the indexed frames in bits per second
+  uint32_t bitRateAvg() {
+    uint32_t ms = indexedMs();
+    return ms == 0 ? 0 : (uint64_t)scanned_bytes * 8000 / ms;
+  }
+
+ protected:
+  static const int kMaxHeaderLen = 8;
+  static const uint32_t kEstimateFrames = 64;
+  static const size_t kFixedPayloadSize = 40;
+  struct Frame {
+    size_t len = 0;
+    int samples = 0;
+    int sample_rate = 0;
+  };
+  Vector<uint32_t> frame_index;
+  int frames_per_entry = 32;
+  int sample_rate = 0;
+  int samples_per_frame = 0;
+  uint32_t scanned_frames = 0;
+  uint32_t scanned_bytes = 0;
+  size_t scan_pos = 0;
+  bool is_scan_complete = false;
+  bool is_tag_checked = false;
+  uint32_t bit_rate_min = 0;
+  uint32_t bit_rate_max = 0;
+  // start of a header which was split by addData()
+  uint8_t carry[kMaxHeaderLen];
+  int carry_len = 0;
+
+  /// Number of bytes which are needed to decode a frame header
+  virtual int headerLen() = 0;
+
+  /// Decodes the frame header: returns false if it is not valid
+  virtual bool decodeFrame(const uint8_t *data, Frame &frame) = 0;
+
+  /// Size of the ID3v2 tag
+  static size_t tagSize(const uint8_t *data) {
+    size_t result = 10 + ((data[6] & 0x7F) << 21 | (data[7] & 0x7F) << 14 |
+                          (data[8] & 0x7F) << 7 | (data[9] & 0x7F));
+    if (data[5] & 0x10) result += 10;
+    return result;
+  }
+
+  uint64_t frameOf(uint32_t timeMs) {
+    return (uint64_t)timeMs * sample_rate / 1000 / samples_per_frame;
+  }
+
+  uint32_t indexedMs() {
+    if (sample_rate == 0) return 0;
+    return (uint64_t)scanned_frames * samples_per_frame * 1000 / sample_rate;
+  }
+
+  void addFrame(size_t pos, const Frame &frame) {
+    if (scanned_frames % frames_per_entry == 0) frame_index.push_back(pos);
+    if (sample_rate == 0) {
+      sample_rate = frame.sample_rate;
+      samples_per_frame = frame.samples;
+    }
+    uint32_t bit_rate =
+        (uint64_t)frame.len * 8 * frame.sample_rate / frame.samples;
+    if (scanned_frames == 0 || bit_rate < bit_rate_min) bit_rate_min = bit_rate;
+    if (bit_rate > bit_rate_max) bit_rate_max = bit_rate;
+    scanned_frames++;
+    scanned_bytes += frame.len;
+  }
+
+  /// Processes the frames starting at scan_pos in the data which was read at
+  /// the indicated position until the index contains maxEntry
+  void scanFrames(size_t pos, const uint8_t *data, size_t len,
+                  size_t maxEntry) {
+    // skip the ID3v2 tag at the beginning of the file
+    if (!is_tag_checked) {
+      if (pos != 0 || scan_pos != 0 || len < 10) return;
+      is_tag_checked = true;
+      if (memcmp(data, "ID3", 3) == 0) scan_pos = tagSize(data);
+    }
+    size_t j = scan_pos - pos;
+    int header_len = headerLen();
+    while (j + header_len <= len && frame_index.size() <= maxEntry) {
+      Frame frame;
+      if (!decodeFrame(data + j, frame)) {
+        // resync
+        j++;
+        continue;
+      }
+      addFrame(pos + j, frame);
+      j += frame.len;
+    }
+    scan_pos = pos + j;
+  }
+
+  size_t indexPosition(SeekableSource &src, size_t fileSize, uint64_t frame) {
+    size_t entry = frame / frames_per_entry;
+    extendIndex(src, fileSize, entry);
+    if (entry >= frame_index.size()) return fileSize;
+    return frame_index[entry];
+  }
+
+  /// Reads the frames from the file until the index contains the indicated
+  /// entry
+  void extendIndex(SeekableSource &src, size_t fileSize, size_t entry) {
+    uint8_t data[1024];
+    carry_len = 0;
+    while (frame_index.size() <= entry && !is_scan_complete) {
+      size_t pos = scan_pos;
+      size_t len = pos + headerLen() <= fileSize
+                       ? readAt(src, pos, data, sizeof(data))
+                       : 0;
+      if (len < (size_t)headerLen()) {
+        is_scan_complete = true;
+        break;
+      }
+      scanFrames(pos, data, len, entry);
+      if (scan_pos + headerLen() > fileSize) is_scan_complete = true;
+    }
+  }
+
+  size_t payloadSize() override {
+    return kFixedPayloadSize + 4 * frame_index.size();
+  }
+
+  bool writePayload(Print &out) override {
+    uint32_t values[] = {(uint32_t)sample_rate,
+                         (uint32_t)samples_per_frame,
+                         (uint32_t)frames_per_entry,
+                         scanned_frames,
+                         scanned_bytes,
+                         (uint32_t)scan_pos,
+                         bit_rate_min,
+                         bit_rate_max,
+                         is_scan_complete,
+                         (uint32_t)frame_index.size()};
+    for (uint32_t value : values) {
+      if (!writeLE32(out, value)) return false;
+    }
+    for (uint32_t pos : frame_index) {
+      if (!writeLE32(out, pos)) return false;
+    }
+    return true;
+  }
+
+  bool readPayload(Stream &in, size_t len) override {
+    uint8_t data[kFixedPayloadSize];
+    if (len < sizeof(data) || readFully(in, data, sizeof(data)) != sizeof(data))
+      return false;
+    uint32_t count = le32(data + 36);
+    if (len != payloadSize(count) || le32(data + 8) == 0) {
+      LOGW("SeekIndex: invalid index record");
+      return false;
+    }
+    frame_index.resize(count);
+    for (uint32_t j = 0; j < count; j++) {
+      uint8_t value[4];
+      if (readFully(in, value, 4) != 4) {
+        reset();
+        return false;
+      }
+      frame_index[j] = le32(value);
+    }
+    sample_rate = le32(data);
+    samples_per_frame = le32(data + 4);
+    frames_per_entry = le32(data + 8);
+    scanned_frames = le32(data + 12);
+    scanned_bytes = le32(data + 16);
+    scan_pos = le32(data + 20);
+    bit_rate_min = le32(data + 24);
+    bit_rate_max = le32(data + 28);
+    is_scan_complete = le32(data + 32) != 0;
+    is_tag_checked = true;
+    carry_len = 0;
+    return true;
+  }
+
+  size_t payloadSize(uint32_t count) { return kFixedPayloadSize + 4 * count; }
+};
+
+/**
+ * @brief SeekIndex for MP3 files. If the first frame contains a Xing/Info or
+ * VBRI header we use its table of contents. Otherwise we check the first
+ * frames: for constant bit rates the position is calculated, for variable bit
+ * rates we use the frame index which is only extended up to the requested
+ * time.
+ * @ingroup player
+ * @author Phil Schatzmann
+ * @copyright GPLv3
+ */
+class SeekIndexMP3 : public SeekIndexFrames {
+ public:
+  typedef HeaderParserMP3::FrameHeader FrameHeader;
+
+  void reset() override {
+    SeekIndexFrames::reset();
+    toc.clear();
+    mode = Mode::FrameIndex;
+  }
+
+  bool findPosition(SeekableSource &src, size_t fileSize, uint32_t timeMs,
+                    size_t &pos) override {
+    if (!is_valid && !parse(src, fileSize)) return false;
+    uint64_t frame = frameOf(timeMs);
+    switch (mode) {
+      case Mode::Xing:
+        pos = xingPosition(frame, fileSize);
+        break;
+      case Mode::VBRI:
+        pos = vbriPosition(frame);
+        break;
+      case Mode::CBR:
+        pos = audio_start + (uint64_t)timeMs * bit_rate / 8000;
+        break;
+      default:
+        pos = indexPosition(src, fileSize, frame);
+        break;
+    }
+    if (pos > fileSize) pos = fileSize;
+    return true;
+  }
+
+  uint32_t durationMs(SeekableSource &src, size_t fileSize) override {
+    if (is_scan_complete) return indexedMs();
+    if (!is_valid && !parse(src, fileSize)) return 0;
+    switch (mode) {
+      case Mode::Xing:
+      case Mode::VBRI:
+        return (uint64_t)total_frames * samples_per_frame * 1000 / sample_rate;
+      case Mode::CBR:
+        return (uint64_t)(fileSize - audio_start) * 8000 / bit_rate;
+      default:
+        return SeekIndexFrames::durationMs(src, fileSize);
+    }
+  }
+
+ protected:
+  enum class Mode { Xing, VBRI, CBR, FrameIndex };
+  Mode mode = Mode::FrameIndex;
+  size_t audio_start = 0;
+  int bit_rate = 0;
+  // Xing: 100 entries in 1/256 of the size; VBRI: size of each segment
+  Vector<uint32_t> toc;
+  uint32_t toc_bytes = 0;
+  uint32_t total_frames = 0;
+  uint32_t frames_per_toc_entry = 0;
+
+  uint8_t recordType() override { return 'M'; }
+
+  int headerLen() override { return 4; }
+
+  bool decodeFrame(const uint8_t *data, Frame &frame) override {
+    FrameHeader header;
+    if (!isValid(data, header)) return false;
+    frame.len = header.getFrameLength();
+    frame.samples = header.getSamplesPerFrame();
+    frame.sample_rate = header.getSampleRate();
+    return true;
+  }
+
+  static bool isValid(const uint8_t *data, FrameHeader &header) {
+    return FrameHeader::decode(data, header) && header.isValid();
+  }
+
+  /// Determines the seek mode: a loaded frame index is kept
+  bool parse(SeekableSource &src, size_t fileSize) {
+    uint8_t data[512];
+    // skip ID3v2 tag
+    audio_start = 0;
+    if (readAt(src, 0, data, 10) == 10 && memcmp(data, "ID3", 3) == 0) {
+      audio_start = tagSize(data);
+    }
+    // find the first frame which is followed by a valid frame
+    FrameHeader header;
+    bool found = false;
+    for (int block = 0; block < 16 && !found; block++) {
+      size_t len = readAt(src, audio_start, data, sizeof(data));
+      if (len < 4) break;
+      int j = 0;
+      for (; j + 4 <= (int)len; j++) {
+        FrameHeader next;
+        uint8_t next_data[4];
+        if (!isValid(data + j, header)) continue;
+        size_t next_pos = audio_start + j + header.getFrameLength();
+        if (readAt(src, next_pos, next_data, 4) == 4 &&
+            isValid(next_data, next)) {
+          found = true;
+          break;
+        }
+      }
+      audio_start += j;
+    }
+    if (!found) {
+      LOGE("SeekIndexMP3: no valid frame found");
+      return false;
+    }
+    sample_rate = header.getSampleRate();
+    samples_per_frame = header.getSamplesPerFrame();
+    bit_rate = header.getBitRate();
+
+    if (parseXing(src, header) || parseVBRI(src)) {
+      is_valid = true;
+      return true;
+    }
+    mode = isConstantBitRate(src) ? Mode::CBR : Mode::FrameIndex;
+    is_valid = true;
+    return true;
+  }
+
+  bool parseXing(SeekableSource &src, const FrameHeader &header) {
+    bool mono = header.channelMode == FrameHeader::ChannelModeID::SINGLE;
+    int side_info = header.audioVersion == FrameHeader::MPEGVersionID::MPEG_1
+                        ? (mono ? 17 : 32)
+                        : (mono ? 9 : 17);
+    uint8_t data[120];
+    size_t pos = audio_start + 4 + side_info;
+    if (readAt(src, pos, data, 8) != 8) return false;
+    if (memcmp(data, "Xing", 4) != 0 && memcmp(data, "Info", 4) != 0)
+      return false;
+    uint32_t flags = be32(data + 4);
+    // without frames and toc we can not use it
+    if ((flags & 0x1) == 0 || (flags & 0x4) == 0) return false;
+    size_t len = 4 + ((flags & 0x2) ? 4 : 0) + 100;
+    if (readAt(src, pos + 8, data, len) != len) return false;
+    total_frames = be32(data);
+    toc_bytes = (flags & 0x2) ? be32(data + 4) : 0;
+    const uint8_t *p_toc = data + len - 100;
+    toc.resize(100);
+    for (int j = 0; j < 100; j++) toc[j] = p_toc[j];
+    mode = Mode::Xing;
+    LOGI("SeekIndexMP3: Xing with %u frames", (unsigned)total_frames);
+    return total_frames > 0;
+  }
+
+  bool parseVBRI(SeekableSource &src) {
+    uint8_t data[26];
+    size_t pos = audio_start + 4 + 32;
+    if (readAt(src, pos, data, sizeof(data)) != sizeof(data)) return false;
+    if (memcmp(data, "VBRI", 4) != 0) return false;
+    total_frames = be32(data + 14);
+    int entries = be16(data + 18);
+    int scale = be16(data + 20);
+    int entry_size = be16(data + 22);
+    frames_per_toc_entry = be16(data + 24);
+    if (entries == 0 || entry_size < 1 || entry_size > 4 ||
+        frames_per_toc_entry == 0)
+      return false;
+    toc.resize(entries);
+    pos += sizeof(data);
+    for (int j = 0; j < entries; j++) {
+      uint8_t value[4];
+      if (readAt(src, pos, value, entry_size) != (size_t)entry_size)
+        return false;
+      uint32_t size = 0;
+      for (int k = 0; k < entry_size; k++) size = size << 8 | value[k];
+      toc[j] = size * scale;
+      pos += entry_size;
+    }
+    // the table starts after the VBRI frame
+    uint8_t frame[4];
+    FrameHeader header;
+    readAt(src, audio_start, frame, 4);
+    if (isValid(frame, header)) audio_start += header.getFrameLength();
+    mode = Mode::VBRI;
+    LOGI("SeekIndexMP3: VBRI with %u frames", (unsigned)total_frames);
+    return true;
+  }
+
+  /// Checks if the first frames have the same bit rate
+  bool isConstantBitRate(SeekableSource &src) {
+    size_t pos = audio_start;
+    int bitrate_index = -1;
+    for (int j = 0; j < 8; j++) {
+      uint8_t data[4];
+      FrameHeader header;
+      if (readAt(src, pos, data, 4) != 4 || !isValid(data, header)) break;
+      if (bitrate_index >= 0 && header.bitrateIndex != bitrate_index)
+        return false;
+      bitrate_index = header.bitrateIndex;
+      pos += header.getFrameLength();
+    }
+    return true;
+  }
+
+  size_t xingPosition(uint64_t frame, size_t fileSize) {
+    float percent = 100.0f * frame / total_frames;
+    if (percent >= 100.0f) return fileSize;
+    int idx = (int)percent;
+    float lower = toc[idx];
+    float upper = idx < 99 ? toc[idx + 1] : 256.0f;
+    float value = lower + (upper - lower) * (percent - idx);
+    size_t bytes = toc_bytes > 0 ? toc_bytes : fileSize - audio_start;
+    return audio_start + (size_t)(value / 256.0f * bytes);
+  }
+
+  size_t vbriPosition(uint64_t frame) {
+    size_t pos = audio_start;
+    uint64_t entries = frame / frames_per_toc_entry;
+    for (uint64_t j = 0; j < entries && j < toc.size(); j++) pos += toc[j];
+    return pos;
+  }
+};
+
+/**
+ * @brief SeekIndex for AAC files with ADTS headers: the positions are taken
+ * from the frame index.
+ * @ingroup player
+ * @author Phil Schatzmann
+ * @copyright GPLv3
+ */
+class SeekIndexAAC : public SeekIndexFrames {
+ protected:
+  uint8_t recordType() override { return 'A'; }
+
+  int headerLen() override { return 7; }
+
+  bool decodeFrame(const uint8_t *data, Frame &frame) override {
+    static const int rates[] = {96000, 88200, 64000, 48000, 44100,
+                                32000, 24000, 22050, 16000, 12000,
+                                11025, 8000,  7350};
+    // syncword and layer 0
+    if (data[0] != 0xFF || (data[1] & 0xF6) != 0xF0) return false;
+    int freq_idx = (data[2] >> 2) & 0xF;
+    if (freq_idx > 12) return false;
+    frame.len = ((data[3] & 0x3) << 11) | (data[4] << 3) | (data[5] >> 5);
+    if (frame.len < 7) return false;
+    frame.samples = 1024 * ((data[6] & 0x3) + 1);
+    frame.sample_rate = rates[freq_idx];
+    return true;
+  }
+};
+
+/**
+ * @brief SeekIndex for Ogg files (Opus, Vorbis and FLAC): we use a bisection
+ * on the granule positions of the pages to find the page which contains the
+ * requested time. The header pages are provided to the restarted decoder.
+ * @ingroup player
+ * @author Phil Schatzmann
+ * @copyright GPLv3
+ */
+class SeekIndexOgg : public SeekIndex {
+ public:
+  bool findPosition(SeekableSource &src, size_t fileSize, uint32_t timeMs,
+                    size_t &pos) override {
+    if (!is_valid && !parse(src, fileSize)) return false;
+    uint64_t target = pre_skip + (uint64_t)timeMs * sample_rate / 1000;
+    // bisection: lo is always the start of a page and all pages before lo
+    // end before the target
+    size_t lo = header_end;
+    size_t hi = fileSize;
+    Page page;
+    while (hi - lo > kLinearSearchSize) {
+      size_t mid = lo + (hi - lo) / 2;
+      if (!findPage(src, mid, hi, page)) {
+        hi = mid;
+        continue;
+      }
+      if (page.granule != kNoGranule && page.granule < target) {
+        lo = page.pos + page.len;
+      } else {
+        hi = mid;
+      }
+    }
+    // linear search for the first page which ends after the target
+    pos = lo;
+    while (pos < fileSize) {
+      if (!readPage(src, pos, page)) break;
+      if (page.granule != kNoGranule && page.granule >= target) return true;
+      pos += page.len;
+    }
+    pos = fileSize;
+    return true;
+  }
+
+  size_t headerSize() override { return header_end; }
+
+ protected:
+  static const uint64_t kNoGranule = (uint64_t)-1;
+  static const size_t kLinearSearchSize = 16 * 1024;
+  static const size_t kMaxHeaderLen = 27 + 255;
+  struct Page {
+    size_t pos = 0;
+    size_t len = 0;
+    uint64_t granule = 0;
+  };
+  size_t header_end = 0;
+  size_t file_size = 0;
+  uint32_t sample_rate = 0;
+  uint32_t pre_skip = 0;
+
+  /// Determines the codec from the first page and the end of the header pages
+  bool parse(SeekableSource &src, size_t fileSize) {
+    Page page;
+    uint8_t data[30];
+    file_size = fileSize;
+    if (!readPage(src, 0, page) || readAt(src, 26, data, 1) != 1) {
+      LOGE("SeekIndexOgg: not an ogg file");
+      return false;
+    }
+    // the first packet follows the segment table
+    if (readAt(src, 27 + data[0], data, 30) != 30) return false;
+    pre_skip = 0;
+    if (memcmp(data, "OpusHead", 8) == 0) {
+      sample_rate = 48000;
+      pre_skip = le16(data + 10);
+    } else if (memcmp(data, "\x01vorbis", 7) == 0) {
+      sample_rate = le32(data + 12);
+    } else if (memcmp(data, "\x7F""FLAC", 5) == 0) {
+      sample_rate = (data[27] << 12) | (data[28] << 4) | (data[29] >> 4);
+    } else {
+      LOGE("SeekIndexOgg: unsupported codec");
+      return false;
+    }
+    // the header pages have no (0) or an undefined granule position
+    size_t pos = 0;
+    while (pos < fileSize && readPage(src, pos, page)) {
+      if (page.granule != 0 && page.granule != kNoGranule) break;
+      pos += page.len;
+    }
+    header_end = pos;
+    is_valid = sample_rate > 0;
+    return is_valid;
+  }
+
+  /// Reads the page header at the indicated position
+  bool readPage(SeekableSource &src, size_t pos, Page &page) {
+    uint8_t data[kMaxHeaderLen];
+    size_t len = readAt(src, pos, data, sizeof(data));
+    if (len < 27 || memcmp(data, "OggS", 4) != 0 || data[4] != 0) return false;
+    int segments = data[26];
+    if (len < 27u + segments) return false;
+    size_t body = 0;
+    for (int j = 0; j < segments; j++) body += data[27 + j];
+    page.pos = pos;
+    page.len = 27 + segments + body;
+    page.granule = le64(data + 6);
+    return true;
+  }
+
+  /// Finds the next page starting from pos which is followed by a valid page
+  bool findPage(SeekableSource &src, size_t pos, size_t end, Page &page) {
+    uint8_t data[1024];
+    while (pos < end) {
+      size_t len = readAt(src, pos, data, sizeof(data));
+      if (len < 4) return false;
+      for (size_t j = 0; j + 4 <= len; j++) {
+        if (memcmp(data + j, "OggS", 4) != 0) continue;
+        Page next;
+        if (readPage(src, pos + j, page) &&
+            (page.pos + page.len == file_size ||
+             readPage(src, page.pos + page.len, next))) {
+          return true;
+        }
+      }
+      // the capture pattern might be split
+      pos += len - 3;
+    }
+    return false;
+  }
+};
+
+}  // namespace audio_tools
@@ -0,0 +1,284 @@
+#pragma once
+
+#include "AudioTools/AudioCodecs/ContainerM4A.h"
+#include "AudioTools/AudioCodecs/SeekIndex.h"
+
+namespace audio_tools {
+
+/**
+ * @brief SeekIndex for M4A files which are played with a ContainerM4A: the
+ * sample which contains the requested time is determined from the stts table
+ * and its file position from the stsc, stco (or co64) and stsz tables of the
+ * first audio track. The tables are read from the file on demand, so no RAM
+ * is needed for them.
+ *
+ * The moov box must be in front of the mdat box (fast start): the header
+ * which is replayed to the restarted decoder consists of all data up to the
+ * mdat payload and the container is told to skip the sizes of the samples
+ * before the new position.
+ *
+ * @code
+ * ContainerM4A m4a(multi_decoder);
+ * SeekIndexM4A index(m4a);
+ * player.setSeekIndex(index);
+ * @endcode
+ * @ingroup player
+ * @author Phil Schatzmann
+ * @copyright GPLv3
+ */
+class SeekIndexM4A : public SeekIndex {
+ public:
+  SeekIndexM4A(ContainerM4A &container) { p_container = &container; }
+
+  bool findPosition(SeekableSource &src, size_t fileSize, uint32_t timeMs,
+                    size_t &pos) override {
+    if (!is_valid && !parse(src, fileSize)) return false;
+    uint32_t sample = findSample((uint64_t)timeMs * timescale / 1000, src);
+    if (sample >= sample_count) {
+      pos = mdat_end;
+    } else if (!samplePosition(src, sample, pos)) {
+      return false;
+    }
+    p_container->setStartSample(sample);
+    return true;
+  }
+
+  size_t headerSize() override { return mdat_start; }
+
+  uint32_t durationMs(SeekableSource &src, size_t fileSize) override {
+    if (!is_valid && !parse(src, fileSize)) return 0;
+    return (uint64_t)duration * 1000 / timescale;
+  }
+
+ protected:
+  /// Location of a table: the entries start after the version/flags and
+  /// the entry count
+  struct Table {
+    size_t pos = 0;
+    uint32_t count = 0;
+  };
+  ContainerM4A *p_container = nullptr;
+  size_t mdat_start = 0;
+  size_t mdat_end = 0;
+  uint32_t timescale = 0;
+  uint64_t duration = 0;
+  uint32_t sample_count = 0;
+  uint32_t fixed_sample_size = 0;
+  size_t sizes_pos = 0;
+  Table stts;
+  Table stsc;
+  Table stco;
+  bool is_co64 = false;
+
+  /// Reads the header of the box at pos: returns false at the end
+  bool readBox(SeekableSource &src, size_t pos, size_t end, char *type,
+               size_t &headerLen, size_t &boxLen) {
+    uint8_t data[16];
+    if (pos + 8 > end || readAt(src, pos, data, 8) != 8) return false;
+    memcpy(type, data + 4, 4);
+    headerLen = 8;
+    boxLen = be32(data);
+    if (boxLen == 1) {
+      // 64 bit size
+      if (readAt(src, pos + 8, data + 8, 8) != 8) return false;
+      uint64_t len = ((uint64_t)be32(data + 8) << 32) | be32(data + 12);
+      boxLen = (size_t)len;
+      headerLen = 16;
+    } else if (boxLen == 0) {
+      // up to the end of the file
+      boxLen = end - pos;
+    }
+    return boxLen >= headerLen && pos + boxLen <= end;
+  }
+
+  /// Finds the child box with the indicated type in [pos, end)
+  bool findBox(SeekableSource &src, size_t pos, size_t end, const char *type,
+               size_t &start, size_t &boxEnd) {
+    char box_type[4];
+    size_t header_len = 0, box_len = 0;
+    while (readBox(src, pos, end, box_type, header_len, box_len)) {
+      if (memcmp(box_type, type, 4) == 0) {
+        start = pos + header_len;
+        boxEnd = pos + box_len;
+        return true;
+      }
+      pos += box_len;
+    }
+    return false;
+  }
+
+  /// Locates the moov and mdat boxes and the tables of the audio track
+  bool parse(SeekableSource &src, size_t fileSize) {
+    size_t moov_start = 0, moov_end = 0, mdat_box = 0;
+    char type[4];
+    size_t header_len = 0, box_len = 0, pos = 0;
+    mdat_start = 0;
+    while (readBox(src, pos, fileSize, type, header_len, box_len)) {
+      if (memcmp(type, "moov", 4) == 0) {
+        moov_start = pos + header_len;
+        moov_end = pos + box_len;
+      } else if (memcmp(type, "mdat", 4) == 0 && mdat_start == 0) {
+        mdat_box = pos;
+        mdat_start = pos + header_len;
+        mdat_end = pos + box_len;
+      }
+      pos += box_len;
+    }
+    if (moov_end == 0 || mdat_start == 0) {
+      LOGE("SeekIndexM4A: no moov or mdat");
+      return false;
+    }
+    if (moov_start > mdat_box) {
+      LOGE("SeekIndexM4A: moov after mdat is not supported");
+      return false;
+    }
+    // first audio track
+    size_t trak_start = 0, trak_end = 0;
+    pos = moov_start;
+    while (findBox(src, pos, moov_end, "trak", trak_start, trak_end)) {
+      if (parseTrack(src, trak_start, trak_end)) {
+        is_valid = true;
+        return true;
+      }
+      pos = trak_end;
+    }
+    LOGE("SeekIndexM4A: no audio track");
+    return false;
+  }
+
+  /// Reads the relevant information if the track contains audio
+  bool parseTrack(SeekableSource &src, size_t pos, size_t end) {
+    size_t mdia = 0, mdia_end = 0, start = 0, box_end = 0;
+    uint8_t data[24];
+    if (!findBox(src, pos, end, "mdia", mdia, mdia_end)) return false;
+    // handler type
+    if (!findBox(src, mdia, mdia_end, "hdlr", start, box_end) ||
+        readAt(src, start, data, 12) != 12 || memcmp(data + 8, "soun", 4) != 0)
+      return false;
+    // timescale
+    if (!findBox(src, mdia, mdia_end, "mdhd", start, box_end) ||
+        readAt(src, start, data, 24) != 24)
+      return false;
+    timescale = data[0] == 1 ? be32(data + 20) : be32(data + 12);
+    // sample table
+    size_t minf = 0, minf_end = 0, stbl = 0, stbl_end = 0;
+    if (timescale == 0 ||
+        !findBox(src, mdia, mdia_end, "minf", minf, minf_end) ||
+        !findBox(src, minf, minf_end, "stbl", stbl, stbl_end))
+      return false;
+    if (!readTable(src, stbl, stbl_end, "stts", stts) ||
+        !readTable(src, stbl, stbl_end, "stsc", stsc))
+      return false;
+    is_co64 = !readTable(src, stbl, stbl_end, "stco", stco);
+    if (is_co64 && !readTable(src, stbl, stbl_end, "co64", stco)) return false;
+    // sample sizes
+    if (!findBox(src, stbl, stbl_end, "stsz", start, box_end) ||
+        readAt(src, start, data, 12) != 12)
+      return false;
+    fixed_sample_size = be32(data + 4);
+    sample_count = be32(data + 8);
+    sizes_pos = start + 12;
+    // duration from the stts entries
+    duration = 0;
+    for (uint32_t j = 0; j < stts.count; j++) {
+      if (readAt(src, stts.pos + j * 8, data, 8) != 8) return false;
+      duration += (uint64_t)be32(data) * be32(data + 4);
+    }
+    LOGI("SeekIndexM4A: %u samples, timescale %u", (unsigned)sample_count,
+         (unsigned)timescale);
+    return true;
+  }
+
+  bool readTable(SeekableSource &src, size_t pos, size_t end, const char *type,
+                 Table &table) {
+    size_t start = 0, box_end = 0;
+    uint8_t data[8];
+    if (!findBox(src, pos, end, type, start, box_end) ||
+        readAt(src, start, data, 8) != 8)
+      return false;
+    table.count = be32(data + 4);
+    table.pos = start + 8;
+    return true;
+  }
+
+  /// Determines the sample which contains the indicated time (in timescale
+  /// units) from the stts entries
+  uint32_t findSample(uint64_t time, SeekableSource &src) {
+    uint64_t sample = 0;
+    uint8_t data[8];
+    for (uint32_t j = 0; j < stts.count; j++) {
+      if (readAt(src, stts.pos + j * 8, data, 8) != 8) break;
+      uint32_t count = be32(data);
+      uint32_t delta = be32(data + 4);
+      uint64_t entry_time = (uint64_t)count * delta;
+      if (delta > 0 && time < entry_time) return sample + time / delta;
+      time -= entry_time;
+      sample += count;
+    }
+    return sample_count;
+  }
+
+  /// Determines the file position of the sample: the chunk is taken from the
+  /// stsc runs, its offset from stco and the samples before it in the chunk
+  /// from stsz
+  bool samplePosition(SeekableSource &src, uint32_t sample, size_t &pos) {
+    uint8_t data[12];
+    uint32_t first_sample = 0;
+    for (uint32_t j = 0; j < stsc.count; j++) {
+      if (readAt(src, stsc.pos + j * 12, data, 12) != 12) return false;
+      uint32_t first_chunk = be32(data);
+      uint32_t samples_per_chunk = be32(data + 4);
+      // the run ends with the next entry or with the last chunk
+      uint32_t next_chunk = stco.count + 1;
+      if (j + 1 < stsc.count) {
+        if (readAt(src, stsc.pos + (j + 1) * 12, data, 4) != 4) return false;
+        next_chunk = be32(data);
+      }
+      if (samples_per_chunk == 0 || next_chunk <= first_chunk) continue;
+      uint64_t run = (uint64_t)(next_chunk - first_chunk) * samples_per_chunk;
+      if (sample < first_sample + run) {
+        uint32_t chunk_idx = (sample - first_sample) / samples_per_chunk;
+        uint32_t chunk = first_chunk - 1 + chunk_idx;
+        uint32_t chunk_sample = first_sample + chunk_idx * samples_per_chunk;
+        return chunkOffset(src, chunk, pos) &&
+               addSampleSizes(src, chunk_sample, sample, pos);
+      }
+      first_sample += run;
+    }
+    LOGE("SeekIndexM4A: sample %u not in stsc", (unsigned)sample);
+    return false;
+  }
+
+  bool chunkOffset(SeekableSource &src, uint32_t chunk, size_t &pos) {
+    uint8_t data[8];
+    if (chunk >= stco.count) return false;
+    if (is_co64) {
+      if (readAt(src, stco.pos + chunk * 8, data, 8) != 8) return false;
+      pos = (size_t)(((uint64_t)be32(data) << 32) | be32(data + 4));
+    } else {
+      if (readAt(src, stco.pos + chunk * 4, data, 4) != 4) return false;
+      pos = be32(data);
+    }
+    return true;
+  }
+
+  /// Adds the sizes of the samples [from, to) to pos
+  bool addSampleSizes(SeekableSource &src, uint32_t from, uint32_t to,
+                      size_t &pos) {
+    if (fixed_sample_size > 0) {
+      pos += (size_t)(to - from) * fixed_sample_size;
+      return true;
+    }
+    uint8_t data[64];
+    while (from < to) {
+      uint32_t n = min((uint32_t)(sizeof(data) / 4), to - from);
+      if (readAt(src, sizes_pos + from * 4, data, n * 4) != n * 4)
+        return false;
+      for (uint32_t j = 0; j < n; j++) pos += be32(data + j * 4);
+      from += n;
+    }
+    return true;
+  }
+};
+
+}  // namespace audio_tools
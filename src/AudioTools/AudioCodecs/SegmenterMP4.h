@@ -0,0 +1,903 @@
+#pragma once
+
+#include <stdio.h>
+#include <string.h>
+
+#include "AudioTools/AudioCodecs/ContainerMP4.h"
+#include "AudioTools/CoreAudio/AudioBasic/Collections/Vector.h"
+#include "AudioTools/CoreAudio/AudioLogger.h"
+
+namespace audio_tools {
+
+/**
+ * @brief Storage for the completed segments of a SegmenterMP4, e.g. rolling
+ * files on a SD drive (see SegmentStoreFile). Segments which are dropped from
+ * the playlist are removed again. Without a store the segments are kept in
+ * RAM.
+ * @ingroup codecs
+ * @author Phil Schatzmann
+ * @copyright GPLv3
+ */
+class SegmentStore {
+ public:
+  virtual ~SegmentStore() = default;
+  /// Starts to write the indicated segment
+  virtual bool open(const char* name) = 0;
+  /// Writes the next block of the open segment
+  virtual size_t write(const uint8_t* data, size_t len) = 0;
+  /// Closes the open segment
+  virtual void close() = 0;
+  /// Removes a segment which is not needed any more
+  virtual void remove(const char* name) = 0;
+  /// Reads the data of a stored segment from the indicated position
+  virtual size_t read(const char* name, size_t pos, uint8_t* data,
+                      size_t len) = 0;
+};
+
+/**
+ * @brief Cuts a fragmented MP4 stream (e.g. the output of MuxerMP4) into
+ * HLS/CMAF media segments and maintains the corresponding HLS media playlist.
+ * Set it as output of the MuxerMP4: 'ftyp'+'moov' become the init segment
+ * and the 'moof'+'mdat' fragments are collected into segments. A new segment
+ * is started with a key frame of the reference track (video, or audio if
+ * there is no video) when the next key frame interval would exceed the
+ * target duration, so the target duration should be a multiple of the key
+ * frame interval.
+ *
+ * With setPartDuration() the segments are also split into partial segments
+ * and the playlist contains the Low-Latency HLS tags: a part is closed
+ * before the next fragment would exceed the part duration, so the fragments
+ * of the MuxerMP4 must not be longer than a part. With setIndex() each
+ * segment starts with a 'sidx' box, and if all segments are kept
+ * (setWindowSize(0)) the complete recording is available as a single
+ * seekable file with a trailing 'mfra' index after end() (see
+ * ResourceType::VOD).
+ *
+ * The result is provided by name (see find() and read()): "live.m3u8",
+ * "init.mp4", "seg<n>.m4s", "part<n>.<p>.m4s" and "vod.mp4", so it can be
+ * served e.g. with the HLSServerT.
+ *
+ * @code
+ * SegmenterMP4 segmenter;
+ * MuxerMP4 mux(segmenter);
+ * HLSServer server(segmenter);
+ * @endcode
+ * @ingroup codecs
+ * @ingroup video
+ * @author Phil Schatzmann
+ * @copyright GPLv3
+ */
+class SegmenterMP4 : public Print {
+ public:
+  /// Type of a resource which can be requested by name
+  enum class ResourceType { Undefined, Playlist, Init, Segment, Part, VOD };
+
+  /// Resource which was found by find()
+  struct Resource {
+    ResourceType type = ResourceType::Undefined;
+    uint32_t seq = 0;
+    int part = -1;
+    /// size in bytes: 0 for the playlist, which is generated on request
+    size_t size = 0;
+  };
+
+  SegmenterMP4() = default;
+  ~SegmenterMP4() { clear(); }
+
+  /// Defines the max duration of a segment in ms (default 4000): it is
+  /// published as EXT-X-TARGETDURATION (rounded up to seconds)
+  void setTargetDuration(uint32_t ms) { target_ms = ms; }
+
+  /// Defines the max duration of the partial segments in ms for Low-Latency
+  /// HLS: 0 (default) deactivates them
+  void setPartDuration(uint32_t ms) { part_ms = ms; }
+
+  /// Number of segments which are kept in the playlist (default 6): 0 keeps
+  /// all of them, so that the result can be provided as VOD
+  void setWindowSize(int segments) { window_size = segments; }
+
+  /// Starts each segment with a 'sidx' segment index (default false)
+  void setIndex(bool active) { is_index = active; }
+
+  /// Defines the storage for the completed segments
+  void setSegmentStore(SegmentStore& store) { p_store = &store; }
+
+  bool begin() {
+    clear();
+    is_active = true;
+    return true;
+  }
+
+  /// Completes the last segment: the playlist is marked as ended
+  void end() {
+    if (!is_active) return;
+    closeSegment();
+    if (window_size == 0) writeMfra();
+    is_active = false;
+    is_ended = true;
+  }
+
+  operator bool() { return is_active; }
+
+  size_t write(uint8_t ch) override { return write(&ch, 1); }
+
+  /// Receives the fragmented MP4 stream
+  size_t write(const uint8_t* data, size_t len) override {
+    if (!is_active) return 0;
+    size_t pos = 0;
+    while (pos < len) {
+      if (box_remaining == 0) {
+        // collect the box header
+        size_t n = min(len - pos, sizeof(box_header) - header_len);
+        memcpy(box_header + header_len, data + pos, n);
+        header_len += n;
+        pos += n;
+        if (header_len < sizeof(box_header)) break;
+        header_len = 0;
+        beginBox();
+      } else {
+        size_t n = min(len - pos, box_remaining);
+        boxData(data + pos, n);
+        pos += n;
+        box_remaining -= n;
+      }
+      if (box_remaining == 0) endBox();
+    }
+    return len;
+  }
+
+  /// True after end()
+  bool isEnded() { return is_ended; }
+
+  /// Sequence number of the first segment in the playlist
+  uint32_t firstSequence() {
+    return segments.empty() ? next_seq : segments[0]->seq;
+  }
+
+  /// Number of completed segments in the playlist
+  int segmentCount() {
+    int result = 0;
+    for (auto seg : segments) {
+      if (seg->is_complete) result++;
+    }
+    return result;
+  }
+
+  /// Duration of the indicated segment in ms
+  uint32_t segmentDurationMs(uint32_t seq) {
+    Segment* seg = segment(seq);
+    return seg == nullptr ? 0 : toMs(seg->duration);
+  }
+
+  /// Number of completed partial segments of the indicated segment
+  int partCount(uint32_t seq) {
+    Segment* seg = segment(seq);
+    return seg == nullptr ? 0 : completedParts(*seg);
+  }
+
+  /// Provides the init segment ('ftyp'+'moov')
+  Vector<uint8_t>& initSegment() { return init; }
+
+  /// Checks if the indicated segment (part < 0) or partial segment is
+  /// available: used to implement blocking playlist reloads
+  bool isAvailable(uint32_t seq, int part = -1) {
+    if (is_ended || seq < firstSequence()) return true;
+    Segment* seg = segment(seq);
+    if (seg == nullptr) return false;
+    if (seg->is_complete) return true;
+    return part >= 0 && part < completedParts(*seg);
+  }
+
+  /// Writes the HLS media playlist
+  void writePlaylist(Print& out) {
+    char line[160];
+    bool is_ll = part_ms > 0;
+    out.print("#EXTM3U\n");
+    snprintf(line, sizeof(line), "#EXT-X-VERSION:%d\n", is_ll ? 9 : 7);
+    out.print(line);
+    snprintf(line, sizeof(line), "#EXT-X-TARGETDURATION:%u\n",
+             (unsigned)targetDurationSec());
+    out.print(line);
+    if (is_ll) {
+      char part[16], hold_back[16];
+      snprintf(line, sizeof(line),
+               "#EXT-X-SERVER-CONTROL:CAN-BLOCK-RELOAD=YES,PART-HOLD-BACK=%s\n",
+               seconds(hold_back, sizeof(hold_back), 3 * part_ms));
+      out.print(line);
+      snprintf(line, sizeof(line), "#EXT-X-PART-INF:PART-TARGET=%s\n",
+               seconds(part, sizeof(part), part_ms));
+      out.print(line);
+    }
+    if (window_size == 0) {
+      out.print(is_ended ? "#EXT-X-PLAYLIST-TYPE:VOD\n"
+                         : "#EXT-X-PLAYLIST-TYPE:EVENT\n");
+    }
+    snprintf(line, sizeof(line), "#EXT-X-MEDIA-SEQUENCE:%u\n",
+             (unsigned)firstSequence());
+    out.print(line);
+    out.print("#EXT-X-INDEPENDENT-SEGMENTS\n");
+    out.print("#EXT-X-MAP:URI=\"init.mp4\"\n");
+
+    char duration[16];
+    for (auto seg : segments) {
+      // the parts are only listed for the most recent segments
+      if (is_ll && seg->seq + 3 >= next_seq) {
+        int parts = completedParts(*seg);
+        for (int j = 0; j < parts; j++) {
+          Part& p = seg->parts[j];
+          snprintf(line, sizeof(line),
+                   "#EXT-X-PART:DURATION=%s,URI=\"part%u.%d.m4s\"%s\n",
+                   seconds(duration, sizeof(duration), toMs(p.duration)),
+                   (unsigned)seg->seq, j,
+                   p.is_independent ? ",INDEPENDENT=YES" : "");
+          out.print(line);
+        }
+        if (!seg->is_complete) {
+          snprintf(line, sizeof(line),
+                   "#EXT-X-PRELOAD-HINT:TYPE=PART,URI=\"part%u.%d.m4s\"\n",
+                   (unsigned)seg->seq, parts);
+          out.print(line);
+        }
+      }
+      if (seg->is_complete) {
+        snprintf(line, sizeof(line), "#EXTINF:%s,\nseg%u.m4s\n",
+                 seconds(duration, sizeof(duration), toMs(seg->duration)),
+                 (unsigned)seg->seq);
+        out.print(line);
+      }
+    }
+    if (is_ended) out.print("#EXT-X-ENDLIST\n");
+  }
+
+  /// Determines the resource for the indicated name (e.g. "seg12.m4s"): a
+  /// leading '/' is ignored
+  bool find(const char* name, Resource& result) {
+    result = Resource();
+    if (name == nullptr) return false;
+    if (*name == '/') name++;
+    unsigned seq = 0;
+    int part = 0;
+    char end = 0;
+    if (strcmp(name, "live.m3u8") == 0) {
+      result.type = ResourceType::Playlist;
+      return true;
+    }
+    if (strcmp(name, "init.mp4") == 0) {
+      if (!is_init_complete) return false;
+      result.type = ResourceType::Init;
+      result.size = init.size();
+      return true;
+    }
+    if (strcmp(name, "vod.mp4") == 0) {
+      if (!isVOD()) return false;
+      result.type = ResourceType::VOD;
+      result.size = vodSize();
+      return true;
+    }
+    if (sscanf(name, "seg%u.m4%c", &seq, &end) == 2 && end == 's' &&
+        strcmp(name + strlen(name) - 4, ".m4s") == 0) {
+      Segment* seg = segment(seq);
+      if (seg == nullptr || !seg->is_complete) return false;
+      result.type = ResourceType::Segment;
+      result.seq = seq;
+      result.size = seg->fileSize();
+      return true;
+    }
+    if (sscanf(name, "part%u.%d.m4%c", &seq, &part, &end) == 3 &&
+        end == 's') {
+      Segment* seg = segment(seq);
+      if (seg == nullptr || part < 0 || part >= completedParts(*seg))
+        return false;
+      result.type = ResourceType::Part;
+      result.seq = seq;
+      result.part = part;
+      result.size = seg->parts[part].size;
+      return true;
+    }
+    return false;
+  }
+
+  /// Reads the data of a resource (except for the playlist) from the
+  /// indicated position
+  size_t read(Resource& res, size_t pos, uint8_t* data, size_t len) {
+    if (pos >= res.size) return 0;
+    len = min(len, res.size - pos);
+    switch (res.type) {
+      case ResourceType::Init:
+        memcpy(data, init.data() + pos, len);
+        return len;
+      case ResourceType::Segment: {
+        Segment* seg = segment(res.seq);
+        return seg == nullptr ? 0 : readSegment(*seg, pos, data, len);
+      }
+      case ResourceType::Part: {
+        Segment* seg = segment(res.seq);
+        if (seg == nullptr || res.part >= (int)seg->parts.size()) return 0;
+        Part& p = seg->parts[res.part];
+        return readSegment(*seg, seg->sidx.size() + p.offset + pos, data, len);
+      }
+      case ResourceType::VOD:
+        return readVOD(pos, data, len);
+      default:
+        return 0;
+    }
+  }
+
+ protected:
+  /// Subsegment which starts with a fragment of the reference track
+  struct Fragment {
+    size_t offset = 0;
+    size_t moof_offset = 0;
+    uint64_t time = 0;
+    uint32_t duration = 0;
+    bool is_key = false;
+  };
+  struct Part {
+    size_t offset = 0;
+    size_t size = 0;
+    uint64_t duration = 0;
+    bool is_independent = false;
+  };
+  struct Segment {
+    uint32_t seq = 0;
+    uint64_t duration = 0;  ///< in ticks of the reference track
+    /// media data: the capacity grows in steps, so the used size is
+    /// tracked separately; released once the segment has been stored
+    Vector<uint8_t> data;
+    size_t size = 0;
+    Vector<uint8_t> sidx;
+    Vector<Fragment> fragments;
+    Vector<Part> parts;
+    bool is_complete = false;
+    bool is_stored = false;
+    size_t fileSize() { return sidx.size() + size; }
+  };
+  /// information of the first 'traf' of a 'moof'
+  struct FragmentInfo {
+    uint32_t track_id = 0;
+    uint64_t time = 0;
+    uint32_t duration = 0;
+    bool is_key = true;
+  };
+  enum class BoxTarget { Ignore, Init, Moof, Segment };
+
+  uint32_t target_ms = 4000;
+  uint32_t part_ms = 0;
+  int window_size = 6;
+  bool is_index = false;
+  SegmentStore* p_store = nullptr;
+  bool is_active = false;
+  bool is_ended = false;
+
+  // box parser
+  uint8_t box_header[8];
+  size_t header_len = 0;
+  size_t box_remaining = 0;
+  BoxTarget box_target = BoxTarget::Ignore;
+  Vector<uint8_t> moof;
+
+  // init segment and tracks
+  Vector<uint8_t> init;
+  bool is_init_complete = false;
+  uint32_t ref_track_id = 0;
+  uint32_t ref_timescale = 0;
+  bool is_ref_video = false;
+
+  // segments: heap allocated, so that the pointers stay valid
+  Vector<Segment*> segments;
+  Segment* p_current = nullptr;
+  bool is_part_open = false;
+  uint32_t next_seq = 0;
+  // key frame interval of the reference track in ticks
+  uint64_t ref_ticks = 0;
+  uint64_t key_ticks = 0;
+  uint64_t gop_ticks = 0;
+  Vector<uint8_t> mfra;
+
+  void clear() {
+    for (auto seg : segments) {
+      if (seg->is_stored && p_store != nullptr) {
+        char name[32];
+        p_store->remove(segmentName(name, sizeof(name), seg->seq));
+      }
+      delete seg;
+    }
+    segments.clear();
+    p_current = nullptr;
+    is_part_open = false;
+    next_seq = 0;
+    ref_ticks = 0;
+    key_ticks = 0;
+    gop_ticks = 0;
+    header_len = 0;
+    box_remaining = 0;
+    box_target = BoxTarget::Ignore;
+    moof.clear();
+    init.clear();
+    is_init_complete = false;
+    ref_track_id = 0;
+    ref_timescale = 0;
+    is_ref_video = false;
+    mfra.clear();
+    is_ended = false;
+  }
+
+  Segment* segment(uint32_t seq) {
+    for (auto seg : segments) {
+      if (seg->seq == seq) return seg;
+    }
+    return nullptr;
+  }
+
+  int completedParts(Segment& seg) {
+    int result = seg.parts.size();
+    if (&seg == p_current && is_part_open) result--;
+    return result;
+  }
+
+  uint32_t toMs(uint64_t ticks) {
+    return ref_timescale == 0 ? 0 : (uint32_t)(ticks * 1000 / ref_timescale);
+  }
+
+  uint64_t toTicks(uint32_t ms) { return (uint64_t)ms * ref_timescale / 1000; }
+
+  static const char* seconds(char* str, size_t len, uint32_t ms) {
+    snprintf(str, len, "%u.%03u", (unsigned)(ms / 1000), (unsigned)(ms % 1000));
+    return str;
+  }
+
+  static const char* segmentName(char* str, size_t len, uint32_t seq) {
+    snprintf(str, len, "seg%u.m4s", (unsigned)seq);
+    return str;
+  }
+
+  uint32_t targetDurationSec() {
+    return (target_ms + 999) / 1000;
+  }
+
+  // ---- box parser ----
+
+  void beginBox() {
+    uint32_t size = be32(box_header);
+    const char* type = (const char*)box_header + 4;
+    if (size < 8) {
+      // 64 bit sizes are not used for fragments
+      LOGE("SegmenterMP4: unsupported box size %u", (unsigned)size);
+      box_remaining = 0;
+      return;
+    }
+    box_remaining = size - 8;
+    if (memcmp(type, "moof", 4) == 0) {
+      box_target = BoxTarget::Moof;
+      moof.clear();
+      append(moof, box_header, 8);
+    } else if (!is_init_complete) {
+      box_target = BoxTarget::Init;
+      append(init, box_header, 8);
+    } else if (p_current != nullptr) {
+      box_target = BoxTarget::Segment;
+      appendSegment(box_header, 8);
+    } else {
+      box_target = BoxTarget::Ignore;
+    }
+  }
+
+  void boxData(const uint8_t* data, size_t len) {
+    switch (box_target) {
+      case BoxTarget::Init:
+        append(init, data, len);
+        break;
+      case BoxTarget::Moof:
+        append(moof, data, len);
+        break;
+      case BoxTarget::Segment:
+        appendSegment(data, len);
+        break;
+      default:
+        break;
+    }
+  }
+
+  void endBox() {
+    if (box_target == BoxTarget::Init &&
+        memcmp(box_header + 4, "moov", 4) == 0) {
+      parseMoov();
+    } else if (box_target == BoxTarget::Moof) {
+      onMoof();
+    }
+    box_target = BoxTarget::Ignore;
+  }
+
+  static void append(Vector<uint8_t>& vector, const uint8_t* data,
+                     size_t len) {
+    size_t old_size = vector.size();
+    vector.resize(old_size + len);
+    memcpy(vector.data() + old_size, data, len);
+  }
+
+  void appendSegment(const uint8_t* data, size_t len) {
+    Segment& seg = *p_current;
+    if (seg.size + len > (size_t)seg.data.size()) {
+      seg.data.resize(max(seg.size + len, (size_t)seg.data.size() * 3 / 2 + 1024));
+    }
+    memcpy(seg.data.data() + seg.size, data, len);
+    seg.size += len;
+  }
+
+  static uint32_t be32(const uint8_t* p) {
+    return (uint32_t)p[0] << 24 | (uint32_t)p[1] << 16 | (uint32_t)p[2] << 8 |
+           p[3];
+  }
+
+  /// Finds a box in the indicated range: returns the payload or nullptr
+  static const uint8_t* findBox(const uint8_t* data, size_t len,
+                                const char* type, size_t& payloadLen,
+                                size_t start = 0) {
+    size_t pos = start;
+    while (pos + 8 <= len) {
+      uint32_t size = be32(data + pos);
+      if (size < 8 || pos + size > len) return nullptr;
+      if (memcmp(data + pos + 4, type, 4) == 0) {
+        payloadLen = size - 8;
+        return data + pos + 8;
+      }
+      pos += size;
+    }
+    return nullptr;
+  }
+
+  /// Determines the reference track and its timescale from 'moov'
+  void parseMoov() {
+    is_init_complete = true;
+    size_t moov_len = 0, len = 0;
+    const uint8_t* moov_data =
+        findBox(init.data(), init.size(), "moov", moov_len);
+    if (moov_data == nullptr) return;
+    size_t pos = 0;
+    while (pos + 8 <= moov_len) {
+      uint32_t size = be32(moov_data + pos);
+      if (size < 8 || pos + size > moov_len) break;
+      if (memcmp(moov_data + pos + 4, "trak", 4) == 0) {
+        const uint8_t* trak = moov_data + pos + 8;
+        size_t trak_len = size - 8;
+        uint32_t track_id = 0, timescale = 0;
+        bool is_video = false;
+        const uint8_t* tkhd = findBox(trak, trak_len, "tkhd", len);
+        if (tkhd != nullptr && len >= 28) {
+          track_id = be32(tkhd + (tkhd[0] == 1 ? 20 : 12));
+        }
+        size_t mdia_len = 0;
+        const uint8_t* mdia = findBox(trak, trak_len, "mdia", mdia_len);
+        if (mdia != nullptr) {
+          const uint8_t* mdhd = findBox(mdia, mdia_len, "mdhd", len);
+          if (mdhd != nullptr && len >= 24) {
+            timescale = be32(mdhd + (mdhd[0] == 1 ? 20 : 12));
+          }
+          const uint8_t* hdlr = findBox(mdia, mdia_len, "hdlr", len);
+          is_video = hdlr != nullptr && len >= 12 &&
+                     memcmp(hdlr + 8, "vide", 4) == 0;
+        }
+        // the first video track or the first track
+        if (ref_track_id == 0 || (is_video && !is_ref_video)) {
+          ref_track_id = track_id;
+          ref_timescale = timescale;
+          is_ref_video = is_video;
+        }
+      }
+      pos += size;
+    }
+    LOGI("SegmenterMP4: reference track %u with timescale %u",
+         (unsigned)ref_track_id, (unsigned)ref_timescale);
+  }
+
+  /// Determines the track, time, duration and the key frame flag from 'moof'
+  bool parseMoof(FragmentInfo& info) {
+    size_t moof_len = 0, traf_len = 0, len = 0;
+    const uint8_t* moof_data =
+        findBox(moof.data(), moof.size(), "moof", moof_len);
+    if (moof_data == nullptr) return false;
+    const uint8_t* traf = findBox(moof_data, moof_len, "traf", traf_len);
+    if (traf == nullptr) return false;
+    const uint8_t* tfhd = findBox(traf, traf_len, "tfhd", len);
+    if (tfhd == nullptr || len < 8) return false;
+    uint32_t tfhd_flags = be32(tfhd) & 0xFFFFFF;
+    info.track_id = be32(tfhd + 4);
+    size_t pos = 8;
+    uint32_t default_duration = 0, default_flags = 0;
+    if (tfhd_flags & 0x01) pos += 8;  // base-data-offset
+    if (tfhd_flags & 0x02) pos += 4;  // sample-description-index
+    if ((tfhd_flags & 0x08) && pos + 4 <= len) {
+      default_duration = be32(tfhd + pos);
+      pos += 4;
+    }
+    if (tfhd_flags & 0x10) pos += 4;  // default-sample-size
+    if ((tfhd_flags & 0x20) && pos + 4 <= len) default_flags = be32(tfhd + pos);
+
+    const uint8_t* tfdt = findBox(traf, traf_len, "tfdt", len);
+    if (tfdt != nullptr && len >= 8) {
+      info.time = tfdt[0] == 1 && len >= 12
+                      ? (uint64_t)be32(tfdt + 4) << 32 | be32(tfdt + 8)
+                      : be32(tfdt + 4);
+    }
+
+    const uint8_t* trun = findBox(traf, traf_len, "trun", len);
+    if (trun == nullptr || len < 8) return false;
+    uint32_t trun_flags = be32(trun) & 0xFFFFFF;
+    uint32_t count = be32(trun + 4);
+    pos = 8;
+    if (trun_flags & 0x01) pos += 4;  // data-offset
+    uint32_t first_flags = default_flags;
+    if ((trun_flags & 0x04) && pos + 4 <= len) {
+      first_flags = be32(trun + pos);
+      pos += 4;
+    }
+    info.duration = 0;
+    for (uint32_t j = 0; j < count; j++) {
+      uint32_t duration = default_duration;
+      if (trun_flags & 0x100) {
+        if (pos + 4 > len) break;
+        duration = be32(trun + pos);
+        pos += 4;
+      }
+      if (trun_flags & 0x200) pos += 4;  // sample-size
+      if (trun_flags & 0x400) {
+        if (pos + 4 > len) break;
+        if (j == 0 && !(trun_flags & 0x04)) first_flags = be32(trun + pos);
+        pos += 4;
+      }
+      if (trun_flags & 0x800) pos += 4;  // composition-time-offset
+      info.duration += duration;
+    }
+    // sample_is_non_sync_sample
+    info.is_key = (first_flags & 0x00010000) == 0;
+    return true;
+  }
+
+  void onMoof() {
+    FragmentInfo info;
+    if (!parseMoof(info)) {
+      LOGW("SegmenterMP4: invalid moof");
+      return;
+    }
+    bool is_ref = info.track_id == ref_track_id;
+    if (is_ref && info.is_key) {
+      if (ref_ticks > key_ticks) gop_ticks = ref_ticks - key_ticks;
+      key_ticks = ref_ticks;
+      // segments start with a key frame of the reference track: we cut if
+      // the next key frame interval would not fit any more
+      uint64_t target = toTicks(target_ms);
+      if (p_current == nullptr || p_current->duration >= target ||
+          p_current->duration + gop_ticks > target) {
+        closeSegment();
+        openSegment();
+      }
+    }
+    if (p_current == nullptr) {
+      LOGW("SegmenterMP4: ignoring fragment before the first key frame");
+      return;
+    }
+    Segment& seg = *p_current;
+    if (part_ms > 0) {
+      uint64_t part_target = toTicks(part_ms);
+      if (is_ref && info.duration > part_target) {
+        LOGW("SegmenterMP4: fragment of %u ms is longer than a part",
+             (unsigned)toMs(info.duration));
+      }
+      // the part must not exceed the part duration
+      if (is_part_open && is_ref &&
+          seg.parts[seg.parts.size() - 1].duration + info.duration >
+              part_target) {
+        closePart();
+      }
+      if (!is_part_open) {
+        Part part;
+        part.offset = seg.size;
+        part.is_independent = is_ref && info.is_key;
+        seg.parts.push_back(part);
+        is_part_open = true;
+      }
+    }
+    if (is_ref) {
+      Fragment fragment;
+      fragment.offset = seg.fragments.empty() ? 0 : seg.size;
+      fragment.moof_offset = seg.size;
+      fragment.time = info.time;
+      fragment.duration = info.duration;
+      fragment.is_key = info.is_key;
+      seg.fragments.push_back(fragment);
+      seg.duration += info.duration;
+      ref_ticks += info.duration;
+      if (is_part_open) seg.parts[seg.parts.size() - 1].duration += info.duration;
+    }
+    appendSegment(moof.data(), moof.size());
+  }
+
+  void openSegment() {
+    p_current = new Segment();
+    p_current->seq = next_seq++;
+    segments.push_back(p_current);
+  }
+
+  void closePart() {
+    if (!is_part_open) return;
+    Segment& seg = *p_current;
+    Part& part = seg.parts[seg.parts.size() - 1];
+    part.size = seg.size - part.offset;
+    is_part_open = false;
+  }
+
+  void closeSegment() {
+    if (p_current == nullptr) return;
+    closePart();
+    Segment& seg = *p_current;
+    if (is_index) writeSidx(seg);
+    seg.is_complete = true;
+    if (toMs(seg.duration) > target_ms) {
+      LOGW("SegmenterMP4: segment %u exceeds the target duration",
+           (unsigned)seg.seq);
+    }
+    LOGI("SegmenterMP4: segment %u with %u bytes and %u ms",
+         (unsigned)seg.seq, (unsigned)seg.fileSize(),
+         (unsigned)toMs(seg.duration));
+    p_current = nullptr;
+    storeSegment(seg);
+    removeOldSegments();
+  }
+
+  /// Moves the data to the SegmentStore
+  void storeSegment(Segment& seg) {
+    if (p_store == nullptr) return;
+    char name[32];
+    if (!p_store->open(segmentName(name, sizeof(name), seg.seq))) {
+      LOGE("SegmenterMP4: could not store %s", name);
+      return;
+    }
+    p_store->write(seg.sidx.data(), seg.sidx.size());
+    p_store->write(seg.data.data(), seg.size);
+    p_store->close();
+    seg.is_stored = true;
+    seg.data.reset();
+  }
+
+  void removeOldSegments() {
+    if (window_size <= 0) return;
+    while (segmentCount() > window_size) {
+      Segment* seg = segments[0];
+      if (seg->is_stored) {
+        char name[32];
+        p_store->remove(segmentName(name, sizeof(name), seg->seq));
+      }
+      delete seg;
+      segments.erase(0);
+    }
+  }
+
+  size_t readSegment(Segment& seg, size_t pos, uint8_t* data, size_t len) {
+    if (pos >= seg.fileSize()) return 0;
+    len = min(len, seg.fileSize() - pos);
+    if (seg.is_stored) {
+      char name[32];
+      return p_store->read(segmentName(name, sizeof(name), seg.seq), pos, data,
+                           len);
+    }
+    size_t result = 0;
+    if (pos < (size_t)seg.sidx.size()) {
+      result = min(len, seg.sidx.size() - pos);
+      memcpy(data, seg.sidx.data() + pos, result);
+      pos = 0;
+    } else {
+      pos -= seg.sidx.size();
+    }
+    memcpy(data + result, seg.data.data() + pos, len - result);
+    return len;
+  }
+
+  // ---- index ----
+
+  /// Segment index with one reference per fragment of the reference track
+  void writeSidx(Segment& seg) {
+    MP4BoxWriter b;
+    size_t pos = b.beginBox("sidx");
+    b.u32(0);  // version + flags
+    b.u32(ref_track_id);
+    b.u32(ref_timescale);
+    b.u32(seg.fragments.empty() ? 0 : (uint32_t)seg.fragments[0].time);
+    b.u32(0);  // first_offset: the fragments follow directly
+    b.u16(0);  // reserved
+    b.u16(seg.fragments.size());
+    for (int j = 0; j < seg.fragments.size(); j++) {
+      Fragment& f = seg.fragments[j];
+      size_t end = j + 1 < seg.fragments.size() ? seg.fragments[j + 1].offset
+                                                : seg.size;
+      b.u32((uint32_t)(end - f.offset) & 0x7FFFFFFF);  // reference_type 0
+      b.u32(f.duration);
+      // starts_with_SAP, SAP_type 1
+      b.u32(f.is_key ? 0x90000000 : 0);
+    }
+    b.endBox(pos);
+    seg.sidx.resize(b.size());
+    memcpy(seg.sidx.data(), b.data(), b.size());
+  }
+
+  /// Random access index for the key frames of the VOD file
+  void writeMfra() {
+    MP4BoxWriter b;
+    size_t pos = b.beginBox("mfra");
+    size_t tfra_pos = b.beginBox("tfra");
+    b.u32(0x01000000);  // version 1
+    b.u32(ref_track_id);
+    b.u32(0);  // 1 byte traf, trun and sample numbers
+    size_t count_pos = b.size();
+    b.u32(0);
+    uint32_t count = 0;
+    uint64_t offset = init.size();
+    for (auto seg : segments) {
+      for (auto& f : seg->fragments) {
+        if (!f.is_key) continue;
+        uint64_t moof_offset = offset + seg->sidx.size() + f.moof_offset;
+        b.u32((uint32_t)(f.time >> 32));
+        b.u32((uint32_t)f.time);
+        b.u32((uint32_t)(moof_offset >> 32));
+        b.u32((uint32_t)moof_offset);
+        b.u8(1);
+        b.u8(1);
+        b.u8(1);
+        count++;
+      }
+      offset += seg->fileSize();
+    }
+    for (int j = 0; j < 4; j++) {
+      b.buffer[count_pos + j] = (uint8_t)(count >> (24 - 8 * j));
+    }
+    b.endBox(tfra_pos);
+    size_t mfro_pos = b.beginBox("mfro");
+    b.u32(0);
+    b.u32(b.size() - pos + 4);  // size of mfra
+    b.endBox(mfro_pos);
+    b.endBox(pos);
+    mfra.resize(b.size());
+    memcpy(mfra.data(), b.data(), b.size());
+  }
+
+  /// All segments are available as one file
+  bool isVOD() { return is_ended && window_size == 0 && is_init_complete; }
+
+  size_t vodSize() {
+    size_t result = init.size() + mfra.size();
+    for (auto seg : segments) result += seg->fileSize();
+    return result;
+  }
+
+  size_t readVOD(size_t pos, uint8_t* data, size_t len) {
+    size_t result = 0;
+    size_t start = 0;
+    // init segment
+    if (pos < (size_t)init.size()) {
+      size_t n = min(len, init.size() - pos);
+      memcpy(data, init.data() + pos, n);
+      result += n;
+    }
+    start += init.size();
+    // segments
+    for (auto seg : segments) {
+      size_t end = start + seg->fileSize();
+      if (result < len && pos + result < end) {
+        result += readSegment(*seg, pos + result - start, data + result,
+                              min(len - result, end - pos - result));
+      }
+      start = end;
+    }
+    // index
+    if (result < len && pos + result >= start) {
+      size_t offset = pos + result - start;
+      if (offset < (size_t)mfra.size()) {
+        size_t n = min(len - result, mfra.size() - offset);
+        memcpy(data + result, mfra.data() + offset, n);
+        result += n;
+      }
+    }
+    return result;
+  }
+};
+
+}  // namespace audio_tools
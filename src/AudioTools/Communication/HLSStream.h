@@ -24,9 +24,45 @@ namespace audio_tools_hls {
  */
 
 
+/**
+ * @brief Download statistics of the URLLoaderHLS
+ * @author Phil Schatzmann
+ * @copyright GPLv3
+ */
+struct HLSDownloadStatistics {
+  /// number of completely downloaded segments
+  uint32_t segments = 0;
+  /// number of failed segment requests
+  uint32_t failed = 0;
+  /// total downloaded bytes
+  uint64_t bytes = 0;
+  /// time spent for the completed segments (request until last byte) in ms
+  uint32_t download_ms = 0;
+  /// download time of the last completed segment in ms
+  uint32_t last_segment_ms = 0;
+  /// download rate of the last completed segment in bytes per second
+  float last_bytes_per_second = 0.0f;
+  /// average download rate in bytes per second
+  float bytes_per_second = 0.0f;
+  /// number of requests which needed a new connection
+  uint32_t connects = 0;
+  /// number of requests which reused a kept alive connection
+  uint32_t reused_connections = 0;
+  /// number of reads which found no data for the playing segment
+  uint32_t underflows = 0;
+};
+
 /**
  * @brief We feed the URLLoaderHLS with some url strings. The data of the
  * related segments are provided via the readBytes() method.
+ *
+ * While the current segment is playing, the following segments are
+ * requested in advance (see setPrefetchCount()): each download has its own
+ * URLStream and a bounded buffer, so the request latency of the next segment
+ * is hidden behind the playback of the current one. The reading is
+ * interleaved between the open downloads: a download pauses when its buffer
+ * is full and continues when the data has been consumed. When a download has
+ * been completed, its connection is kept alive for the next segment.
  * @author Phil Schatzmann
  * @copyright GPLv3
  */
@@ -40,16 +76,37 @@ class URLLoaderHLS {
 
   bool begin() {
     TRACED();
-    buffer.resize(buffer_size * buffer_count);
-
+    // the pool: playing segment + prefetched segments
+    int count = prefetch_count + 1;
+    for (int j = downloads.size(); j < count; j++) {
+      Download *p_download = new Download();
+      if (p_download == nullptr) return false;
+      downloads.push_back(p_download);
+    }
+    for (auto p_download : downloads) {
+      p_download->buffer.resize(buffer_size * buffer_count);
+      if (ca_cert != nullptr) p_download->stream.setCACert(ca_cert);
+    }
+    copy_buffer.resize(DEFAULT_BUFFER_SIZE);
+    head = 0;
+    used = 0;
     active = true;
     return true;
   }
 
   void end() {
     TRACED();
-    url_stream.end();
-    buffer.clear();
+    for (auto p_download : downloads) {
+      p_download->stream.end();
+      releaseUrl(*p_download);
+      delete p_download;
+    }
+    downloads.clear();
+    for (auto url : urls) delete[] url;
+    urls.clear();
+    copy_buffer.resize(0);
+    head = 0;
+    used = 0;
     active = false;
   }
 
@@ -62,17 +119,20 @@ class URLLoaderHLS {
     urls.push_back((const char *)str);
   }
 
-  /// Provides the number of open urls which can be played. Refills them, when
-  /// min limit is reached.
-  int urlCount() { return urls.size(); }
+  /// Provides the number of open urls which can be played: this includes
+  /// the prefetched segments
+  int urlCount() {
+    int prefetched = used > 0 ? used - 1 : 0;
+    return urls.size() + prefetched;
+  }
 
   /// Available bytes of the audio stream
   int available() {
     if (!active) return 0;
     TRACED();
     bufferRefill();
-
-    return buffer.available();
+    if (used == 0) return 0;
+    return current().buffer.available();
   }
 
   /// Provides data from the audio stream
@@ -81,97 +141,215 @@ class URLLoaderHLS {
     TRACED();
     bufferRefill();
 
-    if (buffer.available() < len) LOGW("Buffer underflow");
-    return buffer.readArray(data, len);
+    size_t result = 0;
+    while (used > 0 && result < len) {
+      Download &download = current();
+      result += download.buffer.readArray(data + result, len - result);
+      // continue with the next prefetched segment
+      if (download.is_open || !download.buffer.isEmpty()) break;
+      nextDownload();
+    }
+    if (result < len) {
+      LOGW("Buffer underflow");
+      stats.underflows++;
+    }
+    return result;
   }
 
   const char *contentType() {
-    return url_stream.httpRequest().reply().get(CONTENT_TYPE);
+    if (used == 0) return nullptr;
+    return current().stream.httpRequest().reply().get(CONTENT_TYPE);
   }
 
-  int contentLength() { return url_stream.contentLength(); }
+  int contentLength() {
+    if (used == 0) return 0;
+    return current().stream.contentLength();
+  }
 
+  /// Defines the buffer size of each segment download
   void setBufferSize(int size, int count) {
     buffer_size = size;
     buffer_count = count;
     // support call after begin()!
-    if (buffer.size() != 0) {
-      buffer.resize(buffer_size * buffer_count);
+    for (auto p_download : downloads) {
+      if (p_download->buffer.size() != 0) {
+        p_download->buffer.resize(buffer_size * buffer_count);
+      }
     }
   }
 
-  void setCACert(const char *cert) { url_stream.setCACert(cert); }
+  /// Defines the number of segments which are downloaded in advance (default
+  /// 1): call before begin()
+  void setPrefetchCount(int count) { prefetch_count = count < 0 ? 0 : count; }
+
+  /// Keep the connection open for the next segment (default true)
+  void setKeepAlive(bool flag) { is_keep_alive = flag; }
+
+  void setCACert(const char *cert) {
+    ca_cert = cert;
+    for (auto p_download : downloads) p_download->stream.setCACert(cert);
+  }
+
+  /// Provides the download statistics
+  HLSDownloadStatistics &statistics() { return stats; }
 
  protected:
+  struct Download {
+    URLStream stream;
+    RingBuffer<uint8_t> buffer{0};
+    const char *url = nullptr;
+    bool is_open = false;
+    uint32_t start_ms = 0;
+    uint32_t last_data_ms = 0;
+    size_t bytes = 0;
+  };
   Vector<const char *> urls{10};
-  RingBuffer<uint8_t> buffer{0};
+  Vector<Download *> downloads;
+  Vector<uint8_t> copy_buffer;
+  // downloads[head] is playing, followed by used-1 prefetched downloads
+  int head = 0;
+  int used = 0;
+  int prefetch_count = 1;
+  bool is_keep_alive = true;
   bool active = false;
   int buffer_size = DEFAULT_BUFFER_SIZE;
   int buffer_count = HLS_BUFFER_COUNT;
-  URLStream url_stream;
-  const char *url_to_play = nullptr;
+  const char *ca_cert = nullptr;
+  HLSDownloadStatistics stats;
+
+  Download &current() { return *downloads[head]; }
+
+  Download &downloadAt(int idx) {
+    return *downloads[(head + idx) % downloads.size()];
+  }
 
-  /// try to keep the buffer filled
+  /// try to keep the buffers filled
   void bufferRefill() {
     TRACED();
-    // we have nothing to do
-    if (urls.empty()) {
+    // start the next request: the first one or a prefetch
+    if (used < downloads.size() && !urls.empty()) {
+      startDownload(downloadAt(used));
+      used++;
+    }
+    if (used == 0) {
       LOGD("urls empty");
       delay(HLS_UNDER_OVERFLOW_WAIT_TIME);
       return;
     }
-    if (buffer.availableForWrite() == 0) {
-      LOGD("buffer full");
-      delay(HLS_UNDER_OVERFLOW_WAIT_TIME);
-      return;
+
+    // interleaved reading of all open downloads
+    int total = 0;
+    for (int j = 0; j < used; j++) {
+      total += fillBuffer(downloadAt(j));
     }
 
-    // switch current stream if we have no more data
-    if (!url_stream && !urls.empty()) {
-      LOGD("Refilling");
-      if (url_to_play != nullptr) {
-        delete url_to_play;
-      }
-      url_to_play = urls[0];
-      LOGI("playing %s", url_to_play);
-      url_stream.end();
-      url_stream.setConnectionClose(true);
-      url_stream.setTimeout(HLS_TIMEOUT);
-      url_stream.begin(url_to_play);
-      url_stream.waitForData(HLS_TIMEOUT);
-      urls.pop_front();
-      // assert(urls[0]!=url);
+    // the playing segment is done
+    if (!current().is_open && current().buffer.isEmpty()) nextDownload();
+
+    if (total == 0) delay(HLS_UNDER_OVERFLOW_WAIT_TIME);
+  }
+
+  void startDownload(Download &download) {
+    releaseUrl(download);
+    download.url = urls[0];
+    urls.pop_front();
+    download.buffer.reset();
+    download.bytes = 0;
+    download.start_ms = millis();
+    download.last_data_ms = download.start_ms;
 
-      LOGI("Playing %s of %d", url_stream.urlStr(), (int)urls.size());
+    bool reuse = download.stream.httpRequest().connected();
+    download.stream.setConnectionClose(!is_keep_alive);
+    download.stream.setTimeout(HLS_TIMEOUT);
+    download.is_open = download.stream.begin(download.url);
+    if (reuse) {
+      stats.reused_connections++;
+    } else {
+      stats.connects++;
+    }
+    if (!download.is_open) {
+      LOGE("Request failed: %s", download.url);
+      stats.failed++;
+      download.stream.end();
+      return;
     }
+    LOGI("Loading %s of %d", download.url, (int)urls.size());
+  }
 
+  /// Reads the data which is available without blocking
+  int fillBuffer(Download &download) {
     int total = 0;
-    int failed = 0;
-    int to_write = min(buffer.availableForWrite(), DEFAULT_BUFFER_SIZE);
-    // try to keep the buffer filled
-    while (to_write > 0) {
-      uint8_t tmp[to_write];
-      memset(tmp, 0, to_write);
-      int read = url_stream.readBytes(tmp, to_write);
-      total += read;
-      if (read > 0) {
-        failed = 0;
-        buffer.writeArray(tmp, read);
-        LOGD("buffer add %d -> %d:", read, buffer.available());
-
-        to_write = min(buffer.availableForWrite(), DEFAULT_BUFFER_SIZE);
-      } else {
-        delay(10);
-      }
-      // After we processed all data we close the stream to get a new url
-      if (url_stream.totalRead() == url_stream.contentLength()) {
-        LOGI("Closing stream because all bytes were processed: available: %d",
-             url_stream.available());
-        url_stream.end();
+    while (download.is_open) {
+      int to_write = download.buffer.availableForWrite();
+      if (to_write == 0) break;
+      int avail = download.stream.available();
+      if (avail <= 0) {
+        if (isComplete(download)) {
+          closeDownload(download);
+        } else if (millis() - download.last_data_ms > HLS_TIMEOUT) {
+          LOGW("Timeout: giving up on %s", download.url);
+          download.stream.end();
+          download.is_open = false;
+          stats.failed++;
+        }
         break;
       }
-      LOGD("Refilled with %d now %d available to write", total,
-           buffer.availableForWrite());
+      to_write = min(min(to_write, avail), (int)copy_buffer.size());
+      int read = download.stream.readBytes(copy_buffer.data(), to_write);
+      if (read <= 0) break;
+      download.buffer.writeArray(copy_buffer.data(), read);
+      download.bytes += read;
+      download.last_data_ms = millis();
+      total += read;
+      LOGD("buffer add %d -> %d:", read, download.buffer.available());
+      if (isComplete(download)) closeDownload(download);
+    }
+    return total;
+  }
+
+  bool isComplete(Download &download) {
+    int len = download.stream.contentLength();
+    if (len > 0) return download.stream.totalRead() >= (size_t)len;
+    // no content length: we need to wait until the connection is closed
+    return !download.stream;
+  }
+
+  void closeDownload(Download &download) {
+    uint32_t ms = millis() - download.start_ms;
+    LOGI("Segment loaded: %d bytes in %d ms", (int)download.bytes, (int)ms);
+    download.is_open = false;
+    if (!is_keep_alive || download.stream.contentLength() <= 0) {
+      download.stream.end();
+    }
+    stats.segments++;
+    stats.bytes += download.bytes;
+    stats.download_ms += ms;
+    stats.last_segment_ms = ms;
+    if (ms > 0) {
+      stats.last_bytes_per_second = 1000.0f * download.bytes / ms;
+    }
+    if (stats.download_ms > 0) {
+      stats.bytes_per_second = 1000.0f * stats.bytes / stats.download_ms;
+    }
+  }
+
+  /// The playing segment is done: continue with the next one
+  void nextDownload() {
+    if (used == 0) return;
+    Download &download = current();
+    if (download.is_open) {
+      // e.g. we give up on a segment which does not provide data
+      download.stream.end();
+      download.is_open = false;
+    }
+    head = (head + 1) % downloads.size();
+    used--;
+  }
+
+  void releaseUrl(Download &download) {
+    if (download.url != nullptr) {
+      delete[] download.url;
+      download.url = nullptr;
     }
   }
 };
@@ -307,6 +485,15 @@ class HLSParser {
     url_loader.setBufferSize(size, count);
   }
 
+  /// Defines the number of segments which are downloaded in advance
+  void setPrefetchCount(int count) { url_loader.setPrefetchCount(count); }
+
+  /// Reuse the connection for the next segment
+  void setKeepAlive(bool flag) { url_loader.setKeepAlive(flag); }
+
+  /// Provides the segment download statistics
+  HLSDownloadStatistics &statistics() { return url_loader.statistics(); }
+
   void setCACert(const char *cert) {
     url_stream.setCACert(cert);
     url_loader.setCACert(cert);
@@ -640,9 +827,11 @@ class HLSParser {
 namespace audio_tools {
 /**
  * @brief HTTP Live Streaming using HLS: The resulting .ts data is provided
- * via readBytes() that dynamically reload new Segments. Please note that
- * this reloading adds a considerable delay: So if you want to play back the
- * audio, you should buffer the content in a seaparate task.
+ * via readBytes() that dynamically reload new Segments. The next segments are
+ * requested while the current segment is playing (see setPrefetchCount()),
+ * but each new request still blocks until the reply header has been
+ * received: So if you want to play back the audio, you should buffer the
+ * content in a seaparate task.
  *
  * @author Phil Schatzmann
  * @ingroup hls
@@ -708,9 +897,21 @@ class HLSStreamT : public AbstractURLStream {
     return parser.readBytes(data, len);
   }
 
-  /// Redefines the read buffer size
+  /// Redefines the read buffer size of each segment download
   void setBufferSize(int size, int count) { parser.setBufferSize(size, count); }
 
+  /// Defines the number of segments which are downloaded in advance while
+  /// the current segment is playing (default 1): call before begin()
+  void setPrefetchCount(int count) { parser.setPrefetchCount(count); }
+
+  /// Keeps the http connection open for the next segment (default true)
+  void setKeepAlive(bool flag) { parser.setKeepAlive(flag); }
+
+  /// Provides the segment download statistics (e.g. the download rate)
+  audio_tools_hls::HLSDownloadStatistics &statistics() {
+    return parser.statistics();
+  }
+
   /// Defines the certificate
   void setCACert(const char *cert) override { parser.setCACert(cert); }
 
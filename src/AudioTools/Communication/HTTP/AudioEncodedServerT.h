@@ -158,10 +158,42 @@ class AudioEncoderServerT : public AudioServerT<Client, Server> {
   EncodedAudioOutput encoded_stream;
   AudioInfo audio_info;
   AudioEncoder *encoder = nullptr;
+  Vector<uint8_t> silence;
 
   // moved to be part of reply content to avoid timeout issues in Chrome
   void sendReplyHeader() override {}
 
+  /// Broadcast: the input is encoded only once into the shared buffer
+  bool setupBroadcast() override {
+    if (this->in == nullptr) {
+      LOGE("The broadcast mode requires an input stream");
+      return false;
+    }
+    if (!this->broadcast.begin(this->broadcast_buffer_size)) {
+      LOGE("Could not allocate %d bytes", (int)this->broadcast_buffer_size);
+      return false;
+    }
+    if (encoder) {
+      encoder->end();
+      encoder->begin();
+    }
+    encoded_stream.setOutput(&this->broadcast);
+    encoded_stream.setEncoder(encoder);
+    encoded_stream.begin();
+    // capture the stream header (e.g. WAV) by encoding a single silent frame:
+    // it is sent to each new client first
+    int frame_size = audio_info.channels * audio_info.bits_per_sample / 8;
+    if (frame_size > 0) {
+      silence.resize(frame_size);
+      memset(silence.data(), 0, frame_size);
+      this->broadcast.beginHeader();
+      encoded_stream.write(silence.data(), frame_size);
+      this->broadcast.endHeader();
+    }
+    this->copier.begin(encoded_stream, *this->in);
+    return true;
+  }
+
   void sendReplyContent() override {
     TRACED();
     // restart encoder
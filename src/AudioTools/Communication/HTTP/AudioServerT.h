@@ -33,8 +33,10 @@ class ChunkedPrint : public Print {
 
   size_t write(const uint8_t *data, size_t len) override {
     if (p_out == nullptr || len == 0) return 0;
-    p_out->print(len, HEX);
-    p_out->print("\r\n");
+    // not all Print implementations support print(size_t, HEX)
+    char size_line[12];
+    snprintf(size_line, sizeof(size_line), "%X\r\n", (unsigned)len);
+    p_out->write((const uint8_t *)size_line, strlen(size_line));
     size_t written = p_out->write(data, len);
     p_out->print("\r\n");
     return written;
@@ -51,6 +53,156 @@ class ChunkedPrint : public Print {
   Print *p_out = nullptr;
 };
 
+/**
+ * @brief Shared ring buffer for broadcasting one stream to multiple clients:
+ * the data is written only once and each client keeps its own absolute read
+ * position (cursor). The start of each write() is recorded as frame
+ * boundary (encoders write complete frames), so that clients which are
+ * lagging behind can be skipped forward to a boundary instead of blocking
+ * the producer.
+ *
+ * An optional stream header (e.g. the WAV header) which is written between
+ * beginHeader() and endHeader() is kept separately and must be sent to each
+ * new client first.
+ *
+ * @ingroup http
+ * @author Phil Schatzmann
+ * @copyright GPLv3
+ */
+class BroadcastBuffer : public Print {
+ public:
+  BroadcastBuffer() = default;
+
+  /// Allocates the ring buffer: the oldest data is overwritten when full
+  bool begin(size_t size, int maxBoundaries = 64) {
+    if (size == 0 || !buffer.resize(size)) return false;
+    boundaries.resize(maxBoundaries);
+    reset();
+    return true;
+  }
+
+  /// Releases the memory
+  void end() {
+    buffer.resize(0);
+    boundaries.resize(0);
+    header.resize(0);
+    reset();
+  }
+
+  /// Clears the data and the header
+  void reset() {
+    write_pos = 0;
+    boundary_count = 0;
+    boundary_idx = 0;
+    header.clear();
+    is_header = false;
+  }
+
+  /// All data written until endHeader() is stored as stream header
+  void beginHeader() {
+    header.clear();
+    is_header = true;
+  }
+
+  void endHeader() { is_header = false; }
+
+  size_t write(uint8_t c) override { return write(&c, 1); }
+
+  size_t write(const uint8_t *data, size_t len) override {
+    if (len == 0) return 0;
+    if (is_header) {
+      size_t old_size = header.size();
+      header.resize(old_size + len);
+      memcpy(header.data() + old_size, data, len);
+      return len;
+    }
+    size_t size = buffer.size();
+    if (size == 0) return 0;
+    addBoundary(write_pos);
+    // if we write more then the size, only the end is relevant
+    const uint8_t *src = data;
+    size_t n = len;
+    if (n > size) {
+      src += n - size;
+      n = size;
+    }
+    size_t offset = (write_pos + (len - n)) % size;
+    size_t first = min(n, size - offset);
+    memcpy(buffer.data() + offset, src, first);
+    memcpy(buffer.data(), src + first, n - first);
+    write_pos += len;
+    return len;
+  }
+
+  int availableForWrite() override { return buffer.size(); }
+
+  /// Total number of bytes that have been written
+  uint64_t writePos() { return write_pos; }
+
+  /// Start position for a new client: the most recent frame boundary
+  uint64_t startPos() {
+    if (boundary_count == 0) return write_pos;
+    return boundaryAt(boundary_count - 1);
+  }
+
+  /// Provides the data at the indicated position as one contiguous block and
+  /// returns its length. If the reader is lagging behind so that its data is
+  /// lost (or about to be overwritten) the position is moved to a frame
+  /// boundary in the 2nd half of the buffer and true is returned in skipped.
+  size_t read(uint64_t &pos, const uint8_t *&data, bool &skipped) {
+    size_t size = buffer.size();
+    skipped = false;
+    if (size == 0 || pos >= write_pos) return 0;
+    if (write_pos - pos > size - size / 4) {
+      pos = skipPos();
+      skipped = true;
+      if (pos >= write_pos) return 0;
+    }
+    size_t offset = pos % size;
+    data = buffer.data() + offset;
+    return min((size_t)(write_pos - pos), size - offset);
+  }
+
+  /// Provides the stream header
+  Vector<uint8_t> &streamHeader() { return header; }
+
+  size_t size() { return buffer.size(); }
+
+ protected:
+  Vector<uint8_t> buffer;
+  Vector<uint8_t> header;
+  Vector<uint64_t> boundaries;  // ring of frame start positions
+  int boundary_count = 0;
+  int boundary_idx = 0;  // index for next boundary
+  uint64_t write_pos = 0;
+  bool is_header = false;
+
+  void addBoundary(uint64_t pos) {
+    if (boundaries.size() == 0) return;
+    boundaries[boundary_idx] = pos;
+    boundary_idx = (boundary_idx + 1) % boundaries.size();
+    if (boundary_count < boundaries.size()) boundary_count++;
+  }
+
+  /// boundary by age: 0 is the oldest
+  uint64_t boundaryAt(int idx) {
+    int start = boundary_idx - boundary_count;
+    if (start < 0) start += boundaries.size();
+    return boundaries[(start + idx) % boundaries.size()];
+  }
+
+  /// Oldest frame boundary which is in the newer half of the buffer
+  uint64_t skipPos() {
+    uint64_t limit = write_pos - min((uint64_t)write_pos,
+                                     (uint64_t)(buffer.size() / 2));
+    for (int j = 0; j < boundary_count; j++) {
+      uint64_t pos = boundaryAt(j);
+      if (pos >= limit) return pos;
+    }
+    return write_pos;
+  }
+};
+
 /**
  * @brief A minimal, single-client HTTP server that streams audio (or any
  * other data) to a browser or media player: in -copy> client. The data is
@@ -70,6 +222,14 @@ class ChunkedPrint : public Print {
  * AudioEncoderServerT if you need the input to be encoded (e.g. to WAV or
  * MP3) before it is sent to the client.
  *
+ * With setBroadcast() the server supports multiple clients (up to
+ * setMaxClients()): the input Stream is copied (and encoded) only once into a
+ * shared BroadcastBuffer and each client is served from its own read
+ * position. Clients that can not keep up are skipped forward to a frame
+ * boundary, so they never block the producer. The requests of new clients
+ * are also processed as the data arrives: clients which do not complete
+ * their request within setRequestTimeout() ms are disconnected.
+ *
  * @tparam Client the client class e.g. WiFiClient
  * @tparam Server the server class e.g. WiFiServer
  * @ingroup http
@@ -165,6 +325,7 @@ class AudioServerT {
    */
   bool doLoop() {
     // LOGD("doLoop");
+    if (is_broadcast) return doLoopBroadcast();
     bool active = true;
 
     if (!client_obj.connected()) {
@@ -209,10 +370,37 @@ class AudioServerT {
   Client *out_ptr() { return &client_obj; }
 
   /// Checks if any client has connected
-  bool isClientConnected() { return client_obj.connected(); }
+  bool isClientConnected() {
+    if (is_broadcast) return broadcast_clients.size() > 0;
+    return client_obj.connected();
+  }
 
   /// Checks if any client has connected
-  operator bool() { return client_obj.connected(); }
+  operator bool() { return isClientConnected(); }
+
+  /// Activates the broadcast mode (multiple clients with one shared input):
+  /// the bufferSize defines the size of the shared ring buffer. Needs to be
+  /// set before calling begin().
+  void setBroadcast(bool flag, size_t bufferSize = 16 * 1024) {
+    is_broadcast = flag;
+    broadcast_buffer_size = bufferSize;
+  }
+
+  /// Determines if the broadcast mode is active
+  bool isBroadcast() { return is_broadcast; }
+
+  /// Defines the maximum number of clients in the broadcast mode (default 10)
+  void setMaxClients(int count) { max_clients = count; }
+
+  /// Max time in ms until a new client in the broadcast mode must have sent
+  /// the complete request (default 2000)
+  void setRequestTimeout(uint32_t ms) { request_timeout_ms = ms; }
+
+  /// Number of connected clients in the broadcast mode
+  int clientCount() {
+    if (is_broadcast) return broadcast_clients.size();
+    return client_obj.connected() ? 1 : 0;
+  }
 
   /// Changes the copy buffer size
   void setCopyBufferSize(int size) { copier.resize(size); }
@@ -243,6 +431,18 @@ class AudioServerT {
       endChunked();
       client_obj.stop();
     }
+    for (auto client : broadcast_clients) {
+      client->chunked_print.end();
+      client->client.stop();
+      delete client;
+    }
+    broadcast_clients.clear();
+    for (auto client : pending_clients) {
+      client->client.stop();
+      delete client;
+    }
+    pending_clients.clear();
+    broadcast.end();
     // reset the state
     callback = nullptr;
     in = nullptr;
@@ -280,6 +480,29 @@ class AudioServerT {
   bool is_chunked = true;
   ChunkedPrint chunked_print;
 
+  /// Client in the broadcast mode with its own read position
+  struct BroadcastClient {
+    Client client;
+    ChunkedPrint chunked_print;
+    uint64_t pos = 0;
+    size_t header_pos = 0;
+    // availableForWrite() is supported: 0 means the send buffer is full
+    bool is_available_for_write = false;
+  };
+  /// Client in the broadcast mode which has not completed its request yet
+  struct PendingClient {
+    Client client;
+    int line_len = 0;
+    uint32_t timeout = 0;
+  };
+  bool is_broadcast = false;
+  size_t broadcast_buffer_size = 16 * 1024;
+  int max_clients = 10;
+  uint32_t request_timeout_ms = 2000;
+  BroadcastBuffer broadcast;
+  Vector<BroadcastClient *> broadcast_clients;
+  Vector<PendingClient *> pending_clients;
+
   void setupServer(int port) {
     Server tmp(port);
     server = tmp;
@@ -292,9 +515,166 @@ class AudioServerT {
     connectWiFi();
 #endif
     server.begin();
+    if (is_broadcast) return setupBroadcast();
+    return true;
+  }
+
+  /// Starts the shared copy of the input into the broadcast buffer
+  virtual bool setupBroadcast() {
+    if (in == nullptr) {
+      LOGE("The broadcast mode requires an input stream");
+      return false;
+    }
+    if (!broadcast.begin(broadcast_buffer_size)) {
+      LOGE("Could not allocate %d bytes", (int)broadcast_buffer_size);
+      return false;
+    }
+    copier.begin(broadcast, *in);
+    return true;
+  }
+
+  /// Copies the input once and distributes it to all clients
+  bool doLoopBroadcast() {
+    acceptBroadcastClient();
+    processPendingClients();
+
+    // produce: copy the input into the shared buffer
+    if (converter_ptr == nullptr) {
+      copier.copy();
+    } else {
+      copier.copy(*converter_ptr);
+    }
+
+    // consume: each client from its own position
+    for (int j = 0; j < broadcast_clients.size(); j++) {
+      BroadcastClient *client = broadcast_clients[j];
+      if (!client->client.connected() || !sendBroadcastData(*client)) {
+        LOGI("Client disconnected");
+        client->client.stop();
+        delete client;
+        broadcast_clients.erase(j);
+        j--;
+      }
+    }
     return true;
   }
 
+  /// Sends the next available block to the client without blocking: the
+  /// size is limited by availableForWrite(). Returns false if the connection
+  /// was lost
+  bool sendBroadcastData(BroadcastClient &client) {
+    Print *p_out = &client.client;
+    if (is_chunked) p_out = &client.chunked_print;
+    size_t limit = broadcastWriteLimit(client);
+    if (limit == 0) return true;
+
+    // the stream header is sent first
+    Vector<uint8_t> &header = broadcast.streamHeader();
+    if (client.header_pos < header.size()) {
+      size_t len = min(header.size() - client.header_pos, limit);
+      size_t written = p_out->write(header.data() + client.header_pos, len);
+      client.header_pos += written;
+      return client.client.connected();
+    }
+
+    const uint8_t *data = nullptr;
+    bool skipped = false;
+    size_t len = broadcast.read(client.pos, data, skipped);
+    if (skipped) LOGI("Client too slow: skipped data");
+    if (len == 0) return true;
+    if (len > limit) len = limit;
+    size_t written = p_out->write(data, len);
+    client.pos += written;
+    return written > 0 || client.client.connected();
+  }
+
+  /// Max number of bytes which can be sent to the client without blocking.
+  /// Clients which do not support availableForWrite() (always 0) get at most
+  /// the copy buffer size to give all clients a chance.
+  size_t broadcastWriteLimit(BroadcastClient &client) {
+    int avail = client.client.availableForWrite();
+    if (avail > 0) client.is_available_for_write = true;
+    size_t limit = copier.bufferSize();
+    if (client.is_available_for_write) limit = min(limit, (size_t)avail);
+    // chunk size line and trailing CRLF
+    const size_t chunk_overhead = 12;
+    if (is_chunked) limit = limit > chunk_overhead ? limit - chunk_overhead : 0;
+    return limit;
+  }
+
+  /// Accepts a new client: its request is processed by
+  /// processPendingClients()
+  void acceptBroadcastClient() {
+    if (broadcast_clients.size() + pending_clients.size() >= max_clients)
+      return;
+#if USE_SERVER_ACCEPT
+    client_obj = server.accept();  // listen for incoming clients
+#else
+    client_obj = server.available();  // listen for incoming clients
+#endif
+    if (!client_obj) return;
+    PendingClient *pending = new PendingClient();
+    pending->client = client_obj;
+    pending->timeout = millis() + request_timeout_ms;
+    pending_clients.push_back(pending);
+  }
+
+  /// Processes the available request data of the new clients: a client with
+  /// a complete request gets the reply header and is added to the broadcast
+  /// clients
+  void processPendingClients() {
+    for (int j = 0; j < pending_clients.size(); j++) {
+      PendingClient *pending = pending_clients[j];
+      bool is_complete = false;
+      if (pending->client.connected() &&
+          readBroadcastRequest(*pending, is_complete) && !is_complete) {
+        continue;
+      }
+      pending_clients.erase(j);
+      j--;
+      if (is_complete) {
+        addBroadcastClient(pending->client);
+      } else {
+        pending->client.stop();
+      }
+      delete pending;
+    }
+  }
+
+  /// Consumes the available characters of the request up to the empty line
+  /// without blocking: returns false if the request did not complete in time
+  bool readBroadcastRequest(PendingClient &pending, bool &isComplete) {
+    while (pending.client.available() > 0) {
+      char c = pending.client.read();
+      if (c == '\r') continue;
+      if (c != '\n') {
+        pending.line_len++;
+        continue;
+      }
+      // an empty line is the end of the request
+      if (pending.line_len == 0) {
+        isComplete = true;
+        return true;
+      }
+      pending.line_len = 0;
+    }
+    if ((int32_t)(millis() - pending.timeout) < 0) return true;
+    LOGW("Request timeout");
+    return false;
+  }
+
+  /// Sends the reply header and adds the client to the broadcast clients
+  void addBroadcastClient(Client &newClient) {
+    client_obj = newClient;
+    AudioServerT<Client, Server>::sendReplyHeader();
+    BroadcastClient *client = new BroadcastClient();
+    client->client = client_obj;
+    client->chunked_print.begin(client->client);
+    client->pos = broadcast.startPos();
+    broadcast_clients.push_back(client);
+    LOGI("Number of clients: %d", broadcast_clients.size());
+  }
+
 #ifdef USE_WIFI
   void connectWiFi() {
     TRACED();
@@ -396,36 +776,45 @@ class AudioServerT {
   void processClient() {
     // LOGD("processClient");
     if (client_obj) {
-      LOGI("New Client:");
+      if (readRequest()) {
+        sendReplyHeader();
+        sendReplyContent();
 
-      std::string currentLine;
-      currentLine.reserve(128);
+        sent = 0;
+      } else {
+        client_obj.stop();
+      }
+    }
+  }
 
-      while (client_obj.connected()) {
-        if (client_obj.available()) {
-          char c = client_obj.read();
+  /// Reads the request of the new client_obj: returns true when the end of
+  /// the request (empty line) was found
+  bool readRequest() {
+    LOGI("New Client:");
 
-          if (c == '\n') {
-            LOGI("Request: %s", currentLine.c_str());
+    std::string currentLine;
+    currentLine.reserve(128);
 
-            // if the current line is blank, you got two newline characters in a
-            // row. that's the end of the client HTTP request, so send a response:
-            if (currentLine.length() == 0) {
-              sendReplyHeader();
-              sendReplyContent();
+    while (client_obj.connected()) {
+      if (client_obj.available()) {
+        char c = client_obj.read();
 
-              sent = 0;
+        if (c == '\n') {
+          LOGI("Request: %s", currentLine.c_str());
 
-              break;
-            } else {
-              currentLine = "";
-            }
-          } else if (c != '\r') {
-            currentLine += c;
+          // if the current line is blank, you got two newline characters in a
+          // row. that's the end of the client HTTP request, so send a response:
+          if (currentLine.length() == 0) {
+            return true;
+          } else {
+            currentLine = "";
           }
+        } else if (c != '\r') {
+          currentLine += c;
         }
       }
     }
+    return false;
   }
 };
 
@@ -0,0 +1,328 @@
+#pragma once
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "AudioToolsConfig.h"
+#include "AudioTools/AudioCodecs/SegmenterMP4.h"
+
+#ifdef USE_WIFI
+#  include "AudioTools/Communication/Network/Network.h"
+#endif
+#ifdef USE_ETHERNET
+#  include <Ethernet.h>
+#endif
+
+namespace audio_tools {
+
+/**
+ * @brief HTTP server which provides the HLS playlist and the segments of a
+ * SegmenterMP4 to any number of clients (e.g. browsers with hls.js or
+ * Safari): a live encoder can feed the players directly without an external
+ * packager. Each call of doLoop()/copy() accepts a new client, processes the
+ * request data which is available and sends the next block of each pending
+ * response, so no threads or blocking loops are used. Clients which do not
+ * complete their request within setRequestTimeout() ms are disconnected.
+ *
+ * Requests for a playlist with the Low-Latency HLS parameters _HLS_msn and
+ * _HLS_part and requests for a partial segment which is not complete yet are
+ * kept open until the data is available (blocking playlist reload and
+ * preload hints), but at most for setBlockingTimeout() ms.
+ *
+ * @tparam Client the client class e.g. WiFiClient
+ * @tparam Server the server class e.g. WiFiServer
+ * @ingroup http
+ * @author Phil Schatzmann
+ * @copyright GPLv3
+ */
+template <class Client, class Server>
+class HLSServerT {
+ public:
+  HLSServerT(SegmenterMP4& segmenter, int port = 80) {
+    p_segmenter = &segmenter;
+    Server tmp(port);
+    server = tmp;
+    buffer.resize(1024);
+  }
+
+  ~HLSServerT() { end(); }
+
+  /// Starts the server: the network must already be connected
+  bool begin() {
+    server.begin();
+    return true;
+  }
+
+  /// Disconnects all clients
+  void end() {
+    for (auto request : requests) {
+      request->client.stop();
+      delete request;
+    }
+    requests.clear();
+  }
+
+  /// Add this method to your loop: the same functionality like doLoop()
+  bool copy() { return doLoop(); }
+
+  /// Add this method to your loop: accepts new clients and sends the
+  /// pending replies
+  bool doLoop() {
+    acceptClient();
+    for (int j = 0; j < requests.size(); j++) {
+      Request* request = requests[j];
+      if (!processRequest(*request)) {
+        request->client.stop();
+        delete request;
+        requests.erase(j);
+        j--;
+      }
+    }
+    return true;
+  }
+
+  /// Defines the maximum number of open requests (default 10)
+  void setMaxClients(int count) { max_clients = count; }
+
+  /// Number of open requests
+  int clientCount() { return requests.size(); }
+
+  /// Max time in ms a request waits for data which is not available yet
+  /// (default 5000)
+  void setBlockingTimeout(uint32_t ms) { blocking_timeout_ms = ms; }
+
+  /// Max time in ms until a client must have sent the complete request
+  /// (default 2000)
+  void setRequestTimeout(uint32_t ms) { request_timeout_ms = ms; }
+
+  /// Number of bytes which are sent to a client in one doLoop() (default 1024)
+  void setBufferSize(int size) { buffer.resize(size); }
+
+ protected:
+  /// Collects the generated playlist
+  class PlaylistPrint : public Print {
+   public:
+    Vector<uint8_t> data;
+    size_t write(uint8_t ch) override { return write(&ch, 1); }
+    size_t write(const uint8_t* buffer, size_t len) override {
+      size_t old_size = data.size();
+      data.resize(old_size + len);
+      memcpy(data.data() + old_size, buffer, len);
+      return len;
+    }
+  };
+
+  /// Open request of a client
+  struct Request {
+    Client client;
+    char path[64] = {0};
+    long msn = -1;
+    int part = -1;
+    uint32_t timeout = 0;
+    // incremental parsing of the request
+    char line[160];
+    int line_len = 0;
+    bool is_first_line = true;
+    bool is_request_complete = false;
+    bool is_header_sent = false;
+    SegmenterMP4::Resource resource;
+    PlaylistPrint playlist;
+    size_t pos = 0;
+  };
+
+  SegmenterMP4* p_segmenter = nullptr;
+#ifdef ESP32
+  Server server;
+#else
+  Server server{80};
+#endif
+  Client client_obj;
+  Vector<Request*> requests;
+  Vector<uint8_t> buffer;
+  int max_clients = 10;
+  uint32_t blocking_timeout_ms = 5000;
+  uint32_t request_timeout_ms = 2000;
+
+  void acceptClient() {
+    if (requests.size() >= max_clients) return;
+#if USE_SERVER_ACCEPT
+    client_obj = server.accept();  // listen for incoming clients
+#else
+    client_obj = server.available();  // listen for incoming clients
+#endif
+    if (!client_obj) return;
+    Request* request = new Request();
+    request->client = client_obj;
+    request->timeout = millis() + request_timeout_ms;
+    requests.push_back(request);
+  }
+
+  /// Processes the available characters of the request: the request line
+  /// "GET /path?query HTTP/1.1" is parsed and the remaining header lines are
+  /// skipped. Returns false if the request did not complete in time.
+  bool readRequest(Request& request) {
+    while (request.client.available() > 0) {
+      char c = request.client.read();
+      if (c == '\r') continue;
+      if (c != '\n') {
+        if (request.line_len < (int)sizeof(request.line) - 1)
+          request.line[request.line_len++] = c;
+        continue;
+      }
+      request.line[request.line_len] = 0;
+      // an empty line is the end of the request
+      if (request.line_len == 0) {
+        request.is_request_complete = true;
+        request.timeout = millis() + blocking_timeout_ms;
+        return true;
+      }
+      if (request.is_first_line) {
+        LOGI("Request: %s", request.line);
+        parseRequestLine(request, request.line);
+        request.is_first_line = false;
+      }
+      request.line_len = 0;
+    }
+    if ((int32_t)(millis() - request.timeout) < 0) return true;
+    LOGW("HLSServer: request timeout");
+    return false;
+  }
+
+  void parseRequestLine(Request& request, char* line) {
+    char* path = strchr(line, ' ');
+    if (path == nullptr) return;
+    path++;
+    char* end = strchr(path, ' ');
+    if (end != nullptr) *end = 0;
+    char* query = strchr(path, '?');
+    if (query != nullptr) {
+      *query++ = 0;
+      char* msn = strstr(query, "_HLS_msn=");
+      if (msn != nullptr) request.msn = atol(msn + 9);
+      char* part = strstr(query, "_HLS_part=");
+      if (part != nullptr) request.part = atoi(part + 10);
+    }
+    strncpy(request.path, path, sizeof(request.path) - 1);
+  }
+
+  /// Sends the next block: returns false when the request is complete
+  bool processRequest(Request& request) {
+    if (!request.client.connected()) return false;
+    if (!request.is_request_complete) {
+      if (!readRequest(request)) return false;
+      if (!request.is_request_complete) return true;
+    }
+    if (!request.is_header_sent) {
+      if (!isReady(request)) {
+        if ((int32_t)(millis() - request.timeout) < 0) return true;
+        LOGW("HLSServer: timeout for %s", request.path);
+      }
+      return sendHeader(request);
+    }
+    size_t size = request.resource.type == SegmenterMP4::ResourceType::Playlist
+                      ? request.playlist.data.size()
+                      : request.resource.size;
+    if (request.pos >= size) return false;
+    size_t len = min((size_t)buffer.size(), size - request.pos);
+    const uint8_t* data = buffer.data();
+    if (request.resource.type == SegmenterMP4::ResourceType::Playlist) {
+      data = request.playlist.data.data() + request.pos;
+    } else {
+      len = p_segmenter->read(request.resource, request.pos, buffer.data(),
+                              len);
+      if (len == 0) return false;
+    }
+    size_t written = request.client.write(data, len);
+    request.pos += written;
+    return written > 0 || request.client.connected();
+  }
+
+  /// Checks if the requested data is available
+  bool isReady(Request& request) {
+    if (p_segmenter->isEnded()) return true;
+    SegmenterMP4::Resource resource;
+    bool found = p_segmenter->find(request.path, resource);
+    if (found && resource.type == SegmenterMP4::ResourceType::Playlist) {
+      // blocking playlist reload
+      return request.msn < 0 ||
+             p_segmenter->isAvailable((uint32_t)request.msn, request.part);
+    }
+    if (!found) {
+      // preload hint: the partial segment is not complete yet
+      unsigned seq = 0;
+      int part = 0;
+      const char* name = request.path[0] == '/' ? request.path + 1 : request.path;
+      if (sscanf(name, "part%u.%d", &seq, &part) == 2 &&
+          seq >= p_segmenter->firstSequence()) {
+        return p_segmenter->isAvailable(seq, part);
+      }
+    }
+    return true;
+  }
+
+  bool sendHeader(Request& request) {
+    request.is_header_sent = true;
+    Client& client = request.client;
+    if (!p_segmenter->find(request.path, request.resource)) {
+      LOGI("HLSServer: %s not found", request.path);
+      client.println("HTTP/1.1 404 Not Found");
+      client.println("Content-Length: 0");
+      client.println("Connection: close");
+      client.println();
+      return false;
+    }
+    const char* mime = "video/iso.segment";
+    size_t size = request.resource.size;
+    switch (request.resource.type) {
+      case SegmenterMP4::ResourceType::Playlist:
+        mime = "application/vnd.apple.mpegurl";
+        p_segmenter->writePlaylist(request.playlist);
+        size = request.playlist.data.size();
+        break;
+      case SegmenterMP4::ResourceType::Init:
+      case SegmenterMP4::ResourceType::VOD:
+        mime = "video/mp4";
+        break;
+      default:
+        break;
+    }
+    client.println("HTTP/1.1 200 OK");
+    client.print("Content-Type: ");
+    client.println(mime);
+    client.print("Content-Length: ");
+    client.println((unsigned long)size);
+    // the playlist changes all the time
+    if (request.resource.type == SegmenterMP4::ResourceType::Playlist) {
+      client.println("Cache-Control: no-cache");
+    }
+    // players are usually loaded from a different origin
+    client.println("Access-Control-Allow-Origin: *");
+    client.println("Connection: close");
+    client.println();
+    return size > 0;
+  }
+};
+
+#ifdef USE_WIFI
+/// @brief WiFi HLS server
+/// @ingroup http
+using HLSServerWiFi = HLSServerT<WiFiClient, WiFiServer>;
+
+/// @brief HLS server (defaults to WiFi when USE_WIFI is defined)
+/// @ingroup http
+using HLSServer = HLSServerT<WiFiClient, WiFiServer>;
+#endif
+
+#ifdef USE_ETHERNET
+/// @brief Ethernet HLS server
+/// @ingroup http
+using HLSServerEthernet = HLSServerT<EthernetClient, EthernetServer>;
+
+#ifndef USE_WIFI
+/// @brief HLS server (defaults to Ethernet when USE_WIFI is not defined)
+/// @ingroup http
+using HLSServer = HLSServerT<EthernetClient, EthernetServer>;
+#endif
+#endif
+
+}  // namespace audio_tools
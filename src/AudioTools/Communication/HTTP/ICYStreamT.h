@@ -110,17 +110,10 @@ class ICYStreamT : public AbstractURLStream {
   virtual size_t readBytes(uint8_t* data, size_t len) override {
     size_t result = 0;
     if (icy.hasMetaData()) {
-      // get data
+      // read directly into the caller's buffer
       int read = url.readBytes(data, len);
-      // remove metadata from data
-      int pos = 0;
-      for (int j = 0; j < read; j++) {
-        icy.processChar(data[j]);
-        if (icy.isData()) {
-          data[pos++] = data[j];
-        }
-      }
-      result = pos;
+      // remove the metadata blocks: the audio runs are moved in one step
+      if (read > 0) result = icy.processBlock(data, data, read);
     } else {
       // fast access if there is no metadata
       result = url.readBytes(data, len);
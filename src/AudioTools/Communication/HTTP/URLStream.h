@@ -301,12 +301,19 @@ class URLStream : public AbstractURLStream {
 
   bool preProcess(const char* urlStr, const char* acceptMime) {
     TRACED();
+    bool keep_alive = active && isReusable(urlStr);
     url_str = urlStr;
     url.setUrl(url_str.c_str());
     int result = -1;
 
-    // close it - if we have an active connection
-    if (active) end();
+    // close it - if we have an active connection which can not be reused
+    if (keep_alive) {
+      LOGI("reusing connection");
+      active = false;
+      clear();
+    } else if (active) {
+      end();
+    }
 
     // optional: login if necessary if no external client is defined
     if (client == nullptr){
@@ -336,6 +343,21 @@ class URLStream : public AbstractURLStream {
     return true;
   }
 
+  /// The connection can be kept for the next request if the last reply has
+  /// been fully consumed, both sides agreed on keep-alive and we stay on the
+  /// same server
+  bool isReusable(const char* nextUrl) {
+    if (!request.connected()) return false;
+    if (content_length <= 0 || total_read < content_length) return false;
+    StrView con_req(request.header().get(CONNECTION));
+    if (!con_req.equalsIgnoreCase(CON_KEEP_ALIVE)) return false;
+    StrView con_reply(request.reply().get(CONNECTION));
+    if (con_reply.equalsIgnoreCase(CON_CLOSE)) return false;
+    Url next(nextUrl);
+    return StrView(next.host()).equals(url.host()) &&
+           next.port() == url.port() && next.isSecure() == url.isSecure();
+  }
+
   /// Process the Http request and handle redirects
   template <typename T>
   int process(MethodID action, Url& url, const char* reqMime, T reqData,
@@ -0,0 +1,298 @@
+#pragma once
+#include <stdint.h>
+#include <string.h>
+
+#include "AudioTools/CoreAudio/AudioBasic/Collections/Vector.h"
+#include "AudioToolsConfig.h"
+
+namespace audio_tools {
+
+/// Result of RTPJitterBuffer::read()
+enum RTPJitterResult {
+  /// No packet is due yet
+  RTP_JITTER_EMPTY = 0,
+  /// The next packet in sequence was provided
+  RTP_JITTER_PACKET = 1,
+  /// The next packet in sequence is missing: it needs to be concealed
+  RTP_JITTER_LOST = 2
+};
+
+/**
+ * @brief Statistics of the RTPJitterBuffer
+ * @ingroup rtsp
+ */
+struct RTPJitterStatistics {
+  /// Packets that have been accepted
+  uint32_t received = 0;
+  /// Packets that have been provided in sequence
+  uint32_t played = 0;
+  /// Packets that arrived after their playout time and were dropped
+  uint32_t late = 0;
+  /// Packets that never arrived (and were concealed)
+  uint32_t lost = 0;
+  /// Packets that arrived out of order but still in time
+  uint32_t reordered = 0;
+  /// Packets that were received more than once
+  uint32_t duplicates = 0;
+  /// Packets dropped because the buffer was full
+  uint32_t overflows = 0;
+  /// Interarrival jitter (RFC 3550) in ms
+  float jitterMs = 0.0f;
+  /// Currently used target latency in ms
+  uint32_t targetLatencyMs = 0;
+  /// Number of buffered packets
+  int bufferedPackets = 0;
+};
+
+/**
+ * @brief Jitter buffer for RTP packets: the packets are stored by their
+ * sequence number, so that reordered packets are provided in the correct
+ * order, duplicates are removed and packets which arrive after their playout
+ * time are dropped. A packet is released once it has been buffered for the
+ * target latency. If the next packet in sequence is still missing at that
+ * time, read() reports it as lost, so that the caller can conceal the gap.
+ *
+ * If the RTP clock rate is known, the interarrival jitter is estimated as
+ * described in RFC 3550 and (in adaptive mode) the target latency is
+ * raised to 4 times the jitter, limited by the maximum latency.
+ *
+ * The jitter buffer only fixes the order and timing of the packets: clock
+ * drift between sender and receiver needs to be compensated by resampling
+ * (e.g. with the AdaptiveResamplingBuffer).
+ * @ingroup rtsp
+ * @author Phil Schatzmann
+ * @copyright GPLv3
+ */
+class RTPJitterBuffer {
+ public:
+  RTPJitterBuffer() = default;
+
+  /// Defines the number of packets that can be buffered: the value is
+  /// rounded up to a power of 2, so that the slot index stays consistent when
+  /// the 16 bit sequence number wraps around
+  bool begin(int maxPackets = 16) {
+    if (maxPackets <= 0 || maxPackets > kResyncLimit) {
+      LOGE("Invalid number of packets: %d", maxPackets);
+      return false;
+    }
+    int size = 1;
+    while (size < maxPackets) size <<= 1;
+    slots.resize(size);
+    payloads.resize(size * stride);
+    reset();
+    return true;
+  }
+
+  /// Releases the allocated memory
+  void end() {
+    slots.resize(0);
+    payloads.resize(0);
+    stride = 0;
+    reset();
+  }
+
+  /// Removes all buffered packets and restarts the sequence tracking
+  void reset() {
+    for (int j = 0; j < slots.size(); j++) slots[j].used = false;
+    count = 0;
+    is_synced = false;
+    has_transit = false;
+    jitter = 0.0f;
+  }
+
+  /// Minimum (or fixed) time in ms a packet is buffered before it is released
+  void setTargetLatencyMs(uint32_t ms) { target_ms = ms; }
+  /// Upper limit for the adaptive target latency in ms
+  void setMaxLatencyMs(uint32_t ms) { max_ms = ms; }
+  /// Adapts the target latency to the measured jitter (default true)
+  void setAdaptive(bool flag) { is_adaptive = flag; }
+  /// RTP timestamp units per second: needed for the jitter estimate
+  void setClockRate(uint32_t rate) { clock_rate = rate; }
+
+  /// Adds a received RTP packet payload: returns false if it was dropped
+  bool write(uint16_t seq, uint32_t timestamp, const uint8_t* payload,
+             size_t len, uint32_t nowMs) {
+    if (slots.size() == 0) return false;
+    updateJitter(timestamp, nowMs);
+
+    if (!is_synced) {
+      next_seq = seq;
+      highest_seq = seq;
+      is_synced = true;
+    }
+    int16_t diff = (int16_t)(uint16_t)(seq - next_seq);
+    if (diff < -kResyncLimit || diff > kResyncLimit) {
+      // sender restart or long interruption
+      LOGW("RTP sequence jump %u -> %u: resync", (unsigned)next_seq,
+           (unsigned)seq);
+      reset();
+      return write(seq, timestamp, payload, len, nowMs);
+    }
+    if (diff < 0) {
+      stats.late++;
+      return false;
+    }
+    // no space: drop the oldest entries
+    while (diff >= slots.size()) {
+      Slot& oldest = slot(next_seq);
+      if (oldest.used && oldest.seq == next_seq) {
+        oldest.used = false;
+        count--;
+        stats.overflows++;
+      } else {
+        stats.lost++;
+      }
+      next_seq++;
+      diff--;
+    }
+
+    Slot& entry = slot(seq);
+    if (entry.used) {
+      if (entry.seq == seq) {
+        stats.duplicates++;
+        return false;
+      }
+      // stale entry: replace it
+      entry.used = false;
+      count--;
+      stats.overflows++;
+    }
+    if ((int16_t)(uint16_t)(seq - highest_seq) < 0) {
+      stats.reordered++;
+    } else {
+      highest_seq = seq;
+    }
+    if (len > stride) setStride(len);
+    memcpy(&payloads[index(seq) * stride], payload, len);
+    entry.seq = seq;
+    entry.timestamp = timestamp;
+    entry.arrival_ms = nowMs;
+    entry.len = len;
+    entry.used = true;
+    count++;
+    stats.received++;
+    return true;
+  }
+
+  /// Provides the next packet payload in sequence if it is due. len is
+  /// set to the payload size (which is truncated to maxLen).
+  RTPJitterResult read(uint8_t* data, size_t maxLen, size_t& len,
+                       uint32_t nowMs) {
+    len = 0;
+    if (count == 0) return RTP_JITTER_EMPTY;
+    Slot& entry = slot(next_seq);
+    uint32_t latency = targetLatencyMs();
+    if (entry.used && entry.seq == next_seq) {
+      if (nowMs - entry.arrival_ms < latency && count < slots.size()) {
+        return RTP_JITTER_EMPTY;
+      }
+      len = entry.len < maxLen ? entry.len : maxLen;
+      memcpy(data, &payloads[index(next_seq) * stride], len);
+      entry.used = false;
+      count--;
+      next_seq++;
+      stats.played++;
+      return RTP_JITTER_PACKET;
+    }
+    // the next packet is missing: give up when a later packet is due
+    if (!isLaterPacketDue(nowMs, latency)) return RTP_JITTER_EMPTY;
+    next_seq++;
+    stats.lost++;
+    return RTP_JITTER_LOST;
+  }
+
+  /// Number of buffered packets
+  int size() { return count; }
+
+  /// Maximum number of packets
+  int capacity() { return slots.size(); }
+
+  /// Currently used target latency in ms
+  uint32_t targetLatencyMs() {
+    uint32_t result = target_ms;
+    if (is_adaptive && clock_rate > 0) {
+      uint32_t adaptive = 4.0f * jitter * 1000.0f / clock_rate;
+      if (adaptive > result) result = adaptive;
+      if (max_ms > 0 && result > max_ms) result = max_ms;
+    }
+    return result;
+  }
+
+  /// Provides the statistics
+  RTPJitterStatistics statistics() {
+    RTPJitterStatistics result = stats;
+    result.jitterMs = clock_rate > 0 ? jitter * 1000.0f / clock_rate : 0.0f;
+    result.targetLatencyMs = targetLatencyMs();
+    result.bufferedPackets = count;
+    return result;
+  }
+
+  /// Resets the statistics
+  void clearStatistics() { stats = RTPJitterStatistics(); }
+
+ protected:
+  struct Slot {
+    uint16_t seq = 0;
+    uint32_t timestamp = 0;
+    uint32_t arrival_ms = 0;
+    size_t len = 0;
+    bool used = false;
+  };
+  static constexpr int kResyncLimit = 3000;
+  Vector<Slot> slots;
+  Vector<uint8_t> payloads;
+  size_t stride = 0;
+  int count = 0;
+  uint16_t next_seq = 0;
+  uint16_t highest_seq = 0;
+  bool is_synced = false;
+  uint32_t target_ms = 40;
+  uint32_t max_ms = 200;
+  bool is_adaptive = true;
+  uint32_t clock_rate = 0;
+  // jitter estimate in timestamp units
+  float jitter = 0.0f;
+  int32_t last_transit = 0;
+  bool has_transit = false;
+  RTPJitterStatistics stats;
+
+  int index(uint16_t seq) { return seq & (slots.size() - 1); }
+  Slot& slot(uint16_t seq) { return slots[index(seq)]; }
+
+  /// Grows the payload size of all slots and keeps the buffered data
+  void setStride(size_t newStride) {
+    Vector<uint8_t> tmp;
+    tmp.resize(slots.size() * newStride);
+    for (int j = 0; j < slots.size(); j++) {
+      if (slots[j].used) {
+        memcpy(&tmp[j * newStride], &payloads[j * stride], slots[j].len);
+      }
+    }
+    payloads.swap(tmp);
+    stride = newStride;
+  }
+
+  /// RFC 3550 interarrival jitter: J += (|D| - J) / 16
+  void updateJitter(uint32_t timestamp, uint32_t nowMs) {
+    if (clock_rate == 0) return;
+    int32_t arrival = (uint64_t)nowMs * clock_rate / 1000;
+    int32_t transit = arrival - (int32_t)timestamp;
+    if (has_transit) {
+      int32_t d = transit - last_transit;
+      if (d < 0) d = -d;
+      jitter += ((float)d - jitter) / 16.0f;
+    }
+    last_transit = transit;
+    has_transit = true;
+  }
+
+  bool isLaterPacketDue(uint32_t nowMs, uint32_t latency) {
+    if (count >= slots.size()) return true;
+    for (int j = 0; j < slots.size(); j++) {
+      if (slots[j].used && nowMs - slots[j].arrival_ms >= latency) return true;
+    }
+    return false;
+  }
+};
+
+}  // namespace audio_tools
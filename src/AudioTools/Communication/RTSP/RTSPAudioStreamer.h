@@ -16,8 +16,10 @@
 #else
 #include "AudioTools/Concurrency/RTOS.h"
 #endif
+#include "AudioTools/Concurrency/LockGuard.h"
 #include "AudioTools/CoreAudio/AudioBasic/Collections/Vector.h"
 #include "AudioTools/CoreAudio/AudioTimer.h"
+#include "AudioTools/CoreAudio/Buffers.h"
 #include "IAudioSource.h"
 #include "RTSPPlatform.h"
 
@@ -38,7 +40,10 @@ namespace audio_tools {
  * @section technical Technical Details
  * - Uses RTP protocol with L16 payload format (16-bit linear PCM)
  * - Default streaming buffer size: 2048 bytes
- * - Supports multiple concurrent clients via reference counting
+ * - Supports multiple concurrent clients: each packet is encoded and
+ *   packetized once and then sent to the transport of each playing client.
+ *   TCP interleaved clients use their own send queue, so a slow client only
+ *   loses packets but does not stall the others.
  * - Automatic port allocation starting from 6970
  *
  * @note This base class does not include timer functionality
@@ -76,11 +81,6 @@ class RTSPAudioStreamerBase {
 
     m_udpRefCount = 0;
 
-    m_useTcpInterleaved = false;
-    m_RtspTcpSocket = Platform::NULL_TCP_SOCKET;
-    m_TcpRtpChannel = 0;
-    m_TcpRtcpChannel = 1;
-
     m_lastSamplesSent = 0;
   }
 
@@ -112,6 +112,7 @@ class RTSPAudioStreamerBase {
    */
   virtual ~RTSPAudioStreamerBase() {
     // mRtpBuf is automatically managed by Vector
+    for (auto &dest : m_destinations) delete dest.p_queue;
   }
 
   /**
@@ -171,6 +172,7 @@ class RTSPAudioStreamerBase {
    *
    * @param aClientIP IP address of the RTP client that will receive the stream
    * @param aClientPort Port number on the client for receiving RTP packets
+   * @param client Identifies the client (e.g. the RtspSession)
    * @return true if transport initialization succeeded, false on socket
    * creation failure
    *
@@ -179,12 +181,18 @@ class RTSPAudioStreamerBase {
    * @note Call releaseUdpTransport() when streaming to this client is complete
    * @see releaseUdpTransport(), getRtpServerPort(), getRtcpServerPort()
    */
-  bool initUdpTransport(IPAddress aClientIP, uint16_t aClientPort) {
-    m_ClientIP = aClientIP;
-    m_ClientPort = aClientPort;
-
-    m_SequenceNumber = random(65536);
-
+  bool initUdpTransport(IPAddress aClientIP, uint16_t aClientPort,
+                        void *client = nullptr) {
+    LockGuard guard(m_mutex);
+    RtpDestination *dest = addDestination(client);
+    if (dest == nullptr) return false;
+    bool was_udp = !dest->is_tcp && dest->is_setup;
+    dest->is_tcp = false;
+    dest->is_setup = true;
+    dest->ip = aClientIP;
+    dest->port = aClientPort;
+
+    if (was_udp) return true;
     if (m_udpRefCount != 0) {
       ++m_udpRefCount;
       return true;
@@ -208,10 +216,10 @@ class RTSPAudioStreamerBase {
     ++m_udpRefCount;
 
     LOGI("RTP Streamer set up with client IP %s and client Port %i",
-         m_ClientIP.toString().c_str(), m_ClientPort);
+         aClientIP.toString().c_str(), aClientPort);
 
     // If client IP is unknown (0.0.0.0), try to learn it from an inbound UDP packet
-    tryLearnClientFromUdp(true);
+    tryLearnClientFromUdp(*dest, true);
 
     return true;
   }
@@ -226,40 +234,115 @@ class RTSPAudioStreamerBase {
    * @param tcpSock Pointer to the RTSP TCP client socket
    * @param rtpChannel Interleaved channel number for RTP packets (e.g., 0)
    * @param rtcpChannel Interleaved channel number for RTCP packets (e.g., 1)
+   * @param client Identifies the client (e.g. the RtspSession)
    */
   void initTcpInterleavedTransport(typename Platform::TcpClientType *tcpSock,
-                                   int rtpChannel, int rtcpChannel) {
-    m_RtspTcpSocket = tcpSock;
-    m_TcpRtpChannel = rtpChannel;
-    m_TcpRtcpChannel = rtcpChannel;
-    m_useTcpInterleaved = true;
-    m_SequenceNumber = random(65536);
+                                   int rtpChannel, int rtcpChannel,
+                                   void *client = nullptr) {
+    LockGuard guard(m_mutex);
+    RtpDestination *dest = addDestination(client);
+    if (dest == nullptr) return;
+    if (dest->is_setup && !dest->is_tcp) releaseUdpSockets();
+    dest->is_tcp = true;
+    dest->is_setup = true;
+    dest->tcp_socket = tcpSock;
+    dest->is_available_for_write = false;
+    dest->rtp_channel = rtpChannel;
+    if (dest->p_queue == nullptr) {
+      dest->p_queue = new SingleBuffer<uint8_t>(m_tcpQueueSize);
+    }
+    resetQueue(*dest);
     LOGI("Using RTP over RTSP TCP interleaved: ch=%d/%d", rtpChannel,
          rtcpChannel);
   }
 
   /**
-   * @brief Release UDP transport resources
+   * @brief Release the transport resources of a client
    *
-   * Decrements the reference count for UDP socket usage and closes sockets
-   * when no more clients are using them. This implements proper resource
-   * management for multiple concurrent streaming sessions.
+   * Removes the client from the list of destinations, decrements the
+   * reference count for UDP socket usage and closes sockets when no more
+   * clients are using them. This implements proper resource management for
+   * multiple concurrent streaming sessions.
    *
+   * @param client Identifies the client (e.g. the RtspSession)
    * @note Only closes sockets when reference count reaches zero
    * @note Always call this method when streaming to a client is complete
    * @see initUdpTransport()
    */
-  void releaseUdpTransport(void) {
-    --m_udpRefCount;
-    if (m_udpRefCount == 0) {
-      m_RtpServerPort = 0;
-      m_RtcpServerPort = 0;
-      Platform::closeUdpSocket(m_RtpSocket);
-      Platform::closeUdpSocket(m_RtcpSocket);
+  void releaseUdpTransport(void *client = nullptr) {
+    // wait for a running TCP send: the socket is closed after this call
+    LockGuard send_guard(m_sendMutex);
+    LockGuard guard(m_mutex);
+    int idx = findDestination(client);
+    if (idx < 0) return;
+    RtpDestination &dest = m_destinations[idx];
+    if (dest.is_setup && !dest.is_tcp) releaseUdpSockets();
+    delete dest.p_queue;
+    m_destinations.erase(idx);
+  }
 
-      m_RtpSocket = Platform::NULL_UDP_SOCKET;
-      m_RtcpSocket = Platform::NULL_UDP_SOCKET;
+  /**
+   * @brief Start the streaming to a client
+   *
+   * Marks the client as playing: the audio source (and timer) is started
+   * with the first playing client, the others just join the running stream.
+   *
+   * @param client Identifies the client (e.g. the RtspSession)
+   */
+  void startClient(void *client = nullptr) {
+    bool is_first = false;
+    {
+      LockGuard guard(m_mutex);
+      RtpDestination *dest = addDestination(client);
+      if (dest == nullptr || dest->is_playing) return;
+      is_first = playingCount() == 0;
+      dest->is_playing = true;
+      resetQueue(*dest);
+    }
+    if (is_first) start();
+  }
+
+  /**
+   * @brief Stop the streaming to a client
+   *
+   * The audio source (and timer) is stopped when the last playing client
+   * stops.
+   *
+   * @param client Identifies the client (e.g. the RtspSession)
+   */
+  void stopClient(void *client = nullptr) {
+    bool is_last = false;
+    {
+      LockGuard guard(m_mutex);
+      int idx = findDestination(client);
+      if (idx < 0 || !m_destinations[idx].is_playing) return;
+      m_destinations[idx].is_playing = false;
+      is_last = playingCount() == 0;
     }
+    if (is_last) stop();
+  }
+
+  /// Number of clients which are currently receiving the stream
+  int clientCount() {
+    LockGuard guard(m_mutex);
+    return playingCount();
+  }
+
+  /// Maximum number of clients (default 4)
+  void setMaxClients(int count) { m_maxClients = count; }
+
+  int maxClients() { return m_maxClients; }
+
+  /// Defines the size of the send queue in bytes of each TCP interleaved
+  /// client: if a client can not keep up, new packets are dropped for this
+  /// client only
+  void setClientQueueSize(int bytes) { m_tcpQueueSize = bytes; }
+
+  /// Number of packets that were dropped for the indicated client
+  uint32_t droppedPackets(void *client = nullptr) {
+    LockGuard guard(m_mutex);
+    int idx = findDestination(client);
+    return idx < 0 ? 0 : m_destinations[idx].dropped;
   }
 
   /**
@@ -527,17 +610,42 @@ class RTSPAudioStreamerBase {
   uint32_t m_Timestamp;
   int m_SendIdx;
 
-  IPAddress m_ClientIP;
-  uint16_t m_ClientPort;
   uint32_t m_prevMsec;
 
   int m_udpRefCount;
 
-  // TCP interleaved transport
-  bool m_useTcpInterleaved;
-  typename Platform::TcpClientType *m_RtspTcpSocket;
-  int m_TcpRtpChannel;
-  int m_TcpRtcpChannel;
+  /// Transport of a single client
+  struct RtpDestination {
+    void *client = nullptr;
+    bool is_setup = false;
+    bool is_playing = false;
+    bool is_tcp = false;
+    // UDP transport
+    IPAddress ip;
+    uint16_t port = 0;
+    // TCP interleaved transport with send queue
+    typename Platform::TcpClientType *tcp_socket = nullptr;
+    int rtp_channel = 0;
+    SingleBuffer<uint8_t> *p_queue = nullptr;
+    uint32_t dropped = 0;
+    /// incremented with each reset of the queue
+    uint32_t queue_generation = 0;
+    /// availableForWrite() is supported: 0 means the send buffer is full
+    bool is_available_for_write = false;
+  };
+  audio_tools::Vector<RtpDestination> m_destinations;
+  int m_maxClients = 4;
+  int m_tcpQueueSize = 1024 * 8;
+#ifdef __linux__
+  StdMutex m_mutex;
+  StdMutex m_sendMutex;
+#else
+  Mutex m_mutex;
+  Mutex m_sendMutex;
+#endif
+  // TCP clients with queued data and the data which is currently sent
+  audio_tools::Vector<void *> m_tcpClients;
+  audio_tools::Vector<uint8_t> m_tcpSendBuf;
 
   int m_payloadType = 96;
   int m_lastSamplesSent = 0;
@@ -591,37 +699,163 @@ class RTSPAudioStreamerBase {
     mRtpBuf[11] = (uint8_t)(m_Ssrc & 0xFF);
   }
 
+  /// Sends the packet in mRtpBuf to all playing clients: TCP clients are
+  /// served after the lock was released, so that a blocking send does not
+  /// stall the session handling
   inline void sendOut(uint16_t totalLen) {
-    if (m_useTcpInterleaved && m_RtspTcpSocket != Platform::NULL_TCP_SOCKET) {
-      LOGD("Sending TCP: %d", totalLen);
-      uint8_t hdr[4];
-      hdr[0] = 0x24;  // '$'
-      hdr[1] = (uint8_t)m_TcpRtpChannel;
-      hdr[2] = (uint8_t)((totalLen >> 8) & 0xFF);
-      hdr[3] = (uint8_t)(totalLen & 0xFF);
-      Platform::sendSocket(m_RtspTcpSocket, hdr, sizeof(hdr));
-      Platform::sendSocket(m_RtspTcpSocket, mRtpBuf.data(), totalLen);
-    } else {
-      // If client IP is still unknown, attempt to learn it just-in-time
-      tryLearnClientFromUdp(false);
-      LOGI("Sending UDP: %d bytes (to %s:%d)", totalLen,
-           m_ClientIP.toString().c_str(), m_ClientPort);
-      Platform::sendUdpSocket(m_RtpSocket, mRtpBuf.data(), totalLen, m_ClientIP,
-                              m_ClientPort);
+    LockGuard send_guard(m_sendMutex);
+    {
+      LockGuard guard(m_mutex);
+      sendOutLocked(totalLen);
+    }
+    for (auto client : m_tcpClients) flushTcp(client);
+  }
+
+  inline void sendOutLocked(uint16_t totalLen) {
+    m_tcpClients.clear();
+    for (auto &dest : m_destinations) {
+      if (!dest.is_playing || !dest.is_setup) continue;
+      if (dest.is_tcp) {
+        if (dest.tcp_socket == Platform::NULL_TCP_SOCKET) continue;
+        enqueueTcp(dest, totalLen);
+        m_tcpClients.push_back(dest.client);
+      } else {
+        // If client IP is still unknown, attempt to learn it just-in-time
+        tryLearnClientFromUdp(dest, false);
+        LOGD("Sending UDP: %d bytes (to %s:%d)", totalLen,
+             dest.ip.toString().c_str(), dest.port);
+        Platform::sendUdpSocket(m_RtpSocket, mRtpBuf.data(), totalLen,
+                                dest.ip, dest.port);
+      }
+    }
+  }
+
+  /// Adds the packet with the interleaved frame header to the send queue
+  inline void enqueueTcp(RtpDestination &dest, uint16_t totalLen) {
+    SingleBuffer<uint8_t> &queue = *dest.p_queue;
+    if (queue.availableForWrite() < totalLen + 4) {
+      // client can not keep up: drop the packet for this client only
+      if (dest.dropped++ % 100 == 0) {
+        LOGW("Client queue full: %u packets dropped",
+             (unsigned)dest.dropped);
+      }
+      return;
+    }
+    uint8_t hdr[4];
+    hdr[0] = 0x24;  // '$'
+    hdr[1] = (uint8_t)dest.rtp_channel;
+    hdr[2] = (uint8_t)((totalLen >> 8) & 0xFF);
+    hdr[3] = (uint8_t)(totalLen & 0xFF);
+    queue.writeArray(hdr, sizeof(hdr));
+    queue.writeArray(mRtpBuf.data(), totalLen);
+  }
+
+  /// Sends the queued data of a client without holding m_mutex: the size is
+  /// limited by availableForWrite(), so that a client with a full TCP window
+  /// does not stall the others. The part which was not sent stays in the
+  /// queue.
+  inline void flushTcp(void *client) {
+    typename Platform::TcpClientType *socket = Platform::NULL_TCP_SOCKET;
+    uint32_t generation = 0;
+    int len = 0;
+    {
+      LockGuard guard(m_mutex);
+      int idx = findDestination(client);
+      if (idx < 0) return;
+      RtpDestination &dest = m_destinations[idx];
+      if (!dest.is_tcp || dest.p_queue == nullptr) return;
+      len = min(dest.p_queue->available(), tcpWriteLimit(dest));
+      if (len == 0) return;
+      if (m_tcpSendBuf.size() < len) m_tcpSendBuf.resize(len);
+      memcpy(m_tcpSendBuf.data(), dest.p_queue->data(), len);
+      socket = dest.tcp_socket;
+      generation = dest.queue_generation;
+    }
+    LOGD("Sending TCP: %d", len);
+    int sent = Platform::sendSocket(socket, m_tcpSendBuf.data(), len);
+    if (sent <= 0) return;
+    LockGuard guard(m_mutex);
+    int idx = findDestination(client);
+    // the queue might have been reset in the meantime
+    if (idx < 0 || m_destinations[idx].queue_generation != generation) return;
+    m_destinations[idx].p_queue->clearArray(sent);
+  }
+
+  /// Max number of bytes which can be sent to the client without blocking.
+  /// Clients which do not support availableForWrite() (always 0) get at most
+  /// one packet per call to give all clients a chance.
+  int tcpWriteLimit(RtpDestination &dest) {
+    int avail = Platform::availableForWrite(dest.tcp_socket);
+    if (avail > 0) dest.is_available_for_write = true;
+    if (dest.is_available_for_write) return avail;
+    return mRtpBuf.size() + 4;
+  }
+
+  void resetQueue(RtpDestination &dest) {
+    if (dest.p_queue == nullptr) return;
+    dest.p_queue->reset();
+    dest.queue_generation++;
+  }
+
+  /// Number of playing clients
+  int playingCount() {
+    int result = 0;
+    for (auto &dest : m_destinations) {
+      if (dest.is_playing) result++;
+    }
+    return result;
+  }
+
+  int findDestination(void *client) {
+    for (int j = 0; j < m_destinations.size(); j++) {
+      if (m_destinations[j].client == client) return j;
+    }
+    return -1;
+  }
+
+  /// Provides the existing destination of the client or adds a new one
+  RtpDestination *addDestination(void *client) {
+    int idx = findDestination(client);
+    if (idx >= 0) return &m_destinations[idx];
+    if (m_destinations.size() >= m_maxClients) {
+      LOGE("Too many clients: %d", m_maxClients);
+      return nullptr;
+    }
+    // start a new stream with a random sequence number
+    if (m_destinations.size() == 0) m_SequenceNumber = random(65536);
+    RtpDestination dest;
+    dest.client = client;
+    m_destinations.push_back(dest);
+    return &m_destinations[m_destinations.size() - 1];
+  }
+
+  /// Decrements the UDP socket reference count and closes the sockets when
+  /// they are not used any more
+  void releaseUdpSockets() {
+    if (m_udpRefCount <= 0) return;
+    --m_udpRefCount;
+    if (m_udpRefCount == 0) {
+      m_RtpServerPort = 0;
+      m_RtcpServerPort = 0;
+      Platform::closeUdpSocket(m_RtpSocket);
+      Platform::closeUdpSocket(m_RtcpSocket);
+
+      m_RtpSocket = Platform::NULL_UDP_SOCKET;
+      m_RtcpSocket = Platform::NULL_UDP_SOCKET;
     }
   }
 
-  inline void tryLearnClientFromUdp(bool warnIfNone) {
-    if (m_ClientIP == IPAddress(0, 0, 0, 0) && m_RtpSocket) {
+  inline void tryLearnClientFromUdp(RtpDestination &dest, bool warnIfNone) {
+    if (dest.ip == IPAddress(0, 0, 0, 0) && m_RtpSocket) {
       int avail = m_RtpSocket->parsePacket();
       if (avail > 0) {
         IPAddress learnedIp = m_RtpSocket->remoteIP();
         uint16_t learnedPort = m_RtpSocket->remotePort();
         if (learnedIp != IPAddress(0, 0, 0, 0)) {
-          m_ClientIP = learnedIp;
-          if (m_ClientPort == 0) m_ClientPort = learnedPort;
+          dest.ip = learnedIp;
+          if (dest.port == 0) dest.port = learnedPort;
           LOGI("RTP learned client via UDP: %s:%u",
-               m_ClientIP.toString().c_str(), (unsigned)m_ClientPort);
+               dest.ip.toString().c_str(), (unsigned)dest.port);
         }
       } else if (warnIfNone) {
         LOGW("Client IP unknown (0.0.0.0) and no inbound UDP yet");
@@ -16,6 +16,7 @@
 #include "AudioTools/CoreAudio/AudioBasic/Collections/Vector.h"
 #include "AudioTools/CoreAudio/Buffers.h"
 #include "AudioTools/CoreAudio/ResampleStream.h"
+#include "RTPJitterBuffer.h"
 
 namespace audio_tools {
 
@@ -29,6 +30,12 @@ namespace audio_tools {
  * into host format before writing to the configured output. For compressed
  * formats, register decoders with addDecoder().
  *
+ * The received RTP packets pass a jitter buffer (RTPJitterBuffer) which
+ * restores the sequence order, removes duplicates and conceals lost packets
+ * of PCM encodings. Use setJitterBufferLatencyMs() to trade latency against
+ * robustness or setJitterBufferActive(false) to forward the packets in
+ * arrival order.
+ *
  * Usage:
  * - Construct and set an output via setOutput()
  * - Call begin(address, port)
@@ -96,6 +103,36 @@ class RTSPClient : public AudioInfoSource, public AudioInfoSupport {
     m_resampler.setStepSize(step);
     // Always route via resampler; factor 1.0 is pass-through
   }
+  /**
+   * @brief Enable or disable the RTP jitter buffer (default: enabled).
+   * When disabled, the payloads are forwarded in arrival order.
+   */
+  void setJitterBufferActive(bool active) { m_jitterActive = active; }
+
+  /**
+   * @brief Define the latency of the jitter buffer: packets are buffered for
+   * at least minMs to restore their order. If adaptive is true, the latency
+   * is raised up to maxMs when the measured network jitter requires it.
+   */
+  void setJitterBufferLatencyMs(uint32_t minMs, uint32_t maxMs = 200,
+                                bool adaptive = true) {
+    m_jitter.setTargetLatencyMs(minMs);
+    m_jitter.setMaxLatencyMs(maxMs);
+    m_jitter.setAdaptive(adaptive);
+  }
+
+  /**
+   * @brief Define the maximum number of packets in the jitter buffer
+   * (default 16). Call before begin().
+   */
+  void setJitterBufferPackets(int packets) { m_jitterPackets = packets; }
+
+  /**
+   * @brief Statistics of the jitter buffer: late, lost, reordered and
+   * duplicate packets and the measured jitter.
+   */
+  RTPJitterStatistics jitterStatistics() { return m_jitter.statistics(); }
+
   /**
    * @brief Set idle backoff delay (ms) for zero-return cases.
    * Used in available() and copy() to avoid busy loops.
@@ -370,6 +407,7 @@ class RTSPClient : public AudioInfoSource, public AudioInfoSupport {
         m_isPlaying = false;
         // drop any buffered payload
         m_pktBuf.clear();
+        m_jitter.reset();
       }
     }
     return ok;
@@ -481,6 +519,7 @@ class RTSPClient : public AudioInfoSource, public AudioInfoSupport {
 
   // Buffers
   SingleBuffer<uint8_t> m_pktBuf{0};
+  Vector<uint8_t> m_rxBuf;
   SingleBuffer<uint8_t> m_tcpCmd{0};
   char m_hdrBuf[1024];
   char m_bodyBuf[1024];
@@ -496,6 +535,14 @@ class RTSPClient : public AudioInfoSource, public AudioInfoSupport {
   uint32_t m_connectRetryDelayMs = 500;
   uint32_t m_headerTimeoutMs = 4000;  // header read timeout
 
+  // Jitter buffer and loss concealment
+  RTPJitterBuffer m_jitter;
+  bool m_jitterActive = true;
+  int m_jitterPackets = 16;
+  Vector<uint8_t> m_lastPayload;
+  size_t m_lastPayloadLen = 0;
+  uint8_t m_lossRun = 0;
+
   // Resampling pipeline
   ResampleStream m_resampler;
   float m_resampleStep = 1.0f;
@@ -515,6 +562,11 @@ class RTSPClient : public AudioInfoSource, public AudioInfoSupport {
     m_pktBuf.clear();
     m_decoderReady = false;
     m_udp_active = false;
+    m_jitter.begin(m_jitterPackets);
+    m_jitter.setClockRate(0);
+    m_jitter.clearStatistics();
+    m_lastPayloadLen = 0;
+    m_lossRun = 0;
   }
 
   void buildUrls(const char* path) {
@@ -594,6 +646,10 @@ class RTSPClient : public AudioInfoSource, public AudioInfoSupport {
       LOGE("no UDP");
       return;
     }
+    if (m_jitterActive) {
+      serviceJitterBuffer();
+      return;
+    }
     if (m_pktBuf.available() > 0) {
       LOGI("Still have unprocessed data");
       return;  // still have data buffered
@@ -626,6 +682,83 @@ class RTSPClient : public AudioInfoSource, public AudioInfoSupport {
     m_pktBuf.clearArray(payloadOffset);
   }
 
+  // Moves all pending UDP packets into the jitter buffer and provides the
+  // next due payload (or its concealment) in m_pktBuf
+  void serviceJitterBuffer() {
+    for (int j = 0; j < m_jitter.capacity(); j++) {
+      int packetSize = m_udp.parsePacket();
+      if (packetSize <= 0) break;
+      if ((size_t)packetSize > m_rxBuf.size()) m_rxBuf.resize(packetSize);
+      int n = m_udp.read(m_rxBuf.data(), packetSize);
+      if (n <= 12) {
+        LOGE("packet too small: %d", n);
+        continue;
+      }
+      const uint8_t* data = m_rxBuf.data();
+      size_t payloadOffset = computeRtpPayloadOffset(data, (size_t)n);
+      if (payloadOffset >= (size_t)n) {
+        LOGW("no payload: %d", n);
+        continue;
+      }
+      uint16_t seq = ((uint16_t)data[2] << 8) | data[3];
+      uint32_t timestamp = ((uint32_t)data[4] << 24) |
+                           ((uint32_t)data[5] << 16) |
+                           ((uint32_t)data[6] << 8) | data[7];
+      m_jitter.write(seq, timestamp, data + payloadOffset, n - payloadOffset,
+                     millis());
+    }
+
+    if (m_pktBuf.available() > 0) return;  // still have data buffered
+    if (m_pktBuf.size() < m_rxBuf.size()) m_pktBuf.resize(m_rxBuf.size());
+    size_t len = 0;
+    switch (m_jitter.read(m_pktBuf.data(), m_pktBuf.size(), len, millis())) {
+      case RTP_JITTER_PACKET:
+        m_pktBuf.setAvailable(len);
+        m_lossRun = 0;
+        if ((size_t)m_lastPayload.size() < len) m_lastPayload.resize(len);
+        memcpy(m_lastPayload.data(), m_pktBuf.data(), len);
+        m_lastPayloadLen = len;
+        break;
+      case RTP_JITTER_LOST:
+        concealLoss();
+        break;
+      default:
+        break;
+    }
+  }
+
+  // Replaces a lost PCM packet: the last packet is repeated with a fade out
+  // and after 3 consecutive losses we output silence. Compressed formats are
+  // left to the decoder.
+  void concealLoss() {
+    const char* m = mime();
+    size_t len = m_lastPayloadLen;
+    if (m == nullptr || len == 0) return;
+    if (m_lossRun < 255) m_lossRun++;
+    LOGI("concealing lost RTP packet (%d)", m_lossRun);
+    uint8_t* out = m_pktBuf.data();
+    if (strcmp(m, "audio/L16") == 0) {
+      // network byte order: scale by 1/2, 1/4, 1/8, then silence
+      int shift = m_lossRun <= 3 ? m_lossRun : 16;
+      for (size_t j = 0; j + 1 < len; j += 2) {
+        int16_t sample = (int16_t)(((uint16_t)m_lastPayload[j] << 8) |
+                                   m_lastPayload[j + 1]);
+        sample = shift < 16 ? sample >> shift : 0;
+        out[j] = (uint16_t)sample >> 8;
+        out[j + 1] = (uint16_t)sample & 0xFF;
+      }
+    } else if (strcmp(m, "audio/L8") == 0) {
+      memset(out, 0x80, len);
+    } else if (strcmp(m, "audio/PCMU") == 0) {
+      memset(out, 0xFF, len);
+    } else if (strcmp(m, "audio/PCMA") == 0) {
+      memset(out, 0xD5, len);
+    } else {
+      return;
+    }
+    m_pktBuf.setAvailable(len);
+  }
+
   void primeUdpPath() {
     if (!m_udp_active) return;
     if (m_serverRtpPort == 0) return;
@@ -836,6 +969,7 @@ class RTSPClient : public AudioInfoSource, public AudioInfoSupport {
         }
       }
       m_payloadType = (uint8_t)pt;
+      m_jitter.setClockRate(rate > 0 ? rate : 0);
       // Fill AudioInfo only for raw PCM encodings
       if (strcasecmp(m_encoding, "L16") == 0) {
         m_info = AudioInfo(rate, (ch > 0 ? ch : (ch == 0 ? 1 : ch)), 16);
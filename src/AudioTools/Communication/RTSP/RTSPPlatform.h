@@ -125,6 +125,17 @@ class RTSPPlatform {
     return sockfd->write((uint8_t *)buf, len);
   }
 
+  /**
+   * @brief Number of bytes which can be sent over the TCP socket without
+   * blocking
+   * @param sockfd TCP socket
+   * @return Free space of the send buffer: 0 if it is full or if the client
+   * does not support availableForWrite()
+   */
+  static int availableForWrite(TcpClient* sockfd) {
+    return sockfd->availableForWrite();
+  }
+
   /**
    * @brief Send UDP packet to specified destination
    * @param sockfd UDP socket
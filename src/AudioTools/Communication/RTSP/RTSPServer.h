@@ -59,6 +59,13 @@ class RTSPServer : public RTSPServerBase<Platform> {
       LOGE("Couldn't start server thread");
       return false;
     }
+    // one session task handles all sessions: it runs as long as the server,
+    // so that accepting a client can not race with the end of the task
+    if (!sessionTask.begin([this]() { sessionThreadLoop(); })) {
+      LOGE("Couldn't start sessionThread");
+      serverTask.end();
+      return false;
+    }
     return true;
   }
 
@@ -78,18 +85,8 @@ class RTSPServer : public RTSPServerBase<Platform> {
     LOGD("Server thread listening... (numClients: %d)", this->client_count);
     int prevClientCount = this->client_count;
     this->acceptClient();
-    // If a new client was accepted, start session task
     if (this->client_count > prevClientCount) {
-      LOGI("Client connected");
-      if (!sessionTask.begin([this]() { sessionThreadLoop(); })) {
-        LOGE("Couldn't start sessionThread");
-        Platform::closeSocket(&this->client);
-        this->client_count--;
-      } else {
-        LOGI("Number of clients: %d", this->client_count);
-      }
-    } else if (this->client_count > 0) {
-      LOGD("Waiting for current session to end (numClients: %d)", this->client_count);
+      LOGI("Client connected - number of clients: %d", this->client_count);
     }
     int time = 200 - (millis() - lastCheck);
     if (time < 0) time = 0;
@@ -97,14 +94,9 @@ class RTSPServer : public RTSPServerBase<Platform> {
   }
 
   void sessionThreadLoop() {
-    LOGD("RTSP Task running");
-    while (this->rtspSession && this->rtspSession->isSessionOpen()) {
-      this->handleSession();
-      delay(30);
-    }
-    delay(500);
-    LOGI("Session cleaned up: (numClients: %d)", this->client_count);
-    sessionTask.end();
+    // handleSession() does nothing if there are no sessions
+    this->handleSession();
+    delay(this->client_count > 0 ? 10 : 100);
   }
 };
 
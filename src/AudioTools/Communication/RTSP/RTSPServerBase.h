@@ -21,6 +21,10 @@ namespace audio_tools {
  * This class contains all protocol, session, and connection logic, but no task/timer code.
  * Derived classes implement scheduling: either with tasks (RTSPServer) or manual loop (RTSPServerTaskless).
  *
+ * Multiple clients (up to setMaxClients()) can connect at the same time: each
+ * gets its own RtspSession and all playing sessions are fed by the shared
+ * RTSPAudioStreamer, so the audio is encoded and packetized only once.
+ *
  * @tparam Platform Target hardware platform (e.g., Arduino, ESP32)
  *
  * @ingroup rtsp
@@ -78,15 +82,21 @@ class RTSPServerBase {
       delete server;
       server = nullptr;
     }
-    client_count = 0;
-    if (rtspSession) {
-      delete rtspSession;
-      rtspSession = nullptr;
+    LockGuard guard(sessions_mutex);
+    for (auto& entry : sessions) {
+      delete entry.session;
     }
+    sessions.clear();
+    client_count = 0;
   }
 
   /// Get number of connected clients
   int clientCount() { return client_count; }
+  /// Defines the maximum number of concurrent clients (default 4)
+  void setMaxClients(int count) {
+    max_clients = count;
+    streamer->setMaxClients(count);
+  }
   /// Returns true if any client is connected
   operator bool() { return client_count > 0; }
   /// Set session timeout in milliseconds
@@ -98,51 +108,65 @@ class RTSPServerBase {
   typename Platform::TcpClientType client;
   RTSPAudioStreamerBase<Platform>* streamer = nullptr;
   int client_count = 0;
-  RtspSession<Platform>* rtspSession = nullptr;
+  int max_clients = 4;
+  /// Session of a connected client
+  struct SessionEntry {
+    RtspSession<Platform>* session = nullptr;
+    unsigned long lastRequestTime = 0;
+  };
+  Vector<SessionEntry> sessions;
+#ifdef __linux__
+  StdMutex sessions_mutex;
+#else
+  Mutex sessions_mutex;
+#endif
   bool (*onSessionPathCb)(const char*, void*) = nullptr;
   void* onSessionPathRef = nullptr;
   unsigned long sessionTimeoutMs = 60000; // 60 seconds
-  unsigned long lastRequestTime = 0; 
 
-  /// Accept new client if none is active
+  /// Accept new client if the maximum number of clients is not reached
   void acceptClient() {
-    if (client_count == 0 && server) {
+    if (client_count < max_clients && server) {
       auto newClient = Platform::getAvailableClient(server);
       if (newClient.connected()) {
         client = newClient;
-        client_count++;
-        // Create session
-        rtspSession = new RtspSession<Platform>(client, *streamer);
+        // Create session: it keeps its own copy of the client
+        SessionEntry entry;
+        entry.session = new RtspSession<Platform>(client, *streamer);
         if (onSessionPathCb) {
-          rtspSession->setOnSessionPath(onSessionPathCb, onSessionPathRef);
+          entry.session->setOnSessionPath(onSessionPathCb, onSessionPathRef);
         }
-        lastRequestTime = millis();
+        entry.lastRequestTime = millis();
+        LockGuard guard(sessions_mutex);
+        sessions.push_back(entry);
+        client_count++;
       }
     }
   }
 
-  /// Handle requests session if active
+  /// Handle requests of all active sessions
   void handleSession() {
-    if (client_count > 0 && rtspSession) {
-      uint32_t timeout = 30;
+    LockGuard guard(sessions_mutex);
+    for (int j = 0; j < sessions.size(); j++) {
+      SessionEntry& entry = sessions[j];
+      RtspSession<Platform>* rtspSession = entry.session;
+      uint32_t timeout = sessions.size() > 1 ? 5 : 30;
       bool gotRequest = rtspSession->handleRequests(timeout);
       if (gotRequest) {
-        lastRequestTime = millis();
+        entry.lastRequestTime = millis();
       }
       // If streaming, check for session timeout
       if (sessionTimeoutMs > 0 && rtspSession->isStreaming()) {
-        if ((millis() - lastRequestTime) > sessionTimeoutMs) {
+        if ((millis() - entry.lastRequestTime) > sessionTimeoutMs) {
           // Timeout, mark session closed
           rtspSession->closeSession();
         }
       }
-      // Clean up if session closed
+      // Clean up if session closed: the destructor closes the socket
       if (!rtspSession->isSessionOpen()) {
         delete rtspSession;
-        rtspSession = nullptr;
-        if (client.connected()) {
-          Platform::closeSocket(&client);
-        }
+        sessions.erase(j);
+        j--;
         client_count--;
       }
     }
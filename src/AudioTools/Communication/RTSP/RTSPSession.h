@@ -114,10 +114,12 @@ class RtspSession {
     LOGI("RTSP session destructor");
 
     // Ensure streaming is stopped and resources are released
-    if (m_streaming && m_Streamer) {
-      LOGI("Final cleanup: stopping streamer in destructor");
-      m_Streamer->stop();
-      m_Streamer->releaseUdpTransport();
+    if (m_Streamer) {
+      if (m_streaming) {
+        LOGI("Final cleanup: stopping streamer in destructor");
+        m_Streamer->stopClient(this);
+      }
+      m_Streamer->releaseUdpTransport(this);
       m_streaming = false;
     }
 
@@ -178,10 +180,10 @@ class RtspSession {
           m_sessionOpen = false;  // Session ended by TEARDOWN
 
           // Properly cleanup streaming on TEARDOWN command
-          if (m_streaming && m_Streamer) {
+          if (m_Streamer) {
             LOGI("Stopping streamer due to TEARDOWN");
-            m_Streamer->stop();
-            m_Streamer->releaseUdpTransport();
+            m_Streamer->stopClient(this);
+            m_Streamer->releaseUdpTransport(this);
             m_streaming = false;
           }
         }
@@ -192,10 +194,10 @@ class RtspSession {
       m_sessionOpen = false;  // Session ended by client disconnect
 
       // CRITICAL: Properly cleanup streaming when client disconnects
-      if (m_streaming && m_Streamer) {
+      if (m_Streamer) {
         LOGI("Stopping streamer due to client disconnect");
-        m_Streamer->stop();
-        m_Streamer->releaseUdpTransport();
+        m_Streamer->stopClient(this);
+        m_Streamer->releaseUdpTransport(this);
         m_streaming = false;
       }
 
@@ -721,7 +723,7 @@ class RtspSession {
       // Initialize TCP interleaved transport on same RTSP TCP socket
       int ch0 = (m_InterleavedRtp >= 0) ? m_InterleavedRtp : 0;
       int ch1 = (m_InterleavedRtcp >= 0) ? m_InterleavedRtcp : (ch0 + 1);
-      m_Streamer->initTcpInterleavedTransport(m_RtspClient, ch0, ch1);
+      m_Streamer->initTcpInterleavedTransport(m_RtspClient, ch0, ch1, this);
 
       // Reply with interleaved channels
       snprintf(m_Buf1.data(), m_Buf1.size(),
@@ -781,7 +783,8 @@ class RtspSession {
 
     sendSocket(m_RtspClient, m_Response.data(), strlen(m_Response.data()));
 
-    m_Streamer->start();
+    // join the shared stream
+    m_Streamer->startClient(this);
   }
 
   /**
@@ -790,7 +793,7 @@ class RtspSession {
    */
   void handleRtspPause() {
     if (m_streaming && m_Streamer) {
-      m_Streamer->stop();
+      m_Streamer->stopClient(this);
     }
     snprintf(m_Response.data(), m_Response.size(),
              "RTSP/1.0 200 OK\r\n"
@@ -804,7 +807,7 @@ class RtspSession {
    * Sends Response to TEARDOWN command, stops the RTP stream
    */
   void handleRtspTeardown() {
-    m_Streamer->stop();
+    m_Streamer->stopClient(this);
 
     // simulate SETUP server response
     snprintf(m_Response.data(), m_Response.size(),
@@ -840,7 +843,7 @@ class RtspSession {
          clientIP.toString().c_str(), (unsigned)clientPort,
          (unsigned)m_RtpClientPort);
 
-    m_Streamer->initUdpTransport(clientIP, m_RtpClientPort);
+    m_Streamer->initUdpTransport(clientIP, m_RtpClientPort, this);
   }
 
   typename Platform::TcpClientType*& getClient() { return m_RtspClient; }
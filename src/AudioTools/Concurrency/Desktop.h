@@ -4,3 +4,4 @@
 #include "SynchronizedQueue.h"
 #include "SynchronizedBuffer.h"
 #include "Desktop/Task.h"
+#include "Desktop/TaskPool.h"
@@ -0,0 +1,341 @@
+// Pool of worker threads which are shared by many tasks
+#pragma once
+#ifdef USE_CPP_TASK
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+
+#include "AudioTools/Concurrency/ITask.h"
+#include "AudioTools/CoreAudio/AudioBasic/Collections/Vector.h"
+
+namespace audio_tools {
+
+/**
+ * @brief Fixed number of worker threads which process submitted jobs. Each
+ * worker has its own deque which is sorted by deadline: the owner takes the
+ * most urgent job from the front and idle workers steal the least urgent job
+ * from the back of the other deques.
+ *
+ * A job which is submitted from a worker is queued on the same worker, other
+ * jobs are distributed round robin.
+ *
+ * @note Supported by all Linux platforms with C++11 support
+ * @ingroup concurrency
+ * @author Phil Schatzmann
+ * @copyright GPLv3
+ */
+class TaskPool {
+ public:
+  typedef std::chrono::steady_clock Clock;
+
+  /// @param workers number of threads: 0 uses one per core
+  TaskPool(int workers = 0) { worker_count = workers; }
+  ~TaskPool() { end(); }
+
+  /// Starts the worker threads
+  bool begin() {
+    if (is_active) return false;
+    int n = worker_count;
+    if (n <= 0) n = std::thread::hardware_concurrency();
+    if (n <= 0) n = 1;
+    // submit() needs the workers as soon as is_active is set
+    for (int j = 0; j < n; j++) {
+      workers.push_back(new Worker());
+    }
+    running_workers = n;
+    is_active = true;
+    for (int j = 0; j < n; j++) {
+      workers[j]->thread = std::thread([this, j] { workerLoop(j); });
+    }
+    return true;
+  }
+
+  /// Starts the indicated number of worker threads
+  bool begin(int workers) {
+    worker_count = workers;
+    return begin();
+  }
+
+  /// Stops all workers: jobs which have not been started are discarded
+  void end() {
+    if (!is_active) return;
+    {
+      std::lock_guard<std::mutex> lk(idle_mtx);
+      is_active = false;
+    }
+    idle_cv.notify_all();
+    for (auto w : workers) {
+      if (w->thread.joinable()) w->thread.join();
+    }
+    for (auto w : workers) delete w;
+    workers.clear();
+    {
+      std::lock_guard<std::mutex> lk(idle_mtx);
+      pending = 0;
+      unfinished = 0;
+    }
+    done_cv.notify_all();
+  }
+
+  /// Submits a job which should be started within deadlineUs microseconds (0
+  /// = no deadline)
+  bool submit(std::function<void()> job, uint32_t deadlineUs = 0) {
+    if (!is_active) return false;
+    Job entry;
+    entry.fn = job;
+    entry.deadline = deadlineUs == 0
+                         ? Clock::time_point::max()
+                         : Clock::now() + std::chrono::microseconds(deadlineUs);
+    int idx = currentWorker();
+    if (idx < 0) idx = next_worker++ % workers.size();
+    Worker &w = *workers[idx];
+    // count first, so that the counters never get negative
+    {
+      std::lock_guard<std::mutex> lk(idle_mtx);
+      pending++;
+      unfinished++;
+    }
+    {
+      std::lock_guard<std::mutex> lk(w.mtx);
+      // keep the deque sorted by deadline
+      auto it = w.jobs.end();
+      while (it != w.jobs.begin() && (it - 1)->deadline > entry.deadline) --it;
+      w.jobs.insert(it, entry);
+    }
+    idle_cv.notify_one();
+    return true;
+  }
+
+  /// Waits until all submitted jobs have been processed
+  void waitIdle() {
+    std::unique_lock<std::mutex> lk(idle_mtx);
+    done_cv.wait(lk, [this] { return unfinished == 0 || !is_active; });
+  }
+
+  /// Number of worker threads
+  int size() { return workers.size(); }
+
+  /// Number of jobs which have not been started yet
+  int pendingCount() {
+    std::lock_guard<std::mutex> lk(idle_mtx);
+    return pending;
+  }
+
+  /// Number of processed jobs
+  uint64_t executedCount() { return executed; }
+
+  /// Number of jobs which were started after their deadline
+  uint32_t missedDeadlineCount() { return missed_deadlines; }
+
+  /// Number of jobs which were taken from the deque of an other worker
+  uint32_t stolenCount() { return stolen; }
+
+  /// Returns true if the workers are running
+  bool isActive() { return is_active; }
+
+  /// Returns true if the pool is not active and all workers have stopped
+  bool isStopped() { return !is_active && running_workers == 0; }
+
+  /// Returns true if called from one of the worker threads of this pool
+  bool isWorkerThread() { return currentWorker() >= 0; }
+
+ protected:
+  struct Job {
+    std::function<void()> fn;
+    Clock::time_point deadline;
+  };
+  struct Worker {
+    std::mutex mtx;
+    std::deque<Job> jobs;
+    std::thread thread;
+  };
+  Vector<Worker *> workers;
+  int worker_count = 0;
+  std::atomic<bool> is_active{false};
+  std::atomic<int> running_workers{0};
+  std::atomic<unsigned> next_worker{0};
+  std::mutex idle_mtx;
+  std::condition_variable idle_cv;
+  std::condition_variable done_cv;
+  // protected by idle_mtx
+  int pending = 0;
+  int unfinished = 0;
+  std::atomic<uint64_t> executed{0};
+  std::atomic<uint32_t> missed_deadlines{0};
+  std::atomic<uint32_t> stolen{0};
+
+  /// Index of the worker of the calling thread in this pool or -1
+  int currentWorker() {
+    if (currentPool() != this) return -1;
+    return currentIndex();
+  }
+
+  static TaskPool *&currentPool() {
+    static thread_local TaskPool *pool = nullptr;
+    return pool;
+  }
+
+  static int &currentIndex() {
+    static thread_local int idx = -1;
+    return idx;
+  }
+
+  bool popLocal(int idx, Job &job) {
+    Worker &w = *workers[idx];
+    std::lock_guard<std::mutex> lk(w.mtx);
+    if (w.jobs.empty()) return false;
+    job = w.jobs.front();
+    w.jobs.pop_front();
+    return true;
+  }
+
+  bool steal(int idx, Job &job) {
+    int n = workers.size();
+    for (int j = 1; j < n; j++) {
+      Worker &w = *workers[(idx + j) % n];
+      std::lock_guard<std::mutex> lk(w.mtx);
+      if (w.jobs.empty()) continue;
+      job = w.jobs.back();
+      w.jobs.pop_back();
+      stolen++;
+      return true;
+    }
+    return false;
+  }
+
+  void workerLoop(int idx) {
+    currentPool() = this;
+    currentIndex() = idx;
+    while (is_active) {
+      Job job;
+      if (popLocal(idx, job) || steal(idx, job)) {
+        {
+          std::lock_guard<std::mutex> lk(idle_mtx);
+          pending--;
+        }
+        if (Clock::now() > job.deadline) missed_deadlines++;
+        job.fn();
+        executed++;
+        bool idle = false;
+        {
+          std::lock_guard<std::mutex> lk(idle_mtx);
+          idle = --unfinished == 0;
+        }
+        if (idle) done_cv.notify_all();
+        continue;
+      }
+      std::unique_lock<std::mutex> lk(idle_mtx);
+      idle_cv.wait(lk, [this] { return pending > 0 || !is_active; });
+    }
+    currentPool() = nullptr;
+    currentIndex() = -1;
+    running_workers--;
+  }
+};
+
+/**
+ * @brief ITask which is executed by the workers of a TaskPool instead of a
+ * dedicated thread: after each call of the process function the task is
+ * submitted again, so that many tasks can share a few threads. The process
+ * function should therefore only process a small block of data and return.
+ *
+ * @note Supported by all Linux platforms with C++11 support
+ * @ingroup concurrency
+ * @author Phil Schatzmann
+ * @copyright GPLv3
+ */
+class PooledTask : public ITask {
+ public:
+  PooledTask(TaskPool &pool, uint32_t deadlineUs = 0) {
+    p_pool = &pool;
+    deadline_us = deadlineUs;
+  }
+  ~PooledTask() { end(); }
+
+  /// Defines the time in which each call should be started (0 = no deadline)
+  void setDeadlineUs(uint32_t us) { deadline_us = us; }
+
+  bool begin(std::function<void()> process) override {
+    std::lock_guard<std::mutex> lk(mtx);
+    // the pool discards the queued call when it is stopped
+    if (is_scheduled && p_pool->isStopped()) is_scheduled = false;
+    if (is_scheduled) return false;
+    loop_code = process;
+    is_ended = false;
+    is_suspended = false;
+    return schedule();
+  }
+
+  /// Stops the task and waits for the running call to finish
+  void end() override {
+    {
+      std::lock_guard<std::mutex> lk(mtx);
+      is_ended = true;
+    }
+    // we can not wait for ourself
+    if (p_pool->isWorkerThread()) return;
+    while (true) {
+      {
+        std::lock_guard<std::mutex> lk(mtx);
+        if (!is_scheduled) break;
+        // the stopped pool discarded the queued call
+        if (p_pool->isStopped()) {
+          is_scheduled = false;
+          break;
+        }
+      }
+      std::this_thread::sleep_for(std::chrono::microseconds(100));
+    }
+  }
+
+  void suspend() {
+    std::lock_guard<std::mutex> lk(mtx);
+    is_suspended = true;
+  }
+
+  void resume() {
+    std::lock_guard<std::mutex> lk(mtx);
+    is_suspended = false;
+    if (!is_ended && !is_scheduled) schedule();
+  }
+
+  bool isSuspended() override { return is_suspended; }
+  bool isEnded() override { return is_ended; }
+  bool isRunning() override { return !is_suspended && !is_ended; }
+
+ protected:
+  TaskPool *p_pool = nullptr;
+  std::function<void()> loop_code;
+  uint32_t deadline_us = 0;
+  // protects the state transitions
+  std::mutex mtx;
+  bool is_scheduled = false;
+  std::atomic<bool> is_suspended{false};
+  std::atomic<bool> is_ended{true};
+
+  /// Submits the next call: mtx must be locked
+  bool schedule() {
+    is_scheduled = p_pool->submit([this] { run(); }, deadline_us);
+    return is_scheduled;
+  }
+
+  void run() {
+    if (!is_ended && !is_suspended) loop_code();
+    // the object might be deleted as soon as is_scheduled is false
+    std::lock_guard<std::mutex> lk(mtx);
+    if (is_ended || is_suspended) {
+      is_scheduled = false;
+    } else {
+      schedule();
+    }
+  }
+};
+
+}  // namespace audio_tools
+
+#endif
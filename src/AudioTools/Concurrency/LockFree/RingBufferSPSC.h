@@ -26,6 +26,9 @@ namespace audio_tools {
  *   replaces modulo and wrap-around is handled by a single bit-AND.
  * - readArray / writeArray use memcpy for bulk transfers and split them at
  *   the wrap-around point, giving at most two memcpy calls per operation.
+ * - peekReadSpan / peekWriteSpan lend the contiguous region up to the
+ *   wrap-around point, so that the data can be processed in place; the
+ *   matching commitRead / commitWrite publishes the new tail / head.
  *
  * Not suitable for MPMC (multiple producers or consumers); use
  * QueueLockFree for that.
@@ -95,6 +98,50 @@ class RingBufferSPSC : public BaseBuffer<T> {
     return (int)n;
   }
 
+  // Zero-copy read — called only by the consumer: the span ends at the
+  // wrap-around point.
+  T* peekReadSpan(int& len) override {
+    size_t h = head_.load(std::memory_order_acquire);
+    size_t t = tail_.load(std::memory_order_relaxed);
+    size_t t_idx = t & mask_;
+    size_t n = h - t;
+    if (n > capacity_ - t_idx) n = capacity_ - t_idx;
+    len = (int)n;
+    return n > 0 ? buf_ + t_idx : nullptr;
+  }
+
+  int commitRead(int len) override {
+    if (len <= 0) return 0;
+    size_t h = head_.load(std::memory_order_acquire);
+    size_t t = tail_.load(std::memory_order_relaxed);
+    size_t n = (size_t)len < h - t ? (size_t)len : h - t;
+    tail_.store(t + n, std::memory_order_release);
+    return (int)n;
+  }
+
+  int clearArray(int len) override { return commitRead(len); }
+
+  // Zero-copy write — called only by the producer.
+  T* peekWriteSpan(int& len) override {
+    size_t t = tail_.load(std::memory_order_acquire);
+    size_t h = head_.load(std::memory_order_relaxed);
+    size_t h_idx = h & mask_;
+    size_t n = capacity_ - (h - t);
+    if (n > capacity_ - h_idx) n = capacity_ - h_idx;
+    len = (int)n;
+    return n > 0 ? buf_ + h_idx : nullptr;
+  }
+
+  int commitWrite(int len) override {
+    if (len <= 0) return 0;
+    size_t t = tail_.load(std::memory_order_acquire);
+    size_t h = head_.load(std::memory_order_relaxed);
+    size_t space = capacity_ - (h - t);
+    size_t n = (size_t)len < space ? (size_t)len : space;
+    head_.store(h + n, std::memory_order_release);
+    return (int)n;
+  }
+
   // available() is called from both sides (consumer AND feedback ISR on
   // producer core), so we use acquire on both loads for a consistent
   // snapshot regardless of which core is calling.
@@ -0,0 +1,273 @@
+#pragma once
+
+#include <atomic>
+
+#include "AudioTools/Concurrency/LockFree/RingBufferSPSC.h"
+#include "AudioTools/CoreAudio/AudioStreams.h"
+
+#ifdef __linux__
+#include "AudioTools/Concurrency/Desktop.h"
+#else
+#include "AudioTools/Concurrency/RTOS.h"
+#endif
+
+#ifndef PIPELINE_TASK_STACK_SIZE
+#define PIPELINE_TASK_STACK_SIZE 8 * 1024
+#endif
+
+namespace audio_tools {
+
+/**
+ * @brief Stage which splits a Pipeline into two groups which are running
+ * concurrently: the data is handed over with a lock-free RingBufferSPSC and
+ * the components after the stage (output chain) or before the stage (input
+ * chain) are processed by a separate Task.
+ *
+ * Output chain: write() only copies the data into the queue and the task
+ * writes it to the next component. Input chain: the task reads from the
+ * previous component into the queue and readBytes() only copies the data from
+ * the queue.
+ *
+ * If the queue is full (write) or empty (readBytes) we wait up to the timeout
+ * (back-pressure); a timeout of 0 returns immediately with what was possible.
+ * In the output chain an audio info change waits until the task has written
+ * the queued data (in the old format) and pauses the task while the
+ * components after the stage are updated. In the input chain the change is
+ * forwarded directly, since it is usually reported by the task itself.
+ *
+ * @code
+ * pipeline.add(decoder);
+ * pipeline.add(task_stage);  // resampler and effects run in separate task
+ * pipeline.add(resample);
+ * pipeline.add(effects);
+ * pipeline.setOutput(i2s);
+ * @endcode
+ *
+ * @ingroup concurrency
+ * @author Phil Schatzmann
+ * @copyright GPLv3
+ */
+class PipelineTaskStage : public ModifyingStream {
+ public:
+  /// @param queueSize size of the queue in bytes (rounded up to a power of 2)
+  /// @param stackSize stack size of the task (words on FreeRTOS)
+  /// @param priority task priority
+  /// @param core core to pin the task to, or -1
+  PipelineTaskStage(int queueSize = DEFAULT_BUFFER_SIZE * 8,
+                    int stackSize = PIPELINE_TASK_STACK_SIZE, int priority = 1,
+                    int core = -1) {
+    queue_size = queueSize;
+    task_stack_size = stackSize;
+    task_priority = priority;
+    task_core = core;
+  }
+
+  ~PipelineTaskStage() { end(); }
+
+  /// Defines the output: the task writes the data to it
+  void setOutput(Print &out) override {
+    p_print = &out;
+    p_stream = nullptr;
+  }
+
+  /// Defines the input: the task reads the data from it
+  void setStream(Stream &in) override {
+    p_stream = &in;
+    p_print = nullptr;
+  }
+
+  /// Defines the queue size in bytes: call before begin()
+  void setQueueSize(int size) { queue_size = size; }
+
+  /// Max number of bytes which are processed by the task in one step
+  void setChunkSize(int size) { chunk_size = size; }
+
+  /// Max time in ms write() and readBytes() wait for the queue: 0 = no wait
+  void setTimeout(uint32_t ms) { timeout_ms = ms; }
+
+  /// Allocates the queue and starts the task
+  bool begin() override {
+    end();
+    if (p_print == nullptr && p_stream == nullptr) {
+      LOGE("No input or output defined");
+      return false;
+    }
+    if (queue.size() != (size_t)queue_size) queue.resize(queue_size);
+    // the task is stopped by end(): it is safe to reset the queue
+    queue.reset();
+    frame.resize(frameSize());
+    overflows = 0;
+    underruns = 0;
+    is_active = true;
+    task.create("PipelineTaskStage", task_stack_size, task_priority,
+                task_core);
+    return task.begin([this]() { process(); });
+  }
+
+  /// Stops the task: waits for the active processing step to complete
+  void end() override {
+    if (!is_active) return;
+    is_active = false;
+    // process() sets is_busy before it checks is_active
+    while (is_busy) delay(1);
+    task.end();
+  }
+
+  /// Forwards the audio info change: in the output chain we wait for the
+  /// queued data to be written and pause the task during the update
+  void setAudioInfo(AudioInfo newInfo) override {
+    bool is_pause = is_active && p_print != nullptr;
+    if (is_pause) {
+      while (is_active && queue.available() > 0) delay(1);
+      is_paused = true;
+      // process() sets is_busy before it checks is_paused
+      while (is_busy) delay(1);
+    }
+    ModifyingStream::setAudioInfo(newInfo);
+    frame.resize(frameSize());
+    is_paused = false;
+  }
+
+  /// Copies the data into the queue: waits if the queue is full
+  size_t write(const uint8_t *data, size_t len) override {
+    if (!is_active || p_print == nullptr) return 0;
+    size_t result = 0;
+    uint32_t end_time = millis() + timeout_ms;
+    while (result < len) {
+      result += queue.writeArray(data + result, len - result);
+      if (result == len) break;
+      if (result < len && (int32_t)(millis() - end_time) >= 0) {
+        overflows++;
+        break;
+      }
+      delay(1);
+    }
+    return result;
+  }
+
+  /// Free space in the queue
+  int availableForWrite() override {
+    return is_active ? queue.availableForWrite() : 0;
+  }
+
+  /// Copies the data from the queue: waits if the queue is empty
+  size_t readBytes(uint8_t *data, size_t len) override {
+    if (!is_active || p_stream == nullptr) return 0;
+    uint32_t end_time = millis() + timeout_ms;
+    int result = queue.readArray(data, len);
+    while (result == 0) {
+      if ((int32_t)(millis() - end_time) >= 0) {
+        underruns++;
+        break;
+      }
+      delay(1);
+      result = queue.readArray(data, len);
+    }
+    return result;
+  }
+
+  /// Bytes in the queue
+  int available() override { return is_active ? queue.available() : 0; }
+
+  /// Waits until the task has written all queued data to the output
+  void flush() override {
+    if (p_print == nullptr) return;
+    while (is_active && (queue.available() > 0 || is_busy)) delay(1);
+    p_print->flush();
+  }
+
+  /// Number of write() calls which could not queue all data
+  uint32_t overflowCount() { return overflows; }
+
+  /// Number of readBytes() calls which did not find any data
+  uint32_t underrunCount() { return underruns; }
+
+  /// Provides the task e.g. to check the state
+  Task &getTask() { return task; }
+
+ protected:
+  Print *p_print = nullptr;
+  Stream *p_stream = nullptr;
+  RingBufferSPSC<uint8_t> queue;
+  Task task;
+  Vector<uint8_t> frame;
+  std::atomic<bool> is_active{false};
+  std::atomic<bool> is_busy{false};
+  std::atomic<bool> is_paused{false};
+  int queue_size;
+  int chunk_size = DEFAULT_BUFFER_SIZE;
+  uint32_t timeout_ms = 1000;
+  int task_stack_size;
+  int task_priority;
+  int task_core;
+  uint32_t overflows = 0;
+  uint32_t underruns = 0;
+
+  int frameSize() { return info.channels * info.bits_per_sample / 8; }
+
+  /// One step of the task: moves up to chunk_size bytes
+  void process() {
+    is_busy = true;
+    size_t result = is_active && !is_paused ? processStep() : 0;
+    is_busy = false;
+    // wait outside of the busy section, so that end() does not block
+    if (result == 0) delay(1);
+  }
+
+  size_t processStep() {
+    int len = 0;
+    size_t result = 0;
+    if (p_print != nullptr) {
+      // zero copy from the queue to the output in full frames
+      uint8_t *data = queue.peekReadSpan(len);
+      if (len > chunk_size) len = chunk_size;
+      int frame_size = frameSize();
+      if (frame_size > 1) len -= len % frame_size;
+      if (len > 0) {
+        result = p_print->write(data, len);
+        // the output accepted a partial frame: complete it
+        int open = frame_size > 1 ? result % frame_size : 0;
+        if (open > 0) result += writeAll(data + result, frame_size - open);
+        queue.commitRead(result);
+      } else if (frame_size > 1 && queue.available() >= frame_size) {
+        // frame wraps around the end of the queue
+        result = writeFrame(frame_size);
+      }
+    } else if (p_stream != nullptr) {
+      // zero copy from the input to the queue
+      uint8_t *data = queue.peekWriteSpan(len);
+      if (len > chunk_size) len = chunk_size;
+      if (len > 0) result = p_stream->readBytes(data, len);
+      queue.commitWrite(result);
+    }
+    return result;
+  }
+
+  /// Writes a single frame which is split by the end of the queue
+  size_t writeFrame(int size) {
+    if ((int)frame.size() < size) frame.resize(size);
+    queue.readArray(frame.data(), size);
+    writeAll(frame.data(), size);
+    return size;
+  }
+
+  /// Writes all data to the output: gives up after the timeout
+  size_t writeAll(const uint8_t *data, int size) {
+    int pos = 0;
+    uint32_t end_time = millis() + timeout_ms;
+    while (pos < size && is_active) {
+      int written = p_print->write(data + pos, size - pos);
+      pos += written;
+      if (written == 0) {
+        if ((int32_t)(millis() - end_time) >= 0) {
+          LOGE("write timeout: %d bytes lost", size - pos);
+          break;
+        }
+        delay(1);
+      }
+    }
+    return pos;
+  }
+};
+
+}  // namespace audio_tools
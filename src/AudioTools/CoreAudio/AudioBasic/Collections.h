@@ -5,6 +5,7 @@
  * @brief Vector, List, Queue, Stack...
  */
 
+#include "AudioTools/CoreAudio/AudioBasic/Collections/AllocatorPool.h"
 #include "AudioTools/CoreAudio/AudioBasic/Collections/Vector.h"
 #include "AudioTools/CoreAudio/AudioBasic/Collections/List.h"
 #include "AudioTools/CoreAudio/AudioBasic/Collections/Stack.h"
@@ -0,0 +1,343 @@
+#pragma once
+#include <string.h>
+
+#include "AudioTools/CoreAudio/AudioBasic/Collections/Allocator.h"
+
+namespace audio_tools {
+
+/**
+ * @brief Statistics of an AllocatorPool or AllocatorArena
+ * @ingroup memorymgmt
+ */
+struct AllocatorStats {
+  /// bytes which are used by the active allocations (incl. rounding/padding)
+  size_t in_use = 0;
+  /// bytes which were requested by the active allocations
+  size_t requested = 0;
+  /// max value of in_use
+  size_t peak = 0;
+  /// bytes which were requested from the parent allocator
+  size_t reserved = 0;
+  /// number of active allocations
+  size_t allocations = 0;
+  /// number of allocations which were delegated to the parent allocator
+  size_t fallbacks = 0;
+  /// share of in_use which is not used by the requested data (0.0 - 1.0)
+  float fragmentation() {
+    return in_use == 0 ? 0.0f : 1.0f - (float)requested / in_use;
+  }
+};
+
+/**
+ * @brief Allocator with fixed size classes (powers of 2 from 16 bytes up to
+ * the indicated max block size): the blocks are taken from chunks which are
+ * requested from the parent allocator and freed blocks are kept in a free list
+ * per size class, so that they can be reused by the next allocation of the
+ * same class. Repeated allocations and releases (e.g. when a stream is started
+ * and stopped) therefore do not fragment the heap. Bigger requests are
+ * delegated to the parent allocator. The chunks are only released by clear()
+ * or the destructor. Not thread safe.
+ * Please note that Vector (and therefore the buffers) only use the allocator
+ * if USE_ALLOCATOR is true.
+ * @ingroup memorymgmt
+ * @author Phil Schatzmann
+ * @copyright GPLv3
+ */
+class AllocatorPool : public Allocator {
+ public:
+  /// @param maxBlockSize biggest size class
+  /// @param chunkSize size of the memory which is requested from the parent
+  /// @param parent allocator which provides the chunks
+  AllocatorPool(size_t maxBlockSize = 4096, size_t chunkSize = 8192,
+                Allocator &parent = DefaultAllocatorRAM) {
+    p_parent = &parent;
+    chunk_size = chunkSize;
+    class_count = 0;
+    for (size_t size = kMinBlockSize;
+         size <= maxBlockSize && class_count < kMaxClasses; size *= 2) {
+      class_count++;
+    }
+  }
+
+  ~AllocatorPool() { clear(); }
+
+  /// Preallocates count blocks for the indicated size
+  bool reserve(size_t size, int count) {
+    int cls = sizeClass(size);
+    if (cls < 0) return false;
+    for (int j = 0; j < count; j++) {
+      if (!addChunk(cls, 1)) return false;
+    }
+    return true;
+  }
+
+  /// Releases all chunks: only valid if there are no active allocations
+  void clear() {
+    if (st.allocations > 0) {
+      LOGW("AllocatorPool: clear with %d active allocations",
+           (int)st.allocations);
+    }
+    Chunk *chunk = p_chunks;
+    while (chunk != nullptr) {
+      Chunk *next = chunk->next;
+      p_parent->free(chunk);
+      chunk = next;
+    }
+    p_chunks = nullptr;
+    memset(free_list, 0, sizeof(free_list));
+    st = AllocatorStats();
+  }
+
+  /// Provides the statistics
+  AllocatorStats stats() { return st; }
+
+  /// frees memory
+  void free(void *memory) override {
+    if (memory == nullptr) return;
+    Header *header = (Header *)((uint8_t *)memory - kHeaderSize);
+    st.allocations--;
+    st.requested -= header->requested;
+    if (header->size_class == kFallback) {
+      st.in_use -= header->requested + kHeaderSize;
+      p_parent->free(header);
+      return;
+    }
+    int cls = header->size_class;
+    st.in_use -= blockSize(cls);
+    // we reuse the memory for the next pointer
+    Block *block = (Block *)header;
+    block->next = free_list[cls];
+    free_list[cls] = block;
+  }
+
+ protected:
+  static const size_t kAlign = 2 * sizeof(void *);
+  static const size_t kHeaderSize = kAlign;
+  static const size_t kMinBlockSize = 16;
+  static const int kMaxClasses = 16;
+  static const uint16_t kFallback = 0xFFFF;
+  struct Header {
+    uint16_t size_class;
+    uint32_t requested;
+  };
+  struct Block {
+    Block *next;
+  };
+  struct Chunk {
+    Chunk *next;
+  };
+  Allocator *p_parent = nullptr;
+  Block *free_list[kMaxClasses] = {nullptr};
+  Chunk *p_chunks = nullptr;
+  size_t chunk_size;
+  int class_count;
+  AllocatorStats st;
+
+  /// total size of a block of the indicated class incl. header
+  size_t blockSize(int cls) { return (kMinBlockSize << cls) + kHeaderSize; }
+
+  /// Determines the size class for the requested size: -1 if too big
+  int sizeClass(size_t size) {
+    for (int cls = 0; cls < class_count; cls++) {
+      if (size <= (kMinBlockSize << cls)) return cls;
+    }
+    return -1;
+  }
+
+  /// Requests a new chunk from the parent and adds the blocks to the free list
+  bool addChunk(int cls, int minBlocks) {
+    size_t block_size = blockSize(cls);
+    int count = (chunk_size - kAlign) / block_size;
+    if (count < minBlocks) count = minBlocks;
+    size_t size = kAlign + count * block_size;
+    uint8_t *mem = (uint8_t *)p_parent->allocate(size);
+    if (mem == nullptr) return false;
+    st.reserved += size;
+    Chunk *chunk = (Chunk *)mem;
+    chunk->next = p_chunks;
+    p_chunks = chunk;
+    for (int j = 0; j < count; j++) {
+      Block *block = (Block *)(mem + kAlign + j * block_size);
+      block->next = free_list[cls];
+      free_list[cls] = block;
+    }
+    return true;
+  }
+
+  void *do_allocate(size_t size) override {
+    if (size == 0) size = 1;
+    int cls = sizeClass(size);
+    Header *header = nullptr;
+    size_t used = 0;
+    if (cls < 0) {
+      header = (Header *)p_parent->allocate(size + kHeaderSize);
+      if (header == nullptr) return nullptr;
+      header->size_class = kFallback;
+      used = size + kHeaderSize;
+      st.fallbacks++;
+    } else {
+      if (free_list[cls] == nullptr && !addChunk(cls, 1)) return nullptr;
+      Block *block = free_list[cls];
+      free_list[cls] = block->next;
+      header = (Header *)block;
+      header->size_class = cls;
+      used = blockSize(cls);
+    }
+    header->requested = size;
+    st.allocations++;
+    st.requested += size;
+    st.in_use += used;
+    if (st.in_use > st.peak) st.peak = st.in_use;
+    uint8_t *result = (uint8_t *)header + kHeaderSize;
+    memset(result, 0, size);
+    return result;
+  }
+};
+
+/**
+ * @brief Bump allocator: the memory is taken sequentially from a single
+ * buffer, so an allocation is just a pointer increment. Freed memory is only
+ * recovered if it was the last allocation or when all allocations have been
+ * released; reset() rewinds the arena when no arena allocation is active. If
+ * the buffer is full we delegate to the parent allocator (see setFallback()).
+ * Not thread safe.
+ * @ingroup memorymgmt
+ * @author Phil Schatzmann
+ * @copyright GPLv3
+ */
+class AllocatorArena : public Allocator {
+ public:
+  /// Arena of the indicated size, which is requested from the parent on the
+  /// first allocation
+  AllocatorArena(size_t size, Allocator &parent = DefaultAllocatorRAM) {
+    p_parent = &parent;
+    arena_size = size;
+  }
+
+  /// Arena which uses the provided memory
+  AllocatorArena(uint8_t *buffer, size_t size,
+                 Allocator &parent = DefaultAllocatorRAM) {
+    p_parent = &parent;
+    p_buffer = alignUp(buffer);
+    arena_size = size - (p_buffer - buffer);
+    is_external = true;
+  }
+
+  ~AllocatorArena() {
+    if (!is_external && p_buffer != nullptr) p_parent->free(p_buffer);
+  }
+
+  /// Activates/deactivates the use of the parent allocator if the arena is
+  /// full (default true)
+  void setFallback(bool flag) { is_fallback = flag; }
+
+  /// Releases all allocations of the arena in one step. This is refused while
+  /// arena allocations are active, because their owners (e.g. a Vector) still
+  /// call free() later, which would corrupt the arena after the reset.
+  bool reset() {
+    if (st.allocations > st.fallbacks_active) {
+      LOGE("AllocatorArena: reset with %d active allocations",
+           (int)(st.allocations - st.fallbacks_active));
+      return false;
+    }
+    pos = 0;
+    last_pos = 0;
+    st.allocations = st.fallbacks_active;
+    st.requested = st.fallback_requested;
+    st.in_use = st.fallback_requested;
+    return true;
+  }
+
+  /// Provides the statistics
+  AllocatorStats stats() { return st; }
+
+  /// Bytes which are still available in the arena
+  size_t available() { return arena_size - pos; }
+
+  /// frees memory
+  void free(void *memory) override {
+    if (memory == nullptr) return;
+    uint8_t *header = (uint8_t *)memory - kHeaderSize;
+    size_t requested = *(size_t *)header;
+    st.allocations--;
+    st.requested -= requested;
+    if (!isInArena(header)) {
+      st.fallbacks_active--;
+      st.fallback_requested -= requested;
+      st.in_use -= requested;
+      p_parent->free(header);
+      return;
+    }
+    // the last allocation can be undone
+    if ((size_t)(header - p_buffer) == last_pos) {
+      st.in_use -= pos - last_pos;
+      pos = last_pos;
+    }
+    // everything was released: we can start from the beginning
+    if (st.allocations == st.fallbacks_active) {
+      st.in_use -= pos;
+      pos = 0;
+      last_pos = 0;
+    }
+  }
+
+ protected:
+  static const size_t kAlign = 2 * sizeof(void *);
+  static const size_t kHeaderSize = kAlign;
+  struct Stats : public AllocatorStats {
+    size_t fallbacks_active = 0;
+    size_t fallback_requested = 0;
+  };
+  Allocator *p_parent = nullptr;
+  uint8_t *p_buffer = nullptr;
+  size_t arena_size = 0;
+  size_t pos = 0;
+  size_t last_pos = 0;
+  bool is_external = false;
+  bool is_fallback = true;
+  Stats st;
+
+  static uint8_t *alignUp(uint8_t *ptr) {
+    uintptr_t value = (uintptr_t)ptr;
+    return (uint8_t *)((value + kAlign - 1) & ~(uintptr_t)(kAlign - 1));
+  }
+
+  bool isInArena(uint8_t *ptr) {
+    return p_buffer != nullptr && ptr >= p_buffer &&
+           ptr < p_buffer + arena_size;
+  }
+
+  void *do_allocate(size_t size) override {
+    if (size == 0) size = 1;
+    if (p_buffer == nullptr) {
+      p_buffer = (uint8_t *)p_parent->allocate(arena_size);
+      if (p_buffer == nullptr) return nullptr;
+      st.reserved = arena_size;
+    }
+    size_t total = (size + kHeaderSize + kAlign - 1) & ~(kAlign - 1);
+    uint8_t *header = nullptr;
+    if (pos + total <= arena_size) {
+      header = p_buffer + pos;
+      last_pos = pos;
+      pos += total;
+      st.in_use += total;
+    } else {
+      if (!is_fallback) return nullptr;
+      header = (uint8_t *)p_parent->allocate(size + kHeaderSize);
+      if (header == nullptr) return nullptr;
+      st.fallbacks++;
+      st.fallbacks_active++;
+      st.fallback_requested += size;
+      st.in_use += size;
+    }
+    *(size_t *)header = size;
+    st.allocations++;
+    st.requested += size;
+    if (st.in_use > st.peak) st.peak = st.in_use;
+    uint8_t *result = header + kHeaderSize;
+    memset(result, 0, size);
+    return result;
+  }
+};
+
+}  // namespace audio_tools
@@ -0,0 +1,264 @@
+#pragma once
+#include <string.h>
+
+#include "AudioTools/CoreAudio/AudioBasic/Collections/Vector.h"
+#include "AudioTools/CoreAudio/AudioBasic/SIMD.h"
+#include "AudioTools/CoreAudio/AudioBasic/SampleFormat.h"
+#include "AudioTools/CoreAudio/AudioBasic/int24_t.h"
+#include "AudioToolsConfig.h"
+
+namespace audio_tools {
+
+/**
+ * @brief Mixing gain which moves linearly to a new target value over a
+ * defined number of samples, so that weight changes do not click. While the
+ * ramp is active the gain is updated every MixRamp::kChunk samples, so that
+ * the mixing kernels can still use a constant gain per block.
+ * @ingroup simd
+ */
+struct MixRamp {
+  /// number of samples which are mixed with the same gain during a ramp
+  static const int kChunk = 16;
+  float current = 0.0f;
+  float target = 0.0f;
+  float step = 0.0f;
+  int remaining = 0;
+
+  /// Sets the gain immediately
+  void set(float value) {
+    current = target = value;
+    remaining = 0;
+  }
+
+  /// Moves to the new gain over the indicated number of samples
+  void setTarget(float value, int samples) {
+    if (samples <= 0 || value == current) {
+      set(value);
+      return;
+    }
+    target = value;
+    step = (target - current) / samples;
+    remaining = samples;
+  }
+
+  /// The input does not contribute to the result: it can be skipped
+  bool isSilent() const { return current == 0.0f && remaining == 0; }
+
+  bool isRamping() const { return remaining > 0; }
+
+  /// Current gain in Q14 fixed point (16384 = 1.0)
+  int16_t q14() const {
+    if (current >= 1.0f) return 16384;
+    if (current <= 0.0f) return 0;
+    return (int16_t)(current * 16384.0f + 0.5f);
+  }
+
+  /// Number of the next len samples which can use the current gain
+  int chunk(int len) const {
+    return remaining > 0 && len > kChunk ? kChunk : len;
+  }
+
+  /// Advances the ramp by the indicated number of samples
+  void advance(int samples) {
+    if (samples >= remaining) {
+      current = target;
+      remaining = 0;
+    } else {
+      current += step * samples;
+      remaining -= samples;
+    }
+  }
+};
+
+/**
+ * @brief Sums up weighted blocks of samples for the InputMixer and
+ * OutputMixer: call clear(), add() the data of each input with its MixRamp
+ * gain and get the saturated result with read(). The generic version
+ * accumulates in float: the input is converted with SampleFormat, so T needs
+ * to be supported there.
+ * @ingroup simd
+ * @tparam T sample type
+ */
+template <typename T>
+class MixAccumulator {
+ public:
+  /// Sets the sum of the first samples to 0
+  void clear(int samples) {
+    if (acc.size() < samples) acc.resize(samples);
+    memset(acc.data(), 0, samples * sizeof(float));
+  }
+
+  /// Adds len samples multiplied by the gain starting at the sample offset.
+  /// Inputs with a silent gain are skipped.
+  void add(const T* in, int offset, int len, MixRamp& gain) {
+    if (gain.isSilent()) return;
+    float* sum = acc.data() + offset;
+    float tmp[kBlock];
+    int pos = 0;
+    while (pos < len) {
+      int n = gain.chunk(len - pos);
+      if (n > kBlock) n = kBlock;
+      SampleFormat<T>::toFloat(in + pos, tmp, n);
+      mixAdd(sum + pos, tmp, n, gain.current);
+      gain.advance(n);
+      pos += n;
+    }
+  }
+
+  /// Provides the saturated result for the first samples
+  void read(T* out, int samples) {
+    float zero = SampleFormat<T>::zero();
+    float amplitude = SampleFormat<T>::amplitude();
+    scaleAndClip(acc.data(), acc.data(), samples, 1.0f, 0.0f,
+                 zero - amplitude, zero + amplitude);
+    SampleFormat<T>::fromFloat(acc.data(), out, samples);
+  }
+
+ protected:
+  static const int kBlock = 64;
+  Vector<float> acc;
+};
+
+/**
+ * @brief Mixing of float samples: no conversion is needed
+ * @ingroup simd
+ */
+template <>
+class MixAccumulator<float> {
+ public:
+  void clear(int samples) {
+    if (acc.size() < samples) acc.resize(samples);
+    memset(acc.data(), 0, samples * sizeof(float));
+  }
+
+  void add(const float* in, int offset, int len, MixRamp& gain) {
+    if (gain.isSilent()) return;
+    float* sum = acc.data() + offset;
+    int pos = 0;
+    while (pos < len) {
+      int n = gain.chunk(len - pos);
+      mixAdd(sum + pos, in + pos, n, gain.current);
+      gain.advance(n);
+      pos += n;
+    }
+  }
+
+  void read(float* out, int samples) {
+    scaleAndClip(acc.data(), out, samples, 1.0f, 0.0f, -1.0f, 1.0f);
+  }
+
+ protected:
+  Vector<float> acc;
+};
+
+/**
+ * @brief Integer mixing with an int32 accumulator and Q14 gains: used for
+ * int8_t and int16_t samples, so no float operations are needed per sample.
+ * @ingroup simd
+ * @tparam T int8_t or int16_t
+ */
+template <typename T>
+class MixAccumulatorQ14 {
+ public:
+  void clear(int samples) {
+    if (acc.size() < samples) acc.resize(samples);
+    memset(acc.data(), 0, samples * sizeof(int32_t));
+  }
+
+  void add(const T* in, int offset, int len, MixRamp& gain) {
+    if (gain.isSilent()) return;
+    int32_t* sum = acc.data() + offset;
+    int pos = 0;
+    while (pos < len) {
+      int n = gain.chunk(len - pos);
+      mixAdd(sum + pos, in + pos, n, gain.q14());
+      gain.advance(n);
+      pos += n;
+    }
+  }
+
+ protected:
+  Vector<int32_t> acc;
+};
+
+/// @brief Mixing of 16 bit samples in Q14 fixed point
+/// @ingroup simd
+template <>
+class MixAccumulator<int16_t> : public MixAccumulatorQ14<int16_t> {
+ public:
+  void read(int16_t* out, int samples) { mixStore(acc.data(), out, samples); }
+};
+
+/// @brief Mixing of 8 bit samples in Q14 fixed point
+/// @ingroup simd
+template <>
+class MixAccumulator<int8_t> : public MixAccumulatorQ14<int8_t> {
+ public:
+  void read(int8_t* out, int samples) {
+    for (int j = 0; j < samples; j++) {
+      int32_t v = (acc[j] + (1 << 13)) >> 14;
+      out[j] = v > 127 ? 127 : (v < -128 ? -128 : v);
+    }
+  }
+};
+
+#if PREFER_FIXEDPOINT
+/**
+ * @brief Integer mixing of 24 and 32 bit samples with an int64 accumulator
+ * and Q14 gains: with PREFER_FIXEDPOINT no float operations are needed per
+ * sample.
+ * @ingroup simd
+ * @tparam T int24_t or int32_t
+ * @tparam MaxValue max sample value used for the saturation
+ */
+template <typename T, int32_t MaxValue>
+class MixAccumulatorQ14Wide {
+ public:
+  void clear(int samples) {
+    if (acc.size() < samples) acc.resize(samples);
+    memset(acc.data(), 0, samples * sizeof(int64_t));
+  }
+
+  void add(const T* in, int offset, int len, MixRamp& gain) {
+    if (gain.isSilent()) return;
+    int64_t* sum = acc.data() + offset;
+    int pos = 0;
+    while (pos < len) {
+      int n = gain.chunk(len - pos);
+      int64_t g = gain.q14();
+      for (int j = pos; j < pos + n; j++) {
+        T sample = in[j];
+        sum[j] += (int64_t)(int32_t)sample * g;
+      }
+      gain.advance(n);
+      pos += n;
+    }
+  }
+
+  void read(T* out, int samples) {
+    for (int j = 0; j < samples; j++) {
+      int64_t v = (acc[j] + (1 << 13)) >> 14;
+      if (v > MaxValue) v = MaxValue;
+      if (v < -(int64_t)MaxValue - 1) v = -(int64_t)MaxValue - 1;
+      out[j] = (int32_t)v;
+    }
+  }
+
+ protected:
+  Vector<int64_t> acc;
+};
+
+/// @brief Mixing of 24 bit samples in Q14 fixed point
+/// @ingroup simd
+template <>
+class MixAccumulator<int24_t> : public MixAccumulatorQ14Wide<int24_t, 8388607> {
+};
+
+/// @brief Mixing of 32 bit samples in Q14 fixed point
+/// @ingroup simd
+template <>
+class MixAccumulator<int32_t>
+    : public MixAccumulatorQ14Wide<int32_t, INT32_MAX> {};
+#endif
+
+}  // namespace audio_tools
@@ -0,0 +1,268 @@
+#pragma once
+#include <stdint.h>
+
+#include "AudioToolsConfig.h"
+
+#if USE_SIMD
+#  if defined(__AVX__) || defined(__SSE__) || defined(_M_X64)
+#    include <immintrin.h>
+#    define AUDIO_SIMD_SSE
+// the integer kernels need SSE2 (e.g. _mm_loadu_si128, _mm_cvtepi32_ps)
+#    if defined(__SSE2__) || defined(_M_X64) || \
+        (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#      define AUDIO_SIMD_SSE2
+#    endif
+#    if defined(__AVX__)
+#      define AUDIO_SIMD_AVX
+#    endif
+#  elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+#    include <arm_neon.h>
+#    define AUDIO_SIMD_NEON
+#  endif
+#endif
+
+#if defined(USE_ESP32_DSP)
+#  include "esp_dsp.h"
+#endif
+
+/**
+ * @defgroup simd SIMD
+ * @ingroup basic
+ * @brief Vectorized kernels for the DSP hot paths: they use AVX/SSE on x86,
+ * NEON on ARM and esp-dsp on the ESP32 (if USE_ESP32_DSP is defined) and fall
+ * back to portable unrolled C++ code. Set USE_SIMD to false to force the
+ * portable versions.
+ */
+
+namespace audio_tools {
+
+/**
+ * @brief Calculates the dot product sum(a[j] * b[j]) of two arrays. This
+ * generic version is used for all non float types: it accumulates in T with
+ * 4 independent accumulators so that the compiler can pipeline the loop.
+ * @ingroup simd
+ */
+template <typename T>
+inline T dotProduct(const T* a, const T* b, int len) {
+  T acc0 = 0, acc1 = 0, acc2 = 0, acc3 = 0;
+  int j = 0;
+  for (; j + 4 <= len; j += 4) {
+    acc0 += a[j] * b[j];
+    acc1 += a[j + 1] * b[j + 1];
+    acc2 += a[j + 2] * b[j + 2];
+    acc3 += a[j + 3] * b[j + 3];
+  }
+  for (; j < len; j++) acc0 += a[j] * b[j];
+  return (acc0 + acc1) + (acc2 + acc3);
+}
+
+/**
+ * @brief Calculates the dot product sum(a[j] * b[j]) of two float arrays
+ * using the best instruction set that is available. The arrays do not need
+ * to be aligned.
+ * @ingroup simd
+ */
+inline float dotProduct(const float* a, const float* b, int len) {
+  if (len <= 0) return 0.0f;
+#if defined(USE_ESP32_DSP)
+  float result = 0.0f;
+  dsps_dotprod_f32(a, b, &result, len);
+  return result;
+#else
+  int j = 0;
+  float sum = 0.0f;
+#  if defined(AUDIO_SIMD_AVX)
+  __m256 acc8 = _mm256_setzero_ps();
+  for (; j + 8 <= len; j += 8) {
+    acc8 = _mm256_add_ps(
+        acc8, _mm256_mul_ps(_mm256_loadu_ps(a + j), _mm256_loadu_ps(b + j)));
+  }
+  __m128 acc = _mm_add_ps(_mm256_castps256_ps128(acc8),
+                          _mm256_extractf128_ps(acc8, 1));
+#  elif defined(AUDIO_SIMD_SSE)
+  __m128 acc = _mm_setzero_ps();
+#  endif
+#  if defined(AUDIO_SIMD_SSE)
+  for (; j + 4 <= len; j += 4) {
+    acc = _mm_add_ps(acc, _mm_mul_ps(_mm_loadu_ps(a + j), _mm_loadu_ps(b + j)));
+  }
+  // horizontal add of the 4 lanes
+  __m128 shuf = _mm_shuffle_ps(acc, acc, _MM_SHUFFLE(2, 3, 0, 1));
+  __m128 sums = _mm_add_ps(acc, shuf);
+  shuf = _mm_movehl_ps(shuf, sums);
+  sums = _mm_add_ss(sums, shuf);
+  sum = _mm_cvtss_f32(sums);
+#  elif defined(AUDIO_SIMD_NEON)
+  float32x4_t acc = vdupq_n_f32(0.0f);
+  for (; j + 4 <= len; j += 4) {
+    acc = vmlaq_f32(acc, vld1q_f32(a + j), vld1q_f32(b + j));
+  }
+  float32x2_t half = vadd_f32(vget_low_f32(acc), vget_high_f32(acc));
+  sum = vget_lane_f32(vpadd_f32(half, half), 0);
+#  else
+  float acc0 = 0.0f, acc1 = 0.0f, acc2 = 0.0f, acc3 = 0.0f;
+  for (; j + 4 <= len; j += 4) {
+    acc0 += a[j] * b[j];
+    acc1 += a[j + 1] * b[j + 1];
+    acc2 += a[j + 2] * b[j + 2];
+    acc3 += a[j + 3] * b[j + 3];
+  }
+  sum = (acc0 + acc1) + (acc2 + acc3);
+#  endif
+  for (; j < len; j++) sum += a[j] * b[j];
+  return sum;
+#endif
+}
+
+/**
+ * @brief Mixing kernel for 16 bit samples: adds the samples multiplied with
+ * a Q14 gain (16384 = 1.0) to an int32 accumulator: acc[j] += in[j] * gain.
+ * As long as the sum of the gains is below 4.0 the accumulator can not
+ * overflow.
+ * @ingroup simd
+ */
+inline void mixAdd(int32_t* acc, const int16_t* in, int len, int16_t gain) {
+  int j = 0;
+#if defined(AUDIO_SIMD_SSE2)
+  __m128i g = _mm_set1_epi16(gain);
+  for (; j + 8 <= len; j += 8) {
+    __m128i x = _mm_loadu_si128((const __m128i*)(in + j));
+    // 32 bit products from the low and high 16 bits
+    __m128i lo = _mm_mullo_epi16(x, g);
+    __m128i hi = _mm_mulhi_epi16(x, g);
+    __m128i* a = (__m128i*)(acc + j);
+    _mm_storeu_si128(
+        a, _mm_add_epi32(_mm_loadu_si128(a), _mm_unpacklo_epi16(lo, hi)));
+    _mm_storeu_si128(a + 1, _mm_add_epi32(_mm_loadu_si128(a + 1),
+                                          _mm_unpackhi_epi16(lo, hi)));
+  }
+#elif defined(AUDIO_SIMD_NEON)
+  int16x4_t g = vdup_n_s16(gain);
+  for (; j + 8 <= len; j += 8) {
+    int16x8_t x = vld1q_s16(in + j);
+    vst1q_s32(acc + j, vmlal_s16(vld1q_s32(acc + j), vget_low_s16(x), g));
+    vst1q_s32(acc + j + 4,
+              vmlal_s16(vld1q_s32(acc + j + 4), vget_high_s16(x), g));
+  }
+#endif
+  for (; j < len; j++) acc[j] += (int32_t)in[j] * gain;
+}
+
+/**
+ * @brief Mixing kernel for the other integer types which fit into an int32
+ * accumulator with a Q14 gain (e.g. int8_t)
+ * @ingroup simd
+ */
+template <typename T>
+inline void mixAdd(int32_t* acc, const T* in, int len, int16_t gain) {
+  for (int j = 0; j < len; j++) acc[j] += (int32_t)in[j] * gain;
+}
+
+/**
+ * @brief Mixing kernel for float: acc[j] += in[j] * gain
+ * @ingroup simd
+ */
+inline void mixAdd(float* acc, const float* in, int len, float gain) {
+  int j = 0;
+#if defined(AUDIO_SIMD_SSE)
+  __m128 g = _mm_set1_ps(gain);
+  for (; j + 4 <= len; j += 4) {
+    __m128 v = _mm_add_ps(_mm_loadu_ps(acc + j),
+                          _mm_mul_ps(_mm_loadu_ps(in + j), g));
+    _mm_storeu_ps(acc + j, v);
+  }
+#elif defined(AUDIO_SIMD_NEON)
+  for (; j + 4 <= len; j += 4) {
+    vst1q_f32(acc + j, vmlaq_n_f32(vld1q_f32(acc + j), vld1q_f32(in + j), gain));
+  }
+#endif
+  for (; j < len; j++) acc[j] += in[j] * gain;
+}
+
+/**
+ * @brief Converts a Q14 accumulator (see mixAdd()) to 16 bit samples with
+ * rounding and saturation
+ * @ingroup simd
+ */
+inline void mixStore(const int32_t* acc, int16_t* out, int len) {
+  int j = 0;
+#if defined(AUDIO_SIMD_SSE2)
+  __m128i round = _mm_set1_epi32(1 << 13);
+  for (; j + 8 <= len; j += 8) {
+    __m128i a0 = _mm_loadu_si128((const __m128i*)(acc + j));
+    __m128i a1 = _mm_loadu_si128((const __m128i*)(acc + j + 4));
+    a0 = _mm_srai_epi32(_mm_add_epi32(a0, round), 14);
+    a1 = _mm_srai_epi32(_mm_add_epi32(a1, round), 14);
+    _mm_storeu_si128((__m128i*)(out + j), _mm_packs_epi32(a0, a1));
+  }
+#elif defined(AUDIO_SIMD_NEON)
+  for (; j + 8 <= len; j += 8) {
+    int16x4_t lo = vqrshrn_n_s32(vld1q_s32(acc + j), 14);
+    int16x4_t hi = vqrshrn_n_s32(vld1q_s32(acc + j + 4), 14);
+    vst1q_s16(out + j, vcombine_s16(lo, hi));
+  }
+#endif
+  for (; j < len; j++) {
+    int32_t v = (acc[j] + (1 << 13)) >> 14;
+    out[j] = v > 32767 ? 32767 : (v < -32768 ? -32768 : v);
+  }
+}
+
+/**
+ * @brief Multiplies each value with its own factor and clips the result:
+ * out[j] = clip(in[j] * factors[j]) with the limits minValue and maxValue.
+ * in and out may be the same array.
+ * @ingroup simd
+ */
+inline void multiplyAndClip(const float* in, const float* factors, float* out,
+                            int len, float minValue, float maxValue) {
+  int j = 0;
+#if defined(AUDIO_SIMD_SSE)
+  __m128 lo = _mm_set1_ps(minValue);
+  __m128 hi = _mm_set1_ps(maxValue);
+  for (; j + 4 <= len; j += 4) {
+    __m128 v = _mm_mul_ps(_mm_loadu_ps(in + j), _mm_loadu_ps(factors + j));
+    _mm_storeu_ps(out + j, _mm_min_ps(_mm_max_ps(v, lo), hi));
+  }
+#elif defined(AUDIO_SIMD_NEON)
+  float32x4_t lo = vdupq_n_f32(minValue);
+  float32x4_t hi = vdupq_n_f32(maxValue);
+  for (; j + 4 <= len; j += 4) {
+    float32x4_t v = vmulq_f32(vld1q_f32(in + j), vld1q_f32(factors + j));
+    vst1q_f32(out + j, vminq_f32(vmaxq_f32(v, lo), hi));
+  }
+#endif
+  for (; j < len; j++) {
+    float v = in[j] * factors[j];
+    out[j] = v > maxValue ? maxValue : (v < minValue ? minValue : v);
+  }
+}
+
+/**
+ * @brief Integer only gain for 16 bit samples: each sample is multiplied
+ * with its Q15 gain (32768 = 1.0, max 65535) with rounding and saturation.
+ * This is intended for processors without FPU.
+ * @ingroup simd
+ */
+inline void applyGainQ15(int16_t* data, const int32_t* gains, int len) {
+  for (int j = 0; j < len; j++) {
+    int32_t v = ((int32_t)data[j] * gains[j] + (1 << 14)) >> 15;
+    data[j] = v > 32767 ? 32767 : (v < -32767 ? -32767 : v);
+  }
+}
+
+/**
+ * @brief Integer only gain for 32 bit samples: each sample is multiplied
+ * with its Q31 gain (2^31 = 1.0, max 2^32 - 1) with rounding and saturation
+ * to +/- maxValue.
+ * @ingroup simd
+ */
+inline void applyGainQ31(int32_t* data, const int64_t* gains, int len,
+                         int32_t maxValue = 2147483647) {
+  for (int j = 0; j < len; j++) {
+    int64_t v = ((int64_t)data[j] * gains[j] + (1LL << 30)) >> 31;
+    data[j] = v > maxValue ? maxValue : (v < -maxValue ? -maxValue : v);
+  }
+}
+
+}  // namespace audio_tools
@@ -0,0 +1,322 @@
+#pragma once
+#include <stdint.h>
+#include <string.h>
+
+#include "AudioTools/CoreAudio/AudioBasic/SIMD.h"
+#include "AudioTools/CoreAudio/AudioBasic/int24_3bytes_t.h"
+#include "AudioTools/CoreAudio/AudioBasic/int24_4bytes_t.h"
+
+namespace audio_tools {
+
+/**
+ * @brief Describes how a sample type is represented: the zero point, the
+ * maximum amplitude and the block conversion from and to float. Signed
+ * integers use 0 as zero point, unsigned integers the middle of their range
+ * (e.g. 128 for uint8_t) and float uses -1.0 to 1.0. Types without a
+ * specialization are not supported by convertSamples().
+ * @ingroup simd
+ * @tparam T sample type
+ */
+template <typename T>
+struct SampleFormat {
+  static const bool is_supported = false;
+  static float zero() { return 0.0f; }
+  static float amplitude() { return 1.0f; }
+  static void toFloat(const T* in, float* out, int len) {}
+  static void fromFloat(const float* in, T* out, int len) {}
+};
+
+/// @brief 8 bit signed samples
+/// @ingroup simd
+template <>
+struct SampleFormat<int8_t> {
+  static const bool is_supported = true;
+  static float zero() { return 0.0f; }
+  static float amplitude() { return 127.0f; }
+  static void toFloat(const int8_t* in, float* out, int len) {
+    for (int j = 0; j < len; j++) out[j] = in[j];
+  }
+  static void fromFloat(const float* in, int8_t* out, int len) {
+    for (int j = 0; j < len; j++) out[j] = (int8_t)in[j];
+  }
+};
+
+/// @brief 8 bit unsigned samples (e.g. 8 bit WAV) with 128 as zero point
+/// @ingroup simd
+template <>
+struct SampleFormat<uint8_t> {
+  static const bool is_supported = true;
+  static float zero() { return 128.0f; }
+  static float amplitude() { return 127.0f; }
+  static void toFloat(const uint8_t* in, float* out, int len) {
+    for (int j = 0; j < len; j++) out[j] = in[j];
+  }
+  static void fromFloat(const float* in, uint8_t* out, int len) {
+    for (int j = 0; j < len; j++) out[j] = (uint8_t)in[j];
+  }
+};
+
+/// @brief 16 bit signed samples
+/// @ingroup simd
+template <>
+struct SampleFormat<int16_t> {
+  static const bool is_supported = true;
+  static float zero() { return 0.0f; }
+  static float amplitude() { return 32767.0f; }
+  static void toFloat(const int16_t* in, float* out, int len) {
+    int j = 0;
+#if defined(AUDIO_SIMD_SSE2)
+    for (; j + 8 <= len; j += 8) {
+      __m128i v = _mm_loadu_si128((const __m128i*)(in + j));
+      // sign extend by shifting the upper half of each 32 bit lane down
+      __m128i lo = _mm_srai_epi32(_mm_unpacklo_epi16(v, v), 16);
+      __m128i hi = _mm_srai_epi32(_mm_unpackhi_epi16(v, v), 16);
+      _mm_storeu_ps(out + j, _mm_cvtepi32_ps(lo));
+      _mm_storeu_ps(out + j + 4, _mm_cvtepi32_ps(hi));
+    }
+#elif defined(AUDIO_SIMD_NEON)
+    for (; j + 8 <= len; j += 8) {
+      int16x8_t v = vld1q_s16(in + j);
+      vst1q_f32(out + j, vcvtq_f32_s32(vmovl_s16(vget_low_s16(v))));
+      vst1q_f32(out + j + 4, vcvtq_f32_s32(vmovl_s16(vget_high_s16(v))));
+    }
+#endif
+    for (; j < len; j++) out[j] = in[j];
+  }
+  static void fromFloat(const float* in, int16_t* out, int len) {
+    int j = 0;
+#if defined(AUDIO_SIMD_SSE2)
+    for (; j + 8 <= len; j += 8) {
+      __m128i lo = _mm_cvttps_epi32(_mm_loadu_ps(in + j));
+      __m128i hi = _mm_cvttps_epi32(_mm_loadu_ps(in + j + 4));
+      _mm_storeu_si128((__m128i*)(out + j), _mm_packs_epi32(lo, hi));
+    }
+#elif defined(AUDIO_SIMD_NEON)
+    for (; j + 8 <= len; j += 8) {
+      int16x4_t lo = vqmovn_s32(vcvtq_s32_f32(vld1q_f32(in + j)));
+      int16x4_t hi = vqmovn_s32(vcvtq_s32_f32(vld1q_f32(in + j + 4)));
+      vst1q_s16(out + j, vcombine_s16(lo, hi));
+    }
+#endif
+    for (; j < len; j++) out[j] = (int16_t)in[j];
+  }
+};
+
+/// @brief 16 bit unsigned samples with 32768 as zero point
+/// @ingroup simd
+template <>
+struct SampleFormat<uint16_t> {
+  static const bool is_supported = true;
+  static float zero() { return 32768.0f; }
+  static float amplitude() { return 32767.0f; }
+  static void toFloat(const uint16_t* in, float* out, int len) {
+    for (int j = 0; j < len; j++) out[j] = in[j];
+  }
+  static void fromFloat(const float* in, uint16_t* out, int len) {
+    for (int j = 0; j < len; j++) out[j] = (uint16_t)in[j];
+  }
+};
+
+/// @brief 32 bit signed samples
+/// @ingroup simd
+template <>
+struct SampleFormat<int32_t> {
+  static const bool is_supported = true;
+  static float zero() { return 0.0f; }
+  // biggest float below 2^31: 2147483647 would be rounded up and overflow
+  static float amplitude() { return 2147483520.0f; }
+  static void toFloat(const int32_t* in, float* out, int len) {
+    int j = 0;
+#if defined(AUDIO_SIMD_SSE2)
+    for (; j + 4 <= len; j += 4) {
+      __m128i v = _mm_loadu_si128((const __m128i*)(in + j));
+      _mm_storeu_ps(out + j, _mm_cvtepi32_ps(v));
+    }
+#elif defined(AUDIO_SIMD_NEON)
+    for (; j + 4 <= len; j += 4) {
+      vst1q_f32(out + j, vcvtq_f32_s32(vld1q_s32(in + j)));
+    }
+#endif
+    for (; j < len; j++) out[j] = (float)in[j];
+  }
+  static void fromFloat(const float* in, int32_t* out, int len) {
+    int j = 0;
+#if defined(AUDIO_SIMD_SSE2)
+    for (; j + 4 <= len; j += 4) {
+      __m128i v = _mm_cvttps_epi32(_mm_loadu_ps(in + j));
+      _mm_storeu_si128((__m128i*)(out + j), v);
+    }
+#elif defined(AUDIO_SIMD_NEON)
+    for (; j + 4 <= len; j += 4) {
+      vst1q_s32(out + j, vcvtq_s32_f32(vld1q_f32(in + j)));
+    }
+#endif
+    for (; j < len; j++) out[j] = (int32_t)in[j];
+  }
+};
+
+/// @brief 24 bit samples which are stored left aligned in 4 bytes
+/// @ingroup simd
+template <>
+struct SampleFormat<int24_4bytes_t> {
+  static const bool is_supported = true;
+  static float zero() { return 0.0f; }
+  static float amplitude() { return 8388607.0f; }
+  static void toFloat(const int24_4bytes_t* in, float* out, int len) {
+    const uint8_t* src = (const uint8_t*)in;
+    int j = 0;
+#if defined(AUDIO_SIMD_SSE2)
+    for (; j + 4 <= len; j += 4) {
+      __m128i v = _mm_loadu_si128((const __m128i*)(src + j * 4));
+      _mm_storeu_ps(out + j, _mm_cvtepi32_ps(_mm_srai_epi32(v, 8)));
+    }
+#elif defined(AUDIO_SIMD_NEON)
+    for (; j + 4 <= len; j += 4) {
+      int32x4_t v = vreinterpretq_s32_u8(vld1q_u8(src + j * 4));
+      vst1q_f32(out + j, vcvtq_f32_s32(vshrq_n_s32(v, 8)));
+    }
+#endif
+    for (; j < len; j++) {
+      int32_t v;
+      memcpy(&v, src + j * 4, 4);
+      out[j] = (float)(v >> 8);
+    }
+  }
+  static void fromFloat(const float* in, int24_4bytes_t* out, int len) {
+    uint8_t* dest = (uint8_t*)out;
+    int j = 0;
+#if defined(AUDIO_SIMD_SSE2)
+    for (; j + 4 <= len; j += 4) {
+      __m128i v = _mm_slli_epi32(_mm_cvttps_epi32(_mm_loadu_ps(in + j)), 8);
+      _mm_storeu_si128((__m128i*)(dest + j * 4), v);
+    }
+#elif defined(AUDIO_SIMD_NEON)
+    for (; j + 4 <= len; j += 4) {
+      int32x4_t v = vshlq_n_s32(vcvtq_s32_f32(vld1q_f32(in + j)), 8);
+      vst1q_u8(dest + j * 4, vreinterpretq_u8_s32(v));
+    }
+#endif
+    for (; j < len; j++) {
+      int32_t v = (int32_t)((uint32_t)(int32_t)in[j] << 8);
+      memcpy(dest + j * 4, &v, 4);
+    }
+  }
+};
+
+/// @brief 24 bit samples which are packed in 3 bytes (little endian)
+/// @ingroup simd
+template <>
+struct SampleFormat<int24_3bytes_t> {
+  static const bool is_supported = true;
+  static float zero() { return 0.0f; }
+  static float amplitude() { return 8388607.0f; }
+  static void toFloat(const int24_3bytes_t* in, float* out, int len) {
+    const uint8_t* src = (const uint8_t*)in;
+    for (int j = 0; j < len; j++, src += 3) {
+      // place the 3 bytes in the upper part and sign extend with the shift
+      int32_t v = (int32_t)(((uint32_t)src[0] << 8) | ((uint32_t)src[1] << 16) |
+                            ((uint32_t)src[2] << 24));
+      out[j] = (float)(v >> 8);
+    }
+  }
+  static void fromFloat(const float* in, int24_3bytes_t* out, int len) {
+    uint8_t* dest = (uint8_t*)out;
+    for (int j = 0; j < len; j++, dest += 3) {
+      int32_t v = (int32_t)in[j];
+      dest[0] = v & 0xFF;
+      dest[1] = (v >> 8) & 0xFF;
+      dest[2] = (v >> 16) & 0xFF;
+    }
+  }
+};
+
+/// @brief float samples in the range of -1.0 to 1.0
+/// @ingroup simd
+template <>
+struct SampleFormat<float> {
+  static const bool is_supported = true;
+  static float zero() { return 0.0f; }
+  static float amplitude() { return 1.0f; }
+  static void toFloat(const float* in, float* out, int len) {
+    if (in != out) memmove(out, in, len * sizeof(float));
+  }
+  static void fromFloat(const float* in, float* out, int len) {
+    if (in != out) memmove(out, in, len * sizeof(float));
+  }
+};
+
+/**
+ * @brief Calculates out[j] = clip(in[j] * factor + offset) with the limits
+ * minValue and maxValue. in and out may be the same array.
+ * @ingroup simd
+ */
+inline void scaleAndClip(const float* in, float* out, int len, float factor,
+                         float offset, float minValue, float maxValue) {
+  int j = 0;
+#if defined(USE_ESP32_DSP)
+  dsps_mulc_f32(in, out, len, factor, 1, 1);
+  if (offset != 0.0f) dsps_addc_f32(out, out, len, offset, 1, 1);
+  for (; j < len; j++) {
+    float v = out[j];
+    out[j] = v > maxValue ? maxValue : (v < minValue ? minValue : v);
+  }
+#else
+#  if defined(AUDIO_SIMD_SSE)
+  __m128 f = _mm_set1_ps(factor);
+  __m128 o = _mm_set1_ps(offset);
+  __m128 lo = _mm_set1_ps(minValue);
+  __m128 hi = _mm_set1_ps(maxValue);
+  for (; j + 4 <= len; j += 4) {
+    __m128 v = _mm_add_ps(_mm_mul_ps(_mm_loadu_ps(in + j), f), o);
+    _mm_storeu_ps(out + j, _mm_min_ps(_mm_max_ps(v, lo), hi));
+  }
+#  elif defined(AUDIO_SIMD_NEON)
+  float32x4_t o = vdupq_n_f32(offset);
+  float32x4_t lo = vdupq_n_f32(minValue);
+  float32x4_t hi = vdupq_n_f32(maxValue);
+  for (; j + 4 <= len; j += 4) {
+    float32x4_t v = vmlaq_n_f32(o, vld1q_f32(in + j), factor);
+    vst1q_f32(out + j, vminq_f32(vmaxq_f32(v, lo), hi));
+  }
+#  endif
+  for (; j < len; j++) {
+    float v = in[j] * factor + offset;
+    out[j] = v > maxValue ? maxValue : (v < minValue ? minValue : v);
+  }
+#endif
+}
+
+/**
+ * @brief Converts an array of samples from one format to another with an
+ * optional gain: the amplitude of the source type is mapped to the amplitude
+ * of the target type and the result is saturated to the target range. The
+ * data is processed in blocks of 64 samples: the source is widened to float,
+ * scaled + clipped and narrowed to the target type with the SIMD instructions
+ * which are available. Supported are int8_t, uint8_t, int16_t, uint16_t,
+ * int24_3bytes_t, int24_4bytes_t, int32_t and float.
+ * @ingroup simd
+ * @return false if one of the types is not supported (nothing is converted)
+ */
+template <typename FromT, typename ToT>
+inline bool convertSamples(const FromT* from, ToT* to, int samples,
+                           float gain = 1.0f) {
+  if (!SampleFormat<FromT>::is_supported || !SampleFormat<ToT>::is_supported) {
+    return false;
+  }
+  const float amp_to = SampleFormat<ToT>::amplitude();
+  const float zero_to = SampleFormat<ToT>::zero();
+  const float factor = gain * amp_to / SampleFormat<FromT>::amplitude();
+  const float offset = zero_to - SampleFormat<FromT>::zero() * factor;
+  const int block = 64;
+  float tmp[block];
+  for (int pos = 0; pos < samples; pos += block) {
+    int len = samples - pos < block ? samples - pos : block;
+    SampleFormat<FromT>::toFloat(from + pos, tmp, len);
+    scaleAndClip(tmp, tmp, len, factor, offset, zero_to - amp_to,
+                 zero_to + amp_to);
+    SampleFormat<ToT>::fromFloat(tmp, to + pos, len);
+  }
+  return true;
+}
+
+}  // namespace audio_tools
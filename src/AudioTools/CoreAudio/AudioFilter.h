@@ -3,3 +3,4 @@
 #include "AudioTools/CoreAudio/AudioFilter/Filter.h"
 #include "AudioTools/CoreAudio/AudioFilter/Equalizer3Bands.h"
 #include "AudioTools/CoreAudio/AudioFilter/MedianFilter.h"
+#include "AudioTools/CoreAudio/AudioFilter/PolyphaseFIR.h"
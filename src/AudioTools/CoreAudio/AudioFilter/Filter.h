@@ -1,8 +1,10 @@
 #pragma once
 #include <math.h>
+#include <string.h>
 
 #include "AudioToolsConfig.h"
 #include "AudioTools/CoreAudio/AudioLogger.h"
+#include "AudioTools/CoreAudio/AudioBasic/SIMD.h"
 #ifdef USE_TYPETRAITS
 #include <type_traits>
 #endif
@@ -34,6 +36,13 @@ class Filter {
   Filter& operator=(Filter const&) = delete;
   /// Processes the input value and returns the filtered output value.
   virtual T process(T in) = 0;
+  /// Processes a block of len samples from in to out (which may be the same
+  /// array). The default calls process(T) for each sample; subclasses override
+  /// it with a devirtualized loop. Subclasses that only override process(T)
+  /// need a `using Filter<T>::process;` to call this overload directly.
+  virtual void process(const T* in, T* out, size_t len) {
+    for (size_t j = 0; j < len; j++) out[j] = process(in[j]);
+  }
   /// Clears the internal state (delay lines) without changing the coefficients.
   /// Call after reconfiguring filter parameters via begin() to avoid transients
   /// from stale state.
@@ -53,6 +62,9 @@ class NoFilter : public Filter<T> {
   // construct without coefs
   NoFilter() = default;
   T process(T in) override { return in; }
+  void process(const T* in, T* out, size_t len) override {
+    if (in != out) memcpy(out, in, len * sizeof(T));
+  }
 };
 
 /**
@@ -74,13 +86,28 @@ class FIR : public Filter<T> {
     setValues(b);
   }
 
+  /// Constructor for coefficients which are only known at runtime (e.g.
+  /// designed with calculateLowPassFIRCoeffs())
+  FIR(Vector<T>& b, const T factor = 1.0)
+      : lenB(b.size()), factor(factor), needs_divide(factor != T(1)) {
+    setValues(b.data());
+  }
+
   template <size_t B>
   void setValues(const T (&b)[B]) {
+    setValues(&b[0]);
+  }
+
+  /// Updates the coefficients: b must contain as many values as defined in
+  /// the constructor
+  void setValues(const T* b) {
     x.resize(lenB);
     coeff_b.resize(2 * lenB - 1);
     for (uint16_t i = 0; i < 2 * lenB - 1; i++) {
       coeff_b[i] = b[(2 * lenB - 1 - i) % lenB];
     }
+    // the delay line is not initialized by Vector::resize()
+    reset();
   }
 
   void reset() override {
@@ -88,13 +115,19 @@ class FIR : public Filter<T> {
     for (uint16_t i = 0; i < lenB; i++) x[i] = 0;
   }
 
-  T process(T value) override {
+  T process(T value) override { return step(value); }
+
+  void process(const T* in, T* out, size_t len) override {
+    for (size_t j = 0; j < len; j++) out[j] = step(in[j]);
+  }
+
+ protected:
+  /// Non virtual single sample step shared by both process() variants
+  inline T step(T value) {
     x[i_b] = value;
-    T b_terms = 0;
-    T* b_shift = &coeff_b[lenB - i_b - 1];
-    for (uint16_t i = 0; i < lenB; i++) {
-      b_terms += b_shift[i] * x[i];
-    }
+    // the doubled coefficient array makes both operands contiguous, so the
+    // convolution is a plain (vectorized) dot product
+    T b_terms = dotProduct(&coeff_b[lenB - i_b - 1], &x[0], lenB);
     i_b++;
     if (i_b == lenB) i_b = 0;
 
@@ -114,7 +147,6 @@ class FIR : public Filter<T> {
     return b_terms;
   }
 
- private:
   const uint16_t lenB;
   uint16_t i_b = 0;
   Vector<T> x;
@@ -151,6 +183,8 @@ class IIR : public Filter<T> {
     for (uint16_t i = 0; i < 2 * lenA - 1; i++) {
       coeff_a[i] = a[(2 * lenA - 2 - i) % lenA] / a0;
     }
+    // the delay lines are not initialized by Vector::resize()
+    reset();
   }
 
   void reset() override {
@@ -160,13 +194,21 @@ class IIR : public Filter<T> {
     for (uint16_t i = 0; i < lenA; i++) y[i] = 0;
   }
 
-  T process(T value) override {
+  T process(T value) override { return step(value); }
+
+  void process(const T* in, T* out, size_t len) override {
+    for (size_t j = 0; j < len; j++) out[j] = step(in[j]);
+  }
+
+ protected:
+  /// Non virtual single sample step shared by both process() variants
+  inline T step(T value) {
     x[i_b] = value;
     T b_terms = 0;
-    T* b_shift = &coeff_b[lenB - i_b - 1];
+    const T* b_shift = &coeff_b[lenB - i_b - 1];
 
     T a_terms = 0;
-    T* a_shift = &coeff_a[lenA - i_a - 1];
+    const T* a_shift = &coeff_a[lenA - i_a - 1];
 
     for (uint16_t i = 0; i < lenB; i++) {
       b_terms += x[i] * b_shift[i];
@@ -196,7 +238,6 @@ class IIR : public Filter<T> {
     return filtered;
   }
 
- private:
   T factor;
   bool needs_divide;
   const uint16_t lenB, lenA;
@@ -253,6 +294,25 @@ class BiQuadDF1 : public Filter<T> {
     return y_1;
   }
 
+  void process(const T* in, T* out, size_t len) override {
+    // keep the state in locals so that it stays in registers
+    const T b0 = b_0, b1 = b_1, b2 = b_2, a1 = a_1, a2 = a_2;
+    T x0 = x_0, x1 = x_1, y1 = y_1, y2 = y_2;
+    for (size_t j = 0; j < len; j++) {
+      T x2 = x1;
+      x1 = x0;
+      x0 = in[j];
+      T y0 = (x0 * b0 + x1 * b1 + x2 * b2) - (y1 * a1 + y2 * a2);
+      y2 = y1;
+      y1 = y0;
+      out[j] = y0;
+    }
+    x_0 = x0;
+    x_1 = x1;
+    y_1 = y1;
+    y_2 = y2;
+  }
+
  protected:
   T b_0 = 0;
   T b_1 = 0;
@@ -314,6 +374,20 @@ class BiQuadDF2 : public Filter<T> {
     return y;
   }
 
+  void process(const T* in, T* out, size_t len) override {
+    // keep the state in locals so that it stays in registers
+    const T b0 = b_0, b1 = b_1, b2 = b_2, a1 = a_1, a2 = a_2;
+    T w0 = w_0, w1 = w_1;
+    for (size_t j = 0; j < len; j++) {
+      T w2 = w1;
+      w1 = w0;
+      w0 = in[j] - a1 * w1 - a2 * w2;
+      out[j] = b0 * w0 + b1 * w1 + b2 * w2;
+    }
+    w_0 = w0;
+    w_1 = w1;
+  }
+
  protected:
   T b_0 = 0;
   T b_1 = 0;
@@ -977,15 +1051,20 @@ class SOSFilter : public Filter<T> {
     for (size_t i = 0; i < N; i++) delete filters[i];
   }
   void reset() override {
-    for (Filter<T>*& filter : filters) filter->reset();
+    for (BiQuadDF2<T>*& filter : filters) filter->reset();
   }
   T process(T value) override {
-    for (Filter<T>*& filter : filters) value = filter->process(value);
+    for (BiQuadDF2<T>*& filter : filters) value = filter->process(value);
     return value;
   }
+  /// Runs each section over the whole block before moving to the next one
+  void process(const T* in, T* out, size_t len) override {
+    filters[0]->process(in, out, len);
+    for (size_t i = 1; i < N; i++) filters[i]->process(out, out, len);
+  }
 
  private:
-  Filter<T>* filters[N];
+  BiQuadDF2<T>* filters[N];
   template <size_t M>
   void copy(T (&dest)[M], const T* src) {
     for (size_t i = 0; i < M; i++) dest[i] = src[i];
@@ -1024,6 +1103,19 @@ class FilterChain : public Filter<T> {
     return value;
   }
 
+  /// Passes the whole block through each filter in turn: one virtual call
+  /// per filter and block instead of per sample
+  void process(const T* in, T* out, size_t len) override {
+    const T* src = in;
+    for (Filter<T>*& filter : filters) {
+      if (filter != nullptr) {
+        filter->process(src, out, len);
+        src = out;
+      }
+    }
+    if (src != out) memcpy(out, src, len * sizeof(T));
+  }
+
  private:
   Filter<T>* filters[N] = {0};
 };
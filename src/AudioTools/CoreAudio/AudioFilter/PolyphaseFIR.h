@@ -0,0 +1,242 @@
+#pragma once
+#include <math.h>
+
+#include "AudioTools/CoreAudio/AudioBasic/Collections/Vector.h"
+#include "AudioTools/CoreAudio/AudioBasic/SIMD.h"
+#include "Filter.h"
+
+namespace audio_tools {
+
+/**
+ * @brief Designs a linear phase low-pass FIR filter with the windowed sinc
+ * method (Blackman window). The result is normalized to a DC gain of 1.
+ * @ingroup filter
+ * @param coef output array with taps values
+ * @param taps number of coefficients: use an odd number for a symmetric
+ * filter with an integer group delay
+ * @param cutoff cutoff frequency relative to the sample rate (0 < cutoff <
+ * 0.5): e.g. 0.45 / factor for a decimation by factor
+ */
+inline void calculateLowPassFIRCoeffs(float* coef, int taps, float cutoff) {
+  if (taps <= 0) return;
+  float center = 0.5f * (taps - 1);
+  float sum = 0.0f;
+  for (int j = 0; j < taps; j++) {
+    float n = j - center;
+    float sinc = (n == 0.0f) ? 2.0f * cutoff
+                             : sinf(2.0f * PI * cutoff * n) / (PI * n);
+    float window =
+        taps == 1 ? 1.0f
+                  : 0.42f - 0.5f * cosf(2.0f * PI * j / (taps - 1)) +
+                        0.08f * cosf(4.0f * PI * j / (taps - 1));
+    coef[j] = sinc * window;
+    sum += coef[j];
+  }
+  if (sum != 0.0f) {
+    for (int j = 0; j < taps; j++) coef[j] /= sum;
+  }
+}
+
+/**
+ * @brief Delay line for the FIR engines: each sample is stored twice (at pos
+ * and pos + len) so that the last len samples are always available as one
+ * contiguous array (oldest first) which can be passed directly to
+ * dotProduct() without any wrap around handling.
+ * @ingroup filter
+ * @tparam T sample type
+ */
+template <typename T = float>
+class FIRDelayLine {
+ public:
+  void resize(int len) {
+    this->len = len;
+    values.resize(2 * len);
+    reset();
+  }
+  void reset() {
+    pos = 0;
+    for (int j = 0; j < values.size(); j++) values[j] = 0;
+  }
+  /// Adds a new sample and overwrites the oldest one
+  inline void write(T value) {
+    values[pos] = value;
+    values[pos + len] = value;
+    if (++pos == len) pos = 0;
+  }
+  /// Provides the last len samples: the oldest first
+  inline const T* data() { return &values[pos]; }
+  int size() { return len; }
+
+ protected:
+  Vector<T> values;
+  int len = 0;
+  int pos = 0;
+};
+
+/**
+ * @brief FIR filter which reduces the sample rate by an integer factor
+ * (anti-aliasing low-pass + downsampling). Only every factor-th output is
+ * computed: the other input samples are just added to the delay line, so
+ * the cost per input sample is taps / factor multiply-adds. The convolution
+ * uses the SIMD dotProduct().
+ * @ingroup filter
+ * @tparam T sample type (float or double)
+ */
+template <typename T = float>
+class DecimatingFIR {
+ public:
+  DecimatingFIR() = default;
+  /// Defines the decimation factor and designs a default low-pass filter
+  DecimatingFIR(int factor, int tapsPerFactor = 16) {
+    begin(factor, tapsPerFactor);
+  }
+  /// Defines the decimation factor and the filter coefficients
+  DecimatingFIR(int factor, const T* coef, int taps) {
+    begin(factor, coef, taps);
+  }
+
+  /// Designs a Blackman windowed sinc low-pass with factor * tapsPerFactor + 1
+  /// taps and the cutoff slightly below the new Nyquist frequency
+  bool begin(int factor, int tapsPerFactor = 16) {
+    if (factor <= 0) return false;
+    int taps = factor * tapsPerFactor + 1;
+    Vector<float> coef;
+    coef.resize(taps);
+    calculateLowPassFIRCoeffs(coef.data(), taps, 0.45f / factor);
+    Vector<T> coefT;
+    coefT.resize(taps);
+    for (int j = 0; j < taps; j++) coefT[j] = coef[j];
+    return begin(factor, coefT.data(), taps);
+  }
+
+  /// Defines the decimation factor and the filter coefficients
+  bool begin(int factor, const T* coef, int taps) {
+    if (factor <= 0 || taps <= 0) {
+      LOGE("Invalid factor %d or taps %d", factor, taps);
+      return false;
+    }
+    this->factor = factor;
+    // stored in reverse order to match the oldest first delay line
+    coeff.resize(taps);
+    for (int j = 0; j < taps; j++) coeff[j] = coef[taps - 1 - j];
+    delay.resize(taps);
+    reset();
+    return true;
+  }
+
+  void reset() {
+    delay.reset();
+    phase = 0;
+  }
+
+  /// Processes len input samples and returns the number of output samples
+  /// written to out (at most len / factor + 1). out may be the same as in.
+  size_t process(const T* in, T* out, size_t len) {
+    size_t result = 0;
+    const int taps = coeff.size();
+    for (size_t j = 0; j < len; j++) {
+      delay.write(in[j]);
+      if (++phase == factor) {
+        phase = 0;
+        out[result++] = dotProduct(coeff.data(), delay.data(), taps);
+      }
+    }
+    return result;
+  }
+
+  int getFactor() { return factor; }
+
+ protected:
+  Vector<T> coeff;
+  FIRDelayLine<T> delay;
+  int factor = 1;
+  int phase = 0;
+};
+
+/**
+ * @brief FIR filter which increases the sample rate by an integer factor
+ * (upsampling + anti-imaging low-pass) in polyphase form: instead of
+ * filtering the zero stuffed signal, each output phase k uses only the
+ * coefficients h[k + m * factor] that hit real input samples. The cost per
+ * output sample is taps / factor multiply-adds. The gain is scaled by factor
+ * to compensate for the inserted zeros.
+ * @ingroup filter
+ * @tparam T sample type (float or double)
+ */
+template <typename T = float>
+class InterpolatingFIR {
+ public:
+  InterpolatingFIR() = default;
+  /// Defines the interpolation factor and designs a default low-pass filter
+  InterpolatingFIR(int factor, int tapsPerFactor = 16) {
+    begin(factor, tapsPerFactor);
+  }
+  /// Defines the interpolation factor and the filter coefficients
+  InterpolatingFIR(int factor, const T* coef, int taps) {
+    begin(factor, coef, taps);
+  }
+
+  /// Designs a Blackman windowed sinc low-pass with factor * tapsPerFactor
+  /// taps and the cutoff slightly below the original Nyquist frequency
+  bool begin(int factor, int tapsPerFactor = 16) {
+    if (factor <= 0) return false;
+    int taps = factor * tapsPerFactor;
+    Vector<float> coef;
+    coef.resize(taps);
+    calculateLowPassFIRCoeffs(coef.data(), taps, 0.45f / factor);
+    Vector<T> coefT;
+    coefT.resize(taps);
+    for (int j = 0; j < taps; j++) coefT[j] = coef[j];
+    return begin(factor, coefT.data(), taps);
+  }
+
+  /// Defines the interpolation factor and the filter coefficients (designed
+  /// for the output sample rate)
+  bool begin(int factor, const T* coef, int taps) {
+    if (factor <= 0 || taps <= 0) {
+      LOGE("Invalid factor %d or taps %d", factor, taps);
+      return false;
+    }
+    this->factor = factor;
+    phase_len = (taps + factor - 1) / factor;
+    // phase k: reversed h[k + m * factor] * factor, zero padded
+    coeff.resize(factor * phase_len);
+    for (int k = 0; k < factor; k++) {
+      T* phase_coeff = &coeff[k * phase_len];
+      for (int m = 0; m < phase_len; m++) {
+        int idx = k + m * factor;
+        phase_coeff[phase_len - 1 - m] =
+            idx < taps ? T(coef[idx] * factor) : T(0);
+      }
+    }
+    delay.resize(phase_len);
+    reset();
+    return true;
+  }
+
+  void reset() { delay.reset(); }
+
+  /// Processes len input samples and writes len * factor samples to out
+  /// (which must not overlap with in). Returns the number of output samples.
+  size_t process(const T* in, T* out, size_t len) {
+    size_t result = 0;
+    for (size_t j = 0; j < len; j++) {
+      delay.write(in[j]);
+      const T* data = delay.data();
+      for (int k = 0; k < factor; k++) {
+        out[result++] = dotProduct(&coeff[k * phase_len], data, phase_len);
+      }
+    }
+    return result;
+  }
+
+  int getFactor() { return factor; }
+
+ protected:
+  Vector<T> coeff;
+  FIRDelayLine<T> delay;
+  int factor = 1;
+  int phase_len = 0;
+};
+
+}  // namespace audio_tools
@@ -66,13 +66,72 @@ class MetaDataICY : public AbstractMetaData {
   /// corresponding callbacks
   virtual size_t write(const uint8_t* data, size_t len) override {
     if (callback != nullptr) {
-      for (size_t j = 0; j < len; j++) {
-        processChar((char)data[j]);
-      }
+      processBlock(data, nullptr, len);
     }
     return len;
   }
 
+  /// Block based alternative to processChar(): splits len bytes into audio
+  /// and metadata. The audio runs are copied with memmove to out (which may
+  /// be identical to in for in place stripping, or nullptr if the audio is
+  /// not needed) and only the size byte and the metadata are processed by
+  /// the state engine. Returns the number of audio bytes.
+  virtual size_t processBlock(const uint8_t* in, uint8_t* out, size_t len) {
+    if (!hasMetaData()) {
+      if (out != nullptr && out != in) memmove(out, in, len);
+      return len;
+    }
+    size_t pos = 0;
+    size_t result = 0;
+    while (pos < len) {
+      int available = len - pos;
+      switch (nextStatus) {
+        case ProcessData: {
+          int n = dataRemaining();
+          if (n > available) n = available;
+          if (out != nullptr && out + result != in + pos) {
+            memmove(out + result, in + pos, n);
+          }
+          processData(in + pos, n);
+          currentStatus = ProcessData;
+          totalData += n;
+          if (totalData >= mp3_blocksize) {
+            LOGI("Data ended")
+            totalData = 0;
+            nextStatus = SetupSize;
+          }
+          pos += n;
+          result += n;
+        } break;
+
+        case SetupSize:
+          processChar(in[pos++]);
+          break;
+
+        case ProcessMetaData: {
+          int n = metaDataLen - metaDataPos;
+          if (n > available) n = available;
+          memcpy(metaData.data() + metaDataPos, in + pos, n);
+          metaDataPos += n;
+          pos += n;
+          currentStatus = ProcessMetaData;
+          if (metaDataPos >= metaDataLen) {
+            processMetaData(metaData.data(), metaDataLen);
+            LOGI("Metadata ended")
+            nextStatus = ProcessData;
+          }
+        } break;
+      }
+    }
+    return result;
+  }
+
+  /// Number of audio bytes until the next metadata size byte: 0 if we are
+  /// currently not processing audio data
+  int dataRemaining() {
+    return nextStatus == ProcessData ? mp3_blocksize - totalData : 0;
+  }
+
   /// Returns the actual status of the state engine for the current byte
   virtual Status status() { return currentStatus; }
 
@@ -266,6 +325,13 @@ class MetaDataICY : public AbstractMetaData {
       }
     }
   }
+
+  /// Block version of processData(char)
+  virtual void processData(const uint8_t* data, int len) {
+    if (dataBuffer != nullptr) {
+      for (int j = 0; j < len; j++) processData((char)data[j]);
+    }
+  }
 };
 
 /**
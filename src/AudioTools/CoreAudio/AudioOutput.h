@@ -1,11 +1,9 @@
 #pragma once
+#include "AudioTools/CoreAudio/AudioBasic/MixAccumulator.h"
 #include "AudioTools/CoreAudio/AudioTypes.h"
 #include "AudioTools/CoreAudio/BaseConverter.h"
 #include "AudioTools/CoreAudio/Buffers.h"
 #include "AudioToolsConfig.h"
-#if defined(USE_ESP32_DSP)
-#include "esp_dsp.h"
-#endif
 
 namespace audio_tools {
 
@@ -357,6 +355,10 @@ class HexDumpOutput : public AudioOutput {
  * @note All input streams must have the same sample format (bit depth, sample
  * rate).
  * @note The mixer normalizes output by dividing by the total weight sum.
+ * Weight changes are faded over setRampSamples() samples to avoid clicks.
+ * @note The data is mixed in blocks directly from the ring buffers with an
+ * integer accumulator for int16_t (and for int24_t/int32_t with
+ * PREFER_FIXEDPOINT): see MixAccumulator.
  * @note In auto-index mode, ensure you write to all streams in each cycle for
  * proper mixing.
  *
@@ -366,47 +368,6 @@ class HexDumpOutput : public AudioOutput {
  * @tparam T Audio sample data type (e.g., int16_t, int32_t, float)
  */
 
-/**
- * @brief Applies a normalized [0,1] mixing gain to a full-range sample T,
- * used by OutputMixer and InputMixer. The default (float) multiply works
- * for any T, including T=float. Specialized for T=int16_t/int24_t/int32_t
- * under PREFER_FIXEDPOINT to go through q1_14_t::scale() (integer-only)
- * instead of a per-sample float multiply -- the same technique used for
- * VolumeStream's fixed-point volume path.
- * @ingroup transform
- */
-template <typename T>
-struct MixGain {
-  float value = 0;
-  MixGain() = default;
-  MixGain(float f) : value(f) {}
-  T scale(T sample) const { return static_cast<T>(value * sample); }
-};
-
-#if PREFER_FIXEDPOINT
-template <>
-struct MixGain<int16_t> {
-  q1_14_t value;
-  MixGain() = default;
-  MixGain(float f) : value(f) {}
-  int16_t scale(int16_t sample) const { return value.scale(sample); }
-};
-template <>
-struct MixGain<int24_t> {
-  q1_14_t value;
-  MixGain() = default;
-  MixGain(float f) : value(f) {}
-  int24_t scale(int24_t sample) const { return value.scale(sample); }
-};
-template <>
-struct MixGain<int32_t> {
-  q1_14_t value;
-  MixGain() = default;
-  MixGain(float f) : value(f) {}
-  int32_t scale(int32_t sample) const { return value.scale(sample); }
-};
-#endif
-
 template <typename T = int16_t>
 class OutputMixer : public Print {
  public:
@@ -449,6 +410,10 @@ class OutputMixer : public Print {
     for (int i = 0; i < count; i++) {
       weights[i] = 1.0;
     }
+    gains.resize(count);
+    for (int i = 0; i < count; i++) {
+      gains[i].set(0.0f);
+    }
 
     update_total_weights();
   }
@@ -464,6 +429,10 @@ class OutputMixer : public Print {
     update_total_weights();
   }
 
+  /// Defines the number of samples over which weight changes are faded
+  /// (default 256): 0 applies the changes immediately
+  void setRampSamples(int samples) { ramp_samples = samples; }
+
   /// Starts the processing.
   bool begin(int copy_buffer_size_bytes = DEFAULT_BUFFER_SIZE) {
     is_active = true;
@@ -477,6 +446,7 @@ class OutputMixer : public Print {
   void end() {
     total_weights = 0.0;
     is_active = false;
+    is_mixing = false;
     // release memory for buffers
     free_buffers();
   }
@@ -625,6 +595,8 @@ class OutputMixer : public Print {
 
  protected:
   Vector<float> weights{0, DefaultAllocatorRAM};
+  Vector<MixRamp> gains{0, DefaultAllocatorRAM};
+  MixAccumulator<T> mixer;
   Vector<BaseBuffer<T> *> buffers{0, DefaultAllocatorRAM};
   Allocator &allocator;
   Vector<T> output{0, allocator};
@@ -636,6 +608,8 @@ class OutputMixer : public Print {
   int output_count = 0;
   void *p_memory = nullptr;
   bool is_auto_index = true;
+  bool is_mixing = false;
+  int ramp_samples = 256;
   BaseBuffer<T> *(*create_buffer_cb)(int size,
                                      Allocator &allocator) = create_buffer;
 
@@ -644,43 +618,38 @@ class OutputMixer : public Print {
     return new RingBuffer<T>(sizeBytes / sizeof(T), allocator);
   }
 
-  /// Mixes the samples from all input streams into the output buffer
-  inline void mixSamples(size_t samples) {
-#if defined(USE_ESP32_DSP)
-    // Temporary float buffers for mixing
-    float mix_out[samples] = {0.0f};
-    float temp[samples] = {0.0f};
-
-    for (uint8_t j = 0; j < output_count; j++) {
-        const float factor = weights[j] / total_weights;
-        // Read int16_t samples and convert to float
-        for (uint16_t i = 0; i < samples; i++) {
-            T s = 0;
-            buffers[j]->read(s);
-            temp[i] = static_cast<float>(s) * factor;
-        }
-        // Add to output
-        dsps_add_f32(mix_out, temp, mix_out, samples, 1, 1, 1);
-    }
-    // Convert back to int16_t with clamping
+  /// Mixes the samples from all input streams into the output buffer: the
+  /// data is taken directly from the buffers which support peekReadSpan()
+  /// and the data of muted inputs is just removed
+  void mixSamples(size_t samples) {
     output.resize(samples);
-    for (size_t i = 0; i < samples; i++) {
-        float v = mix_out[i];
-        output[i] = static_cast<T>(v);
-    }
-#else
-    // Fallback: original scalar code
-    output.resize(samples);
-    memset(output.data(), 0, samples * sizeof(T));
+    mixer.clear(samples);
     for (int j = 0; j < output_count; j++) {
-      MixGain<T> factor(weights[j] / total_weights);
-      for (int i = 0; i < samples; i++) {
-        T sample = 0;
-        buffers[j]->read(sample);
-        output[i] += factor.scale(sample);
+      BaseBuffer<T> *p_buffer = buffers[j];
+      if (gains[j].isSilent()) {
+        p_buffer->commitRead(samples);
+        continue;
+      }
+      int pos = 0;
+      while (pos < (int)samples) {
+        int len = 0;
+        T *data = p_buffer->peekReadSpan(len);
+        if (data == nullptr) {
+          // no direct access: the output is used as temporary buffer
+          data = output.data() + pos;
+          len = p_buffer->readArray(data, samples - pos);
+          if (len <= 0) break;
+          mixer.add(data, pos, len, gains[j]);
+        } else {
+          if (len > (int)samples - pos) len = samples - pos;
+          mixer.add(data, pos, len, gains[j]);
+          p_buffer->commitRead(len);
+        }
+        pos += len;
       }
     }
-#endif
+    mixer.read(output.data(), samples);
+    is_mixing = true;
   }
 
   /// Recalculates the total weights for normalization
@@ -689,6 +658,11 @@ class OutputMixer : public Print {
     for (int j = 0; j < weights.size(); j++) {
       total_weights += weights[j];
     }
+    // normalized gains: faded once the mixing has started
+    for (int j = 0; j < gains.size(); j++) {
+      float gain = total_weights > 0.0f ? weights[j] / total_weights : 0.0f;
+      gains[j].setTarget(gain, is_mixing ? ramp_samples : 0);
+    }
   }
 
   /// Allocates ring buffers for all input streams
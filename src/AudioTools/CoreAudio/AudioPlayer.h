@@ -2,6 +2,8 @@
 
 #include "AudioToolsConfig.h"
 #include "AudioTools/AudioCodecs/AudioCodecs.h"
+#include "AudioTools/AudioCodecs/GaplessInfo.h"
+#include "AudioTools/AudioCodecs/SeekIndex.h"
 #include "AudioTools/CoreAudio/AudioBasic/Debouncer.h"
 #include "AudioTools/CoreAudio/AudioLogger.h"
 #include "AudioTools/CoreAudio/AudioMetaData/MetaData.h"
@@ -30,6 +32,8 @@ namespace audio_tools {
  *
  * Features:
  * - Playback control: begin, play, stop, next, previous, setIndex
+ * - Time based seeking with seekMs() for file sources and a SeekIndex
+ * - Gapless playback which removes the encoder delay and padding
  * - PCM and encoded formats via AudioDecoder with dynamic audio info updates
  * - Volume management (0.0–1.0) with pluggable VolumeControl
  * - Auto-fade in/out to avoid pops; optional silence while inactive
@@ -38,8 +42,8 @@ namespace audio_tools {
  * - Callbacks: metadata updates and stream-change notification
  * - Flow control: adjustable copy buffer and optional delay when output is full
  *
- * Pipeline: AudioSource → StreamCopy → EncodedAudioOutput → VolumeStream →
- * FadeStream → Output.
+ * Pipeline: AudioSource → StreamCopy → EncodedAudioOutput → TrimStream →
+ * VolumeStream → FadeStream → Output.
  *
  * Operation model: call copy() regularly (non-blocking) or copyAll() for
  * blocking end-to-end playback.
@@ -119,7 +123,8 @@ class AudioPlayer : public AudioInfoSupport, public VolumeSupport {
     if (p_decoder->isResultPCM()) {
       this->fade.setOutput(output);
       this->volume_out.setOutput(fade);
-      out_decoding.setOutput(&volume_out);
+      this->trim.setOutput(volume_out);
+      out_decoding.setOutput(&trim);
       out_decoding.setDecoder(p_decoder);
     } else {
       out_decoding.setOutput(&output);
@@ -134,7 +139,8 @@ class AudioPlayer : public AudioInfoSupport, public VolumeSupport {
     if (p_decoder->isResultPCM()) {
       this->fade.setOutput(output);
       this->volume_out.setOutput(fade);
-      out_decoding.setOutput(&volume_out);
+      this->trim.setOutput(volume_out);
+      out_decoding.setOutput(&trim);
       out_decoding.setDecoder(p_decoder);
     } else {
       out_decoding.setOutput(&output);
@@ -149,7 +155,8 @@ class AudioPlayer : public AudioInfoSupport, public VolumeSupport {
     if (p_decoder->isResultPCM()) {
       this->fade.setOutput(output);
       this->volume_out.setOutput(fade);
-      out_decoding.setOutput(&volume_out);
+      this->trim.setOutput(volume_out);
+      out_decoding.setOutput(&trim);
       out_decoding.setDecoder(p_decoder);
     } else {
       out_decoding.setOutput(&output);
@@ -198,7 +205,7 @@ class AudioPlayer : public AudioInfoSupport, public VolumeSupport {
     if (index >= 0) {
       setStream(p_source->selectStream(index));
       if (p_input_stream != nullptr) {
-        if (meta_active) {
+        if (meta_active || p_seek_index != nullptr || is_gapless) {
           copier.setCallbackOnWrite(decodeMetaData, this);
         }
         copier.begin(out_decoding, *p_input_stream);
@@ -262,6 +269,7 @@ class AudioPlayer : public AudioInfoSupport, public VolumeSupport {
     LOGI("channels: %d", (int)info.channels);
     this->info = info;
     // notifiy volume
+    trim.setAudioInfo(info);
     volume_out.setAudioInfo(info);
     fade.setAudioInfo(info);
     // notifiy final ouput: e.g. i2s
@@ -349,22 +357,87 @@ class AudioPlayer : public AudioInfoSupport, public VolumeSupport {
   bool setStream(Stream* input) {
     end();
     out_decoding.begin();
-    p_input_stream = input;
-    eof_called = false;  // reset EOF state for new stream
-    if (p_input_stream != nullptr) {
-      LOGD("open selected stream");
-      meta_out.begin();
-      copier.begin(out_decoding, *p_input_stream);
-    }
-    // execute callback if defined
-    if (on_stream_change_callback != nullptr)
-      on_stream_change_callback(p_input_stream, p_reference);
-    return p_input_stream != nullptr;
+    return openStream(input);
   }
 
   /// Returns the currently active input Stream (e.g., file)
   Stream* getStream() { return p_input_stream; }
 
+  /// Defines the format specific SeekIndex which is used by seekMs(): it is
+  /// also extended with the played data. The index of the actual file can be
+  /// restored with load() in the stream change callback and stored with
+  /// save() in the EOF callback. The player defines the path and size of
+  /// each file as key: a key defined with SeekIndex::setFileKey() for the
+  /// same path (e.g. with a modification time) is kept.
+  void setSeekIndex(SeekIndex& index) {
+    p_seek_index = &index;
+    p_seek_index->reset();
+    if (p_input_stream != nullptr) {
+      p_seek_index->setDefaultFileKey(p_source->toStr(),
+                                      p_source->streamSize());
+    }
+    copier.setCallbackOnWrite(decodeMetaData, this);
+  }
+
+  /// Provides the SeekIndex: nullptr if not defined
+  SeekIndex* getSeekIndex() { return p_seek_index; }
+
+  /// Total playing time of the actual stream in ms: 0 if not known. This
+  /// needs a SeekIndex and an AudioSource which supports seek()
+  uint32_t durationMs() {
+    if (p_seek_index == nullptr || p_input_stream == nullptr) return 0;
+    size_t size = p_source->streamSize();
+    if (size == 0) return 0;
+    SourceSeek src(*p_source, *p_input_stream);
+    uint32_t result = p_seek_index->durationMs(src, size);
+    // continue where we stopped
+    p_source->seek(stream_pos);
+    return result;
+  }
+
+  /// Jumps to the indicated playback time in the actual stream. This needs
+  /// a SeekIndex for the format and an AudioSource which supports seek()
+  bool seekMs(uint32_t timeMs) {
+    TRACED();
+    if (p_seek_index == nullptr || p_input_stream == nullptr) {
+      LOGE("seekMs: no SeekIndex or stream");
+      return false;
+    }
+    size_t size = p_source->streamSize();
+    if (size == 0) {
+      LOGE("seekMs: not supported by the AudioSource");
+      return false;
+    }
+    // end silently
+    if (is_auto_fade) {
+      fade.setFadeOutActive(true);
+      copier.copy();
+    }
+    SourceSeek src(*p_source, *p_input_stream);
+    size_t pos = 0;
+    bool result = p_seek_index->findPosition(src, size, timeMs, pos);
+    if (result) {
+      LOGI("seekMs: %u ms -> %u", (unsigned)timeMs, (unsigned)pos);
+      // restart the decoder and provide the header again
+      p_decoder->begin();
+      writeHeader(src, p_seek_index->headerSize());
+      result = p_source->seek(pos);
+      if (result) {
+        stream_pos = pos;
+        // the encoder delay is only relevant at the beginning
+        uint64_t frame = (uint64_t)timeMs * info.sample_rate / 1000;
+        uint64_t end = gapless_info.samples;
+        trim.setTrim(0, end > frame ? end - frame : 0);
+      }
+    } else {
+      p_source->seek(stream_pos);
+    }
+    if (is_auto_fade) fade.setFadeInActive(true);
+    timeout = millis() + p_source->timeoutAutoNext();
+    eof_called = false;
+    return result;
+  }
+
   /// Checks whether playback is active
   bool isActive() { return active; }
 
@@ -415,6 +488,24 @@ class AudioPlayer : public AudioInfoSupport, public VolumeSupport {
   /// Enables/disables auto-advance at end/timeout (overrides AudioSource)
   void setAutoNext(bool next) { autonext = next; }
 
+  /// Activates gapless playback: at the end of a stream with a known size
+  /// the next stream is opened and decoded in the same copy() call without
+  /// fading, and the encoder delay and padding (LAME or iTunSMPB tag) are
+  /// removed, so that the tracks are spliced sample accurately. The decoder
+  /// is not restarted between the streams, so they must all have the same
+  /// format.
+  void setGapless(bool flag) {
+    is_gapless = flag;
+    if (flag) copier.setCallbackOnWrite(decodeMetaData, this);
+  }
+
+  /// Returns true if gapless playback is active
+  bool isGapless() { return is_gapless; }
+
+  /// Provides the encoder delay and padding of the actual stream: e.g. to
+  /// change the decoder delay
+  GaplessInfo& gaplessInfo() { return gapless_info; }
+
   /// Sets delay (ms) to wait when output is full
   void setDelayIfOutputFull(int delayMs) { delay_if_full = delayMs; }
 
@@ -449,6 +540,16 @@ class AudioPlayer : public AudioInfoSupport, public VolumeSupport {
 
       // handle sound
       result = copier.copyBytes(bytes);
+
+      // gapless: continue with the next stream without waiting for the
+      // timeout
+      if (is_gapless && isStreamEnd()) {
+        nextGapless();
+        if (active && result < bytes) {
+          result += copier.copyBytes(bytes - result);
+        }
+      }
+
       if (result > 0 || timeout == 0) {
         // reset timeout if we had any data
         timeout = millis() + p_source->timeoutAutoNext();
@@ -568,6 +669,7 @@ class AudioPlayer : public AudioInfoSupport, public VolumeSupport {
   AudioSource* p_source = nullptr;
   VolumeStream volume_out;  // Volume control
   FadeStream fade;          // Phase in / Phase Out to avoid popping noise
+  TrimStream trim;          // Removes the encoder delay and padding
   MetaDataID3 meta_out;     // Metadata parser
   EncodedAudioOutput out_decoding;  // Decoding stream
   CopyDecoder no_decoder{true};
@@ -591,6 +693,104 @@ class AudioPlayer : public AudioInfoSupport, public VolumeSupport {
   // EOF callback and guard (invoked once when current stream reaches end)
   void (*on_eof_callback)(AudioPlayer& player) = nullptr;
   bool eof_called = false;
+  SeekIndex* p_seek_index = nullptr;
+  // read position in the actual stream
+  size_t stream_pos = 0;
+  bool is_gapless = false;
+  GaplessInfo gapless_info;
+
+  /// SeekableSource for the SeekIndex which uses the actual stream
+  struct SourceSeek : public SeekableSource {
+    SourceSeek(AudioSource& source, Stream& stream) {
+      p_source = &source;
+      p_stream = &stream;
+    }
+    bool seek(size_t pos) override { return p_source->seek(pos); }
+    size_t readBytes(uint8_t* data, size_t len) override {
+      return p_stream->readBytes(data, len);
+    }
+    AudioSource* p_source;
+    Stream* p_stream;
+  };
+
+  /// Provides the first len bytes of the stream to the decoder
+  void writeHeader(SeekableSource& src, size_t len) {
+    if (len == 0 || !src.seek(0)) return;
+    uint8_t buffer[128];
+    while (len > 0) {
+      size_t n = src.readBytes(buffer, len < sizeof(buffer) ? len : sizeof(buffer));
+      if (n == 0) break;
+      out_decoding.write(buffer, n);
+      len -= n;
+    }
+  }
+
+  /// Opens the provided Stream as input for the running decoder
+  bool openStream(Stream* input) {
+    p_input_stream = input;
+    eof_called = false;  // reset EOF state for new stream
+    stream_pos = 0;
+    if (p_seek_index != nullptr) {
+      p_seek_index->reset();
+      p_seek_index->setDefaultFileKey(p_source->toStr(),
+                                      p_source->streamSize());
+    }
+    if (p_input_stream != nullptr) {
+      LOGD("open selected stream");
+      meta_out.begin();
+      copier.begin(out_decoding, *p_input_stream);
+    }
+    setupGapless();
+    // execute callback if defined
+    if (on_stream_change_callback != nullptr)
+      on_stream_change_callback(p_input_stream, p_reference);
+    return p_input_stream != nullptr;
+  }
+
+  /// Determines the encoder delay and padding of the actual stream
+  void setupGapless() {
+    gapless_info.clear();
+    size_t size = 0;
+    if (is_gapless && p_input_stream != nullptr) size = p_source->streamSize();
+    if (size > 0) {
+      SourceSeek src(*p_source, *p_input_stream);
+      gapless_info.parse(src, size);
+      p_source->seek(0);
+    }
+    trim.setTrim(gapless_info.delay, gapless_info.samples);
+  }
+
+  /// Returns true if all data of a stream with a known size has been copied
+  bool isStreamEnd() {
+    if (p_input_stream == nullptr) return false;
+    size_t size = p_source->streamSize();
+    return size > 0 && stream_pos >= size;
+  }
+
+  /// Moves to the next stream without fading
+  void nextGapless() {
+    if (!eof_called) {
+      eof_called = true;
+      if (on_eof_callback != nullptr) on_eof_callback(*this);
+    }
+    if (!autonext) {
+      active = false;
+      return;
+    }
+    LOGI("-> end of stream - moving by %d", stream_increment);
+    Stream* next = p_source->nextStream(stream_increment);
+    if (next != nullptr) {
+      // the decoder keeps its state, so frames which depend on the previous
+      // data (e.g. the MP3 bit reservoir) are decoded and the output is not
+      // restarted
+      meta_out.end();
+      active = openStream(next);
+    } else {
+      active = setStream(nullptr);
+      // the end of the last stream was already reported
+      eof_called = true;
+    }
+  }
 
   void setupFade() {
     if (p_final_print != nullptr) {
@@ -642,13 +842,17 @@ class AudioPlayer : public AudioInfoSupport, public VolumeSupport {
     eof_called = false;  // prepare for next stream
   }
 
-  /// Callback implementation which writes to metadata
+  /// Callback implementation which writes to metadata and the SeekIndex
   static void decodeMetaData(void* obj, void* data, size_t len) {
     LOGD("%s, %zu", LOG_METHOD, len);
     AudioPlayer* p = (AudioPlayer*)obj;
     if (p->meta_active) {
       p->meta_out.write((const uint8_t*)data, len);
     }
+    if (p->p_seek_index != nullptr) {
+      p->p_seek_index->addData(p->stream_pos, (const uint8_t*)data, len);
+    }
+    p->stream_pos += len;
   }
 };
 
@@ -1108,6 +1108,109 @@ class ProgressStream : public ModifyingStream {
   }
 };
 
+/**
+ * @brief Removes the indicated number of frames at the beginning and limits
+ * the data to the indicated number of frames: e.g. to remove the encoder delay
+ * and padding of a decoded track for gapless playback. The counting is
+ * restarted with setTrim().
+ * @ingroup io
+ * @author Phil Schatzmann
+ * @copyright GPLv3
+ */
+class TrimStream : public ModifyingStream {
+ public:
+  TrimStream() = default;
+
+  TrimStream(Print &print) { setOutput(print); }
+
+  TrimStream(Stream &stream) { setStream(stream); }
+
+  void setStream(Stream &stream) override {
+    p_stream = &stream;
+    p_print = &stream;
+  }
+
+  void setOutput(Print &print) override { p_print = &print; }
+
+  /// Defines the frames which are skipped at the beginning and the max number
+  /// of frames which are passed on (0 = unlimited)
+  void setTrim(uint64_t skipFrames, uint64_t maxFrames = 0) {
+    skip_frames = skipFrames;
+    max_frames = maxFrames;
+    byte_pos = 0;
+  }
+
+  /// Number of processed bytes since the last setTrim()
+  uint64_t processedBytes() { return byte_pos; }
+
+  /// Provides the data without the trimmed frames
+  size_t readBytes(uint8_t *data, size_t len) override {
+    if (p_stream == nullptr) return 0;
+    size_t result = 0;
+    // skip the data at the beginning
+    while (result == 0) {
+      size_t n = p_stream->readBytes(data, len);
+      if (n == 0) break;
+      size_t offset = 0;
+      result = range(n, offset);
+      byte_pos += n;
+      if (result > 0 && offset > 0) memmove(data, data + offset, result);
+      if (result == 0 && byte_pos >= endPos()) break;
+    }
+    return result;
+  }
+
+  int available() override {
+    if (p_stream == nullptr) return 0;
+    return p_stream->available();
+  }
+
+  /// Writes the data which is not trimmed: the trimmed data is consumed
+  size_t write(const uint8_t *data, size_t len) override {
+    if (p_print == nullptr) return 0;
+    size_t offset = 0;
+    size_t n = range(len, offset);
+    size_t result = len;
+    if (n > 0) {
+      size_t written = p_print->write(data + offset, n);
+      if (written < n) result = offset + written;
+    }
+    byte_pos += result;
+    return result;
+  }
+
+  int availableForWrite() override {
+    if (p_print == nullptr) return 0;
+    return p_print->availableForWrite();
+  }
+
+ protected:
+  Stream *p_stream = nullptr;
+  Print *p_print = nullptr;
+  uint64_t skip_frames = 0;
+  uint64_t max_frames = 0;
+  uint64_t byte_pos = 0;
+
+  uint64_t frameSize() { return info.channels * info.bits_per_sample / 8; }
+
+  uint64_t startPos() { return skip_frames * frameSize(); }
+
+  uint64_t endPos() {
+    return max_frames == 0 ? UINT64_MAX : startPos() + max_frames * frameSize();
+  }
+
+  /// Determines the part of the next len bytes which is not trimmed
+  size_t range(size_t len, size_t &offset) {
+    offset = 0;
+    if (frameSize() == 0) return len;
+    uint64_t from = max(byte_pos, startPos());
+    uint64_t to = min(byte_pos + len, endPos());
+    if (from >= to) return 0;
+    offset = from - byte_pos;
+    return to - from;
+  }
+};
+
 /**
  * @brief Configure Throttle setting
  * @author Phil Schatzmann
@@ -1247,10 +1350,15 @@ class Throttle : public ModifyingStream {
 /**
  * @brief MixerStream is mixing the input from Multiple Input Streams.
  * All streams must have the same audo format (sample rate, channels, bits per
- * sample).
+ * sample). The data is mixed in blocks with the MixAccumulator (int16_t,
+ * and int24_t/int32_t with PREFER_FIXEDPOINT, use an integer accumulator)
+ * and weight changes are faded over setRampSamples() samples.
  * @ingroup transform
  * @author Phil Schatzmann
  * @copyright GPLv3
+ * @tparam T sample type
+ * @tparam SumT ignored: only kept for source compatibility, the accumulator
+ * type is defined by MixAccumulator<T>
  */
 
 template <typename T=int16_t, typename SumT=float>
@@ -1262,6 +1370,7 @@ class InputMixer : public AudioStream {
   int add(Stream &in, int weight = 100) {
     streams.push_back(&in);
     weights.push_back(weight);
+    gains.push_back(MixRamp());
     recalculateWeights();
     return streams.indexOf(&in);
   }
@@ -1296,14 +1405,18 @@ class InputMixer : public AudioStream {
     }
   }
 
+  /// Defines the number of samples over which weight changes are faded
+  /// (default 256): 0 applies the changes immediately
+  void setRampSamples(int samples) { ramp_samples = samples; }
+
   /// Remove all input streams
   void end() override {
     streams.clear();
     weights.clear();
     gains.clear();
-    result_vect.clear();
     current_vect.clear();
     total_weights = 0.0;
+    is_mixing = false;
   }
 
   /// Number of stremams to which are mixed together
@@ -1355,6 +1468,7 @@ class InputMixer : public AudioStream {
     }
     streams.erase(idx);
     weights.erase(idx);
+    gains.erase(idx);
     recalculateWeights();
     return true;
   }
@@ -1367,6 +1481,7 @@ class InputMixer : public AudioStream {
       rc = true;
       streams.erase(idx);
       weights.erase(idx);
+      gains.erase(idx);
       idx = nextEmptyIndex();
     }
     recalculateWeights();
@@ -1395,12 +1510,14 @@ class InputMixer : public AudioStream {
  protected:
   Vector<Stream *> streams{0};
   Vector<int> weights{0};
-  Vector<float> gains{0};
+  Vector<MixRamp> gains{0};
   int total_weights = 0;
   int frame_size = 4;
   bool limit_available_data = false;
   int retry_count = 5;
-  Vector<SumT> result_vect;
+  bool is_mixing = false;
+  int ramp_samples = 256;
+  MixAccumulator<T> mixer;
   Vector<T> current_vect;
 
   /// Recalculate the weights
@@ -1410,32 +1527,31 @@ class InputMixer : public AudioStream {
       total += weights[j];
     }
     total_weights = total;
-    gains.resize(weights.size());
-    for (int j = 0; j < weights.size(); j++) {
-      gains[j] = total_weights == 0 ? 0.0f : static_cast<float>(weights[j]) / total_weights;
+    // normalized gains: faded once the mixing has started
+    for (int j = 0; j < gains.size(); j++) {
+      float gain = total_weights == 0
+                       ? 0.0f
+                       : static_cast<float>(weights[j]) / total_weights;
+      gains[j].setTarget(gain, is_mixing ? ramp_samples : 0);
     }
   }
 
-  /// mixing using a vector of samples
+  /// mixing using a vector of samples: muted streams are not read
   int readBytesVector(T *p_data, int byteCount) {
     int samples = byteCount / sizeof(T);
-    if (result_vect.size() < samples) result_vect.resize(samples);
     if (current_vect.size() < samples) current_vect.resize(samples);
     int stream_count = size();
-    resultClear(samples);
+    mixer.clear(samples);
     int samples_eff_max = 0;
     for (int j = 0; j < stream_count; j++) {
-      if (weights[j] > 0) {
-        int samples_eff =
-            readSamples(streams[j], current_vect.data(), samples, retry_count);
-        if (samples_eff > samples_eff_max) samples_eff_max = samples_eff;
-        resultAdd(MixGain<T>(gains[j]), samples_eff);
-      }
-    }
-    // copy result
-    for (int j = 0; j < samples_eff_max; j++) {
-      p_data[j] = static_cast<T>(result_vect[j]);
-    }
+      if (gains[j].isSilent()) continue;
+      int samples_eff =
+          readSamples(streams[j], current_vect.data(), samples, retry_count);
+      if (samples_eff > samples_eff_max) samples_eff_max = samples_eff;
+      mixer.add(current_vect.data(), 0, samples_eff, gains[j]);
+    }
+    mixer.read(p_data, samples_eff_max);
+    is_mixing = true;
     return samples_eff_max * sizeof(T);
   }
 
@@ -1447,17 +1563,6 @@ class InputMixer : public AudioStream {
     }
     return result;
   }
-
-  void resultAdd(MixGain<T> factor, int samples_eff) {
-    // only accumulate samples that were actually read; tail is already zeroed
-    for (int j = 0; j < samples_eff; j++) {
-      result_vect[j] += static_cast<SumT>(factor.scale(current_vect[j]));
-    }
-  }
-
-  void resultClear(int samples) {
-    memset(result_vect.data(), 0, sizeof(SumT) * samples);
-  }
 };
 
 /**
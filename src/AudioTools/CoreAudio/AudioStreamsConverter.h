@@ -386,9 +386,11 @@ class NumberFormatConverterStreamT : public ReformatBaseStream {
     // addNotifyOnFirstWrite();
 
 #ifdef USE_TYPETRAITS
-    if (std::is_same<TFrom, TTo>::value) return p_print->write(data, len);
+    if (std::is_same<TFrom, TTo>::value && gain == 1.0f)
+      return p_print->write(data, len);
 #else
-    if (sizeof(TFrom) == sizeof(TTo)) return p_print->write(data, len);
+    if (sizeof(TFrom) == sizeof(TTo) && gain == 1.0f)
+      return p_print->write(data, len);
 #endif
 
     size_t samples = len / sizeof(TFrom);
@@ -396,9 +398,13 @@ class NumberFormatConverterStreamT : public ReformatBaseStream {
     TFrom* data_source = (TFrom*)data;
 
     if (!is_buffered) {
-      for (size_t j = 0; j < samples; j++) {
-        TTo value = NumberConverter::convert<TFrom, TTo>(data_source[j]);
-        result_size += p_print->write((uint8_t*)&value, sizeof(TTo));
+      // convert in chunks on the stack: no allocation and one write per chunk
+      TTo chunk[NFC_CHUNK_SAMPLES];
+      for (size_t j = 0; j < samples; j += NFC_CHUNK_SAMPLES) {
+        size_t n = min(samples - j, (size_t)NFC_CHUNK_SAMPLES);
+        NumberConverter::convertArray<TFrom, TTo>(data_source + j, chunk, n,
+                                                  gain);
+        result_size += p_print->write((uint8_t*)chunk, n * sizeof(TTo));
       }
     } else {
       int size_bytes = sizeof(TTo) * samples;
@@ -417,12 +423,14 @@ class NumberFormatConverterStreamT : public ReformatBaseStream {
     if (p_stream == nullptr) return 0;
     size_t samples = len / sizeof(TTo);
     TTo* data_target = (TTo*)data;
-    TFrom source;
     if (!is_buffered) {
-      for (size_t j = 0; j < samples; j++) {
-        source = 0;
-        p_stream->readBytes((uint8_t*)&source, sizeof(TFrom));
-        data_target[j] = NumberConverter::convert<TFrom, TTo>(source);
+      // read and convert in chunks on the stack
+      TFrom chunk[NFC_CHUNK_SAMPLES];
+      for (size_t j = 0; j < samples; j += NFC_CHUNK_SAMPLES) {
+        size_t n = min(samples - j, (size_t)NFC_CHUNK_SAMPLES);
+        n = readSamples<TFrom>(p_stream, chunk, n);
+        NumberConverter::convertArray<TFrom, TTo>(chunk, data_target + j, n,
+                                                  gain);
       }
     } else {
       buffer.resize(sizeof(TFrom) * samples);
@@ -443,11 +451,12 @@ class NumberFormatConverterStreamT : public ReformatBaseStream {
     return p_print == nullptr ? 0 : p_print->availableForWrite();
   }
 
-  /// if set to true we do one big write, else we get a lot of single writes per
-  /// sample
+  /// if set to true we convert all data in one allocated buffer and do one
+  /// big write, else the data is streamed in chunks of NFC_CHUNK_SAMPLES
+  /// samples on the stack
   void setBuffered(bool flag) { is_buffered = flag; }
 
-  /// Defines the gain (only available when buffered is true)
+  /// Defines the gain: the result is saturated to the range of TTo
   void setGain(float value) { gain = value; }
 
   float getByteFactor() override {
@@ -7,6 +7,7 @@
 #endif
 
 #include "AudioTools/CoreAudio/AudioBasic/Collections/Vector.h"
+#include "AudioTools/CoreAudio/AudioBasic/SampleFormat.h"
 #include "AudioTools/CoreAudio/AudioBasic/int24_t.h"
 #include "AudioTools/CoreAudio/AudioLogger.h"
 // Some top level functions: stop(), checkMemory()
@@ -395,10 +396,12 @@ class NumberConverter {
     return value1 * maxValueT<ToT>() / maxValueT<FromT>();
   }
 
-  /// Convert an array of int types
+  /// Convert an array of int types: the types which are supported by
+  /// SampleFormat are converted in blocks with convertSamples()
   template <typename FromT, typename ToT>
   static void convertArray(FromT* from, ToT* to, int samples,
                            float vol = 1.0f) {
+    if (convertSamples<FromT, ToT>(from, to, samples, vol)) return;
     // convert() already maps FromT range to ToT range. Apply only the gain
     // and clip to the valid ToT range to avoid double scaling.
     for (int j = 0; j < samples; j++) {
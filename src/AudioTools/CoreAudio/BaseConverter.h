@@ -1,6 +1,7 @@
 #pragma once
 #include "AudioToolsConfig.h"
 #include "AudioFilter/Filter.h"
+#include "AudioFilter/PolyphaseFIR.h"
 #include "AudioTools/CoreAudio/AudioBasic/Collections.h"
 #include "AudioTools/CoreAudio/AudioBasic/q1_14_t.h"
 #include "AudioTools/CoreAudio/AudioBasic/soft_float_t.h"
@@ -645,6 +646,103 @@ class DecimateT : public BaseConverter {
   uint16_t count = 0;
 };
 
+/**
+ * @brief Provides reduced sampling rates like DecimateT, but applies an
+ * anti-aliasing low-pass filter first: each channel is processed with a
+ * DecimatingFIR which only calculates the samples that are kept.
+ * @ingroup convert
+ * @tparam T sample type
+ */
+template <typename T = int16_t>
+class DecimateFIRT : public BaseConverter {
+ public:
+  DecimateFIRT(int factor, int channels, int tapsPerFactor = 16) {
+    this->taps_per_factor = tapsPerFactor;
+    this->factor = factor;
+    setChannels(channels);
+  }
+  ~DecimateFIRT() { clearFilters(); }
+
+  /// Defines the number of channels
+  void setChannels(int channels) {
+    this->channels = channels;
+    setupFilters();
+  }
+
+  /// Sets the factor: e.g. with 4 we keep every fourth (filtered) sample
+  void setFactor(int factor) {
+    this->factor = factor;
+    setupFilters();
+  }
+
+  /// Defines the number of filter taps per factor (default 16): more taps
+  /// give a steeper transition band
+  void setTapsPerFactor(int taps) {
+    this->taps_per_factor = taps;
+    setupFilters();
+  }
+
+  void clear() {
+    for (auto filter : filters) filter->reset();
+  }
+  void reset() { clear(); }
+
+  size_t convert(uint8_t *src, size_t size) { return convert(src, src, size); }
+
+  size_t convert(uint8_t *target, uint8_t *src, size_t size) {
+    if (channels <= 0 || factor <= 0 || filters.size() != channels) {
+      LOGE("Invalid config: channels %d, factor %d", channels, factor);
+      return 0;
+    }
+    if (size % (sizeof(T) * channels) > 0) {
+      LOGE("Buffer size %d is not a multiple of the number of channels %d",
+           (int)size, channels);
+      return 0;
+    }
+    int frame_count = size / (sizeof(T) * channels);
+    if (block.size() < frame_count) block.resize(frame_count);
+    T *p_target = (T *)target;
+    T *p_source = (T *)src;
+    float *buffer = block.data();
+    size_t out_frames = 0;
+    // each channel only reads and writes its own slots, so we can work in
+    // place
+    for (int ch = 0; ch < channels; ch++) {
+      for (int j = 0; j < frame_count; j++) {
+        buffer[j] = p_source[j * channels + ch];
+      }
+      out_frames = filters[ch]->process(buffer, buffer, frame_count);
+      for (size_t j = 0; j < out_frames; j++) {
+        p_target[j * channels + ch] = NumberConverter::clipT<T>(buffer[j]);
+      }
+    }
+    return out_frames * channels * sizeof(T);
+  }
+
+  operator bool() { return factor > 1; }
+
+ protected:
+  Vector<DecimatingFIR<float> *> filters;
+  Vector<float> block;
+  int channels = 2;
+  int factor = 1;
+  int taps_per_factor = 16;
+
+  void setupFilters() {
+    clearFilters();
+    if (channels <= 0 || factor <= 0) return;
+    filters.resize(channels);
+    for (int j = 0; j < channels; j++) {
+      filters[j] = new DecimatingFIR<float>(factor, taps_per_factor);
+    }
+  }
+
+  void clearFilters() {
+    for (auto filter : filters) delete filter;
+    filters.clear();
+  }
+};
+
 /**
  * @brief Provides a reduced sampling rate by taking a sample at every factor
  * location (ingoring factor-1 samples)
@@ -1722,9 +1820,7 @@ class Converter1Channel : public BaseConverter {
 
   size_t convert(uint8_t *src, size_t size) override {
     T *data = (T *)src;
-    for (size_t j = 0; j < size; j++) {
-      data[j] = p_filter->process(data[j]);
-    }
+    p_filter->process(data, data, size / sizeof(T));
     return size;
   }
 
@@ -1810,18 +1906,29 @@ class ConverterNChannels : public BaseConverter {
   }
 
 
-  // convert all samples for each channel separately
+  // convert all samples for each channel separately: each channel is
+  // deinterleaved into a block so that we need only one filter call per
+  // channel and buffer
   size_t convert(uint8_t *src, size_t size) {
+    if (channels <= 0) return size;
     int count = size / channels / sizeof(T);
-    T *sample = (T *)src;
-    for (size_t j = 0; j < count; j++) {
-      for (int channel = 0; channel < channels; channel++) {
-        if (filters[channel] != nullptr) {
-          FT in = FilterSampleConverter<T, FT>::toFilterType(*sample);
-          FT out = filters[channel]->process(in);
-          *sample = FilterSampleConverter<T, FT>::fromFilterType(out);
-        }
-        sample++;
+    if (count <= 0) return size;
+    if (block.size() < count) block.resize(count);
+    T *samples = (T *)src;
+    FT *buffer = block.data();
+    for (int channel = 0; channel < channels; channel++) {
+      Filter<FT> *filter = filters[channel];
+      if (filter == nullptr) continue;
+      T *sample = samples + channel;
+      for (int j = 0; j < count; j++) {
+        buffer[j] = FilterSampleConverter<T, FT>::toFilterType(*sample);
+        sample += channels;
+      }
+      filter->process(buffer, buffer, count);
+      sample = samples + channel;
+      for (int j = 0; j < count; j++) {
+        *sample = FilterSampleConverter<T, FT>::fromFilterType(buffer[j]);
+        sample += channels;
       }
     }
     return size;
@@ -1844,6 +1951,7 @@ class ConverterNChannels : public BaseConverter {
 
  protected:
   Vector<Filter<FT> *> filters;
+  Vector<FT> block;
   int channels = 0;
 };
 
@@ -52,6 +52,31 @@ class BaseBuffer {
     return lenResult;
   }
 
+  /// Provides the address of the next contiguous entries which can be read
+  /// without copying and sets len to their number: returns nullptr if this
+  /// is not supported. Call commitRead() when the data has been processed.
+  virtual T *peekReadSpan(int &len) {
+    len = 0;
+    return nullptr;
+  }
+
+  /// Removes the next len entries after they have been processed via
+  /// peekReadSpan()
+  virtual int commitRead(int len) { return clearArray(len); }
+
+  /// Provides the address of the next contiguous free entries which can be
+  /// filled without copying and sets len to their number: returns nullptr if
+  /// this is not supported. Call commitWrite() when the data has been filled
+  /// in.
+  virtual T *peekWriteSpan(int &len) {
+    len = 0;
+    return nullptr;
+  }
+
+  /// Makes the next len entries, which have been filled via peekWriteSpan(),
+  /// available for reading
+  virtual int commitWrite(int len) { return 0; }
+
   /// Fills the buffer data
   virtual int writeArray(const T data[], int len) {
     // LOGD("%s: %d", LOG_METHOD, len);
@@ -193,8 +218,8 @@ class SingleBuffer : public BaseBuffer<T> {
    *
    * @param size in entries
    */
-  SingleBuffer(int size, Allocator &allocator = DefaultAllocator)
-      : _allocator(allocator) {
+  SingleBuffer(int size, Allocator &allocator = DefaultAllocatorRAM)
+      : p_allocator(&allocator) {
     buffer.resize(size);
     reset();
   }
@@ -286,6 +311,34 @@ class SingleBuffer : public BaseBuffer<T> {
     return len;
   }
 
+  /// Provides the unread data
+  T *peekReadSpan(int &len) override {
+    len = available();
+    return len > 0 ? data() : nullptr;
+  }
+
+  /// Consumes len entries without moving the remaining data
+  int commitRead(int len) override {
+    int result = min(len, available());
+    if (result <= 0) return 0;
+    current_read_pos += result;
+    if (current_read_pos == current_write_pos) reset();
+    return result;
+  }
+
+  /// Provides the free space after the written data
+  T *peekWriteSpan(int &len) override {
+    len = availableForWrite();
+    return len > 0 ? buffer.data() + current_write_pos : nullptr;
+  }
+
+  int commitWrite(int len) override {
+    int result = min(len, availableForWrite());
+    if (result <= 0) return 0;
+    current_write_pos += result;
+    return result;
+  }
+
   /// Moves the unprocessed data to the beginning of the buffer
   void trim() {
     int av = available();
@@ -341,12 +394,12 @@ class SingleBuffer : public BaseBuffer<T> {
   uint64_t timestamp = 0;
 
  protected:
-  Allocator _allocator; 
+  Allocator *p_allocator = &DefaultAllocatorRAM;
   int current_read_pos = 0;
   int current_write_pos = 0;
   bool owns_buffer = true;
   bool is_clear_with_zero = false;
-  Vector<T> buffer{0, _allocator};
+  Vector<T> buffer{0, *p_allocator};
 };
 
 /**
@@ -422,6 +475,38 @@ class RingBuffer : public BaseBuffer<T> {
     return to_read;
   }
 
+  /// Provides the data up to the end of the physical buffer: the rest is
+  /// available after the commitRead()
+  T *peekReadSpan(int &len) override {
+    len = min(_numElems, max_size - _iTail);
+    return len > 0 ? _aucBuffer.data() + _iTail : nullptr;
+  }
+
+  int commitRead(int len) override {
+    int result = min(len, available());
+    if (result <= 0) return 0;
+    _iTail = (_iTail + result) % max_size;
+    _numElems -= result;
+    return result;
+  }
+
+  int clearArray(int len) override { return commitRead(len); }
+
+  /// Provides the free space up to the end of the physical buffer: the rest
+  /// is available after the commitWrite()
+  T *peekWriteSpan(int &len) override {
+    len = min(availableForWrite(), max_size - _iHead);
+    return len > 0 ? _aucBuffer.data() + _iHead : nullptr;
+  }
+
+  int commitWrite(int len) override {
+    int result = min(len, availableForWrite());
+    if (result <= 0) return 0;
+    _iHead = (_iHead + result) % max_size;
+    _numElems += result;
+    return result;
+  }
+
   // Bulk write: see readArray() above for why this avoids the inherited
   // per-element BaseBuffer<T>::writeArray() loop.
   virtual int writeArray(const T data[], int len) override {
@@ -751,6 +836,45 @@ class NBuffer : public BaseBuffer<T> {
     return actual_read_buffer->peek(result);
   }
 
+  /// Provides the unread data of the current read block
+  T *peekReadSpan(int &len) override {
+    if (available() == 0) {
+      len = 0;
+      return nullptr;
+    }
+    return actual_read_buffer->peekReadSpan(len);
+  }
+
+  int commitRead(int len) override {
+    if (available() == 0) return 0;
+    return actual_read_buffer->commitRead(len);
+  }
+
+  /// Provides the free space of the current write block
+  T *peekWriteSpan(int &len) override {
+    if (availableForWrite() == 0) {
+      len = 0;
+      return nullptr;
+    }
+    return actual_write_buffer->peekWriteSpan(len);
+  }
+
+  /// Commits the data of the current write block: a full block is made
+  /// available for reading
+  int commitWrite(int len) override {
+    if (actual_write_buffer == nullptr) return 0;
+    int result = actual_write_buffer->commitWrite(len);
+    if (start_time == 0l) {
+      start_time = millis();
+    }
+    sample_count += result;
+    if (actual_write_buffer->isFull()) {
+      addFilledBuffer(actual_write_buffer);
+      actual_write_buffer = getNextAvailableBuffer();
+    }
+    return result;
+  }
+
   /// checks if the buffer is full
   bool isFull() { return availableForWrite() == 0; }
 
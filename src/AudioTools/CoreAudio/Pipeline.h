@@ -10,6 +10,11 @@ namespace audio_tools {
  * @brief We can build a input or an output chain: an input chain starts with
  * setInput(); followed by add() an output chain consinsts of add() and ends
  * with setOutput();
+ * With setStatsActive() we measure the time, the bytes in/out and the
+ * underruns of each component, which can be queried with stats() or printed
+ * periodically with setStatsReport().
+ * Add a PipelineTaskStage to process the following (output chain) or the
+ * preceding (input chain) components in a separate task.
  * @ingroup transform
  * @author Phil Schatzmann
  * @copyright GPLv3
@@ -18,6 +23,28 @@ class Pipeline : public AudioStream {
   friend MultiOutput;
 
  public:
+  /// Measurements of a single component (see setStatsActive())
+  struct StageStats {
+    /// number of write (output chain) or read (input chain) calls
+    uint32_t calls = 0;
+    /// bytes which were passed to the component
+    uint64_t bytes_in = 0;
+    /// bytes which were provided by the component to the next stage
+    uint64_t bytes_out = 0;
+    /// time spent in the component itself (w/o the other stages)
+    uint64_t time_us = 0;
+    /// max duration of a single call (including the downstream/upstream
+    /// stages)
+    uint32_t max_call_us = 0;
+    /// calls which did not process any data
+    uint32_t underruns = 0;
+    /// availableForWrite() (output chain) or available() (input chain) after
+    /// the last call
+    int available = 0;
+    /// min value of available since the last reset
+    int min_available = 0;
+  };
+
   Pipeline() = default;
   ~Pipeline() { end(); }
   ///  adds a component
@@ -116,6 +143,7 @@ class Pipeline : public AudioStream {
 
   /// Defines the input for an input pipeline: must be first call before add()
   bool setInput(Stream& in) {
+    p_input = &in;
     if (has_output) {
       LOGE("Defined as output");
       is_ok = false;
@@ -148,6 +176,11 @@ class Pipeline : public AudioStream {
       return 0;
     }
     LOGD("write: %u", (unsigned)len);
+    if (probes.size() > 0) {
+      size_t result = probes[0]->write(data, len);
+      reportStats();
+      return result;
+    }
     return components[0]->write(data, len);
   }
 
@@ -162,7 +195,9 @@ class Pipeline : public AudioStream {
     if (!is_active) return 0;
     Stream* in = getInput();
     if (in == nullptr) return 0;
-    return in->readBytes(data, len);
+    size_t result = in->readBytes(data, len);
+    reportStats();
+    return result;
   }
 
   /// Optional method: Calls begin on all components and setAudioInfo on first
@@ -199,6 +234,7 @@ class Pipeline : public AudioStream {
     }
 
     setNotifyActive(true);
+    if (is_stats_active) setupProbes();
     is_active = ok;
     is_ok = ok;
     return ok;
@@ -206,6 +242,7 @@ class Pipeline : public AudioStream {
 
   /// Calls end on all components
   void end() override {
+    removeProbes();
     for (auto c : components) {
       c->end();
     }
@@ -221,6 +258,7 @@ class Pipeline : public AudioStream {
     p_out_stream = nullptr;
     p_print = nullptr;
     p_stream = nullptr;
+    p_input = nullptr;
     p_ai_source = nullptr;
     p_ai_input = nullptr;
     is_ok = false;
@@ -283,6 +321,68 @@ class Pipeline : public AudioStream {
   /// Returns true if pipeline is correctly set up and is active
   operator bool() override { return is_ok && is_active; }
 
+  /// Activates the per component measurements: must be called before begin()
+  void setStatsActive(bool flag) { is_stats_active = flag; }
+
+  /// Determines if the per component measurements are active
+  bool isStatsActive() { return is_stats_active; }
+
+  /// Prints the statistics every interval_ms milliseconds to the indicated
+  /// output
+  void setStatsReport(Print& out, uint32_t interval_ms = 1000) {
+    p_report = &out;
+    report_interval_ms = interval_ms;
+    report_time = millis() + interval_ms;
+  }
+
+  /// Provides the measurements of the component with the indicated index
+  StageStats stats(int idx) {
+    StageStats result;
+    if (idx < 0 || idx >= size() || probes.size() != size() + 1) return result;
+    // output chain: probe[idx] feeds the component, probe[idx+1] receives its
+    // output; input chain: probe[idx] is read by the component and probe[idx+1]
+    // reads from it
+    Probe& in = *probes[idx];
+    Probe& out = *probes[idx + 1];
+    Probe& call = has_input ? out : in;
+    Probe& next = has_input ? in : out;
+    result.calls = call.calls;
+    result.bytes_in = in.bytes;
+    result.bytes_out = out.bytes;
+    result.time_us =
+        call.time_us > next.time_us ? call.time_us - next.time_us : 0;
+    result.max_call_us = call.max_call_us;
+    result.underruns = call.underruns;
+    result.available = call.last_available;
+    result.min_available = call.min_available;
+    return result;
+  }
+
+  /// Resets all measurements
+  void resetStats() {
+    for (auto p : probes) p->reset();
+  }
+
+  /// Prints the measurements of all components
+  void printStats(Print& out) {
+    if (probes.size() == 0) {
+      out.println("pipeline: no stats");
+      return;
+    }
+    char msg[160];
+    for (int j = 0; j < size(); j++) {
+      StageStats st = stats(j);
+      snprintf(msg, sizeof(msg),
+               "pipeline[%d]: calls=%u in=%llu out=%llu time_us=%llu "
+               "max_us=%u underruns=%u available=%d min_available=%d",
+               j, (unsigned)st.calls, (unsigned long long)st.bytes_in,
+               (unsigned long long)st.bytes_out,
+               (unsigned long long)st.time_us, (unsigned)st.max_call_us,
+               (unsigned)st.underruns, st.available, st.min_available);
+      out.println(msg);
+    }
+  }
+
  protected:
   Vector<ModifyingStream*> components{0};
   Vector<ModifyingStream*> cleanup{0};
@@ -298,6 +398,120 @@ class Pipeline : public AudioStream {
   AudioOutput* p_out_print = nullptr;
   AudioStream* p_out_stream = nullptr;
   Print* p_print = nullptr;
+  // original input of an input pipeline
+  Stream* p_input = nullptr;
+  // measurements
+  bool is_stats_active = false;
+  Print* p_report = nullptr;
+  uint32_t report_interval_ms = 0;
+  uint32_t report_time = 0;
+
+  /// Measures the calls which pass between two components
+  struct Probe : public AudioStream {
+    Print* p_print = nullptr;
+    Stream* p_stream = nullptr;
+    uint32_t calls = 0;
+    uint64_t bytes = 0;
+    uint64_t time_us = 0;
+    uint32_t max_call_us = 0;
+    uint32_t underruns = 0;
+    int last_available = 0;
+    int min_available = 0;
+
+    void reset() {
+      calls = 0;
+      bytes = 0;
+      time_us = 0;
+      max_call_us = 0;
+      underruns = 0;
+      min_available = last_available;
+    }
+
+    size_t write(const uint8_t* data, size_t len) override {
+      uint32_t start = micros();
+      size_t result = p_print->write(data, len);
+      update(micros() - start, len, result, p_print->availableForWrite());
+      return result;
+    }
+
+    int availableForWrite() override {
+      return p_print == nullptr ? 0 : p_print->availableForWrite();
+    }
+
+    size_t readBytes(uint8_t* data, size_t len) override {
+      uint32_t start = micros();
+      size_t result = p_stream->readBytes(data, len);
+      update(micros() - start, len, result, p_stream->available());
+      return result;
+    }
+
+    int available() override {
+      return p_stream == nullptr ? 0 : p_stream->available();
+    }
+
+   protected:
+    void update(uint32_t us, size_t len, size_t result, int avail) {
+      calls++;
+      bytes += result;
+      time_us += us;
+      if (us > max_call_us) max_call_us = us;
+      if (len > 0 && result == 0) underruns++;
+      last_available = avail;
+      if (calls == 1 || avail < min_available) min_available = avail;
+    }
+  };
+  Vector<Probe*> probes{0};
+
+  /// Inserts a Probe before, between and after the components
+  void setupProbes() {
+    removeProbes();
+    int n = size();
+    if (n == 0) return;
+    if (has_input && p_input == nullptr) return;
+    if (!has_input && p_print == nullptr) return;
+    for (int j = 0; j <= n; j++) {
+      probes.push_back(new Probe());
+    }
+    if (has_input) {
+      for (int j = 0; j <= n; j++) {
+        Stream* src = j == 0 ? p_input : components[j - 1];
+        probes[j]->p_stream = src;
+        if (j < n) components[j]->setStream(*probes[j]);
+      }
+    } else {
+      probes[0]->p_print = components[0];
+      for (int j = 0; j < n; j++) {
+        Print* dest = j + 1 < n ? (Print*)components[j + 1] : p_print;
+        probes[j + 1]->p_print = dest;
+        components[j]->setOutput(*probes[j + 1]);
+      }
+    }
+  }
+
+  /// Restores the direct links between the components
+  void removeProbes() {
+    if (probes.size() > 0) {
+      int n = size();
+      if (has_input) {
+        for (int j = 0; j < n; j++) {
+          components[j]->setStream(*probes[j]->p_stream);
+        }
+      } else {
+        for (int j = 0; j < n; j++) {
+          components[j]->setOutput(*probes[j + 1]->p_print);
+        }
+      }
+    }
+    for (auto p : probes) delete p;
+    probes.clear();
+  }
+
+  void reportStats() {
+    if (p_report == nullptr || probes.size() == 0) return;
+    if ((int32_t)(millis() - report_time) < 0) return;
+    report_time = millis() + report_interval_ms;
+    printStats(*p_report);
+  }
 
   /// Support for ModifyingOutput
   struct ModifyingStreamAdapter : public ModifyingStream {
@@ -332,7 +546,7 @@ class Pipeline : public AudioStream {
   Stream* getInput() {
     Stream* in = p_stream;
     if (size() > 0) {
-      in = &last();
+      in = probes.size() > 0 ? (Stream*)probes[size()] : &last();
     }
     return in;
   }
@@ -0,0 +1,443 @@
+#pragma once
+#include <math.h>
+
+#include "AudioTools/CoreAudio/AudioBasic/Collections/Vector.h"
+#include "AudioTools/CoreAudio/AudioBasic/SIMD.h"
+#include "AudioTools/CoreAudio/ResampleStream.h"
+
+namespace audio_tools {
+
+/**
+ * @brief Quality presets for the SincResampler: a higher quality uses more
+ * filter taps (steeper anti-aliasing filter and better stopband attenuation)
+ * and more precalculated filter phases, so it needs more CPU and memory.
+ * @ingroup transform
+ */
+enum class ResampleQuality { Low, Medium, High, Best };
+
+/**
+ * @brief Bandlimited resampler for an arbitrary ratio using a polyphase
+ * windowed sinc (Kaiser window) filter. The filter coefficients are
+ * precalculated for a fixed number of phases (fractional positions) and the
+ * result is linearly interpolated between the 2 closest phases, so each output
+ * sample costs 2 dot products (see dotProduct() in SIMD.h) per channel.
+ *
+ * The input is provided as planar float data (one array per channel) and the
+ * result is written as interleaved frames. When downsampling, the cutoff
+ * frequency is lowered to the new Nyquist frequency and the filter is widened
+ * accordingly.
+ * @ingroup transform
+ * @author Phil Schatzmann
+ * @copyright GPLv3
+ */
+class SincResampler {
+ public:
+  /// Defines the channels, the step size (input samples per output sample)
+  /// and the quality
+  bool begin(int channels, float stepSize,
+             ResampleQuality quality = ResampleQuality::Medium) {
+    if (channels <= 0 || stepSize <= 0.0f) {
+      LOGE("Invalid channels %d or step size %f", channels, stepSize);
+      return false;
+    }
+    this->channels = channels;
+    this->quality = quality;
+    history.resize(channels);
+    // force the recalculation of the filter
+    step_size = 0.0f;
+    taps = 0;
+    setStepSize(stepSize);
+    reset();
+    return true;
+  }
+
+  /// Changes the step size: the filter is only recalculated if the cutoff
+  /// frequency changes (which only happens when downsampling)
+  void setStepSize(float stepSize) {
+    if (stepSize <= 0.0f || stepSize == step_size) return;
+    step_size = stepSize;
+    int base_taps, phases;
+    float beta, rolloff;
+    getQualityParameters(base_taps, phases, beta, rolloff);
+    // quantize the downsampling factor to 1% to avoid a recalculation for
+    // each small (adaptive) step size change
+    float factor = stepSize > 1.0f ? ceilf(stepSize * 100.0f) / 100.0f : 1.0f;
+    int new_taps = ((int)ceilf(base_taps * factor) + 1) & ~1;
+    float new_cutoff = rolloff / factor;
+    if (new_taps == taps && new_cutoff == cutoff && phases == phase_count) {
+      return;
+    }
+    bool taps_changed = new_taps != taps;
+    taps = new_taps;
+    cutoff = new_cutoff;
+    phase_count = phases;
+    calculateTable(beta);
+    if (taps_changed) reset();
+  }
+
+  float getStepSize() { return step_size; }
+
+  /// Clears the history
+  void reset() {
+    // prefill half a window, so that the first output is aligned with the
+    // first input sample
+    for (int ch = 0; ch < channels; ch++) {
+      history[ch].resize(taps / 2 - 1);
+      for (int j = 0; j < history[ch].size(); j++) history[ch][j] = 0.0f;
+    }
+    position = 0.0;
+  }
+
+  /// Adds frames of planar input data: input[ch] points to frames values
+  void addFrames(const float *const *input, size_t frames) {
+    for (int ch = 0; ch < channels; ch++) {
+      Vector<float> &h = history[ch];
+      int old_size = h.size();
+      h.resize(old_size + frames);
+      memcpy(h.data() + old_size, input[ch], frames * sizeof(float));
+    }
+  }
+
+  /// Calculates all output frames which are possible with the available
+  /// input: the result is interleaved and out must have space for
+  /// maxFrames * channels values. Returns the number of frames.
+  size_t getFrames(float *out, size_t maxFrames) {
+    if (channels <= 0 || taps <= 0) return 0;
+    size_t frames = 0;
+    int available = history[0].size();
+    while (frames < maxFrames) {
+      int idx = (int)position;
+      if (idx + taps > available) break;
+      float frac_phase = (float)(position - idx) * phase_count;
+      int phase = (int)frac_phase;
+      float weight = frac_phase - phase;
+      if (phase >= phase_count) {  // float rounding for frac close to 1
+        phase = phase_count - 1;
+        weight = 1.0f;
+      }
+      const float *c0 = &table[phase * taps];
+      const float *c1 = c0 + taps;
+      for (int ch = 0; ch < channels; ch++) {
+        const float *x = history[ch].data() + idx;
+        float v0 = dotProduct(c0, x, taps);
+        float v1 = dotProduct(c1, x, taps);
+        *out++ = v0 + weight * (v1 - v0);
+      }
+      position += step_size;
+      frames++;
+    }
+    consume();
+    return frames;
+  }
+
+  /// Estimated number of output frames for the indicated number of input
+  /// frames
+  size_t outputFrames(size_t inputFrames) {
+    return (size_t)(inputFrames / step_size) + 2;
+  }
+
+  /// Number of filter taps per output sample
+  int tapCount() { return taps; }
+
+ protected:
+  Vector<Vector<float>> history;
+  Vector<float> table;
+  ResampleQuality quality = ResampleQuality::Medium;
+  int channels = 0;
+  int taps = 0;
+  int phase_count = 0;
+  float cutoff = 0.0f;
+  float step_size = 1.0f;
+  double position = 0.0;
+
+  void getQualityParameters(int &taps, int &phases, float &beta,
+                            float &rolloff) {
+    switch (quality) {
+      case ResampleQuality::Low:
+        taps = 8;
+        phases = 64;
+        beta = 5.0f;
+        rolloff = 0.85f;
+        break;
+      case ResampleQuality::High:
+        taps = 32;
+        phases = 256;
+        beta = 8.5f;
+        rolloff = 0.94f;
+        break;
+      case ResampleQuality::Best:
+        taps = 64;
+        phases = 512;
+        beta = 10.0f;
+        rolloff = 0.97f;
+        break;
+      default:
+        taps = 16;
+        phases = 128;
+        beta = 6.5f;
+        rolloff = 0.9f;
+        break;
+    }
+  }
+
+  /// Removes the input which is not needed any more
+  void consume() {
+    int drop = (int)position;
+    if (drop <= 0) return;
+    for (int ch = 0; ch < channels; ch++) {
+      Vector<float> &h = history[ch];
+      int keep = h.size() - drop;
+      if (keep > 0) {
+        memmove(h.data(), h.data() + drop, keep * sizeof(float));
+        h.resize(keep);
+      } else {
+        h.clear();
+      }
+    }
+    position -= drop;
+  }
+
+  /// Modified Bessel function of the first kind (order 0)
+  static float besselI0(float x) {
+    float sum = 1.0f, term = 1.0f, half = x * 0.5f;
+    for (int k = 1; k < 30; k++) {
+      term *= (half / k) * (half / k);
+      sum += term;
+      if (term < sum * 1e-9f) break;
+    }
+    return sum;
+  }
+
+  /// Precalculates phase_count + 1 filters: phase p is evaluated at the
+  /// fractional position p / phase_count. Each phase is normalized to a DC
+  /// gain of 1.
+  void calculateTable(float beta) {
+    table.resize((phase_count + 1) * taps);
+    float half = taps / 2;
+    float i0_beta = besselI0(beta);
+    for (int p = 0; p <= phase_count; p++) {
+      float frac = (float)p / phase_count;
+      float *coef = &table[p * taps];
+      float sum = 0.0f;
+      for (int k = 0; k < taps; k++) {
+        // distance of tap k from the interpolated position
+        float x = (half - 1 - k) + frac;
+        float arg = PI * cutoff * x;
+        float sinc = (x == 0.0f) ? cutoff : cutoff * sinf(arg) / arg;
+        float r = x / half;
+        float window = r * r < 1.0f
+                           ? besselI0(beta * sqrtf(1.0f - r * r)) / i0_beta
+                           : 0.0f;
+        coef[k] = sinc * window;
+        sum += coef[k];
+      }
+      if (sum != 0.0f) {
+        for (int k = 0; k < taps; k++) coef[k] /= sum;
+      }
+    }
+  }
+};
+
+/**
+ * @brief High quality resampling stream which uses the SincResampler: in
+ * contrast to ResampleStream (linear) and ResampleStreamT (spline
+ * interpolators) the signal is bandlimited, so there is no audible aliasing
+ * e.g. for 44100 <-> 48000 conversions. The data is processed in blocks:
+ * each write() is converted to planar float arrays and the result is written
+ * with one call to the output.
+ * @ingroup transform
+ * @author Phil Schatzmann
+ * @copyright GPLv3
+ */
+class ResampleStreamSinc : public ReformatBaseStream {
+ public:
+  ResampleStreamSinc() = default;
+  /// Support for resampling via write
+  ResampleStreamSinc(Print &out) { setOutput(out); }
+  /// Support for resampling via write. The audio information is copied from
+  /// the output
+  ResampleStreamSinc(AudioOutput &out) {
+    setAudioInfo(out.audioInfo());
+    setOutput(out);
+  }
+  /// Support for resampling via write and read
+  ResampleStreamSinc(Stream &io) { setStream(io); }
+  /// Support for resampling via write and read. The audio information is
+  /// copied from the io
+  ResampleStreamSinc(AudioStream &io) {
+    setAudioInfo(io.audioInfo());
+    setStream(io);
+  }
+
+  ResampleConfig defaultConfig() {
+    ResampleConfig result;
+    result.copyFrom(audioInfo());
+    return result;
+  }
+
+  bool begin(ResampleConfig cfg) {
+    this->cfg = cfg;
+    AudioStream::setAudioInfo(cfg);
+    return begin();
+  }
+
+  /// Resample from the indicated audio format to the indicated sample rate
+  bool begin(AudioInfo from, int toRate) {
+    cfg.copyFrom(from);
+    cfg.to_sample_rate = toRate;
+    cfg.step_size = 0.0f;
+    AudioStream::setAudioInfo(from);
+    return begin();
+  }
+
+  bool begin(AudioInfo info, float step) {
+    cfg.copyFrom(info);
+    cfg.step_size = step;
+    cfg.to_sample_rate = 0;
+    AudioStream::setAudioInfo(info);
+    return begin();
+  }
+
+  bool begin() override {
+    setupReader();
+    if (cfg.to_sample_rate > 0 && cfg.sample_rate > 0) {
+      cfg.step_size = static_cast<float>(cfg.sample_rate) /
+                      static_cast<float>(cfg.to_sample_rate);
+    }
+    if (cfg.step_size <= 0.0f) cfg.step_size = 1.0f;
+    if (cfg.channels == 0) {
+      LOGE("channels must not be 0");
+      return false;
+    }
+    return resampler.begin(cfg.channels, cfg.step_size, quality);
+  }
+
+  /// Defines the quality: call before begin()
+  void setQuality(ResampleQuality quality) { this->quality = quality; }
+
+  /// Changes the step size (input samples per output sample)
+  void setStepSize(float step) {
+    cfg.step_size = step;
+    resampler.setStepSize(step);
+  }
+
+  float getStepSize() { return cfg.step_size; }
+
+  void setAudioInfo(AudioInfo newInfo) override {
+    bool channels_changed = newInfo.channels != cfg.channels;
+    AudioStream::setAudioInfo(newInfo);
+    cfg.copyFrom(newInfo);
+    if (cfg.to_sample_rate > 0 && cfg.sample_rate > 0) {
+      setStepSize(static_cast<float>(cfg.sample_rate) /
+                  static_cast<float>(cfg.to_sample_rate));
+    }
+    if (channels_changed && cfg.channels > 0) {
+      resampler.begin(cfg.channels, cfg.step_size, quality);
+    }
+  }
+
+  AudioInfo audioInfoOut() override {
+    AudioInfo out = audioInfo();
+    if (cfg.to_sample_rate > 0) {
+      out.sample_rate = cfg.to_sample_rate;
+    } else if (cfg.step_size != 1.0f) {
+      out.sample_rate = out.sample_rate / cfg.step_size;
+    }
+    return out;
+  }
+
+  size_t write(const uint8_t *data, size_t len) override {
+    LOGD("ResampleStreamSinc::write: %d", (int)len);
+    switch (info.bits_per_sample) {
+      case 16:
+        return writeT<int16_t>(data, len);
+      case 24:
+        return writeT<int24_t>(data, len);
+      case 32:
+        return writeT<int32_t>(data, len);
+      default:
+        TRACEE();
+    }
+    return 0;
+  }
+
+  float getByteFactor() override { return 1.0f / cfg.step_size; }
+
+  /// Provides access to the resampling engine
+  SincResampler &sincResampler() { return resampler; }
+
+ protected:
+  SincResampler resampler;
+  ResampleConfig cfg;
+  ResampleQuality quality = ResampleQuality::Medium;
+  Vector<float> planar;
+  Vector<float> result;
+  Vector<uint8_t> out_data;
+  // partial frame from the last write
+  Vector<uint8_t> carry;
+  // carry + new data: kept as member to avoid a heap allocation per write
+  Vector<uint8_t> combined;
+  Vector<const float *> channel_ptr;
+
+  template <typename T>
+  size_t writeT(const uint8_t *data, size_t len) {
+    if (p_print == nullptr) return 0;
+    int channels = cfg.channels;
+    int frame_bytes = sizeof(T) * channels;
+    if (frame_bytes <= 0) return 0;
+
+    // complete a partial frame from the last call
+    const uint8_t *proc_data = data;
+    size_t proc_len = len;
+    if (carry.size() > 0) {
+      combined.resize(carry.size() + len);
+      memcpy(combined.data(), carry.data(), carry.size());
+      memcpy(combined.data() + carry.size(), data, len);
+      proc_data = combined.data();
+      proc_len = combined.size();
+      carry.clear();
+    }
+    size_t frames = proc_len / frame_bytes;
+    size_t leftover = proc_len - frames * frame_bytes;
+    if (leftover > 0) {
+      carry.resize(leftover);
+      memcpy(carry.data(), proc_data + frames * frame_bytes, leftover);
+    }
+    if (frames == 0) return len;
+
+    // deinterleave into planar float arrays
+    planar.resize(frames * channels);
+    const T *samples = (const T *)proc_data;
+    channel_ptr.resize(channels);
+    for (int ch = 0; ch < channels; ch++) {
+      float *dest = planar.data() + ch * frames;
+      channel_ptr[ch] = dest;
+      for (size_t j = 0; j < frames; j++) {
+        T sample = samples[j * channels + ch];
+        dest[j] = static_cast<float>(sample);
+      }
+    }
+    resampler.addFrames(channel_ptr.data(), frames);
+
+    // calculate the result and write it with one call
+    size_t max_frames = resampler.outputFrames(frames);
+    result.resize(max_frames * channels);
+    size_t out_frames = resampler.getFrames(result.data(), max_frames);
+    size_t out_samples = out_frames * channels;
+    out_data.resize(out_samples * sizeof(T));
+    T *out = (T *)out_data.data();
+    for (size_t j = 0; j < out_samples; j++) {
+      out[j] = NumberConverter::clipT<T>(result[j]);
+    }
+    size_t out_bytes = out_samples * sizeof(T);
+    if (out_bytes > 0) {
+      size_t written = p_print->write(out_data.data(), out_bytes);
+      if (written != out_bytes) {
+        LOGE("write error %d -> %d", (int)out_bytes, (int)written);
+      }
+    }
+    return len;
+  }
+};
+
+}  // namespace audio_tools
@@ -69,11 +69,15 @@ class StreamCopyT {
   /// Ends the processing
   void end() {
     this->from = nullptr;
+    this->from_audio = nullptr;
     this->to = nullptr;
+    this->p_from_buffer = nullptr;
+    this->p_to_buffer = nullptr;
   }
 
   /// assign a new output and input stream
   void begin(Print &to, Stream &from) {
+    end();
     this->from = &from;
     this->to = &to;
     begin();
@@ -81,12 +85,31 @@ class StreamCopyT {
 
   /// assign a new output and input stream
   void begin(Print &to, AudioStream &from) {
+    end();
     this->from = &from;
     this->from_audio = &from;
     this->to = &to;
     begin();
   }
 
+  /// Zero copy mode: the data is written to the output directly from the
+  /// memory of the source buffer (see BaseBuffer::peekReadSpan())
+  void begin(Print &to, BaseBuffer<uint8_t> &from) {
+    end();
+    this->p_from_buffer = &from;
+    this->to = &to;
+    begin();
+  }
+
+  /// Zero copy mode: the data is read from the input directly into the
+  /// memory of the target buffer (see BaseBuffer::peekWriteSpan())
+  void begin(BaseBuffer<uint8_t> &to, Stream &from) {
+    end();
+    this->from = &from;
+    this->p_to_buffer = &to;
+    begin();
+  }
+
   /// Provides a pointer to the copy source. Can be used to check if the source
   /// is defined.
   Stream *getFrom() { return from; }
@@ -120,6 +143,10 @@ class StreamCopyT {
     // if no bytes are requested, we do nothing
     if (bytes == 0) return 0;
 
+    // zero copy modes
+    if (p_from_buffer != nullptr) return copyFromBuffer(bytes);
+    if (p_to_buffer != nullptr) return copyToBuffer(bytes);
+
     // synchronize AudioInfo
     syncAudioInfo();
 
@@ -230,7 +257,8 @@ class StreamCopyT {
     size_t result = 0;
     int retry = 0;
 
-    if (from == nullptr || to == nullptr) return result;
+    if (from == nullptr && p_from_buffer == nullptr) return result;
+    if (to == nullptr && p_to_buffer == nullptr) return result;
 
     // copy while source has data available
     int count = 0;
@@ -255,7 +283,9 @@ class StreamCopyT {
   /// available bytes of the data source
   int available() {
     int result = 0;
-    if (from != nullptr) {
+    if (p_from_buffer != nullptr) {
+      result = p_from_buffer->available();
+    } else if (from != nullptr) {
       if (availableCallback != nullptr) {
         result = availableCallback((Stream *)from);
       } else {
@@ -348,6 +378,8 @@ class StreamCopyT {
   Stream *from = nullptr;
   AudioStream *from_audio = nullptr;
   Print *to = nullptr;
+  BaseBuffer<uint8_t> *p_from_buffer = nullptr;
+  BaseBuffer<uint8_t> *p_to_buffer = nullptr;
   Vector<uint8_t> buffer{0, _allocator};
   int buffer_size = DEFAULT_BUFFER_SIZE;
   void (*onWrite)(void *obj, void *buffer, size_t len) = nullptr;
@@ -380,15 +412,126 @@ class StreamCopyT {
     }
   }
 
+  /// rounds the number of bytes down to full frames
+  size_t toFullFrames(size_t bytes) {
+    int copy_size = minCopySize();
+    return copy_size > 0 ? bytes / copy_size * copy_size : bytes;
+  }
+
+  /// makes sure that the copy buffer can hold the indicated bytes
+  void resizeBuffer(size_t bytes) {
+    if (buffer.size() < bytes) {
+      LOGI("Resize to %d", (int)bytes);
+      buffer.resize(bytes);
+    }
+  }
+
+  /// mime detection and conversion of the data
+  void process(uint8_t *data, size_t len) {
+    if (p_mime_detector != nullptr) p_mime_detector->write(data, len);
+    if (p_converter != nullptr) p_converter->convert(data, len);
+  }
+
+  /// Writes the data from the read span of the source buffer: we fall back
+  /// to the copy buffer if the buffer does not support this, if a frame
+  /// is split at the wrap around or if a converter would modify data which
+  /// might stay in the buffer
+  size_t copyFromBuffer(size_t bytes) {
+    size_t max_len = min(bytes, (size_t)buffer_size);
+    if (check_available_for_write) {
+      int to_write = to->availableForWrite();
+      if (to_write == 0) {
+        delay(500);
+        return 0;
+      }
+      max_len = min(max_len, (size_t)to_write);
+    }
+
+    int span_len = 0;
+    uint8_t *data = nullptr;
+    if (p_converter == nullptr) data = p_from_buffer->peekReadSpan(span_len);
+    size_t len = toFullFrames(min(max_len, (size_t)span_len));
+    bool is_in_place = data != nullptr && len > 0;
+    if (!is_in_place) {
+      len = toFullFrames(min(max_len, (size_t)p_from_buffer->available()));
+      resizeBuffer(len);
+      data = buffer.data();
+      len = p_from_buffer->readArray(data, len);
+    }
+    if (len == 0) {
+      delay(delay_on_no_data);
+      return 0;
+    }
+
+    process(data, len);
+    size_t delayCount = 0;
+    size_t result = write(data, len, delayCount);
+    if (onWrite != nullptr) onWrite(onWriteObj, data, result);
+    // data which could not be written stays in the buffer
+    if (is_in_place) p_from_buffer->commitRead(result);
+
+#ifndef COPY_LOG_OFF
+    LOGI("StreamCopy::copyFromBuffer %s %u -> %u bytes - in %u hops (%s)",
+         log_name, (unsigned int)len, (unsigned int)result,
+         (unsigned int)delayCount, is_in_place ? "zero copy" : "copy");
+#endif
+    return result;
+  }
+
+  /// Reads the data into the write span of the target buffer: we fall back
+  /// to the copy buffer if the buffer does not support this or if the span
+  /// is smaller than a frame
+  size_t copyToBuffer(size_t bytes) {
+    size_t max_len = min(bytes, (size_t)buffer_size);
+    if (check_available) max_len = min(max_len, (size_t)available());
+
+    int span_len = 0;
+    uint8_t *data = p_to_buffer->peekWriteSpan(span_len);
+    size_t len = toFullFrames(min(max_len, (size_t)span_len));
+    bool is_in_place = data != nullptr && len > 0;
+    if (!is_in_place) {
+      len = toFullFrames(
+          min(max_len, (size_t)p_to_buffer->availableForWrite()));
+      resizeBuffer(len);
+      data = buffer.data();
+    }
+    size_t result = len > 0 ? from->readBytes(data, len) : 0;
+    if (result == 0) {
+      delay(delay_on_no_data);
+      return 0;
+    }
+
+    process(data, result);
+    if (is_in_place) {
+      result = p_to_buffer->commitWrite(result);
+    } else {
+      result = p_to_buffer->writeArray(data, result);
+    }
+    if (onWrite != nullptr) onWrite(onWriteObj, data, result);
+
+#ifndef COPY_LOG_OFF
+    LOGI("StreamCopy::copyToBuffer %s %u -> %u bytes (%s)", log_name,
+         (unsigned int)len, (unsigned int)result,
+         is_in_place ? "zero copy" : "copy");
+#endif
+    return result;
+  }
+
   /// blocking write - until everything is processed
   size_t write(size_t len, size_t &delayCount) {
     if (!buffer || len == 0) return 0;
+    return write(buffer.data(), len, delayCount);
+  }
+
+  /// blocking write of the indicated data
+  size_t write(const uint8_t *data, size_t len, size_t &delayCount) {
+    if (len == 0) return 0;
     LOGD("write: %d", (int)len);
     size_t total = 0;
     long open = len;
     int retry = 0;
     while (open > 0) {
-      size_t written = to->write((const uint8_t *)buffer.data() + total, open);
+      size_t written = to->write(data + total, open);
       LOGD("write: %d -> %d", (int)open, (int)written);
       total += written;
       open -= written;
@@ -3,7 +3,9 @@
 #include "AudioTools/CoreAudio/AudioStreams.h"
 #include "AudioTools/CoreAudio/AudioOutput.h"
 #include "AudioTools/CoreAudio/VolumeControl.h"
-#include "AudioTools/CoreAudio/AudioBasic/q1_14_t.h"
+#include "AudioTools/CoreAudio/AudioBasic/MixAccumulator.h"
+#include "AudioTools/CoreAudio/AudioBasic/SIMD.h"
+#include "AudioTools/CoreAudio/AudioBasic/SampleFormat.h"
 #include "AudioTools/CoreAudio/AudioTypes.h"
 
 namespace audio_tools {
@@ -20,6 +22,8 @@ struct VolumeStreamConfig : public AudioInfo {
   }
   bool allow_boost = false;
   float volume=1.0;  // start_volume
+  /// duration of the linear gain ramp after a volume change (0 = no ramp)
+  int ramp_ms = 10;
 };
 
 
@@ -27,6 +31,13 @@ struct VolumeStreamConfig : public AudioInfo {
  * @brief Adjust the volume of the related input or output: To work properly the class needs to know the 
  * bits per sample and number of channels!
  * AudioChanges are forwareded to the related Print or Stream class.
+ *
+ * The data is processed in blocks with a per channel gain pattern, so that
+ * interleaved frames can be handled with the SIMD multiplyAndClip() kernel.
+ * If PREFER_FIXEDPOINT is set, 16 bit samples use Q15 and 24/32 bit samples
+ * Q31 gains, so no float operations are needed per sample. Volume changes
+ * are applied as linear gain ramps over ramp_ms and the result is always
+ * saturated.
  * @ingroup transform
  * @ingroup volume
  * @author Phil Schatzmann
@@ -116,6 +127,7 @@ class VolumeStream : public ModifyingStream, public VolumeSupport {
 
         void end() override {
             is_started = false;
+            is_active = false;
         }
 
 
@@ -209,13 +221,9 @@ class VolumeStream : public ModifyingStream, public VolumeSupport {
                 LOGI("setVolume: %f at %d", volume_value, channel);
                 float factor = volumeControl().getVolumeFactor(volume_value);
                 volume_values[channel]=volume_value;
-                #if PREFER_FIXEDPOINT
-                    // q1_14_t saturates at ~1.99994 (its Q1.14 range), so boost
-                    // is capped there (factor can only be >1 if allow_boost==true)
-                    factor_for_channel[channel] = q1_14_t(factor);
-                #else
-                    factor_for_channel[channel]=factor;
-                #endif
+                // ramp only when the data is already processed
+                gains[channel].setTarget(factor, is_active ? rampFrames() : 0);
+                is_pattern_valid = false;
               }
               return true;
             } else {
@@ -250,20 +258,19 @@ class VolumeStream : public ModifyingStream, public VolumeSupport {
         SimulatedAudioPot pot_vc;
         CachedVolumeControl cached_volume{pot_vc};
         Vector<float> volume_values;
+        // gain per channel with the ramp state
+        Vector<MixRamp> gains;
+        // gain for each sample of a block
+        Vector<float> gain_pattern;
         #if PREFER_FIXEDPOINT
-            Vector<q1_14_t> factor_for_channel; // Q1.14 fixed point
-        #else
-            Vector<float> factor_for_channel;
+            Vector<int32_t> gain_pattern_q15;
+            Vector<int64_t> gain_pattern_q31;
         #endif
+        Vector<float> block_values;
+        bool is_pattern_valid = false;
         bool is_started = false;
-        // max value for clipping: integer on the fixed-point path, so the
-        // per-sample clip in applyVolume16/24/32 stays pure-integer instead
-        // of promoting the int32_t/int64_t result to float on every sample.
-        #if PREFER_FIXEDPOINT
-            int64_t max_value = 32767;
-        #else
-            float max_value = 32767;
-        #endif
+        // data has been processed: volume changes are ramped
+        bool is_active = false;
 
         // checks if volume needs to be updated
         bool isVolumeUpdate(){
@@ -273,16 +280,17 @@ class VolumeStream : public ModifyingStream, public VolumeSupport {
         }
 
         bool isAllChannelsFullVolume(){
-            int channels = min((int)info.channels, volume_values.size());
+            int channels = min((int)info.channels, gains.size());
             for (int ch=0;ch < channels;ch++){
-                if (volume_values[ch]!=1.0) return false;
+                if (gains[ch].isRamping() || gains[ch].current!=1.0f) return false;
             }
             return true;
         }
 
         /// Resizes the vectors
         void resizeVectors(int channels) {
-            factor_for_channel.resize(channels);
+            if (gains.size() != channels) is_pattern_valid = false;
+            gains.resize(channels);
             volume_values.resize(channels);
         }
 
@@ -295,13 +303,14 @@ class VolumeStream : public ModifyingStream, public VolumeSupport {
             // keep volume which might habe been defined befor calling begin
             cfg1.volume = info.volume;
             cfg1.allow_boost = info.allow_boost;
+            cfg1.ramp_ms = info.ramp_ms;
             return cfg1;
         }
 
         /// Stores the local variable and calculates some max values
         void setVolumeStreamConfig(VolumeStreamConfig cfg){
+            if (cfg.channels != info.channels) is_pattern_valid = false;
             info = cfg;
-            max_value = NumberConverter::maxValue(info.bits_per_sample);
         }
 
         float volumeValue(float vol){
@@ -318,77 +327,115 @@ class VolumeStream : public ModifyingStream, public VolumeSupport {
             return cached_volume;
         }
 
-        #if PREFER_FIXEDPOINT
-        q1_14_t factorForChannel(int channel){
-        #else
-        float factorForChannel(int channel){
-        #endif
-            if (factor_for_channel.size()==0) return 1.0;
-            if (channel >= factor_for_channel.size()) return 1.0;
-            return factor_for_channel[channel];
+        /// Number of frames of a volume ramp
+        int rampFrames() {
+            if (info.ramp_ms <= 0 || info.sample_rate <= 0) return 0;
+            return info.sample_rate / 1000 * info.ramp_ms;
+        }
+
+        /// Number of samples which are processed with one gain pattern: a
+        /// multiple of the channels
+        int blockSize() {
+            int channels = info.channels;
+            return channels >= 64 ? channels : (64 / channels) * channels;
         }
 
         void applyVolume(const uint8_t *buffer, size_t size){
+            if (info.channels <= 0) return;
+            is_active = true;
             switch(info.bits_per_sample){
                 case 16:
-                    applyVolume16((int16_t*)buffer, size/2);
+                    applyVolumeT<int16_t>((int16_t*)buffer, size/2);
                     break;
                 case 24:
-                    applyVolume24((int24_t*)buffer, size/sizeof(int24_t));
+                    applyVolumeT<int24_t>((int24_t*)buffer, size/sizeof(int24_t));
                     break;
                 case 32:
-                    applyVolume32((int32_t*)buffer, size/4);
+                    applyVolumeT<int32_t>((int32_t*)buffer, size/4);
                     break;
                 default:
                     LOGE("Unsupported bits_per_sample: %d", info.bits_per_sample);
             }
         }
 
-        void applyVolume16(int16_t* data, size_t size){
-            for (size_t j=0;j<size;j++){
-                #if PREFER_FIXEDPOINT
-                int32_t result = factorForChannel(j%info.channels).scale(data[j]);
-                #else
-                float result = factorForChannel(j%info.channels) * data[j];
-                #endif
-                if (!info.allow_boost){
-                    if (result>max_value) result = max_value;
-                    if (result<-max_value) result = -max_value;
-                } 
-                data[j]= static_cast<int16_t>(result);
+        /// Processes the data in blocks: during a ramp the gains are updated
+        /// after each block
+        template <typename T>
+        void applyVolumeT(T* data, size_t size){
+            int block = blockSize();
+            for (size_t pos = 0; pos < size; pos += block) {
+                int len = min((size_t)block, size - pos);
+                updateGainPattern(block);
+                applyBlock(data + pos, len);
+                advanceRamps(len / info.channels);
             }
         }
 
-        void applyVolume24(int24_t* data, size_t size) {
-            for (size_t j=0;j<size;j++){
-                #if PREFER_FIXEDPOINT
-                int32_t result = factorForChannel(j%info.channels).scale(data[j]);
-                #else
-                float result = factorForChannel(j%info.channels) * data[j];
-                #endif
-                if (!info.allow_boost){
-                    if (result>max_value) result = max_value;
-                    if (result<-max_value) result = -max_value;
-                } 
-                int32_t result1 = result;
-                data[j]= static_cast<int24_t>(result1);
+        /// Repeats the current channel gains for the samples of a block
+        void updateGainPattern(int block) {
+            if (is_pattern_valid && gain_pattern.size() == block) return;
+            int channels = info.channels;
+            resizeVectors(channels);
+            gain_pattern.resize(block);
+            for (int j = 0; j < block; j++) {
+                gain_pattern[j] = gains[j % channels].current;
             }
+            #if PREFER_FIXEDPOINT
+                // gains below 2.0: Q15 for 16 bits and Q31 for 24/32 bits
+                gain_pattern_q15.resize(block);
+                gain_pattern_q31.resize(block);
+                for (int j = 0; j < block; j++) {
+                    float gain = gain_pattern[j];
+                    if (gain < 0.0f) gain = 0.0f;
+                    gain_pattern_q15[j] =
+                        gain >= 2.0f ? 65535 : (int32_t)(gain * 32768.0f + 0.5f);
+                    gain_pattern_q31[j] =
+                        gain >= 2.0f ? 0xFFFFFFFFLL
+                                     : (int64_t)(gain * 2147483648.0f + 0.5f);
+                }
+            #endif
+            is_pattern_valid = true;
         }
 
-        void applyVolume32(int32_t* data, size_t size) {
-            for (size_t j=0;j<size;j++){
-                #if PREFER_FIXEDPOINT
-                int64_t result = factorForChannel(j%info.channels).scale(data[j]);
-                #else
-                float result = factorForChannel(j%info.channels) * data[j];
-                #endif
-                if (!info.allow_boost){
-                    if (result>max_value) result = max_value;
-                    if (result<-max_value) result = -max_value;
-                } 
-                data[j]= static_cast<int32_t>(result);
+        /// Moves the ramps forward by the indicated number of frames
+        void advanceRamps(int frames) {
+            for (int ch = 0; ch < gains.size(); ch++) {
+                if (gains[ch].isRamping()) {
+                    gains[ch].advance(frames);
+                    is_pattern_valid = false;
+                }
             }
         }
+
+        /// Float processing: the samples are converted with SampleFormat
+        template <typename T>
+        void applyBlock(T* data, int len) {
+            float zero = SampleFormat<T>::zero();
+            float amplitude = SampleFormat<T>::amplitude();
+            block_values.resize(len);
+            float* values = block_values.data();
+            SampleFormat<T>::toFloat(data, values, len);
+            multiplyAndClip(values, gain_pattern.data(), values, len,
+                            zero - amplitude, zero + amplitude);
+            SampleFormat<T>::fromFloat(values, data, len);
+        }
+
+        #if PREFER_FIXEDPOINT
+        void applyBlock(int16_t* data, int len) {
+            applyGainQ15(data, gain_pattern_q15.data(), len);
+        }
+
+        void applyBlock(int32_t* data, int len) {
+            applyGainQ31(data, gain_pattern_q31.data(), len);
+        }
+
+        /// int24 with 4 bytes is a left aligned 32 bit value
+        void applyBlock(int24_4bytes_t* data, int len) {
+            int32_t* values = (int32_t*)data;
+            applyGainQ31(values, gain_pattern_q31.data(), len, INT24_MAX << 8);
+            for (int j = 0; j < len; j++) values[j] &= ~0xFF;
+        }
+        #endif
 };
 
 }
@@ -72,6 +72,13 @@ class AudioSource {
   /// provides the actual stream (e.g. file) name or url
   virtual const char* toStr() { return nullptr; }
 
+  /// Moves the actual stream to the indicated byte position: only supported
+  /// by file based sources
+  virtual bool seek(size_t pos) { return false; }
+
+  /// Size of the actual stream in bytes: 0 if not known
+  virtual size_t streamSize() { return 0; }
+
  protected:
   int timeout_auto_next_value = 500;
   bool is_auto_next = true;
@@ -457,6 +464,16 @@ class AudioSourceVector : public AudioSource, public PathNamesRegistry {
   /// provides the name at the given index
   const char* name(int index) { return getFullPath(index).c_str(); }
 
+  /// Moves the actual file to the indicated byte position
+  bool seek(size_t pos) override {
+    return current_stream != nullptr && current_stream->seek(pos);
+  }
+
+  /// Size of the actual file in bytes
+  size_t streamSize() override {
+    return current_stream != nullptr ? current_stream->size() : 0;
+  }
+
  protected:
   Vector<FileEntry> files;    // List of all files
   Vector<Str> path_registry;  // Shared registry of unique paths
@@ -683,6 +700,16 @@ class AudioSourceArray : public AudioSource {
   /// provides the name at the given index
   const char* name(int index) { return getFilePath(index); }
 
+  /// Moves the actual file to the indicated byte position
+  bool seek(size_t pos) override {
+    return current_stream != nullptr && current_stream->seek(pos);
+  }
+
+  /// Size of the actual file in bytes
+  size_t streamSize() override {
+    return current_stream != nullptr ? current_stream->size() : 0;
+  }
+
  protected:
   const char* const* file_array = nullptr;  // Pointer to array of const char*
   size_t array_size = 0;
@@ -113,6 +113,12 @@ public:
   /// provides the actual file name
   const char *toStr() { return file_name; }
 
+  /// Moves the actual file to the indicated byte position
+  bool seek(size_t pos) override { return file && file.seek(pos); }
+
+  /// Size of the actual file in bytes
+  size_t streamSize() override { return file ? file.size() : 0; }
+
   // provides default setting go to the next
   virtual bool isAutoNext() { return true; }
 
@@ -137,6 +143,10 @@ public:
     setup_index = rebuild;
   }
 
+  /// Rescans only the directories which have changed since the index was
+  /// created: returns the number of rescanned directories
+  int updateIndex() { return idx.update(); }
+
 protected:
 #if defined(USE_SD_NO_NS)
   SDIndex<SDClass, File> idx{SD};
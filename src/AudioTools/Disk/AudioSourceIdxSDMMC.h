@@ -96,6 +96,12 @@ public:
   /// provides the actual file name
   const char *toStr() { return file_name; }
 
+  /// Moves the actual file to the indicated byte position
+  bool seek(size_t pos) override { return file && file.seek(pos); }
+
+  /// Size of the actual file in bytes
+  size_t streamSize() override { return file ? file.size() : 0; }
+
   // provides default setting go to the next
   virtual bool isAutoNext() { return true; }
 
@@ -120,6 +126,10 @@ public:
     setup_index = rebuild;
   }
 
+  /// Rescans only the directories which have changed since the index was
+  /// created: returns the number of rescanned directories
+  int updateIndex() { return idx.update(); }
+
 protected:
   SDIndex<fs::SDMMCFS,fs::File> idx{SD_MMC};
   File file;
@@ -78,6 +78,12 @@ public:
   /// provides the actual file name
   const char *toStr() { return file_name; }
 
+  /// Moves the actual file to the indicated byte position
+  bool seek(size_t pos) override { return file && file.seek(pos); }
+
+  /// Size of the actual file in bytes
+  size_t streamSize() override { return file ? file.size() : 0; }
+
   // provides default setting go to the next
   virtual bool isAutoNext() { return true; }
 
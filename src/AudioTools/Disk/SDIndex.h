@@ -1,5 +1,8 @@
 #pragma once
 
+#include <type_traits>
+#include <utility>
+
 #include "AudioTools/CoreAudio/AudioBasic/Str.h"
 #include "AudioTools/CoreAudio/AudioBasic/Collections/List.h"
 
@@ -12,9 +15,108 @@
 
 namespace audio_tools {
 
+/// @brief SFINAE helper for SDIndex::replaceFile(): calls sd.rename() if that
+/// method exists - the classic Arduino SD library does not provide it.
+namespace sdindex_detail {
+template <typename T>
+class HasRename {
+  template <typename U>
+  static auto test(int) -> decltype(std::declval<U &>().rename("", ""),
+                                    std::true_type());
+  template <typename U>
+  static std::false_type test(...);
+
+ public:
+  static const bool value = decltype(test<T>(0))::value;
+};
+
+template <typename T>
+typename std::enable_if<HasRename<T>::value, bool>::type renameIfAvailable(
+    T &sd, const char *from, const char *to) {
+  return sd.rename(from, to);
+}
+
+template <typename T>
+typename std::enable_if<!HasRename<T>::value, bool>::type renameIfAvailable(
+    T &, const char *, const char *) {
+  return false;
+}
+}  // namespace sdindex_detail
+
+/**
+ * @brief Print which writes the index entries (one file name per line) to the
+ * index file and records the start position of each entry in the binary
+ * offset file: [magic "SDIX"][version][uint32 offset of entry 0]...[uint32
+ * end of the last entry], all values little endian. So the number of entries
+ * is given by the file size and an entry can be located with a single seek.
+ */
+template <class FileT>
+class SDIndexWriter : public Print {
+ public:
+  static constexpr uint32_t kVersion = 1;
+  static constexpr int kHeaderSize = 8;
+
+  void begin(FileT &idxFile, FileT &offsetFile) {
+    begin(offsetFile);
+    p_idx_file = &idxFile;
+  }
+
+  /// Only records the offsets: used to rebuild the offset table of an
+  /// existing index file
+  void begin(FileT &offsetFile) {
+    p_idx_file = nullptr;
+    p_offset_file = &offsetFile;
+    pos = 0;
+    entries = 0;
+    is_line_start = true;
+    p_offset_file->write((const uint8_t *)"SDIX", 4);
+    writeUint32(kVersion);
+  }
+
+  /// Writes the end position of the last entry
+  void end() { writeUint32(pos); }
+
+  size_t write(uint8_t ch) override { return write(&ch, 1); }
+
+  size_t write(const uint8_t *data, size_t len) override {
+    for (size_t j = 0; j < len; j++) {
+      if (is_line_start) {
+        writeUint32(pos + j);
+        entries++;
+        is_line_start = false;
+      }
+      if (data[j] == '\n') is_line_start = true;
+    }
+    size_t result = p_idx_file != nullptr ? p_idx_file->write(data, len) : len;
+    pos += result;
+    return result;
+  }
+
+  /// Number of entries written so far
+  long count() { return entries; }
+
+ protected:
+  FileT *p_idx_file = nullptr;
+  FileT *p_offset_file = nullptr;
+  uint32_t pos = 0;
+  long entries = 0;
+  bool is_line_start = true;
+
+  void writeUint32(uint32_t value) {
+    uint8_t tmp[4] = {(uint8_t)value, (uint8_t)(value >> 8),
+                      (uint8_t)(value >> 16), (uint8_t)(value >> 24)};
+    p_offset_file->write(tmp, 4);
+  }
+};
+
 /**
  * @brief We store all the relevant file names in an sequential index
- * file. Form there we can access them via an index
+ * file (idx.txt). A binary offset table (idx.off) provides the position of
+ * each entry, so that the access by index needs only a single seek and read.
+ *
+ * For each directory we also record the range of its entries and a signature
+ * of its content (idx-dir.txt): update() uses this to rescan only the
+ * directories which have changed.
  */
 template <class SDT, class FileT>
 class SDIndex {
@@ -27,21 +129,57 @@ class SDIndex {
     this->ext = extension;
     this->file_name_pattern = file_name_pattern;
     idx_path = filePathString(startDir, "idx.txt");
+    idx_offpath = filePathString(startDir, "idx.off");
+    idx_dirpath = filePathString(startDir, "idx-dir.txt");
     idx_defpath = filePathString(startDir, "idx-def.txt");
+    tmp_path = filePathString(startDir, "idx-tmp.txt");
+    tmp_offpath = filePathString(startDir, "idx-tmp.off");
+    tmp_dirpath = filePathString(startDir, "idx-dir-tmp.txt");
+    max_idx = -1;
     int idx_file_size = indexFileTSize();
     LOGI("Index file size: %d", idx_file_size);
     String keyNew =
         String(startDir) + "|" + extension + "|" + file_name_pattern;
     String keyOld = getIndexDef();
-    if (setupIndex && (keyNew != keyOld || idx_file_size == 0)) {
-      FileT idxfile = p_sd->open(idx_path.c_str(), FILE_WRITE);
+    bool is_offset_valid = isOffsetFileValid();
+    // update() removes the offset table before it replaces the index files
+    bool is_interrupted = !is_offset_valid && p_sd->exists(tmp_offpath.c_str());
+    removeTempFiles();
+    if (setupIndex && (keyNew != keyOld || idx_file_size == 0 ||
+                       is_interrupted || !p_sd->exists(idx_dirpath.c_str()))) {
       LOGW("Creating index file");
-      listDir(idxfile, startDir);
+      createIndex(idx_path.c_str(), idx_offpath.c_str(), idx_dirpath.c_str(),
+                  nullptr);
       LOGI("Indexing completed");
-      idxfile.close();
       // update index definition file
       saveIndexDef(keyNew);
+    } else if (idx_file_size > 0 && !is_offset_valid) {
+      LOGW("Creating offset file");
+      createOffsets();
+    }
+  }
+
+  /// Rescans only the directories whose content has changed since the index
+  /// was built and returns the number of rescanned directories.
+  int update() {
+    TRACED();
+    List<DirRecord> changed;
+    findChangedDirectories(changed);
+    if (changed.empty()) {
+      LOGI("Index is up to date");
+      return 0;
     }
+    createIndex(tmp_path.c_str(), tmp_offpath.c_str(), tmp_dirpath.c_str(),
+                &changed);
+    // the offset table is removed first and renamed last: if we are
+    // interrupted, begin() finds no valid offset table and repairs the index
+    p_sd->remove(idx_offpath.c_str());
+    replaceFile(tmp_path.c_str(), idx_path.c_str());
+    replaceFile(tmp_dirpath.c_str(), idx_dirpath.c_str());
+    replaceFile(tmp_offpath.c_str(), idx_offpath.c_str());
+    max_idx = -1;
+    LOGI("Index updated: %d directories rescanned", (int)changed.size());
+    return changed.size();
   }
 
   void ls(Print &p, const char *startDir, const char *extension,
@@ -61,54 +199,42 @@ class SDIndex {
       LOGE("idx %d is negative", idx);
       return nullptr;
     }
-    
+
     // return null when idx too big
-    if (max_idx >= 0 && idx >= max_idx) {
-      LOGE("idx %d >= size %d", idx, max_idx);
+    long count = size();
+    if (idx >= count) {
+      LOGE("idx %d >= size %d", idx, (int)count);
       return nullptr;
     }
-    
-    // find record
+
+    // determine the position of the entry
+    uint32_t range[2];
+    if (!readOffsets(idx, range) || range[1] < range[0]) {
+      LOGE("Invalid offset file: %s", idx_offpath.c_str());
+      return nullptr;
+    }
+
+    // read the entry
     FileT idxfile = p_sd->open(idx_path.c_str());
-    
-    // Check if file was successfully opened
     if (!idxfile) {
       LOGE("Failed to open index file: %s", idx_path.c_str());
       return nullptr;
     }
-    
-    int count = 0;
-
-    if (idxfile.available() == 0) {
-      LOGE("Index file is empty");
+    int len = range[1] - range[0];
+    entry.resize(len + 1);
+    if (!idxfile.seek(range[0]) ||
+        idxfile.read((uint8_t *)entry.data(), len) != len) {
+      LOGE("Failed to read index entry %d", idx);
       idxfile.close();
       return nullptr;
     }
-
-    bool found = false;
-    while (idxfile.available() > 0 && !found) {
-      result = idxfile.readStringUntil('\n');
-
-      // result c-string
-      char *c_str = (char *)result.c_str();
-      // remove potential cr character - hax to avoid any allocations
-      int lastPos = result.length() - 1;
-      if (c_str[lastPos] == 13) {
-        c_str[lastPos] = 0;
-      }
-
-      LOGD("%d -> %s", count, c_str);
-      if (count == idx) {
-        found = true;
-      }
-      count++;
-    }
-    if (!found) {
-      max_idx = count - 1; // Fix: count represents total entries, max valid index is count-1
-    }
     idxfile.close();
 
-    return found ? result.c_str() : nullptr;
+    // remove the line end
+    while (len > 0 && (entry[len - 1] == '\n' || entry[len - 1] == '\r')) len--;
+    entry[len] = 0;
+    LOGD("%d -> %s", idx, entry.data());
+    return entry.data();
   }
 
   /// Find the index of a filename
@@ -164,27 +290,40 @@ class SDIndex {
     return -1;
   }
 
+  /// Number of entries: determined by the size of the offset table
   long size() {
     if (max_idx == -1) {
-      FileT idxfile = p_sd->open(idx_path.c_str());
-      int count = 0;
-
-      while (idxfile.available() > 0) {
-        result = idxfile.readStringUntil('\n');
-        // result c-string
-        char *c_str = (char *)result.c_str();
-        count++;
-      }
-      idxfile.close();
-      max_idx = count;
+      FileT offfile = p_sd->open(idx_offpath.c_str());
+      long file_size = offfile ? (long)offfile.size() : 0;
+      offfile.close();
+      int header = SDIndexWriter<FileT>::kHeaderSize;
+      max_idx = file_size >= header + 4 ? (file_size - header) / 4 - 1 : 0;
     }
     return max_idx;
   }
 
  protected:
+  /// Entries of a directory (incl. subdirectories) in the index
+  struct DirRecord {
+    long first = 0;
+    long count = 0;
+    long new_count = 0;
+    uint32_t signature = 0;
+    long order = 0;
+    String path;
+  };
+  static constexpr uint32_t kSignatureStart = 2166136261u;
   String result;
   String idx_path;
+  String idx_offpath;
+  String idx_dirpath;
   String idx_defpath;
+  String tmp_path;
+  String tmp_offpath;
+  String tmp_dirpath;
+  Vector<char> entry;
+  SDIndexWriter<FileT> *p_writer = nullptr;
+  FileT *p_dir_file = nullptr;
   SDT *p_sd = nullptr;
   List<String> file_path_stack;
   String file_path_str;
@@ -219,9 +358,12 @@ class SDIndex {
       return;
     }
 
+    long first = p_writer != nullptr ? p_writer->count() : 0;
+    uint32_t signature = kSignatureStart;
     rewind(root);
     FileT file = openNext(root);
     while (file) {
+      signature = updateSignature(signature, fileName(file));
       if (isDirectory(file)) {
         String name = String(fileNamePath(file));
         LOGD("name: %s", name.c_str());
@@ -238,9 +380,307 @@ class SDIndex {
       }
       file = openNext(root);
     }
+    if (p_writer != nullptr) {
+      writeDirRecord(first, p_writer->count() - first, signature, dirname);
+    }
     popPath();
   }
 
+  /// (Re)creates the index files: if changed directories are provided, only
+  /// these are rescanned and the rest is taken from the actual index
+  void createIndex(const char *path, const char *offPath, const char *dirPath,
+                   List<DirRecord> *p_changed) {
+    FileT idxfile = openWrite(path);
+    FileT offfile = openWrite(offPath);
+    SDIndexWriter<FileT> writer;
+    writer.begin(idxfile, offfile);
+    p_writer = &writer;
+    if (p_changed == nullptr) {
+      FileT dirfile = openWrite(dirPath);
+      p_dir_file = &dirfile;
+      listDir(writer, start_dir);
+      dirfile.close();
+    } else {
+      String new_dirpath = filePathString(start_dir, "idx-dir-new.txt");
+      FileT new_dirfile = openWrite(new_dirpath.c_str());
+      p_dir_file = &new_dirfile;
+      mergeEntries(writer, *p_changed);
+      new_dirfile.close();
+      mergeDirRecords(dirPath, new_dirpath.c_str(), *p_changed);
+      p_sd->remove(new_dirpath.c_str());
+    }
+    writer.end();
+    p_writer = nullptr;
+    p_dir_file = nullptr;
+    file_path_stack.clear();
+    idxfile.close();
+    offfile.close();
+  }
+
+  /// Copies the entries of the actual index and replaces the entries of the
+  /// changed directories by a rescan
+  void mergeEntries(SDIndexWriter<FileT> &writer, List<DirRecord> &changed) {
+    FileT idxfile = p_sd->open(idx_path.c_str());
+    long pos = 0;
+    for (auto &dir : changed) {
+      for (; pos < dir.first; pos++) copyEntry(idxfile, writer);
+      for (; pos < dir.first + dir.count; pos++) idxfile.readStringUntil('\n');
+      LOGI("Rescanning %s", dir.path.c_str());
+      long first = writer.count();
+      setPath(dir.path.c_str());
+      listDir(writer, dir.path.c_str());
+      file_path_stack.clear();
+      dir.new_count = writer.count() - first;
+    }
+    while (idxfile.available() > 0) copyEntry(idxfile, writer);
+    idxfile.close();
+  }
+
+  void copyEntry(FileT &idxfile, Print &out) {
+    String line = idxfile.readStringUntil('\n');
+    int len = line.length();
+    if (len > 0 && line.c_str()[len - 1] == '\r') line.remove(len - 1);
+    out.println(line.c_str());
+  }
+
+  /// Writes the directory records: the records of the rescanned directories
+  /// are taken from newDirPath and the others are adjusted to the new
+  /// positions
+  void mergeDirRecords(const char *dirPath, const char *newDirPath,
+                       List<DirRecord> &changed) {
+    FileT newfile = p_sd->open(newDirPath);
+    FileT oldfile = p_sd->open(idx_dirpath.c_str());
+    FileT dirfile = openWrite(dirPath);
+    p_dir_file = &dirfile;
+    DirRecord rec;
+    long order = 0;
+    while (readDirRecord(oldfile, rec, order++)) {
+      bool skip = false;
+      for (auto &dir : changed) {
+        if (rec.path == dir.path) {
+          // copy the new records of the subtree: the root is the last one
+          DirRecord new_rec;
+          while (readDirRecord(newfile, new_rec, 0)) {
+            writeDirRecord(new_rec.first, new_rec.count, new_rec.signature,
+                           new_rec.path.c_str());
+            if (new_rec.path == dir.path) break;
+          }
+          skip = true;
+        } else if (isSubdirectory(rec.path, dir.path)) {
+          skip = true;
+        } else if (isSubdirectory(dir.path, rec.path)) {
+          rec.count += dir.new_count - dir.count;
+        } else if (dir.order < rec.order) {
+          rec.first += dir.new_count - dir.count;
+        }
+      }
+      if (!skip) {
+        writeDirRecord(rec.first, rec.count, rec.signature, rec.path.c_str());
+      }
+    }
+    oldfile.close();
+    newfile.close();
+    dirfile.close();
+  }
+
+  /// Compares the directory signatures with the actual content
+  void findChangedDirectories(List<DirRecord> &changed) {
+    FileT dirfile = p_sd->open(idx_dirpath.c_str());
+    if (!dirfile) {
+      LOGE("Failed to open %s", idx_dirpath.c_str());
+      return;
+    }
+    DirRecord rec;
+    long order = 0;
+    while (readDirRecord(dirfile, rec, order++)) {
+      if (directorySignature(rec.path.c_str()) == rec.signature) continue;
+      LOGI("Changed: %s", rec.path.c_str());
+      // the subdirectories are listed before the parent: remove them
+      auto it = changed.begin();
+      while (it != changed.end()) {
+        if (isSubdirectory((*it).path, rec.path)) {
+          auto next = it;
+          ++next;
+          changed.erase(it);
+          it = next;
+        } else {
+          ++it;
+        }
+      }
+      changed.push_back(rec);
+    }
+    dirfile.close();
+  }
+
+  /// Signature of the names in a directory: 0 if it does not exist
+  uint32_t directorySignature(const char *dirname) {
+    FileT root = open(dirname);
+    if (!root || !isDirectory(root)) return 0;
+    uint32_t signature = kSignatureStart;
+    rewind(root);
+    FileT file = openNext(root);
+    while (file) {
+      signature = updateSignature(signature, fileName(file));
+      file = openNext(root);
+    }
+    return signature;
+  }
+
+  /// FNV-1a hash over the file names: our own index files are ignored
+  uint32_t updateSignature(uint32_t signature, const char *name) {
+    StrView name_str(name);
+    if (name_str.startsWith("idx") &&
+        (name_str.endsWith(".txt") || name_str.endsWith(".off"))) {
+      return signature;
+    }
+    for (const char *p = name; *p != 0; p++) {
+      signature = (signature ^ (uint8_t)*p) * 16777619u;
+    }
+    return (signature ^ '/') * 16777619u;
+  }
+
+  bool isSubdirectory(String &path, String &parent) {
+    if (!path.startsWith(parent) || path.length() <= parent.length()) {
+      return false;
+    }
+    return parent.endsWith("/") || path.c_str()[parent.length()] == '/';
+  }
+
+  /// Defines the path stack for a directory below the start directory
+  void setPath(const char *dirname) {
+    file_path_stack.clear();
+    StrView dir(dirname);
+    int pos = StrView(start_dir).length();
+    while (pos < dir.length()) {
+      if (dirname[pos] == '/') {
+        pos++;
+        continue;
+      }
+      int end = dir.indexOf('/', pos);
+      if (end < 0) end = dir.length();
+      String name;
+      for (int j = pos; j < end; j++) name += dirname[j];
+      pushPath(name.c_str());
+      pos = end;
+    }
+  }
+
+  void writeDirRecord(long first, long count, uint32_t signature,
+                      const char *path) {
+    char tmp[40];
+    snprintf(tmp, sizeof(tmp), "%ld|%ld|%lu|", first, count,
+             (unsigned long)signature);
+    p_dir_file->print(tmp);
+    p_dir_file->println(path);
+  }
+
+  bool readDirRecord(FileT &file, DirRecord &rec, long order) {
+    while (file.available() > 0) {
+      String line = file.readStringUntil('\n');
+      int len = line.length();
+      if (len > 0 && line.c_str()[len - 1] == '\r') line.remove(len - 1);
+      unsigned long signature = 0;
+      int path_pos = 0;
+      if (sscanf(line.c_str(), "%ld|%ld|%lu|%n", &rec.first, &rec.count,
+                 &signature, &path_pos) < 3 ||
+          path_pos == 0) {
+        LOGW("Invalid directory record: %s", line.c_str());
+        continue;
+      }
+      rec.signature = signature;
+      rec.path = line.c_str() + path_pos;
+      rec.order = order;
+      rec.new_count = rec.count;
+      return true;
+    }
+    return false;
+  }
+
+  /// Reads the start and end position of an entry from the offset table
+  bool readOffsets(int idx, uint32_t range[2]) {
+    FileT offfile = p_sd->open(idx_offpath.c_str());
+    if (!offfile) return false;
+    uint8_t tmp[8];
+    bool ok = offfile.seek(SDIndexWriter<FileT>::kHeaderSize + 4 * idx) &&
+              offfile.read(tmp, 8) == 8;
+    offfile.close();
+    if (!ok) return false;
+    for (int j = 0; j < 2; j++) {
+      const uint8_t *p = tmp + 4 * j;
+      range[j] = (uint32_t)p[0] | ((uint32_t)p[1] << 8) |
+                 ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+    }
+    return true;
+  }
+
+  bool isOffsetFileValid() {
+    FileT offfile = p_sd->open(idx_offpath.c_str());
+    if (!offfile) return false;
+    uint8_t tmp[8] = {0};
+    bool result = offfile.size() >= SDIndexWriter<FileT>::kHeaderSize + 4 &&
+                  offfile.read(tmp, 8) == 8 && memcmp(tmp, "SDIX", 4) == 0 &&
+                  tmp[4] == SDIndexWriter<FileT>::kVersion;
+    offfile.close();
+    return result;
+  }
+
+  /// Opens a new empty file for writing
+  FileT openWrite(const char *path) {
+    if (p_sd->exists(path)) p_sd->remove(path);
+    return p_sd->open(path, FILE_WRITE);
+  }
+
+  /// Replaces the file by renaming the new version: if the file system does
+  /// not support rename() the new version is copied
+  void replaceFile(const char *from, const char *to) {
+    if (p_sd->exists(to)) p_sd->remove(to);
+    if (sdindex_detail::renameIfAvailable(*p_sd, from, to)) return;
+    if (!copyFile(from, to)) {
+      LOGE("Rename failed: %s", from);
+      return;
+    }
+    p_sd->remove(from);
+  }
+
+  bool copyFile(const char *from, const char *to) {
+    FileT in = p_sd->open(from);
+    if (!in) return false;
+    FileT out = openWrite(to);
+    bool result = (bool)out;
+    uint8_t buffer[64];
+    while (result) {
+      int len = in.read(buffer, sizeof(buffer));
+      if (len <= 0) break;
+      result = out.write(buffer, len) == (size_t)len;
+    }
+    in.close();
+    if (out) out.close();
+    return result;
+  }
+
+  void removeTempFiles() {
+    if (p_sd->exists(tmp_path.c_str())) p_sd->remove(tmp_path.c_str());
+    if (p_sd->exists(tmp_offpath.c_str())) p_sd->remove(tmp_offpath.c_str());
+    if (p_sd->exists(tmp_dirpath.c_str())) p_sd->remove(tmp_dirpath.c_str());
+  }
+
+  /// Rebuilds the offset table from the existing index file
+  void createOffsets() {
+    FileT idxfile = p_sd->open(idx_path.c_str());
+    FileT offfile = openWrite(idx_offpath.c_str());
+    SDIndexWriter<FileT> writer;
+    writer.begin(offfile);
+    uint8_t tmp[512];
+    while (idxfile.available() > 0) {
+      int len = idxfile.read(tmp, sizeof(tmp));
+      if (len <= 0) break;
+      writer.write(tmp, len);
+    }
+    writer.end();
+    idxfile.close();
+    offfile.close();
+  }
+
   bool isDirectory(FileT &f) {
     bool result;
 #ifdef USE_SDFAT
@@ -301,7 +741,7 @@ class SDIndex {
     return key1;
   }
   void saveIndexDef(String keyNew) {
-    FileT idxdef = p_sd->open(idx_defpath.c_str(), FILE_WRITE);
+    FileT idxdef = openWrite(idx_defpath.c_str());
     idxdef.write((const uint8_t *)keyNew.c_str(), keyNew.length());
     idxdef.close();
   }
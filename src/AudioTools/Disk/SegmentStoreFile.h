@@ -0,0 +1,74 @@
+#pragma once
+
+#include <stdio.h>
+
+#include "AudioTools/AudioCodecs/SegmenterMP4.h"
+
+namespace audio_tools {
+
+/**
+ * @brief SegmentStore which keeps the segments of a SegmenterMP4 as rolling
+ * files in a directory (e.g. on a SD drive): the files of the segments which
+ * were dropped from the playlist are deleted again, so only the RAM for the
+ * segment which is currently recorded is needed.
+ *
+ * @code
+ * SegmentStoreFile<fs::SDFS, File> store(SD, "/hls");
+ * segmenter.setSegmentStore(store);
+ * @endcode
+ * @tparam SDT the file system class e.g. fs::SDFS or SdFat
+ * @tparam FileT the file class e.g. File
+ * @ingroup codecs
+ * @author Phil Schatzmann
+ * @copyright GPLv3
+ */
+template <class SDT, class FileT>
+class SegmentStoreFile : public SegmentStore {
+ public:
+  /// @param fs the file system which must already be started
+  /// @param directory existing directory for the segment files
+  SegmentStoreFile(SDT& fs, const char* directory = "") {
+    p_fs = &fs;
+    dir = directory;
+  }
+
+  /// Opens a new empty file: FILE_WRITE appends to an existing file e.g. on
+  /// SdFat, so a file from a previous recording is removed first
+  bool open(const char* name) override {
+    const char* file_path = path(name);
+    if (p_fs->exists(file_path)) p_fs->remove(file_path);
+    file = p_fs->open(file_path, FILE_WRITE);
+    return (bool)file;
+  }
+
+  size_t write(const uint8_t* data, size_t len) override {
+    return file.write(data, len);
+  }
+
+  void close() override { file.close(); }
+
+  void remove(const char* name) override { p_fs->remove(path(name)); }
+
+  size_t read(const char* name, size_t pos, uint8_t* data,
+              size_t len) override {
+    FileT in = p_fs->open(path(name));
+    if (!in) return 0;
+    size_t result = 0;
+    if (in.seek(pos)) result = in.read(data, len);
+    in.close();
+    return result;
+  }
+
+ protected:
+  SDT* p_fs = nullptr;
+  const char* dir = "";
+  FileT file;
+  char path_buffer[80];
+
+  const char* path(const char* name) {
+    snprintf(path_buffer, sizeof(path_buffer), "%s/%s", dir, name);
+    return path_buffer;
+  }
+};
+
+}  // namespace audio_tools
@@ -53,6 +53,19 @@ class FFTDriverCmsisFFT : public FFTDriver {
             input[idx]  = value; 
         }
 
+        void setValues(const float *values, const float *window, int n) override {
+            if (window == nullptr) {
+                memcpy(input, values, n * sizeof(float));
+            } else {
+                arm_mult_f32((float*)values, (float*)window, input, n);
+            }
+        }
+
+        /// The magnitudes have already been calculated by fft()
+        void magnitudes(float *result, int n) override {
+            memcpy(result, output_magn, n * sizeof(float));
+        }
+
         void fft() override {
             TRACED();
 		    arm_rfft_fast_f32(&fft_instance, input, output, false);
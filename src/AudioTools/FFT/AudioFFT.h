@@ -101,7 +101,9 @@ class FFTInverseOverlapAdder {
     rfft_max = 0.0;
     // define new size
     len = size;
-    if (!data.resize(size)) {
+    // Vector::resize() also reports false if the size did not change
+    data.resize(size);
+    if (size > 0 && data.data() == nullptr) {
       LOGE("Could not resize data");
       return false;
     }
@@ -187,6 +189,31 @@ class FFTDriver {
   bool setBin(int pos, FFTBin &bin) { return setBin(pos, bin.real, bin.img); }
   /// gets the value of a bin
   virtual bool getBin(int pos, FFTBin &bin) { return false; }
+  /// Sets all len input values at once: each value is multiplied with the
+  /// corresponding window factor (if window is not null). Drivers override
+  /// this to avoid the virtual setValue() call per sample.
+  virtual void setValues(const float *values, const float *window, int len) {
+    if (window == nullptr) {
+      for (int j = 0; j < len; j++) setValue(j, values[j]);
+    } else {
+      for (int j = 0; j < len; j++) setValue(j, values[j] * window[j]);
+    }
+  }
+  /// Calculates the magnitudes of the bins 0 to len-1
+  virtual void magnitudes(float *result, int len) {
+    for (int j = 0; j < len; j++) result[j] = magnitude(j);
+  }
+  /// Calculates the magnitudes w/o square root of the bins 0 to len-1
+  virtual void magnitudesFast(float *result, int len) {
+    for (int j = 0; j < len; j++) result[j] = magnitudeFast(j);
+  }
+  /// Calculates the phases of the bins 0 to len-1
+  virtual void phases(float *result, int len) {
+    FFTBin bin;
+    for (int j = 0; j < len; j++) {
+      result[j] = getBin(j, bin) ? atan2(bin.img, bin.real) : 0.0f;
+    }
+  }
 };
 
 /**
@@ -244,11 +271,17 @@ class AudioFFTBase : public AudioStream {
         cfg.window_function_ifft != cfg.window_function_fft) {
       cfg.window_function_ifft->begin(cfg.length);
     }
+    if (cfg.stride > cfg.length) {
+      LOGE("stride %d must not be bigger then the length %d", cfg.stride,
+           cfg.length);
+      return false;
+    }
 
     bool is_valid_rxtx = false;
     if (cfg.rxtx_mode == TX_MODE || cfg.rxtx_mode == RXTX_MODE) {
-      // holds last N bytes that need to be reprocessed
-      stride_buffer.resize((cfg.length) * bytesPerSample());
+      // holds the last length samples: the overlap is reprocessed
+      fft_input.resize(cfg.length);
+      setupWindowFactors();
       is_valid_rxtx = true;
     }
     if (cfg.rxtx_mode == RX_MODE || cfg.rxtx_mode == RXTX_MODE) {
@@ -276,6 +309,7 @@ class AudioFFTBase : public AudioStream {
     if (cfg.window_function_ifft != nullptr) {
       cfg.window_function_ifft->begin(cfg.length);
     }
+    if (fft_input.size() > 0) setupWindowFactors();
   }
 
   operator bool() override {
@@ -294,6 +328,9 @@ class AudioFFTBase : public AudioStream {
   void end() override {
     p_driver->end();
     l_magnitudes.resize(0);
+    l_phases.resize(0);
+    fft_input.resize(0);
+    window_factors.resize(0);
     rfft_data.resize(0);
     rfft_add.resize(0);
     step_data.resize(0);
@@ -605,9 +642,7 @@ class AudioFFTBase : public AudioStream {
     if (l_magnitudes.size() == 0) {
       l_magnitudes.resize(size());
     }
-    for (int j = 0; j < size(); j++) {
-      l_magnitudes[j] = magnitude(j);
-    }
+    p_driver->magnitudes(l_magnitudes.data(), size());
     return l_magnitudes.data();
   }
 
@@ -617,12 +652,20 @@ class AudioFFTBase : public AudioStream {
     if (l_magnitudes.size() == 0) {
       l_magnitudes.resize(size());
     }
-    for (int j = 0; j < size(); j++) {
-      l_magnitudes[j] = magnitudeFast(j);
-    }
+    p_driver->magnitudesFast(l_magnitudes.data(), size());
     return l_magnitudes.data();
   }
 
+  /// Provides the phases as array of size size(). Please note that this
+  /// method is allocating additinal memory!
+  float *phases() {
+    if (l_phases.size() == 0) {
+      l_phases.resize(size());
+    }
+    p_driver->phases(l_phases.data(), size());
+    return l_phases.data();
+  }
+
   /// sets the value of a bin
   bool setBin(int idx, float real, float img) {
     has_rfft_data = true;
@@ -662,50 +705,69 @@ class AudioFFTBase : public AudioStream {
   AudioFFTConfig cfg;
   FFTInverseOverlapAdder rfft_add{0};
   Vector<float> l_magnitudes{0};
+  Vector<float> l_phases{0};
   Vector<float> step_data{0};
   Vector<float> mel_bins{0};
-  SingleBuffer<uint8_t> stride_buffer{0};
+  // scaled input samples of the channel_used
+  Vector<float> fft_input{0};
+  int fft_input_pos = 0;
+  // precalculated factors of window_function_fft (empty if not defined)
+  Vector<float> window_factors{0};
   RingBuffer<uint8_t> rfft_data{0};
   bool has_rfft_data = false;
 
-  // Add samples to input data p_x - and process them if full
+  // Add samples to the input data - and process them if full
   template <typename T>
   void processSamples(const void *data, size_t count) {
-    T *dataT = (T *)data;
-    T sample;
-    for (int j = 0; j < count; j += cfg.channels) {
-      sample = dataT[j + cfg.channel_used];
-      if (writeStrideBuffer((uint8_t *)&sample, sizeof(T))) {
-        // process data if buffer is full
-        T *samples = (T *)stride_buffer.data();
-        int sample_count = stride_buffer.size() / sizeof(T);
-        assert(sample_count == cfg.length);
-        for (int j = 0; j < sample_count; j++) {
-          T out_sample = samples[j];
-          T windowed_sample = windowedSample(out_sample, j);
-          float scaled_sample =
-              1.0f / NumberConverter::maxValueT<T>() * windowed_sample;
-          p_driver->setValue(j, scaled_sample);
-        }
+    const T *dataT = (const T *)data;
+    const int channels = cfg.channels;
+    const float scale = 1.0f / NumberConverter::maxValueT<T>();
+    size_t frames = count / channels;
+    size_t frame = 0;
+    while (frame < frames) {
+      // copy as many samples as possible in one go
+      size_t n = cfg.length - fft_input_pos;
+      if (n > frames - frame) n = frames - frame;
+      const T *src = dataT + frame * channels + cfg.channel_used;
+      float *dest = fft_input.data() + fft_input_pos;
+      for (size_t j = 0; j < n; j++) {
+        T sample = src[j * channels];
+        dest[j] = scale * static_cast<float>(sample);
+      }
+      fft_input_pos += n;
+      frame += n;
 
-        fft<T>();
+      // process data if buffer is full
+      if (fft_input_pos == cfg.length) {
+        p_driver->setValues(
+            fft_input.data(),
+            window_factors.size() > 0 ? window_factors.data() : nullptr,
+            cfg.length);
 
-        // remove stride samples
-        stride_buffer.clearArray(cfg.stride * sizeof(T));
+        fft<T>();
 
-        // validate available data in stride buffer
-        if (cfg.stride == cfg.length) assert(stride_buffer.available() == 0);
+        // remove stride samples and keep the overlap
+        int keep = cfg.length - cfg.stride;
+        if (keep > 0) {
+          memmove(fft_input.data(), fft_input.data() + cfg.stride,
+                  keep * sizeof(float));
+        }
+        fft_input_pos = keep;
       }
     }
   }
 
-  template <typename T>
-  T windowedSample(T sample, int pos) {
-    T result = sample;
-    if (cfg.window_function_fft != nullptr) {
-      result = cfg.window_function_fft->factor(pos) * sample;
+  /// Precalculates the factors of the fft window function
+  void setupWindowFactors() {
+    fft_input_pos = 0;
+    if (cfg.window_function_fft == nullptr) {
+      window_factors.resize(0);
+      return;
+    }
+    window_factors.resize(cfg.length);
+    for (int j = 0; j < cfg.length; j++) {
+      window_factors[j] = cfg.window_function_fft->factor(j);
     }
-    return result;
   }
 
   template <typename T>
@@ -795,13 +857,6 @@ class AudioFFTBase : public AudioStream {
     }
   }
 
-  // adds samples to stride buffer, returns true if the buffer is full
-  bool writeStrideBuffer(uint8_t *buffer, size_t len) {
-    assert(stride_buffer.availableForWrite() >= len);
-    stride_buffer.writeArray(buffer, len);
-    return stride_buffer.isFull();
-  }
-
   bool isPowerOfTwo(uint16_t x) { return (x & (x - 1)) == 0; }
 };
 
@@ -36,6 +36,16 @@ class FFTDriverKissFFT : public FFTDriver {
         }
         void setValue(int idx, float value) override {
             k_data[idx].r  = value; 
+            // clear any leftover from a prior rfft()
+            k_data[idx].i  = 0.0f;
+        }
+
+        void setValues(const float *values, const float *window, int n) override {
+            kiss_fft_cpx *data = k_data.data();
+            for (int j = 0; j < n; j++) {
+                data[j].r = window == nullptr ? values[j] : values[j] * window[j];
+                data[j].i = 0.0f;
+            }
         }
 
         void fft() override {
@@ -58,6 +68,18 @@ class FFTDriverKissFFT : public FFTDriver {
             return (k_data[idx].r * k_data[idx].r + k_data[idx].i * k_data[idx].i);
         }
 
+        void magnitudesFast(float *result, int n) override {
+            const kiss_fft_cpx *data = k_data.data();
+            for (int j = 0; j < n; j++) {
+                result[j] = data[j].r * data[j].r + data[j].i * data[j].i;
+            }
+        }
+
+        void magnitudes(float *result, int n) override {
+            magnitudesFast(result, n);
+            for (int j = 0; j < n; j++) result[j] = sqrt(result[j]);
+        }
+
         bool isValid() override{ return p_fft_object!=nullptr; }
 
         bool isReverseFFT() override {return true;}
@@ -49,6 +49,15 @@ class FFTDriverRealFFT : public FFTDriver {
             v_x[idx] = value; 
         }
 
+        void setValues(const float *values, const float *window, int n) override {
+            float *x = v_x.data();
+            if (window == nullptr) {
+                memcpy(x, values, n * sizeof(float));
+            } else {
+                for (int j = 0; j < n; j++) x[j] = values[j] * window[j];
+            }
+        }
+
         void fft() override{
             memset(v_f.data(),0,len*sizeof(float));
             p_fft_object->do_fft(v_f.data(), v_x.data());    
@@ -81,6 +90,31 @@ class FFTDriverRealFFT : public FFTDriver {
             return (re * re) + (im * im);
         }
 
+        void magnitudes(float *result, int n) override {
+            magnitudesFast(result, n);
+            for (int j = 0; j < n; j++) result[j] = sqrt(result[j]);
+        }
+
+        void magnitudesFast(float *result, int n) override {
+            const float *re = v_f.data();
+            const float *im = v_f.data() + len / 2;
+            result[0] = re[0] * re[0];
+            for (int j = 1; j < n && j < len / 2; j++) {
+                result[j] = (re[j] * re[j]) + (im[j] * im[j]);
+            }
+            if (n > len / 2) result[len / 2] = re[len / 2] * re[len / 2];
+        }
+
+        void phases(float *result, int n) override {
+            const float *re = v_f.data();
+            const float *im = v_f.data() + len / 2;
+            result[0] = atan2(0.0f, re[0]);
+            for (int j = 1; j < n && j < len / 2; j++) {
+                result[j] = atan2(-im[j], re[j]);
+            }
+            if (n > len / 2) result[len / 2] = atan2(0.0f, re[len / 2]);
+        }
+
         bool isValid() override{ return p_fft_object!=nullptr; }
 
         /// Get the reconstructed time-domain sample. Only meaningful after
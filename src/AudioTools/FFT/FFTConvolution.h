@@ -0,0 +1,216 @@
+#pragma once
+
+#include "AudioTools/CoreAudio/AudioFilter/Filter.h"
+#include "AudioTools/FFT/AudioFFT.h"
+
+namespace audio_tools {
+
+/**
+ * @brief Convolution with long impulse responses (e.g. reverb or loudspeaker
+ * correction with thousands of taps) using a uniformly partitioned
+ * overlap-save algorithm: the impulse response is split into partitions of
+ * partitionSize samples which are transformed once in begin(). For each block
+ * of partitionSize input samples we need one forward and one inverse FFT of
+ * 2 * partitionSize points plus a complex multiply-add per partition, instead
+ * of irLen multiply-adds per sample. The output is delayed by one partition.
+ *
+ * The FFT is provided by any FFTDriver that supports the reverse FFT (e.g.
+ * FFTDriverRealFFT). Each channel needs its own filter and driver instance.
+ * To process a stream just assign the filter to a FilteredStream<T, float>.
+ * @ingroup filter
+ * @ingroup fft
+ * @author Phil Schatzmann
+ * @copyright GPLv3
+ */
+class FFTConvolutionFilter : public Filter<float> {
+ public:
+  FFTConvolutionFilter(FFTDriver &driver) { p_driver = &driver; }
+  ~FFTConvolutionFilter() { end(); }
+
+  /// Defines the impulse response: the partitionSize must be a power of 2
+  bool begin(const float *ir, size_t irLen, int partitionSize = 512) {
+    if (ir == nullptr || irLen == 0) {
+      LOGE("No impulse response");
+      return false;
+    }
+    if (partitionSize <= 0 || (partitionSize & (partitionSize - 1)) != 0) {
+      LOGE("partitionSize must be a power of 2: %d", partitionSize);
+      return false;
+    }
+    if (!p_driver->isReverseFFT()) {
+      LOGE("The FFTDriver does not support the reverse FFT");
+      return false;
+    }
+    block_size = partitionSize;
+    fft_len = 2 * partitionSize;
+    bins = partitionSize + 1;
+    partitions = (irLen + partitionSize - 1) / partitionSize;
+    if (!p_driver->begin(fft_len) || !p_driver->isValid()) {
+      LOGE("FFTDriver begin failed for %d", fft_len);
+      return false;
+    }
+
+    ir_spectra.resize(partitions * bins);
+    input_spectra.resize(partitions * bins);
+    acc.resize(bins);
+    input_buffer.resize(fft_len);
+    output_buffer.resize(block_size);
+
+    // transform all partitions of the impulse response
+    float scale = driverScale();
+    for (int p = 0; p < partitions; p++) {
+      for (int j = 0; j < fft_len; j++) {
+        size_t idx = (size_t)p * block_size + j;
+        float value = (j < block_size && idx < irLen) ? ir[idx] : 0.0f;
+        p_driver->setValue(j, value);
+      }
+      p_driver->fft();
+      FFTBin *spectrum = &ir_spectra[p * bins];
+      for (int k = 0; k < bins; k++) {
+        p_driver->getBin(k, spectrum[k]);
+        // fold the normalization of the driver into the coefficients
+        spectrum[k].multiply(scale);
+      }
+    }
+    reset();
+    LOGI("FFTConvolutionFilter: %d partitions of %d samples", partitions,
+         block_size);
+    return true;
+  }
+
+  /// Releases the allocated memory
+  void end() {
+    ir_spectra.resize(0);
+    input_spectra.resize(0);
+    acc.resize(0);
+    input_buffer.resize(0);
+    output_buffer.resize(0);
+    partitions = 0;
+  }
+
+  /// Clears the input history without changing the impulse response
+  void reset() override {
+    for (int j = 0; j < input_spectra.size(); j++) input_spectra[j].clear();
+    for (int j = 0; j < input_buffer.size(); j++) input_buffer[j] = 0.0f;
+    for (int j = 0; j < output_buffer.size(); j++) output_buffer[j] = 0.0f;
+    fdl_pos = 0;
+    pos = 0;
+  }
+
+  float process(float in) override {
+    if (partitions == 0) return in;
+    input_buffer[block_size + pos] = in;
+    float result = output_buffer[pos];
+    if (++pos == block_size) {
+      processBlock();
+      pos = 0;
+    }
+    return result;
+  }
+
+  void process(const float *in, float *out, size_t len) override {
+    if (partitions == 0) {
+      Filter<float>::process(in, out, len);
+      return;
+    }
+    size_t done = 0;
+    while (done < len) {
+      size_t n = block_size - pos;
+      if (n > len - done) n = len - done;
+      // in and out might be the same: save the input first
+      memcpy(&input_buffer[block_size + pos], in + done, n * sizeof(float));
+      memcpy(out + done, &output_buffer[pos], n * sizeof(float));
+      pos += n;
+      done += n;
+      if (pos == block_size) {
+        processBlock();
+        pos = 0;
+      }
+    }
+  }
+
+  /// Delay of the output in samples
+  int latency() { return block_size; }
+
+  /// Number of partitions of the impulse response
+  int partitionCount() { return partitions; }
+
+ protected:
+  FFTDriver *p_driver = nullptr;
+  Vector<FFTBin> ir_spectra;
+  Vector<FFTBin> input_spectra;  // frequency domain delay line
+  Vector<FFTBin> acc;
+  Vector<float> input_buffer;  // previous block + current block
+  Vector<float> output_buffer;
+  int block_size = 0;
+  int fft_len = 0;
+  int bins = 0;
+  int partitions = 0;
+  int fdl_pos = 0;
+  int pos = 0;
+
+  void processBlock() {
+    // forward fft of the last 2 blocks
+    for (int j = 0; j < fft_len; j++) p_driver->setValue(j, input_buffer[j]);
+    p_driver->fft();
+    FFTBin *current = &input_spectra[fdl_pos * bins];
+    for (int k = 0; k < bins; k++) p_driver->getBin(k, current[k]);
+
+    // multiply-add the spectra: partition p is applied to the input which is
+    // p blocks old
+    for (int k = 0; k < bins; k++) acc[k].clear();
+    int input_idx = fdl_pos;
+    for (int p = 0; p < partitions; p++) {
+      const FFTBin *x = &input_spectra[input_idx * bins];
+      const FFTBin *h = &ir_spectra[p * bins];
+      FFTBin *y = acc.data();
+      for (int k = 0; k < bins; k++) {
+        y[k].real += x[k].real * h[k].real - x[k].img * h[k].img;
+        y[k].img += x[k].real * h[k].img + x[k].img * h[k].real;
+      }
+      if (--input_idx < 0) input_idx = partitions - 1;
+    }
+
+    // inverse fft: drivers with a full complex buffer need the conjugate
+    // symmetric upper half, the others just ignore it
+    for (int k = 0; k < bins; k++) {
+      p_driver->setBin(k, acc[k].real, acc[k].img);
+      if (k > 0 && k < block_size) {
+        p_driver->setBin(fft_len - k, acc[k].real, -acc[k].img);
+      }
+    }
+    p_driver->rfft();
+
+    // overlap-save: only the 2nd half is free of circular aliasing
+    for (int j = 0; j < block_size; j++) {
+      output_buffer[j] = p_driver->getValue(block_size + j);
+    }
+    memmove(&input_buffer[0], &input_buffer[block_size],
+            block_size * sizeof(float));
+    if (++fdl_pos == partitions) fdl_pos = 0;
+  }
+
+  /// The drivers use different normalizations for fft + rfft: we determine
+  /// the factor with a unit impulse
+  float driverScale() {
+    for (int j = 0; j < fft_len; j++) p_driver->setValue(j, j == 0 ? 1.0f : 0.0f);
+    p_driver->fft();
+    FFTBin bin;
+    for (int k = 0; k < bins; k++) {
+      p_driver->getBin(k, bin);
+      p_driver->setBin(k, bin.real, bin.img);
+      if (k > 0 && k < block_size) {
+        p_driver->setBin(fft_len - k, bin.real, -bin.img);
+      }
+    }
+    p_driver->rfft();
+    float value = p_driver->getValue(0);
+    if (value == 0.0f) {
+      LOGE("Could not determine the FFT scaling");
+      return 1.0f;
+    }
+    return 1.0f / value;
+  }
+};
+
+}  // namespace audio_tools
@@ -99,6 +99,11 @@
 #  define DEFAULT_BITS_PER_SAMPLE 16
 #endif
 
+// chunk size of the unbuffered NumberFormatConverterStreamT
+#ifndef NFC_CHUNK_SAMPLES
+#  define NFC_CHUNK_SAMPLES 64
+#endif
+
 #ifndef I2S_DEFAULT_PORT 
 #  define I2S_DEFAULT_PORT 0
 #endif
@@ -319,6 +324,11 @@
 #  define USE_ALLOCATOR false
 #endif
 
+// Use SSE/AVX/NEON kernels (see AudioBasic/SIMD.h) when the compiler supports them
+#ifndef USE_SIMD
+#  define USE_SIMD true
+#endif
+
 #ifndef USE_ESP32_LOGGER
 #  define USE_ESP32_LOGGER false
 #endif
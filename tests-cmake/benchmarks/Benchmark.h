@@ -0,0 +1,99 @@
+#pragma once
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+
+#include "AudioTools.h"
+
+namespace audio_tools {
+
+/**
+ * @brief Minimal benchmark runner: each benchmark is a function which
+ * processes a block of audio and returns the number of processed samples. It
+ * is called repeatedly until the minimum measuring time has passed and the
+ * result is reported in ns/sample and samples/sec, so that the numbers of
+ * different runs can be compared.
+ */
+class BenchmarkRunner {
+ public:
+  struct Result {
+    const char *name;
+    long calls;
+    double samples;
+    double ns_per_sample;
+    double samples_per_sec;
+  };
+
+  /// Minimum measuring time per benchmark
+  void setMinTimeMs(int ms) { min_time_ms = ms; }
+
+  /// Only benchmarks which contain the indicated text are executed
+  void setFilter(const char *text) { filter = text; }
+
+  /// Measures the function: fn() returns the number of processed samples
+  template <class F>
+  void run(const char *name, F fn) {
+    if (filter != nullptr && strstr(name, filter) == nullptr) return;
+    // warm up caches and lazy allocations
+    fn();
+    long calls = 0;
+    double samples = 0;
+    auto start = Clock::now();
+    double elapsed_ns = 0;
+    do {
+      samples += fn();
+      calls++;
+      elapsed_ns = std::chrono::duration<double, std::nano>(Clock::now() -
+                                                            start)
+                       .count();
+    } while (elapsed_ns < min_time_ms * 1000000.0);
+
+    Result result;
+    result.name = name;
+    result.calls = calls;
+    result.samples = samples;
+    result.ns_per_sample = samples > 0 ? elapsed_ns / samples : 0;
+    result.samples_per_sec = elapsed_ns > 0 ? samples * 1e9 / elapsed_ns : 0;
+    results.push_back(result);
+    fprintf(stderr, "%-32s %10.2f ns/sample %14.0f samples/sec\n", name,
+            result.ns_per_sample, result.samples_per_sec);
+  }
+
+  /// Writes all results as JSON
+  void printJson(FILE *out) {
+    fprintf(out, "{\n  \"build\": {\"simd\": \"%s\", \"fixed_point\": %s},\n",
+            simdName(), PREFER_FIXEDPOINT ? "true" : "false");
+    fprintf(out, "  \"min_time_ms\": %d,\n  \"results\": [\n", min_time_ms);
+    for (int j = 0; j < results.size(); j++) {
+      Result &r = results[j];
+      fprintf(out,
+              "    {\"name\": \"%s\", \"calls\": %ld, \"samples\": %.0f, "
+              "\"ns_per_sample\": %.3f, \"samples_per_sec\": %.0f}%s\n",
+              r.name, r.calls, r.samples, r.ns_per_sample, r.samples_per_sec,
+              j + 1 < results.size() ? "," : "");
+    }
+    fprintf(out, "  ]\n}\n");
+  }
+
+  Vector<Result> &getResults() { return results; }
+
+ protected:
+  typedef std::chrono::steady_clock Clock;
+  Vector<Result> results;
+  int min_time_ms = 200;
+  const char *filter = nullptr;
+
+  static const char *simdName() {
+#if defined(AUDIO_SIMD_AVX)
+    return "avx";
+#elif defined(AUDIO_SIMD_SSE)
+    return "sse";
+#elif defined(AUDIO_SIMD_NEON)
+    return "neon";
+#else
+    return "none";
+#endif
+  }
+};
+
+}  // namespace audio_tools
@@ -0,0 +1,351 @@
+// Performance benchmarks for the DSP and streaming hot paths. The results are
+// printed to stderr and written as JSON to stdout or to the file indicated
+// with --json, so that they can be compared run over run.
+//
+// Usage: benchmarks [--json file] [--filter text] [--time ms]
+#include <cstdlib>
+
+#include "AudioTools.h"
+#include "AudioTools/Concurrency/LockFree/RingBufferSPSC.h"
+#include "AudioTools/FFT/AudioRealFFT.h"
+#include "Benchmark.h"
+
+#ifdef BENCHMARK_CODECS
+#include "AudioTools/AudioCodecs/CodecAACHelix.h"
+#include "AudioTools/AudioCodecs/CodecADPCM.h"
+#include "AudioTools/AudioCodecs/CodecMP3Helix.h"
+#include "AudioTools/AudioCodecs/CodecOpus.h"
+#include "BabyElephantWalk60_mp3.h"
+#include "audio.h"
+#endif
+
+using namespace audio_tools;
+
+const int kFrames = 1024;
+const int kChannels = 2;
+const int kSamples = kFrames * kChannels;
+AudioInfo info(44100, kChannels, 16);
+int16_t pcm[kSamples];
+NullStream null_out;
+
+/// Log output: stdout is reserved for the JSON result
+class StderrPrint : public Print {
+ public:
+  size_t write(uint8_t ch) override { return write(&ch, 1); }
+  size_t write(const uint8_t *data, size_t len) override {
+    return fwrite(data, 1, len, stderr);
+  }
+} log_out;
+
+/// Output which records the written bytes
+class RecordingPrint : public Print {
+ public:
+  size_t write(uint8_t ch) override { return write(&ch, 1); }
+  size_t write(const uint8_t *data, size_t len) override {
+    for (size_t j = 0; j < len; j++) {
+      uint8_t value = data[j];
+      bytes.push_back(value);
+    }
+    return len;
+  }
+  Vector<uint8_t> bytes;
+};
+
+/// Endless input which provides the test signal
+class PcmStream : public Stream {
+ public:
+  int available() override { return sizeof(pcm); }
+  size_t readBytes(uint8_t *data, size_t len) override {
+    size_t result = min(len, sizeof(pcm));
+    memcpy(data, pcm, result);
+    return result;
+  }
+  int read() override { return -1; }
+  int peek() override { return -1; }
+  size_t write(uint8_t) override { return 0; }
+};
+
+static void setupPcm() {
+  for (int j = 0; j < kSamples; j++) {
+    pcm[j] = (int16_t)(20000.0 * sin(j * 0.031) + (rand() % 2000) - 1000);
+  }
+}
+
+static size_t writePcm(Print &out) {
+  out.write((const uint8_t *)pcm, sizeof(pcm));
+  return kSamples;
+}
+
+static void benchmarkFilters(BenchmarkRunner &runner) {
+  static LowPassFilter<float> lowpass[kChannels];
+  static FilteredStream<int16_t, float> biquad(null_out, kChannels);
+  for (int ch = 0; ch < kChannels; ch++) {
+    lowpass[ch].begin(1000, info.sample_rate);
+    biquad.setFilter(ch, lowpass[ch]);
+  }
+  biquad.begin(info);
+  runner.run("filter/biquad-lowpass", [] { return writePcm(biquad); });
+
+  static float coef[32];
+  for (int j = 0; j < 32; j++) coef[j] = 1.0f / 32;
+  static FIR<float> fir_left(coef), fir_right(coef);
+  static FilteredStream<int16_t, float> fir_stream(null_out, kChannels);
+  fir_stream.setFilter(0, fir_left);
+  fir_stream.setFilter(1, fir_right);
+  fir_stream.begin(info);
+  runner.run("filter/fir-32", [] { return writePcm(fir_stream); });
+}
+
+static void benchmarkResample(BenchmarkRunner &runner) {
+  static ResampleStream up(null_out);
+  up.begin(info, 48000);
+  runner.run("resample/44100-48000", [] { return writePcm(up); });
+
+  static ResampleStream down(null_out);
+  down.begin(info, 16000);
+  runner.run("resample/44100-16000", [] { return writePcm(down); });
+}
+
+static void benchmarkConverters(BenchmarkRunner &runner) {
+  static NumberFormatConverterStreamT<int16_t, int32_t> to32(null_out);
+  to32.begin();
+  runner.run("converter/int16-int32", [] { return writePcm(to32); });
+
+  static NumberFormatConverterStreamT<int16_t, float> to_float(null_out);
+  to_float.begin();
+  runner.run("converter/int16-float", [] { return writePcm(to_float); });
+
+  static NumberFormatConverterStreamT<int16_t, int24_t> to24(null_out);
+  to24.begin();
+  runner.run("converter/int16-int24", [] { return writePcm(to24); });
+
+  static ChannelFormatConverterStreamT<int16_t> to_mono(null_out);
+  to_mono.begin(2, 1);
+  runner.run("converter/channels-2-1", [] { return writePcm(to_mono); });
+
+  static ChannelFormatConverterStreamT<int16_t> to_quad(null_out);
+  to_quad.begin(2, 4);
+  runner.run("converter/channels-2-4", [] { return writePcm(to_quad); });
+}
+
+static void benchmarkVolume(BenchmarkRunner &runner) {
+  static VolumeStream volume(null_out);
+  VolumeStreamConfig cfg;
+  cfg.copyFrom(info);
+  cfg.allow_boost = true;
+  cfg.volume = 0.5f;
+  volume.begin(cfg);
+  runner.run("volume/int16", [] { return writePcm(volume); });
+
+  // with an active ramp on every call
+  static float vol = 0.5f;
+  runner.run("volume/int16-ramp", [] {
+    vol = vol == 0.5f ? 0.25f : 0.5f;
+    volume.setVolume(vol);
+    return writePcm(volume);
+  });
+}
+
+static void benchmarkMixers(BenchmarkRunner &runner) {
+  static OutputMixer<int16_t> output_mixer(null_out, 4);
+  output_mixer.setAutoIndex(false);
+  output_mixer.begin(sizeof(pcm));
+  runner.run("mixer/output-4", [] {
+    for (int j = 0; j < 4; j++) {
+      output_mixer.write(j, (const uint8_t *)pcm, sizeof(pcm));
+    }
+    output_mixer.flushMixer();
+    return (size_t)kSamples * 4;
+  });
+
+  static PcmStream in[4];
+  static InputMixer<int16_t> input_mixer;
+  for (int j = 0; j < 4; j++) input_mixer.add(in[j], 25);
+  input_mixer.begin(info);
+  static int16_t result[kSamples];
+  runner.run("mixer/input-4", [] {
+    input_mixer.readBytes((uint8_t *)result, sizeof(result));
+    return (size_t)kSamples * 4;
+  });
+}
+
+static void benchmarkFFT(BenchmarkRunner &runner) {
+  static AudioRealFFT fft;
+  auto cfg = fft.defaultConfig(TX_MODE);
+  cfg.copyFrom(info);
+  cfg.length = 1024;
+  fft.begin(cfg);
+  runner.run("fft/real-1024", [] { return writePcm(fft); });
+}
+
+/// Creates a WAV file with 100 blocks of the indicated sample data
+static void createWAV(RecordingPrint &file, AudioFormat format, int bits,
+                      const void *data, size_t len) {
+  WAVEncoder encoder;
+  WAVAudioInfo wav_info = encoder.defaultConfig();
+  wav_info.sample_rate = info.sample_rate;
+  wav_info.channels = info.channels;
+  wav_info.bits_per_sample = bits;
+  wav_info.format = format;
+  encoder.setOutput(file);
+  encoder.begin(wav_info);
+  for (int j = 0; j < 100; j++) encoder.write((const uint8_t *)data, len);
+  encoder.end();
+}
+
+/// Decodes the WAV file: the decoder converts the samples to linear PCM
+static size_t decodeWAV(EncodedAudioOutput &decoder, RecordingPrint &file) {
+  decoder.begin();
+  decoder.write(file.bytes.data(), file.bytes.size());
+  decoder.end();
+  return (size_t)kSamples * 100;
+}
+
+/// PCM WAV encoding and decoding is just a copy: we measure the formats
+/// which are converted by the WAVDecoder
+static void benchmarkWAV(BenchmarkRunner &runner) {
+  static WAVDecoder wav_decoder;
+  static EncodedAudioOutput decoder(&null_out, &wav_decoder);
+
+  // 24 bit (3 bytes) -> int32
+  static uint8_t pcm24[kSamples * 3];
+  for (int j = 0; j < kSamples; j++) {
+    int32_t value = (int32_t)pcm[j] << 8;
+    pcm24[j * 3] = value & 0xFF;
+    pcm24[j * 3 + 1] = (value >> 8) & 0xFF;
+    pcm24[j * 3 + 2] = (value >> 16) & 0xFF;
+  }
+  static RecordingPrint wav24;
+  createWAV(wav24, AudioFormat::PCM, 24, pcm24, sizeof(pcm24));
+  runner.run("codec/wav-decode-24bit", [] { return decodeWAV(decoder, wav24); });
+
+  // mu-law -> int16
+  static uint8_t mulaw[kSamples];
+  for (int j = 0; j < kSamples; j++) mulaw[j] = pcm[j] & 0xFF;
+  static RecordingPrint wav_mulaw;
+  createWAV(wav_mulaw, AudioFormat::MULAW, 8, mulaw, sizeof(mulaw));
+  runner.run("codec/wav-decode-mulaw",
+             [] { return decodeWAV(decoder, wav_mulaw); });
+
+  // float -> int16
+  static float pcm_float[kSamples];
+  for (int j = 0; j < kSamples; j++) pcm_float[j] = pcm[j] / 32768.0f;
+  static RecordingPrint wav_float;
+  createWAV(wav_float, AudioFormat::IEEE_FLOAT, 32, pcm_float,
+            sizeof(pcm_float));
+  runner.run("codec/wav-decode-float",
+             [] { return decodeWAV(decoder, wav_float); });
+}
+
+#ifdef BENCHMARK_CODECS
+
+static void benchmarkCodecs(BenchmarkRunner &runner) {
+  static CountingPrint decoded;
+  decoded.setOutput(&null_out);
+  static EncodedAudioOutput mp3(&decoded, new MP3DecoderHelix());
+  runner.run("codec/mp3-helix-decode", [] {
+    decoded.count = 0;
+    mp3.begin();
+    mp3.write(BabyElephantWalk60_mp3, BabyElephantWalk60_mp3_len);
+    mp3.end();
+    return decoded.count / 2;
+  });
+
+  static EncodedAudioOutput aac(&decoded, new AACDecoderHelix());
+  runner.run("codec/aac-helix-decode", [] {
+    decoded.count = 0;
+    aac.begin();
+    aac.write(gs_16b_2c_44100hz_aac, gs_16b_2c_44100hz_aac_len);
+    aac.end();
+    return decoded.count / 2;
+  });
+
+  static EncodedAudioOutput adpcm_dec(&null_out,
+                                      new ADPCMDecoder(AV_CODEC_ID_ADPCM_IMA_WAV));
+  static EncodedAudioOutput adpcm_enc(
+      &adpcm_dec, new ADPCMEncoder(AV_CODEC_ID_ADPCM_IMA_WAV));
+  adpcm_dec.begin(info);
+  adpcm_enc.begin(info);
+  runner.run("codec/adpcm-roundtrip", [] { return writePcm(adpcm_enc); });
+
+  static AudioInfo opus_info(24000, 1, 16);
+  static OpusAudioDecoder opus_decoder;
+  static OpusAudioEncoder opus_encoder;
+  static EncodedAudioOutput opus_dec(&null_out, &opus_decoder);
+  static EncodedAudioOutput opus_enc(&opus_dec, &opus_encoder);
+  opus_dec.begin(opus_info);
+  opus_encoder.config().application = OPUS_APPLICATION_AUDIO;
+  opus_enc.begin(opus_info);
+  runner.run("codec/opus-roundtrip", [] { return writePcm(opus_enc); });
+}
+
+#endif
+
+template <class B>
+static size_t bufferRoundTrip(B &buffer) {
+  const uint8_t *data = (const uint8_t *)pcm;
+  static uint8_t result[sizeof(pcm)];
+  int pos = 0;
+  while (pos < (int)sizeof(pcm)) {
+    int n = buffer.writeArray(data + pos, sizeof(pcm) - pos);
+    buffer.flush();
+    buffer.readArray(result + pos, n);
+    pos += n;
+  }
+  return kSamples;
+}
+
+static void benchmarkBuffers(BenchmarkRunner &runner) {
+  static RingBuffer<uint8_t> ring(1000);
+  runner.run("buffer/ring", [] { return bufferRoundTrip(ring); });
+
+  static RingBufferSPSC<uint8_t> spsc(1000);
+  runner.run("buffer/ring-spsc", [] { return bufferRoundTrip(spsc); });
+
+  static NBuffer<uint8_t> nbuffer(512, 4);
+  runner.run("buffer/nbuffer", [] { return bufferRoundTrip(nbuffer); });
+
+  // zero copy from the ring buffer to the output
+  static RingBuffer<uint8_t> source(sizeof(pcm));
+  static StreamCopy copier(sizeof(pcm));
+  copier.setDelayOnNoData(0);
+  copier.begin(null_out, source);
+  runner.run("buffer/ring-streamcopy", [] {
+    source.writeArray((const uint8_t *)pcm, sizeof(pcm));
+    copier.copyAll(0, 0);
+    return (size_t)kSamples;
+  });
+}
+
+int main(int argc, char **argv) {
+  AudioToolsLogger.begin(log_out, AudioToolsLogLevel::Error);
+  BenchmarkRunner runner;
+  const char *json_file = nullptr;
+  for (int j = 1; j < argc - 1; j++) {
+    if (strcmp(argv[j], "--json") == 0) json_file = argv[++j];
+    else if (strcmp(argv[j], "--filter") == 0) runner.setFilter(argv[++j]);
+    else if (strcmp(argv[j], "--time") == 0) runner.setMinTimeMs(atoi(argv[++j]));
+  }
+
+  setupPcm();
+  benchmarkFilters(runner);
+  benchmarkResample(runner);
+  benchmarkConverters(runner);
+  benchmarkVolume(runner);
+  benchmarkMixers(runner);
+  benchmarkFFT(runner);
+  benchmarkWAV(runner);
+#ifdef BENCHMARK_CODECS
+  benchmarkCodecs(runner);
+#endif
+  benchmarkBuffers(runner);
+
+  FILE *out = json_file != nullptr ? fopen(json_file, "w") : stdout;
+  if (out == nullptr) {
+    fprintf(stderr, "could not open %s\n", json_file);
+    return 1;
+  }
+  runner.printJson(out);
+  if (out != stdout) fclose(out);
+  return 0;
+}
@@ -0,0 +1,459 @@
+/// Synthetic test for SegmenterMP4 and HLSServerT: a MuxerMP4 with a fake
+/// H.264 track (25 fps, a key frame every second) and a PCM audio track feeds
+/// the segmenter. We check the segment cuts at the key frames, the partial
+/// segments, the playlist, the 'sidx' and 'mfra' indexes of the VOD file and
+/// finally serve the result with a HLSServerT using in-memory clients.
+
+#include <assert.h>
+
+#include <algorithm>
+#include <cstring>
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "AudioTools.h"
+#include "AudioTools/AudioCodecs/ContainerMP4.h"
+#include "AudioTools/AudioCodecs/SegmenterMP4.h"
+#include "AudioTools/Communication/HTTP/HLSServerT.h"
+
+using namespace audio_tools;
+
+using Bytes = std::vector<uint8_t>;
+
+static const uint8_t sps_pps[] = {0, 0, 0, 1, 0x67, 0x42, 0x00, 0x1e,
+                                  0x95, 0xa8, 0x28, 0,   0,    0,    1,
+                                  0x68, 0xce, 0x3c, 0x80};
+
+/// Collects the generated playlist
+class StringPrint : public Print {
+ public:
+  std::string str;
+  size_t write(uint8_t ch) override {
+    str += (char)ch;
+    return 1;
+  }
+  size_t write(const uint8_t* data, size_t len) override {
+    str.append((const char*)data, len);
+    return len;
+  }
+};
+
+/// Number of recorded video frames since setupMuxer()
+static int frame_count = 0;
+
+/// Writes 'frames' video frames with the corresponding audio (8000 Hz, 40 ms
+/// per frame)
+static void record(MuxerMP4& mux, int frames) {
+  Bytes frame;
+  int16_t audio[320] = {0};
+  for (int j = 0; j < frames; j++) {
+    bool is_key = frame_count++ % 25 == 0;
+    frame.clear();
+    if (is_key) frame.insert(frame.end(), sps_pps, sps_pps + sizeof(sps_pps));
+    const uint8_t nal_header[] = {0, 0, 0, 1, (uint8_t)(is_key ? 0x65 : 0x41)};
+    frame.insert(frame.end(), nal_header, nal_header + sizeof(nal_header));
+    frame.resize(frame.size() + (is_key ? 800 : 200), (uint8_t)j);
+    size_t len = mux.addVideoFrame(frame.data(), frame.size(), is_key);
+    assert(len > 0);
+    len = mux.addAudioFrame((uint8_t*)audio, sizeof(audio));
+    assert(len > 0);
+  }
+}
+
+static void setupMuxer(MuxerMP4& mux) {
+  MuxerVideoConfig cfg;
+  cfg.width = 320;
+  cfg.height = 240;
+  cfg.fps = 25;
+  cfg.format = VideoFormat::H264;
+  mux.setVideoInfo(cfg);
+  mux.setAudioInfo(AudioInfoFormat(8000, 1, 16, AudioFormat::PCM));
+  mux.begin();
+  frame_count = 0;
+}
+
+static uint32_t be32(const uint8_t* p) {
+  return (uint32_t)p[0] << 24 | (uint32_t)p[1] << 16 | (uint32_t)p[2] << 8 |
+         p[3];
+}
+
+static Bytes readAll(SegmenterMP4& segmenter, const char* name) {
+  SegmenterMP4::Resource res;
+  bool is_found = segmenter.find(name, res);
+  assert(is_found);
+  Bytes result(res.size);
+  size_t pos = 0;
+  while (pos < result.size()) {
+    size_t n = segmenter.read(res, pos, result.data() + pos,
+                              min((size_t)100, result.size() - pos));
+    assert(n > 0);
+    pos += n;
+  }
+  return result;
+}
+
+static bool contains(const std::string& str, const char* text) {
+  return str.find(text) != std::string::npos;
+}
+
+/// Max value in ms of the playlist entries which start with 'tag'
+static uint32_t maxDurationMs(const std::string& playlist, const char* tag) {
+  uint32_t result = 0;
+  size_t pos = 0;
+  while ((pos = playlist.find(tag, pos)) != std::string::npos) {
+    pos += strlen(tag);
+    unsigned sec = 0, ms = 0;
+    sscanf(playlist.c_str() + pos, "%u.%u", &sec, &ms);
+    result = max(result, (uint32_t)(sec * 1000 + ms));
+  }
+  return result;
+}
+
+/// In-memory segment store
+class MemoryStore : public SegmentStore {
+ public:
+  std::map<std::string, Bytes> files;
+  std::string open_name;
+  bool open(const char* name) override {
+    open_name = name;
+    files[open_name].clear();
+    return true;
+  }
+  size_t write(const uint8_t* data, size_t len) override {
+    Bytes& file = files[open_name];
+    file.insert(file.end(), data, data + len);
+    return len;
+  }
+  void close() override { open_name.clear(); }
+  void remove(const char* name) override { files.erase(name); }
+  size_t read(const char* name, size_t pos, uint8_t* data,
+              size_t len) override {
+    Bytes& file = files[name];
+    if (pos >= file.size()) return 0;
+    len = min(len, file.size() - pos);
+    memcpy(data, file.data() + pos, len);
+    return len;
+  }
+};
+
+/// Connection which is shared by the client copies
+struct Connection {
+  std::string request;
+  size_t request_pos = 0;
+  std::string response;
+  bool is_connected = true;
+};
+
+/// Client which reads the request and records the response in memory
+class MockClient : public Print {
+ public:
+  MockClient() = default;
+  MockClient(std::shared_ptr<Connection> con) : con(con) {}
+  operator bool() { return con != nullptr; }
+  bool connected() { return con != nullptr && con->is_connected; }
+  int available() { return con->request.size() - con->request_pos; }
+  int read() { return con->request[con->request_pos++]; }
+  void stop() {
+    if (con != nullptr) con->is_connected = false;
+  }
+  size_t write(uint8_t ch) override { return write(&ch, 1); }
+  size_t write(const uint8_t* data, size_t len) override {
+    con->response.append((const char*)data, len);
+    return len;
+  }
+  std::shared_ptr<Connection> con;
+};
+
+/// Server which provides the queued connections
+class MockServer {
+ public:
+  MockServer(int port = 80) {}
+  void begin() {}
+  MockClient accept() { return available(); }
+  MockClient available() {
+    if (pending.empty()) return MockClient();
+    MockClient result(pending[0]);
+    pending.erase(pending.begin());
+    return result;
+  }
+  static std::vector<std::shared_ptr<Connection>> pending;
+};
+std::vector<std::shared_ptr<Connection>> MockServer::pending;
+
+static std::shared_ptr<Connection> request(const char* path) {
+  auto con = std::make_shared<Connection>();
+  con->request = std::string("GET ") + path +
+                 " HTTP/1.1\r\nHost: localhost\r\n\r\n";
+  MockServer::pending.push_back(con);
+  return con;
+}
+
+/// Content after the header: the desktop Print might end the lines with \n
+static std::string body(Connection& con) {
+  size_t pos = con.response.find("\r\n\r\n");
+  if (pos != std::string::npos) return con.response.substr(pos + 4);
+  pos = con.response.find("\n\n");
+  assert(pos != std::string::npos);
+  return con.response.substr(pos + 2);
+}
+
+void setup() {
+  Serial.begin(115200);
+  AudioToolsLogger.begin(Serial, AudioToolsLogLevel::Warning);
+
+  // ---- 1) live playlist with partial segments and a rolling window ----
+  {
+    SegmenterMP4 segmenter;
+    segmenter.setTargetDuration(2000);
+    segmenter.setPartDuration(500);
+    segmenter.setWindowSize(2);
+    MuxerMP4 mux(segmenter);
+    segmenter.begin();
+    setupMuxer(mux);
+
+    record(mux, 60);
+    // segment 0 was cut with the key frame at 2 s, segment 1 is open
+    assert(segmenter.segmentCount() == 1);
+    assert(segmenter.segmentDurationMs(0) == 2000);
+    // 4 parts of 12 frames (480 ms) and the remaining 2 frames
+    assert(segmenter.partCount(0) == 5);
+    assert(segmenter.isAvailable(0));
+    assert(!segmenter.isAvailable(1));
+    assert(segmenter.isAvailable(1, 0) == false);
+    // part 0 of segment 1 is closed by its 13th frame
+    record(mux, 2);
+    assert(!segmenter.isAvailable(1, 0));
+    record(mux, 1);
+    assert(segmenter.isAvailable(1, 0));
+    assert(!segmenter.isAvailable(1, 1));
+
+    StringPrint playlist;
+    segmenter.writePlaylist(playlist);
+    assert(contains(playlist.str, "#EXT-X-VERSION:9\n"));
+    assert(contains(playlist.str, "#EXT-X-TARGETDURATION:2\n"));
+    assert(contains(playlist.str, "CAN-BLOCK-RELOAD=YES"));
+    assert(contains(playlist.str, "#EXT-X-PART-INF:PART-TARGET=0.500\n"));
+    assert(contains(playlist.str, "#EXT-X-MEDIA-SEQUENCE:0\n"));
+    assert(contains(playlist.str, "#EXT-X-MAP:URI=\"init.mp4\"\n"));
+    assert(contains(playlist.str,
+                    "#EXT-X-PART:DURATION=0.480,URI=\"part0.0.m4s\","
+                    "INDEPENDENT=YES\n"));
+    assert(contains(playlist.str,
+                    "#EXT-X-PART:DURATION=0.080,URI=\"part0.4.m4s\"\n"));
+    // no part is longer than the PART-TARGET
+    assert(maxDurationMs(playlist.str, "#EXT-X-PART:DURATION=") <= 500);
+    assert(contains(playlist.str, "#EXTINF:2.000,\nseg0.m4s\n"));
+    assert(contains(playlist.str,
+                    "#EXT-X-PRELOAD-HINT:TYPE=PART,URI=\"part1.1.m4s\"\n"));
+    assert(!contains(playlist.str, "#EXT-X-ENDLIST"));
+
+    // the init segment is ftyp + moov
+    Bytes init = readAll(segmenter, "/init.mp4");
+    assert(memcmp(init.data() + 4, "ftyp", 4) == 0);
+    assert(memcmp(init.data() + be32(init.data()) + 4, "moov", 4) == 0);
+
+    // a segment consists of complete fragments and the parts are slices
+    Bytes seg = readAll(segmenter, "seg0.m4s");
+    assert(memcmp(seg.data() + 4, "moof", 4) == 0);
+    size_t pos = 0, fragments = 0;
+    while (pos < seg.size()) {
+      pos += be32(seg.data() + pos);
+      fragments++;
+    }
+    assert(pos == seg.size());
+    assert(fragments == 50 * 4);  // video+audio: moof+mdat
+    Bytes part = readAll(segmenter, "part0.1.m4s");
+    assert(memcmp(part.data() + 4, "moof", 4) == 0);
+    assert(std::search(seg.begin(), seg.end(), part.begin(), part.end()) !=
+           seg.end());
+
+    // after 2 more segments only the last 2 are kept
+    record(mux, 137);
+    segmenter.end();
+    assert(segmenter.isEnded());
+    assert(segmenter.firstSequence() == 2);
+    assert(segmenter.segmentCount() == 2);
+    SegmenterMP4::Resource res;
+    assert(!segmenter.find("seg0.m4s", res));
+    assert(!segmenter.find("vod.mp4", res));
+    playlist.str.clear();
+    segmenter.writePlaylist(playlist);
+    assert(contains(playlist.str, "#EXT-X-MEDIA-SEQUENCE:2\n"));
+    assert(contains(playlist.str, "#EXT-X-ENDLIST\n"));
+    Serial.println("live segmenter test passed");
+  }
+
+  // ---- 2) the segments do not exceed the target duration ----
+  {
+    SegmenterMP4 segmenter;
+    // the key frame interval of 1 s does not fit twice
+    segmenter.setTargetDuration(1500);
+    segmenter.setWindowSize(0);
+    MuxerMP4 mux(segmenter);
+    segmenter.begin();
+    setupMuxer(mux);
+
+    StringPrint playlist;
+    record(mux, 1);
+    segmenter.writePlaylist(playlist);
+    assert(contains(playlist.str, "#EXT-X-TARGETDURATION:2\n"));
+    record(mux, 125);
+    segmenter.end();
+    assert(segmenter.segmentCount() == 6);
+    for (int j = 0; j < 5; j++) assert(segmenter.segmentDurationMs(j) == 1000);
+    playlist.str.clear();
+    segmenter.writePlaylist(playlist);
+    assert(contains(playlist.str, "#EXT-X-TARGETDURATION:2\n"));
+    assert(maxDurationMs(playlist.str, "#EXTINF:") <= 1500);
+    Serial.println("target duration test passed");
+  }
+
+  // ---- 3) VOD with sidx and mfra, segments stored in a SegmentStore ----
+  {
+    MemoryStore store;
+    SegmenterMP4 segmenter;
+    segmenter.setTargetDuration(2000);
+    segmenter.setWindowSize(0);
+    segmenter.setIndex(true);
+    segmenter.setSegmentStore(store);
+    MuxerMP4 mux(segmenter);
+    segmenter.begin();
+    setupMuxer(mux);
+    record(mux, 150);
+    segmenter.end();
+
+    assert(store.files.size() == 3);
+    StringPrint playlist;
+    segmenter.writePlaylist(playlist);
+    assert(contains(playlist.str, "#EXT-X-PLAYLIST-TYPE:VOD\n"));
+    assert(contains(playlist.str, "#EXTINF:2.000,\nseg2.m4s\n"));
+
+    // each segment starts with a sidx which references the video fragments
+    Bytes seg = readAll(segmenter, "seg1.m4s");
+    assert(seg == store.files["seg1.m4s"]);
+    assert(memcmp(seg.data() + 4, "sidx", 4) == 0);
+    uint32_t sidx_size = be32(seg.data());
+    assert(be32(seg.data() + 12) == 1);          // track
+    assert(be32(seg.data() + 16) == 90000);      // timescale
+    assert(be32(seg.data() + 20) == 50 * 3600);  // earliest time
+    assert((be32(seg.data() + 28) & 0xFFFF) == 50);
+    uint32_t referenced = 0;
+    for (int j = 0; j < 50; j++) {
+      const uint8_t* ref = seg.data() + 32 + j * 12;
+      referenced += be32(ref);
+      assert(be32(ref + 4) == 3600);
+      assert((be32(ref + 8) != 0) == (j % 25 == 0));
+    }
+    assert(sidx_size + referenced == seg.size());
+
+    // the VOD file is init + segments + mfra
+    Bytes vod = readAll(segmenter, "vod.mp4");
+    Bytes init = readAll(segmenter, "init.mp4");
+    assert(std::equal(init.begin(), init.end(), vod.begin()));
+    uint32_t mfra_size = be32(vod.data() + vod.size() - 4);
+    const uint8_t* mfra = vod.data() + vod.size() - mfra_size;
+    assert(memcmp(mfra + 4, "mfra", 4) == 0);
+    assert(memcmp(mfra + 12, "tfra", 4) == 0);
+    uint32_t count = be32(mfra + 28);
+    assert(count == 6);  // one key frame per second
+    for (uint32_t j = 0; j < count; j++) {
+      const uint8_t* entry = mfra + 32 + j * 19;
+      assert(be32(entry + 4) == j * 25 * 3600);
+      uint32_t offset = be32(entry + 12);
+      assert(memcmp(vod.data() + offset + 4, "moof", 4) == 0);
+    }
+    Serial.println("VOD segmenter test passed");
+  }
+
+  // ---- 4) HLS server ----
+  {
+    SegmenterMP4 segmenter;
+    segmenter.setTargetDuration(2000);
+    segmenter.setPartDuration(500);
+    MuxerMP4 mux(segmenter);
+    segmenter.begin();
+    setupMuxer(mux);
+    record(mux, 60);
+
+    HLSServerT<MockClient, MockServer> server(segmenter);
+    server.setBufferSize(500);
+    server.begin();
+
+    auto playlist = request("/live.m3u8");
+    auto seg = request("/seg0.m4s");
+    auto missing = request("/seg9.m4s");
+    // blocking reload for the next part
+    auto blocking = request("/live.m3u8?_HLS_msn=1&_HLS_part=1");
+    for (int j = 0; j < 200; j++) server.doLoop();
+
+    assert(contains(playlist->response, "HTTP/1.1 200 OK"));
+    assert(contains(playlist->response,
+                    "Content-Type: application/vnd.apple.mpegurl"));
+    StringPrint expected;
+    segmenter.writePlaylist(expected);
+    assert(body(*playlist) == expected.str);
+    assert(contains(seg->response, "Content-Type: video/iso.segment"));
+    Bytes seg_data = readAll(segmenter, "seg0.m4s");
+    assert(body(*seg) == std::string(seg_data.begin(), seg_data.end()));
+    assert(contains(missing->response, "HTTP/1.1 404 Not Found"));
+    assert(blocking->response.empty());
+    assert(server.clientCount() == 1);
+
+    // the response is sent as soon as the part is available
+    record(mux, 26);
+    server.doLoop();
+    assert(contains(blocking->response, "HTTP/1.1 200 OK"));
+    for (int j = 0; j < 5; j++) server.doLoop();
+    assert(contains(body(*blocking), "URI=\"part1.1.m4s\""));
+    assert(server.clientCount() == 0);
+    Serial.println("HLS server test passed");
+  }
+
+  // ---- 5) HLS server: default buffer and incremental requests ----
+  {
+    SegmenterMP4 segmenter;
+    segmenter.setTargetDuration(2000);
+    MuxerMP4 mux(segmenter);
+    segmenter.begin();
+    setupMuxer(mux);
+    record(mux, 60);
+
+    HLSServerT<MockClient, MockServer> server(segmenter);
+    server.setRequestTimeout(500);
+    server.begin();
+
+    // the request arrives in pieces: doLoop() does not wait for it
+    auto seg = std::make_shared<Connection>();
+    seg->request = "GET /seg0.m4s HTTP/1.1\r\nHo";
+    MockServer::pending.push_back(seg);
+    auto idle = std::make_shared<Connection>();
+    MockServer::pending.push_back(idle);
+    server.doLoop();
+    server.doLoop();
+    assert(server.clientCount() == 2);
+    assert(seg->response.empty());
+    seg->request += "st: localhost\r\n\r\n";
+    for (int j = 0; j < 100; j++) server.doLoop();
+
+    // the segment was sent with the default buffer size
+    Bytes seg_data = readAll(segmenter, "seg0.m4s");
+    assert(seg_data.size() > 1024);
+    assert(body(*seg) == std::string(seg_data.begin(), seg_data.end()));
+
+    // the client which does not send a request is disconnected
+    assert(server.clientCount() == 1);
+    delay(600);
+    server.doLoop();
+    assert(server.clientCount() == 0);
+    assert(!idle->is_connected);
+    assert(idle->response.empty());
+    Serial.println("HLS server request test passed");
+  }
+
+  Serial.println("All SegmenterMP4 tests passed");
+  exit(0);
+}
+
+void loop() {}
@@ -0,0 +1,118 @@
+/// Plays a MP3 file which was split at a frame boundary into 2 files with
+/// gapless playback: the decoder keeps its state (e.g. the bit reservoir)
+/// across the files, so we get the same audio as for the complete file.
+#include <cassert>
+#include <cstdio>
+#include <vector>
+
+#include "AudioTools.h"
+#include "AudioTools/AudioCodecs/CodecMP3Helix.h"
+#include "BabyElephantWalk60_mp3.h"
+
+using namespace audio_tools;
+
+/// File in memory which supports seek() like a File
+class MemoryFile : public Stream {
+ public:
+  MemoryFile(const uint8_t *data = nullptr, size_t len = 0)
+      : data(data), len(len) {}
+  const uint8_t *data;
+  size_t len;
+  size_t pos = 0;
+  int available() override { return len - pos; }
+  int read() override { return pos < len ? data[pos++] : -1; }
+  int peek() override { return pos < len ? data[pos] : -1; }
+  size_t readBytes(uint8_t *buffer, size_t size) override {
+    size_t n = min(size, (size_t)available());
+    memcpy(buffer, data + pos, n);
+    pos += n;
+    return n;
+  }
+  size_t write(uint8_t ch) override { return 0; }
+  bool seek(size_t p) {
+    if (p > len) return false;
+    pos = p;
+    return true;
+  }
+  size_t size() { return len; }
+};
+
+/// AudioSource with a list of files
+class MemoryFileSource : public AudioSource {
+ public:
+  MemoryFileSource(MemoryFile *files, int count) : files(files), count(count) {}
+  bool begin() override { return true; }
+  Stream *nextStream(int offset) override { return selectStream(idx + offset); }
+  Stream *selectStream(int index) override {
+    if (index < 0 || index >= count) return nullptr;
+    idx = index;
+    files[idx].pos = 0;
+    return &files[idx];
+  }
+  Stream *selectStream(const char *path) override { return selectStream(0); }
+  bool seek(size_t pos) override { return files[idx].seek(pos); }
+  size_t streamSize() override { return files[idx].size(); }
+  MemoryFile *files;
+  int count;
+  int idx = 0;
+};
+
+/// Records the samples which were played
+class SampleRecorder : public AudioOutput {
+ public:
+  std::vector<int16_t> samples;
+  size_t write(const uint8_t *data, size_t len) override {
+    const int16_t *values = (const int16_t *)data;
+    samples.insert(samples.end(), values, values + len / 2);
+    return len;
+  }
+};
+
+/// Plays the files with gapless playback
+static std::vector<int16_t> play(MemoryFile *files, int count) {
+  MemoryFileSource source(files, count);
+  SampleRecorder out;
+  MP3DecoderHelix decoder;
+  AudioPlayer player(source, out, decoder);
+  player.setAutoFade(false);
+  player.setGapless(true);
+  player.begin();
+  while (player.copy() > 0);
+  return out.samples;
+}
+
+/// Determines the first frame boundary after the middle of the data
+static size_t findSplit(const uint8_t *data, size_t len) {
+  size_t pos = 0;
+  while (pos + 4 <= len && pos < len / 2) {
+    HeaderParserMP3::FrameHeader header;
+    bool is_valid = HeaderParserMP3::FrameHeader::decode(data + pos, header);
+    assert(is_valid);
+    pos += header.getFrameLength();
+  }
+  return pos;
+}
+
+int main() {
+  AudioToolsLogger.begin(Serial, AudioToolsLogLevel::Warning);
+  const uint8_t *data = BabyElephantWalk60_mp3;
+  size_t len = BabyElephantWalk60_mp3_len;
+
+  MemoryFile complete(data, len);
+  std::vector<int16_t> expected = play(&complete, 1);
+  assert(expected.size() > 0);
+
+  // the second file does not have a Xing/LAME tag, so only the padding of
+  // the complete file is not removed at the end
+  size_t split = findSplit(data, len);
+  assert(split > 0 && split < len);
+  MemoryFile parts[2] = {MemoryFile(data, split),
+                         MemoryFile(data + split, len - split)};
+  std::vector<int16_t> result = play(parts, 2);
+  assert(result.size() >= expected.size());
+  for (size_t j = 0; j < expected.size(); j++) {
+    assert(result[j] == expected[j]);
+  }
+  printf("mp3-gapless: ok (%u samples)\n", (unsigned)expected.size());
+  return 0;
+}
@@ -0,0 +1,376 @@
+/// Synthetic test for DemuxerMP4::setRandomAccess(): builds a faststart MP4
+/// with an audio and a (large) video track whose chunks are interleaved in
+/// 'mdat', and checks that with random access the audio samples are fetched
+/// directly by their stco/stsz entries: all audio is dispatched in file
+/// order, while the video payload is never read. A second, audio-only build
+/// checks that contiguous chunks are coalesced into a single read.
+
+#include <assert.h>
+#include <cstring>
+#include <vector>
+
+#include "AudioTools.h"
+#include "AudioTools/AudioCodecs/ContainerMP4.h"
+
+using namespace audio_tools;
+
+using Bytes = std::vector<uint8_t>;
+
+static void appendU32BE(Bytes& v, uint32_t x) {
+  v.push_back((uint8_t)(x >> 24));
+  v.push_back((uint8_t)(x >> 16));
+  v.push_back((uint8_t)(x >> 8));
+  v.push_back((uint8_t)x);
+}
+static void appendStr(Bytes& v, const char* s) {
+  for (int i = 0; i < 4; i++) v.push_back((uint8_t)s[i]);
+}
+static void appendBytes(Bytes& v, const Bytes& b) {
+  v.insert(v.end(), b.begin(), b.end());
+}
+
+static Bytes box(const char* type, const Bytes& payload) {
+  Bytes b;
+  appendU32BE(b, (uint32_t)(8 + payload.size()));
+  appendStr(b, type);
+  appendBytes(b, payload);
+  return b;
+}
+
+static Bytes buildFtyp() {
+  Bytes p;
+  appendStr(p, "isom");
+  appendU32BE(p, 0);
+  appendStr(p, "isom");
+  return box("ftyp", p);
+}
+
+static Bytes buildHdlr(const char* handler) {
+  Bytes p;
+  appendU32BE(p, 0);  // version/flags
+  appendU32BE(p, 0);  // pre_defined
+  appendStr(p, handler);
+  return box("hdlr", p);
+}
+
+static Bytes buildMdhd(uint32_t timescale) {
+  Bytes p;
+  appendU32BE(p, 0);          // version/flags
+  appendU32BE(p, 0);          // creation
+  appendU32BE(p, 0);          // modification
+  appendU32BE(p, timescale);  // timescale
+  appendU32BE(p, 0);          // duration
+  return box("mdhd", p);
+}
+
+static Bytes buildMp4a(uint16_t channels, uint32_t sampleRate) {
+  Bytes p(28, 0);
+  p[7] = 1;  // data_reference_index = 1
+  p[16] = (uint8_t)(channels >> 8);
+  p[17] = (uint8_t)channels;
+  p[19] = 16;  // samplesize = 16
+  uint32_t sr = sampleRate << 16;
+  p[24] = (uint8_t)(sr >> 24);
+  p[25] = (uint8_t)(sr >> 16);
+  p[26] = (uint8_t)(sr >> 8);
+  p[27] = (uint8_t)sr;
+  return box("mp4a", p);
+}
+
+static Bytes buildStsd(const Bytes* entry) {
+  Bytes p;
+  appendU32BE(p, 0);               // version/flags
+  appendU32BE(p, entry ? 1 : 0);   // entry_count
+  if (entry) appendBytes(p, *entry);
+  return box("stsd", p);
+}
+
+static Bytes buildStsz(uint32_t sampleSize, uint32_t count) {
+  Bytes p;
+  appendU32BE(p, 0);  // version/flags
+  appendU32BE(p, 0);  // sampleSize = 0 -> variable, per-entry sizes below
+  appendU32BE(p, count);
+  for (uint32_t j = 0; j < count; j++) appendU32BE(p, sampleSize);
+  return box("stsz", p);
+}
+
+static Bytes buildStsc(uint32_t samplesPerChunk) {
+  Bytes p;
+  appendU32BE(p, 0);
+  appendU32BE(p, 1);  // entry_count
+  appendU32BE(p, 1);  // first_chunk
+  appendU32BE(p, samplesPerChunk);
+  appendU32BE(p, 1);  // sample_description_index
+  return box("stsc", p);
+}
+
+static Bytes buildStco(const std::vector<uint32_t>& offsets) {
+  Bytes p;
+  appendU32BE(p, 0);
+  appendU32BE(p, (uint32_t)offsets.size());
+  for (auto off : offsets) appendU32BE(p, off);
+  return box("stco", p);
+}
+
+static Bytes buildStts(uint32_t sampleCount, uint32_t sampleDelta) {
+  Bytes p;
+  appendU32BE(p, 0);
+  appendU32BE(p, 1);  // entry_count
+  appendU32BE(p, sampleCount);
+  appendU32BE(p, sampleDelta);
+  return box("stts", p);
+}
+
+/// Layout of one track: chunks of 'samples_per_chunk' samples of equal size
+struct TrackLayout {
+  const char* handler;
+  uint32_t sample_size;
+  uint32_t samples_per_chunk;
+  std::vector<uint32_t> chunk_offsets;
+};
+
+static Bytes buildTrak(const TrackLayout& t) {
+  uint32_t count = t.samples_per_chunk * (uint32_t)t.chunk_offsets.size();
+  Bytes mp4a = buildMp4a(1, 44100);
+  bool audio = strcmp(t.handler, "soun") == 0;
+  Bytes stblPayload;
+  appendBytes(stblPayload, buildStsd(audio ? &mp4a : nullptr));
+  appendBytes(stblPayload, buildStsz(t.sample_size, count));
+  appendBytes(stblPayload, buildStsc(t.samples_per_chunk));
+  appendBytes(stblPayload, buildStco(t.chunk_offsets));
+  appendBytes(stblPayload, buildStts(count, 1000));
+  Bytes minf = box("minf", box("stbl", stblPayload));
+
+  Bytes mdiaPayload;
+  appendBytes(mdiaPayload, buildHdlr(t.handler));
+  appendBytes(mdiaPayload, buildMdhd(44100));
+  appendBytes(mdiaPayload, minf);
+  return box("trak", box("mdia", mdiaPayload));
+}
+
+static Bytes buildMoov(const std::vector<TrackLayout>& tracks) {
+  Bytes payload;
+  for (auto& t : tracks) appendBytes(payload, buildTrak(t));
+  return box("moov", payload);
+}
+
+/// Minimal in-memory stand-in for Arduino's File which counts the bytes
+/// which were read
+struct MemFile {
+  Bytes data;
+  size_t pos = 0;
+  size_t bytes_read = 0;
+  size_t mdat_start = (size_t)-1;
+  int sample_reads = 0;
+  // number of reads in mdat which fail
+  int fail_reads = 0;
+  size_t position() { return pos; }
+  bool seek(size_t p) {
+    if (p > data.size()) return false;
+    pos = p;
+    return true;
+  }
+  size_t readBytes(char* buf, size_t len) {
+    if (pos >= mdat_start) {
+      sample_reads++;
+      if (fail_reads > 0) {
+        fail_reads--;
+        return 0;
+      }
+    }
+    size_t avail = data.size() - pos;
+    size_t n = std::min(len, avail);
+    memcpy(buf, data.data() + pos, n);
+    pos += n;
+    bytes_read += n;
+    return n;
+  }
+};
+
+/// Records the audio output
+class TestAudioSink : public Print {
+ public:
+  size_t write(uint8_t ch) override {
+    data.push_back(ch);
+    return 1;
+  }
+  size_t write(const uint8_t* buf, size_t len) override {
+    data.insert(data.end(), buf, buf + len);
+    return len;
+  }
+  Bytes data;
+};
+
+/// Builds ftyp + moov + mdat where the chunks of 'tracks' are written in
+/// the indicated order: the sample bytes of audio sample n are 0x10 + n
+static Bytes buildFile(std::vector<TrackLayout>& tracks,
+                       const std::vector<int>& chunkOrder) {
+  Bytes ftyp = buildFtyp();
+  // two-pass: the size of moov does not depend on the offset values
+  for (auto& t : tracks) {
+    t.chunk_offsets.clear();
+  }
+  for (int idx : chunkOrder) tracks[idx].chunk_offsets.push_back(0);
+  size_t moov_size = buildMoov(tracks).size();
+  uint32_t pos = (uint32_t)(ftyp.size() + moov_size + 8);
+  Bytes mdat_payload;
+  for (auto& t : tracks) t.chunk_offsets.clear();
+  int audio_sample = 0;
+  for (int idx : chunkOrder) {
+    TrackLayout& t = tracks[idx];
+    t.chunk_offsets.push_back(pos);
+    bool audio = strcmp(t.handler, "soun") == 0;
+    for (uint32_t s = 0; s < t.samples_per_chunk; s++) {
+      uint8_t value = audio ? (uint8_t)(0x10 + audio_sample++) : 0xEE;
+      for (uint32_t j = 0; j < t.sample_size; j++) mdat_payload.push_back(value);
+    }
+    pos += t.samples_per_chunk * t.sample_size;
+  }
+  Bytes result;
+  appendBytes(result, ftyp);
+  Bytes moov = buildMoov(tracks);
+  assert(moov.size() == moov_size);
+  appendBytes(result, moov);
+  appendBytes(result, box("mdat", mdat_payload));
+  return result;
+}
+
+/// Checks that the sink contains 'count' ADTS wrapped samples of 'size'
+/// bytes in the right order
+static void checkAudio(TestAudioSink& sink, int count, int size) {
+  assert(sink.data.size() == (size_t)count * (7 + size));
+  for (int n = 0; n < count; n++) {
+    const uint8_t* frame = sink.data.data() + n * (7 + size);
+    assert(frame[0] == 0xFF);
+    for (int j = 0; j < size; j++) assert(frame[7 + j] == 0x10 + n);
+  }
+}
+
+void setup() {
+  Serial.begin(115200);
+  AudioToolsLogger.begin(Serial, AudioToolsLogLevel::Warning);
+
+  // ---- 1) interleaved video and audio: the video is skipped ----
+  {
+    std::vector<TrackLayout> tracks = {{"vide", 4000, 1, {}},
+                                       {"soun", 10, 2, {}}};
+    MemFile file;
+    file.data = buildFile(tracks, {0, 1, 0, 1, 0, 1, 0, 1});
+    size_t video_bytes = 4 * 4000;
+
+    DemuxerMP4 demuxer;
+    TestAudioSink audioSink;
+    FileSeekableSource<MemFile, DemuxerMP4> src(file, demuxer);
+    demuxer.setOutputAudio(audioSink);
+    demuxer.setRandomAccess(true);
+    demuxer.begin();
+
+    while (src.copy() > 0) {
+    }
+
+    assert(demuxer.isRandomAccessActive());
+    checkAudio(audioSink, 8, 10);
+    // only the header and the first blocks of mdat were read sequentially
+    assert(file.bytes_read < video_bytes / 4);
+    Serial.println("interleaved random access test passed");
+  }
+
+  // ---- 2) audio only: contiguous chunks are read at once ----
+  {
+    std::vector<TrackLayout> tracks = {{"soun", 100, 4, {}}};
+    MemFile file;
+    file.data = buildFile(tracks, {0, 0, 0, 0, 0, 0, 0, 0});
+
+    DemuxerMP4 demuxer;
+    TestAudioSink audioSink;
+    FileSeekableSource<MemFile, DemuxerMP4> src(file, demuxer, 256);
+    demuxer.setOutputAudio(audioSink);
+    demuxer.setRandomAccess(true);
+    demuxer.setRandomAccessBufferSize(2000);
+    demuxer.begin();
+
+    // sequential reads until mdat is reached
+    while (!demuxer.isRandomAccessActive()) {
+      size_t len = src.copy();
+      assert(len > 0);
+    }
+    file.mdat_start = file.data.size() - 32 * 100;
+    // 32 samples of 100 bytes: 2 reads
+    size_t len = src.copy();
+    assert(len == 2000);
+    len = src.copy();
+    assert(len == 1200);
+    len = src.copy();
+    assert(len == 0);
+    assert(file.sample_reads == 2);
+    checkAudio(audioSink, 32, 100);
+    Serial.println("coalesced read test passed");
+  }
+
+  // ---- 3) a failed read is reported and repeated by the next call ----
+  {
+    std::vector<TrackLayout> tracks = {{"soun", 100, 4, {}}};
+    MemFile file;
+    file.data = buildFile(tracks, {0, 0, 0, 0, 0, 0, 0, 0});
+
+    DemuxerMP4 demuxer;
+    TestAudioSink audioSink;
+    FileSeekableSource<MemFile, DemuxerMP4> src(file, demuxer, 256);
+    demuxer.setOutputAudio(audioSink);
+    demuxer.setRandomAccess(true);
+    demuxer.setRandomAccessBufferSize(2000);
+    demuxer.begin();
+
+    while (!demuxer.isRandomAccessActive()) {
+      size_t len = src.copy();
+      assert(len > 0);
+    }
+    file.mdat_start = file.data.size() - 32 * 100;
+    size_t len = src.copy();
+    assert(len == 2000);
+    // the second block can not be read
+    file.fail_reads = 1;
+    size_t dispatched = audioSink.data.size();
+    len = src.copy();
+    assert(len == 0);
+    assert(demuxer.isRandomAccessError());
+    assert(audioSink.data.size() == dispatched);
+    // the retry provides the same samples
+    len = src.copy();
+    assert(len == 1200);
+    assert(!demuxer.isRandomAccessError());
+    len = src.copy();
+    assert(len == 0);
+    checkAudio(audioSink, 32, 100);
+    Serial.println("failed read test passed");
+  }
+
+  // ---- 4) control: without random access the same file is streamed ----
+  {
+    std::vector<TrackLayout> tracks = {{"vide", 4000, 1, {}},
+                                       {"soun", 10, 2, {}}};
+    MemFile file;
+    file.data = buildFile(tracks, {0, 1, 0, 1, 0, 1, 0, 1});
+
+    DemuxerMP4 demuxer;
+    TestAudioSink audioSink;
+    VideoAudioSync plainSync;
+    demuxer.setVideoAudioSync(&plainSync);
+    FileSeekableSource<MemFile, DemuxerMP4> src(file, demuxer);
+    demuxer.setOutputAudio(audioSink);
+    demuxer.begin();
+
+    while (src.copy() > 0) {
+    }
+
+    assert(!demuxer.isRandomAccessActive());
+    checkAudio(audioSink, 8, 10);
+    assert(file.bytes_read >= file.data.size());
+    Serial.println("sequential control test passed");
+  }
+
+  Serial.println("All DemuxerMP4 random access tests passed");
+  exit(0);
+}
+
+void loop() {}
@@ -0,0 +1,63 @@
+#include <cassert>
+#include <cstdio>
+#include <vector>
+
+#include "AudioTools.h"
+
+using namespace audio_tools;
+
+/// Collects the written data
+class MemoryPrint : public Print {
+ public:
+  std::vector<uint8_t> data;
+  size_t write(uint8_t ch) override {
+    data.push_back(ch);
+    return 1;
+  }
+  size_t write(const uint8_t *buffer, size_t len) override {
+    data.insert(data.end(), buffer, buffer + len);
+    return len;
+  }
+};
+
+const int kSamples = 1000;
+int16_t pcm[kSamples];
+
+/// The decoded data must not depend on the size of the written chunks:
+/// the data following the header in the same write must not be lost
+void testChunks(MemoryPrint &wav, int chunk) {
+  MemoryPrint out;
+  WAVDecoder decoder;
+  decoder.setOutput(out);
+  decoder.begin();
+  for (size_t pos = 0; pos < wav.data.size(); pos += chunk) {
+    size_t len = min((size_t)chunk, wav.data.size() - pos);
+    size_t written = decoder.write(wav.data.data() + pos, len);
+    assert(written == len);
+  }
+  decoder.end();
+  printf("chunk %d: %d bytes\n", chunk, (int)out.data.size());
+  assert(out.data.size() == sizeof(pcm));
+  assert(memcmp(out.data.data(), pcm, sizeof(pcm)) == 0);
+}
+
+int main() {
+  for (int j = 0; j < kSamples; j++) pcm[j] = j * 31;
+
+  MemoryPrint wav;
+  WAVEncoder encoder;
+  WAVAudioInfo info = encoder.defaultConfig();
+  info.sample_rate = 44100;
+  info.channels = 1;
+  info.bits_per_sample = 16;
+  encoder.setOutput(wav);
+  encoder.begin(info);
+  encoder.write((const uint8_t *)pcm, sizeof(pcm));
+  encoder.end();
+
+  for (int chunk : {7, 44, 50, 512, (int)wav.data.size()}) {
+    testChunks(wav, chunk);
+  }
+  printf("wav-decoder: ok\n");
+  return 0;
+}
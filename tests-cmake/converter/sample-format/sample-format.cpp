@@ -0,0 +1,145 @@
+#include <cassert>
+#include <cmath>
+#include <cstdint>
+
+#include "AudioTools.h"
+
+using namespace audio_tools;
+
+// Records all writes
+class CapturePrint : public Print {
+ public:
+  size_t write(uint8_t ch) override { return write(&ch, 1); }
+  size_t write(const uint8_t *data, size_t len) override {
+    calls++;
+    for (size_t j = 0; j < len; j++) {
+      uint8_t value = data[j];
+      bytes.push_back(value);
+    }
+    return len;
+  }
+  Vector<uint8_t> bytes;
+  int calls = 0;
+};
+
+static const int kSamples = 203;  // not a multiple of the block sizes
+
+static void fill(int16_t *data, int len) {
+  for (int j = 0; j < len; j++) {
+    data[j] = (int16_t)(32767.0 * sin(j * 0.05) * (j % 2 ? 1 : -1));
+  }
+  data[0] = 32767;
+  data[1] = -32768;
+  data[2] = 0;
+}
+
+/// reference: scale the amplitudes with double precision and truncate
+static double reference(double value, double ampFrom, double ampTo,
+                        double zeroTo, double gain) {
+  double result = value * gain * ampTo / ampFrom;
+  if (result > ampTo) result = ampTo;
+  if (result < -ampTo) result = -ampTo;
+  return result + zeroTo;
+}
+
+template <typename T>
+static void test_from_int16(double ampTo, double zeroTo, float gain) {
+  int16_t in[kSamples];
+  T out[kSamples];
+  fill(in, kSamples);
+  bool ok = convertSamples<int16_t, T>(in, out, kSamples, gain);
+  assert(ok);
+  float values[kSamples];
+  SampleFormat<T>::toFloat(out, values, kSamples);
+  for (int j = 0; j < kSamples; j++) {
+    double expected = reference(in[j], 32767.0, ampTo, zeroTo, gain);
+    assert(fabs(values[j] - expected) <= 1.0 + fabs(expected) * 1e-6);
+  }
+}
+
+static void test_formats() {
+  test_from_int16<int8_t>(127, 0, 1.0f);
+  test_from_int16<uint8_t>(127, 128, 1.0f);
+  test_from_int16<int16_t>(32767, 0, 1.0f);
+  test_from_int16<uint16_t>(32767, 32768, 1.0f);
+  test_from_int16<int24_4bytes_t>(8388607, 0, 1.0f);
+  test_from_int16<int24_3bytes_t>(8388607, 0, 1.0f);
+  test_from_int16<int32_t>(2147483520.0, 0, 1.0f);
+  // gain with saturation
+  test_from_int16<int16_t>(32767, 0, 2.5f);
+  test_from_int16<int32_t>(2147483520.0, 0, 3.0f);
+  test_from_int16<int8_t>(127, 0, 0.5f);
+}
+
+static void test_float_round_trip() {
+  int16_t in[kSamples], out[kSamples];
+  float values[kSamples];
+  fill(in, kSamples);
+  convertSamples<int16_t, float>(in, values, kSamples);
+  for (int j = 0; j < kSamples; j++) assert(fabs(values[j]) <= 1.0f);
+  assert(values[0] == 1.0f);
+  convertSamples<float, int16_t>(values, out, kSamples);
+  for (int j = 0; j < kSamples; j++) assert(abs(out[j] - in[j]) <= 1);
+
+  // float input is clipped to -1.0 .. 1.0
+  float loud[3] = {2.0f, -3.0f, 0.5f};
+  int24_3bytes_t packed[3];
+  convertSamples<float, int24_3bytes_t>(loud, packed, 3);
+  float back[3];
+  SampleFormat<int24_3bytes_t>::toFloat(packed, back, 3);
+  assert(back[0] == 8388607.0f);
+  assert(back[1] == -8388607.0f);
+  assert(fabs(back[2] - 4194303.0f) <= 1.0f);
+}
+
+static void test_stream_write_modes() {
+  int16_t in[kSamples];
+  fill(in, kSamples);
+
+  CapturePrint buffered_out;
+  NumberFormatConverterStreamT<int16_t, int32_t> buffered(buffered_out);
+  buffered.begin();
+  buffered.write((uint8_t *)in, sizeof(in));
+  assert(buffered_out.calls == 1);
+
+  CapturePrint chunked_out;
+  NumberFormatConverterStreamT<int16_t, int32_t> chunked(chunked_out);
+  chunked.setBuffered(false);
+  chunked.begin();
+  chunked.write((uint8_t *)in, sizeof(in));
+  // one write per chunk instead of one per sample
+  assert(chunked_out.calls ==
+         (kSamples + NFC_CHUNK_SAMPLES - 1) / NFC_CHUNK_SAMPLES);
+
+  assert(chunked_out.bytes.size() == kSamples * sizeof(int32_t));
+  assert(buffered_out.bytes.size() == chunked_out.bytes.size());
+  for (int j = 0; j < buffered_out.bytes.size(); j++) {
+    assert(buffered_out.bytes[j] == chunked_out.bytes[j]);
+  }
+}
+
+static void test_stream_read_with_gain() {
+  int16_t in[kSamples];
+  fill(in, kSamples);
+  MemoryStream source((const uint8_t *)in, sizeof(in));
+  source.begin();
+  NumberFormatConverterStreamT<int16_t, int8_t> converter(source);
+  converter.setBuffered(false);
+  converter.setGain(2.0f);
+  converter.begin();
+  int8_t out[kSamples];
+  size_t len = converter.readBytes((uint8_t *)out, sizeof(out));
+  assert(len == sizeof(out));
+  for (int j = 0; j < kSamples; j++) {
+    double expected = reference(in[j], 32767.0, 127.0, 0.0, 2.0);
+    assert(fabs(out[j] - expected) <= 1.0);
+  }
+}
+
+int main() {
+  test_formats();
+  test_float_round_trip();
+  test_stream_write_modes();
+  test_stream_read_with_gain();
+  return 0;
+}
@@ -0,0 +1,105 @@
+#include <cassert>
+#include <cstdio>
+
+#include "AudioTools.h"
+
+using namespace audio_tools;
+
+static void testPool() {
+  AllocatorPool pool(1024, 4096);
+  void *a = pool.allocate(10);
+  void *b = pool.allocate(100);
+  assert(a != nullptr && b != nullptr);
+  assert(((uintptr_t)a % sizeof(void *)) == 0);
+  // memory is zeroed
+  for (int j = 0; j < 100; j++) assert(((uint8_t *)b)[j] == 0);
+  AllocatorStats st = pool.stats();
+  assert(st.allocations == 2);
+  assert(st.requested == 110);
+  assert(st.fragmentation() > 0.0f);
+  size_t reserved = st.reserved;
+
+  // freed blocks are reused
+  pool.free(b);
+  void *c = pool.allocate(120);
+  assert(c == b);
+  pool.free(c);
+  pool.free(a);
+  assert(pool.stats().allocations == 0);
+  assert(pool.stats().in_use == 0);
+
+  // start/stop cycles do not request more memory
+  for (int cycle = 0; cycle < 100; cycle++) {
+    Vector<int16_t> data(0, pool);
+    data.resize(200);
+    data[199] = 1;
+    SingleBuffer<uint8_t> single(512, pool);
+    RingBuffer<uint8_t> ring(256, pool);
+    int written = ring.writeArray((const uint8_t *)"test", 4);
+    assert(written == 4);
+  }
+  assert(pool.stats().allocations == 0);
+  assert(pool.stats().reserved <= reserved + 3 * 4096);
+  assert(pool.stats().peak > 0);
+
+  // big requests are delegated to the parent
+  void *big = pool.allocate(5000);
+  assert(pool.stats().fallbacks == 1);
+  pool.free(big);
+  assert(pool.stats().allocations == 0);
+}
+
+static void testArena() {
+  AllocatorArena arena(4096);
+  uint8_t *a = (uint8_t *)arena.allocate(100);
+  uint8_t *b = (uint8_t *)arena.allocate(100);
+  assert(b > a);
+  size_t avail = arena.available();
+  // last allocation can be undone
+  arena.free(b);
+  assert(arena.available() > avail);
+  // when everything is released we start from the beginning
+  arena.free(a);
+  assert(arena.available() == 4096);
+  assert(arena.stats().allocations == 0);
+
+  {
+    Vector<float> data(0, arena);
+    data.resize(256);
+    assert(arena.stats().allocations >= 1);
+  }
+  assert(arena.available() == 4096);
+
+  // overflow is delegated to the parent
+  void *c = arena.allocate(3000);
+  void *d = arena.allocate(3000);
+  assert(arena.stats().fallbacks == 1);
+  arena.free(d);
+  // reset is refused while c is still active in the arena
+  bool is_reset = arena.reset();
+  assert(!is_reset);
+  assert(arena.stats().allocations == 1);
+  void *f = arena.allocate(100);
+  assert(f != c);
+  arena.free(f);
+  arena.free(c);
+  is_reset = arena.reset();
+  assert(is_reset);
+  assert(arena.available() == 4096);
+  assert(arena.stats().allocations == 0);
+
+  // external memory
+  static uint8_t memory[1000];
+  AllocatorArena ext(memory, sizeof(memory));
+  ext.setFallback(false);
+  uint8_t *e = (uint8_t *)ext.allocate(500);
+  assert(e >= memory && e < memory + sizeof(memory));
+  assert(ext.stats().peak >= 500);
+}
+
+int main() {
+  testPool();
+  testArena();
+  printf("allocator-pool: ok\n");
+  return 0;
+}
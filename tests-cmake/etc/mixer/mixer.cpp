@@ -0,0 +1,174 @@
+#include <cassert>
+#include <cstdint>
+#include <cstdlib>
+
+#include "AudioTools.h"
+
+using namespace audio_tools;
+
+// Records the last write
+template <typename T>
+class CapturePrint : public Print {
+ public:
+  size_t write(uint8_t ch) override { return 0; }
+  size_t write(const uint8_t *data, size_t len) override {
+    samples.resize(len / sizeof(T));
+    memcpy((uint8_t *)samples.data(), data, samples.size() * sizeof(T));
+    return len;
+  }
+  Vector<T> samples;
+};
+
+// Endless stream with a constant sample value
+class ConstantStream : public Stream {
+ public:
+  ConstantStream(int16_t value) : value(value) {}
+  int available() override { return 1024; }
+  size_t readBytes(uint8_t *data, size_t len) override {
+    int16_t *samples = (int16_t *)data;
+    for (size_t j = 0; j < len / 2; j++) samples[j] = value;
+    return len;
+  }
+  int read() override { return -1; }
+  int peek() override { return -1; }
+  size_t write(uint8_t) override { return 0; }
+
+ protected:
+  int16_t value;
+};
+
+static void test_kernels() {
+  const int len = 203;
+  int16_t in[len];
+  int32_t acc[len], expected[len];
+  for (int j = 0; j < len; j++) {
+    in[j] = (int16_t)(rand() - RAND_MAX / 2);
+    acc[j] = expected[j] = j * 1000;
+  }
+  mixAdd(acc, in, len, 12345);
+  for (int j = 0; j < len; j++) {
+    expected[j] += (int32_t)in[j] * 12345;
+    assert(acc[j] == expected[j]);
+  }
+  // rounding and saturation
+  int32_t values[] = {16384 * 100 + 8192, -16384 * 100 - 8193, 16384 * 40000,
+                      -16384 * 40000, 0, 16383, 8191, -8193, 1};
+  int16_t out[9];
+  mixStore(values, out, 9);
+  int16_t result[] = {101, -101, 32767, -32768, 0, 1, 0, -1, 0};
+  for (int j = 0; j < 9; j++) assert(out[j] == result[j]);
+}
+
+template <typename T>
+static void write(OutputMixer<T> &mixer, int idx, T value, int samples) {
+  Vector<T> data;
+  data.resize(samples);
+  for (int j = 0; j < samples; j++) data[j] = value;
+  mixer.write(idx, (uint8_t *)data.data(), samples * sizeof(T));
+}
+
+template <typename T>
+static void flush(OutputMixer<T> &mixer) {
+  bool is_ok = mixer.flushMixer();
+  assert(is_ok);
+}
+
+static void test_output_mixer_ramp() {
+  CapturePrint<int16_t> out;
+  OutputMixer<int16_t> mixer(out, 2);
+  mixer.setAutoIndex(false);
+  mixer.begin(1024);
+
+  write<int16_t>(mixer, 0, 1000, 100);
+  write<int16_t>(mixer, 1, 3000, 100);
+  flush(mixer);
+  for (int j = 0; j < 100; j++) assert(out.samples[j] == 2000);
+
+  // mute stream 1: the gains are faded over 256 samples
+  mixer.setWeight(1, 0.0f);
+  int last = 2000;
+  for (int block = 0; block < 3; block++) {
+    write<int16_t>(mixer, 0, 1000, 100);
+    write<int16_t>(mixer, 1, 3000, 100);
+    flush(mixer);
+    for (int j = 0; j < 100; j++) {
+      int value = out.samples[j];
+      assert(value <= last && last - value < 150);
+      last = value;
+    }
+  }
+  assert(last == 1000);
+
+  // muted inputs are skipped but their data is consumed
+  write<int16_t>(mixer, 0, 1000, 100);
+  write<int16_t>(mixer, 1, 3000, 100);
+  flush(mixer);
+  assert(mixer.available(1) == 0);
+  for (int j = 0; j < 100; j++) assert(out.samples[j] == 1000);
+}
+
+static void test_output_mixer_float() {
+  CapturePrint<float> out;
+  OutputMixer<float> mixer(out, 3);
+  mixer.setAutoIndex(false);
+  mixer.setWeight(2, 2.0f);
+  mixer.begin(1024);
+  write<float>(mixer, 0, 0.2f, 50);
+  write<float>(mixer, 1, 0.6f, 50);
+  write<float>(mixer, 2, -0.4f, 50);
+  flush(mixer);
+  for (int j = 0; j < 50; j++) assert(fabs(out.samples[j] - 0.0f) < 1e-6);
+}
+
+template <typename T>
+static void test_output_mixer_wide(int32_t maxValue) {
+  CapturePrint<T> out;
+  OutputMixer<T> mixer(out, 2);
+  mixer.setAutoIndex(false);
+  mixer.begin(1024);
+  write<T>(mixer, 0, 1000000, 60);
+  write<T>(mixer, 1, -3000000, 60);
+  flush(mixer);
+  for (int j = 0; j < 60; j++) assert(abs((int32_t)out.samples[j] + 1000000) <= 1);
+
+  // full scale values stay in range
+  write<T>(mixer, 0, maxValue, 60);
+  write<T>(mixer, 1, maxValue, 60);
+  flush(mixer);
+  for (int j = 0; j < 60; j++) {
+    int64_t v = (int32_t)out.samples[j];
+    assert(v <= maxValue && maxValue - v <= 256);
+  }
+}
+
+static void test_input_mixer() {
+  ConstantStream in1(1000), in2(-3000);
+  InputMixer<int16_t> mixer;
+  mixer.add(in1, 50);
+  mixer.add(in2, 50);
+  mixer.begin(AudioInfo(44100, 2, 16));
+  int16_t data[128];
+  size_t len = mixer.readBytes((uint8_t *)data, sizeof(data));
+  assert(len == sizeof(data));
+  for (int j = 0; j < 128; j++) assert(data[j] == -1000);
+
+  mixer.setRampSamples(128);
+  mixer.setWeight(1, 0);
+  len = mixer.readBytes((uint8_t *)data, sizeof(data));
+  assert(len == sizeof(data));
+  assert(data[0] == -1000);
+  for (int j = 1; j < 128; j++) assert(data[j] >= data[j - 1]);
+  len = mixer.readBytes((uint8_t *)data, sizeof(data));
+  assert(len == sizeof(data));
+  for (int j = 0; j < 128; j++) assert(data[j] == 1000);
+}
+
+int main() {
+  test_kernels();
+  test_output_mixer_ramp();
+  test_output_mixer_float();
+  test_output_mixer_wide<int32_t>(INT32_MAX);
+  test_output_mixer_wide<int24_t>(8388607);
+  test_input_mixer();
+  return 0;
+}
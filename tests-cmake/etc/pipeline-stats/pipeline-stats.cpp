@@ -0,0 +1,123 @@
+#include <cassert>
+#include <cstdint>
+#include <cstdio>
+
+#include "AudioTools.h"
+
+using namespace audio_tools;
+
+AudioInfo info(44100, 2, 16);
+
+// Counts the written bytes
+class CountPrint : public Print {
+ public:
+  size_t write(uint8_t ch) override { return write(&ch, 1); }
+  size_t write(const uint8_t *data, size_t len) override {
+    count += len;
+    return len;
+  }
+  size_t count = 0;
+};
+
+// Log output to stdout
+class StdoutPrint : public Print {
+ public:
+  size_t write(uint8_t ch) override { return write(&ch, 1); }
+  size_t write(const uint8_t *data, size_t len) override {
+    return fwrite(data, 1, len, stdout);
+  }
+};
+
+static void testOutputChain() {
+  CountPrint out;
+  VolumeStream volume;
+  NumberFormatConverterStreamT<int16_t, int32_t> bits;
+  Pipeline pip;
+  pip.add(volume);
+  pip.add(bits);
+  pip.setOutput(out);
+  pip.setStatsActive(true);
+  bool is_ok = pip.begin(info);
+  assert(is_ok);
+
+  int16_t data[512] = {0};
+  for (int j = 0; j < 10; j++) {
+    size_t written = pip.write((uint8_t *)data, sizeof(data));
+    assert(written == sizeof(data));
+  }
+  assert(out.count == 10 * sizeof(data) * 2);
+
+  Pipeline::StageStats st0 = pip.stats(0);
+  assert(st0.calls == 10);
+  assert(st0.bytes_in == 10 * sizeof(data));
+  assert(st0.bytes_out == 10 * sizeof(data));
+  assert(st0.underruns == 0);
+  Pipeline::StageStats st1 = pip.stats(1);
+  assert(st1.calls == 10);
+  assert(st1.bytes_in == 10 * sizeof(data));
+  assert(st1.bytes_out == 10 * sizeof(data) * 2);
+  // the time of a call includes the downstream components
+  assert(st0.max_call_us >= st1.time_us / st1.calls);
+  // invalid index provides empty stats
+  assert(pip.stats(2).calls == 0);
+
+  pip.resetStats();
+  assert(pip.stats(0).calls == 0);
+  assert(pip.stats(1).bytes_out == 0);
+
+  // after end() the components are linked directly again
+  pip.end();
+  volume.setOutput(out);
+  out.count = 0;
+  volume.write((uint8_t *)data, sizeof(data));
+  assert(out.count == sizeof(data));
+}
+
+static void testInputChain() {
+  SineWaveGenerator<int16_t> sine(16000);
+  GeneratedSoundStream<int16_t> sound(sine);
+  VolumeStream volume;
+  Pipeline pip;
+  sine.begin(info, 440);
+  pip.setInput(sound);
+  pip.add(volume);
+  pip.setStatsActive(true);
+  bool is_ok = pip.begin(info);
+  assert(is_ok);
+
+  uint8_t buffer[1024];
+  for (int j = 0; j < 5; j++) {
+    size_t len = pip.readBytes(buffer, sizeof(buffer));
+    assert(len == sizeof(buffer));
+  }
+  Pipeline::StageStats st = pip.stats(0);
+  assert(st.calls == 5);
+  assert(st.bytes_in == 5 * sizeof(buffer));
+  assert(st.bytes_out == 5 * sizeof(buffer));
+  assert(st.underruns == 0);
+
+  StdoutPrint log;
+  pip.printStats(log);
+}
+
+static void testInactive() {
+  CountPrint out;
+  VolumeStream volume;
+  Pipeline pip;
+  pip.add(volume);
+  pip.setOutput(out);
+  bool is_ok = pip.begin(info);
+  assert(is_ok);
+  int16_t data[64] = {0};
+  pip.write((uint8_t *)data, sizeof(data));
+  assert(out.count == sizeof(data));
+  assert(pip.stats(0).calls == 0);
+}
+
+int main() {
+  testOutputChain();
+  testInputChain();
+  testInactive();
+  printf("pipeline-stats: ok\n");
+  return 0;
+}
@@ -0,0 +1,211 @@
+#include <cassert>
+#include <cstdint>
+#include <cstdio>
+
+#include "AudioTools.h"
+#include "AudioTools/Concurrency/PipelineTaskStage.h"
+
+using namespace audio_tools;
+
+// Records the data of all writes: we only accept small chunks to test the
+// back-pressure
+class CapturePrint : public Print {
+ public:
+  size_t write(uint8_t ch) override { return write(&ch, 1); }
+  size_t write(const uint8_t *data, size_t len) override {
+    if (len > 100) len = 100;
+    for (size_t j = 0; j < len; j++) {
+      uint8_t value = data[j];
+      bytes.push_back(value);
+    }
+    return len;
+  }
+  Vector<uint8_t> bytes;
+};
+
+// Slow output which records the number of bytes it had received when the
+// audio info changed
+class SlowOutput : public AudioOutput {
+ public:
+  size_t write(const uint8_t *data, size_t len) override {
+    delay(1);
+    if (len > 64) len = 64;
+    bytes += len;
+    return len;
+  }
+  void setAudioInfo(AudioInfo newInfo) override {
+    AudioOutput::setAudioInfo(newInfo);
+    bytes_at_change = bytes;
+  }
+  size_t bytes = 0;
+  size_t bytes_at_change = 0;
+};
+
+// Provides a counting sequence of int16_t
+class CountingStream : public AudioStream {
+ public:
+  size_t readBytes(uint8_t *data, size_t len) override {
+    int16_t *samples = (int16_t *)data;
+    for (size_t j = 0; j < len / 2; j++) samples[j] = value++;
+    return len / 2 * 2;
+  }
+  int available() override { return 1024; }
+  int16_t value = 0;
+};
+
+static void testOutputChain() {
+  AudioInfo info(44100, 2, 16);
+  CapturePrint out;
+  VolumeStream volume;
+  PipelineTaskStage stage(256);
+  Pipeline pip;
+  pip.add(stage);
+  pip.add(volume);
+  pip.setOutput(out);
+  bool is_ok = pip.begin(info);
+  assert(is_ok);
+  volume.setVolume(1.0);
+
+  const int n = 10000;
+  int16_t data[100];
+  int16_t value = 0;
+  for (int j = 0; j < n / 100; j++) {
+    for (int i = 0; i < 100; i++) data[i] = value++;
+    size_t written = pip.write((uint8_t *)data, sizeof(data));
+    assert(written == sizeof(data));
+  }
+  stage.flush();
+  assert(out.bytes.size() == n * 2);
+  int16_t *result = (int16_t *)out.bytes.data();
+  for (int j = 0; j < n; j++) assert(result[j] == j);
+  assert(stage.overflowCount() == 0);
+  pip.end();
+}
+
+static void testBackPressure() {
+  AudioInfo info(44100, 2, 16);
+  CapturePrint out;
+  PipelineTaskStage stage(64);
+  stage.setOutput(out);
+  stage.setAudioInfo(info);
+  stage.setTimeout(0);
+  bool is_ok = stage.begin();
+  assert(is_ok);
+  // no waiting: we can not queue more than the queue size
+  uint8_t data[1024] = {0};
+  size_t written = stage.write(data, sizeof(data));
+  assert(written <= 64);
+  assert(stage.overflowCount() == 1);
+  stage.end();
+}
+
+static void testInputChain() {
+  AudioInfo info(44100, 2, 16);
+  CountingStream in;
+  PipelineTaskStage stage(512);
+  VolumeStream volume;
+  Pipeline pip;
+  pip.setInput(in);
+  pip.add(stage);
+  pip.add(volume);
+  bool is_ok = pip.begin(info);
+  assert(is_ok);
+
+  int16_t data[300];
+  int16_t expected = 0;
+  for (int j = 0; j < 20; j++) {
+    size_t len = pip.readBytes((uint8_t *)data, sizeof(data));
+    assert(len > 0 && len % 2 == 0);
+    for (size_t i = 0; i < len / 2; i++) assert(data[i] == expected++);
+  }
+  pip.end();
+}
+
+// Frames with 10 channels of 32 bits (40 bytes) wrap around the end of the
+// queue: they must be written completely
+static void testWideFrames() {
+  AudioInfo info(44100, 10, 32);
+  CapturePrint out;
+  PipelineTaskStage stage(256);
+  stage.setOutput(out);
+  stage.setAudioInfo(info);
+  bool is_ok = stage.begin();
+  assert(is_ok);
+
+  const int n = 5000;
+  int32_t data[50];
+  int32_t value = 0;
+  for (int j = 0; j < n / 50; j++) {
+    for (int i = 0; i < 50; i++) data[i] = value++;
+    size_t written = stage.write((uint8_t *)data, sizeof(data));
+    assert(written == sizeof(data));
+  }
+  stage.flush();
+  assert(out.bytes.size() == n * 4);
+  int32_t *result = (int32_t *)out.bytes.data();
+  for (int j = 0; j < n; j++) assert(result[j] == j);
+  stage.end();
+}
+
+// Restarting the stage while data is in flight must not lose the alignment
+static void testRestart() {
+  AudioInfo info(44100, 2, 16);
+  CapturePrint out;
+  PipelineTaskStage stage(256);
+  stage.setOutput(out);
+  stage.setAudioInfo(info);
+  int16_t data[100];
+  for (int i = 0; i < 100; i++) data[i] = i;
+  for (int j = 0; j < 20; j++) {
+    bool is_ok = stage.begin();
+    assert(is_ok);
+    size_t written = stage.write((uint8_t *)data, sizeof(data));
+    assert(written == sizeof(data));
+    stage.end();
+    assert(out.bytes.size() % 4 == 0);
+  }
+  // after a restart the data is complete again
+  out.bytes.clear();
+  bool is_ok = stage.begin();
+  assert(is_ok);
+  size_t written = stage.write((uint8_t *)data, sizeof(data));
+  assert(written == sizeof(data));
+  stage.flush();
+  assert(out.bytes.size() == sizeof(data));
+  stage.end();
+}
+
+// The new audio info must reach the output after the queued data
+static void testAudioInfoChange() {
+  AudioInfo info(44100, 2, 16);
+  SlowOutput out;
+  PipelineTaskStage stage(1024);
+  stage.setOutput(out);
+  stage.addNotifyAudioChange(out);
+  stage.setAudioInfo(info);
+  bool is_ok = stage.begin();
+  assert(is_ok);
+
+  uint8_t data[1000] = {0};
+  size_t written = stage.write(data, sizeof(data));
+  assert(written == sizeof(data));
+  stage.setAudioInfo(AudioInfo(44100, 1, 16));
+  assert(out.audioInfo().channels == 1);
+  assert(out.bytes_at_change == sizeof(data));
+  written = stage.write(data, sizeof(data));
+  assert(written == sizeof(data));
+  stage.flush();
+  assert(out.bytes == 2 * sizeof(data));
+  stage.end();
+}
+
+int main() {
+  testOutputChain();
+  testBackPressure();
+  testInputChain();
+  testWideFrames();
+  testRestart();
+  testAudioInfoChange();
+  printf("pipeline-task: ok\n");
+  return 0;
+}
@@ -0,0 +1,217 @@
+#include <cassert>
+#include <cstdio>
+#include <vector>
+
+#include "AudioTools.h"
+
+using namespace audio_tools;
+
+/// File in memory which supports seek() like a File
+class MemoryFile : public Stream {
+ public:
+  std::vector<uint8_t> data;
+  size_t pos = 0;
+  int available() override { return data.size() - pos; }
+  int read() override { return pos < data.size() ? data[pos++] : -1; }
+  int peek() override { return pos < data.size() ? data[pos] : -1; }
+  size_t readBytes(uint8_t *buffer, size_t len) override {
+    size_t n = min(len, (size_t)available());
+    memcpy(buffer, data.data() + pos, n);
+    pos += n;
+    return n;
+  }
+  size_t write(uint8_t ch) override {
+    data.push_back(ch);
+    return 1;
+  }
+  size_t write(const uint8_t *buffer, size_t len) override {
+    data.insert(data.end(), buffer, buffer + len);
+    return len;
+  }
+  bool seek(size_t p) {
+    if (p > data.size()) return false;
+    pos = p;
+    return true;
+  }
+  size_t size() { return data.size(); }
+};
+
+/// SeekableSource to test GaplessInfo directly
+class MemorySeekable : public SeekableSource {
+ public:
+  MemorySeekable(MemoryFile &file) : file(file) {}
+  bool seek(size_t pos) override { return file.seek(pos); }
+  size_t readBytes(uint8_t *data, size_t len) override {
+    return file.readBytes(data, len);
+  }
+  MemoryFile &file;
+};
+
+/// AudioSource with a list of files
+class MemoryFileSource : public AudioSource {
+ public:
+  MemoryFileSource(MemoryFile *files, int count) : files(files), count(count) {}
+  bool begin() override { return true; }
+  Stream *nextStream(int offset) override { return selectStream(idx + offset); }
+  Stream *selectStream(int index) override {
+    if (index < 0 || index >= count) return nullptr;
+    idx = index;
+    files[idx].pos = 0;
+    return &files[idx];
+  }
+  Stream *selectStream(const char *path) override { return selectStream(0); }
+  bool seek(size_t pos) override { return files[idx].seek(pos); }
+  size_t streamSize() override { return files[idx].size(); }
+  MemoryFile *files;
+  int count;
+  int idx = 0;
+};
+
+/// Records the samples which were played
+class SampleRecorder : public AudioOutput {
+ public:
+  std::vector<int16_t> samples;
+  size_t write(const uint8_t *data, size_t len) override {
+    const int16_t *values = (const int16_t *)data;
+    samples.insert(samples.end(), values, values + len / 2);
+    return len;
+  }
+};
+
+static void testTrimStream() {
+  SampleRecorder out;
+  TrimStream trim(out);
+  trim.setAudioInfo(AudioInfo(44100, 2, 16));
+  trim.setTrim(3, 5);
+  int16_t data[20];
+  for (int j = 0; j < 20; j++) data[j] = j;
+  // odd chunk sizes
+  size_t len = trim.write((uint8_t *)data, 7);
+  assert(len == 7);
+  len = trim.write((uint8_t *)data + 7, 33);
+  assert(len == 33);
+  assert(out.samples.size() == 10);
+  for (int j = 0; j < 10; j++) assert(out.samples[j] == 6 + j);
+}
+
+static void testITunes() {
+  MemoryFile file;
+  const char tag[] =
+      "ID3\x03\x00\x00\x00\x00\x01\x00"
+      "COMM\x00\x00\x00\x60\x00\x00\x00engiTunSMPB\x00"
+      " 00000000 00000210 000003C4 0000000000ABCDEF 00000000";
+  file.write((const uint8_t *)tag, sizeof(tag));
+  MemorySeekable src(file);
+  GaplessInfo info;
+  bool is_ok = info.parse(src, file.size());
+  assert(is_ok);
+  assert(info.delay == 0x210);
+  assert(info.padding == 0x3C4);
+  assert(info.samples == 0xABCDEF);
+}
+
+static void testLAME() {
+  // MPEG1 layer 3 stereo 128 kbps: Info header after 32 bytes side info
+  MemoryFile file;
+  uint8_t header[4] = {0xFF, 0xFB, 0x90, 0x00};
+  file.write(header, 4);
+  for (int j = 4; j < 417; j++) file.write((uint8_t)0);
+  uint8_t *p = file.data.data() + 4 + 32;
+  memcpy(p, "Info", 4);
+  p[7] = 0x0F;  // frames, bytes, toc and quality
+  p[8 + 3] = 100;
+  uint8_t *lame = p + 8 + 4 + 4 + 100 + 4;
+  memcpy(lame, "LAME3.100", 9);
+  // delay 576, padding 1000
+  lame[21] = 576 >> 4;
+  lame[22] = ((576 & 0xF) << 4) | (1000 >> 8);
+  lame[23] = 1000 & 0xFF;
+  MemorySeekable src(file);
+  GaplessInfo info;
+  bool is_ok = info.parse(src, file.size());
+  assert(is_ok);
+  assert(info.delay == 576 + 529);
+  assert(info.padding == 1000);
+  assert(info.samples == 100 * 1152 - 576 - 1000);
+}
+
+static void testPlayer() {
+  // 2 raw pcm files: the samples contain a running number
+  MemoryFile files[2];
+  int16_t value = 0;
+  for (int f = 0; f < 2; f++) {
+    for (int j = 0; j < 3000 + f * 777; j++) {
+      files[f].write((const uint8_t *)&value, 2);
+      value++;
+    }
+  }
+  MemoryFileSource source(files, 2);
+  SampleRecorder out;
+  CopyDecoder decoder(true);
+  AudioPlayer player(source, out, decoder);
+  player.setAudioInfo(AudioInfo(44100, 1, 16));
+  player.setAutoFade(false);
+  player.setGapless(true);
+  int eof_count = 0;
+  static int *p_eof_count = &eof_count;
+  player.setOnEOFCallback([](AudioPlayer &p) { (*p_eof_count)++; });
+  player.begin();
+  // no empty copy between the files
+  while (player.copy() > 0);
+  assert(eof_count == 2);
+  assert(out.samples.size() == (size_t)value);
+  for (int j = 0; j < value; j++) assert(out.samples[j] == j);
+}
+
+/// Stateful decoder: every byte is added to the last sample, so the output
+/// is only continuous if the decoder is not restarted between the files
+class DeltaDecoder : public AudioDecoder {
+ public:
+  bool begin() override {
+    value = 0;
+    return true;
+  }
+  size_t write(const uint8_t *data, size_t len) override {
+    for (size_t j = 0; j < len; j++) {
+      value += (int8_t)data[j];
+      p_print->write((const uint8_t *)&value, 2);
+    }
+    return len;
+  }
+  operator bool() override { return true; }
+
+ protected:
+  int16_t value = 0;
+};
+
+static void testPlayerEncoded() {
+  MemoryFile files[3];
+  int total = 0;
+  for (int f = 0; f < 3; f++) {
+    for (int j = 0; j < 2000 + f * 333; j++) files[f].write((uint8_t)1);
+    total += files[f].size();
+  }
+  MemoryFileSource source(files, 3);
+  SampleRecorder out;
+  DeltaDecoder decoder;
+  AudioPlayer player(source, out, decoder);
+  player.setAudioInfo(AudioInfo(44100, 1, 16));
+  player.setAutoFade(false);
+  player.setGapless(true);
+  player.begin();
+  // the decoder keeps running across the files
+  while (player.copy() > 0);
+  assert(out.samples.size() == (size_t)total);
+  for (int j = 0; j < total; j++) assert(out.samples[j] == j + 1);
+}
+
+int main() {
+  AudioToolsLogger.begin(Serial, AudioToolsLogLevel::Warning);
+  testTrimStream();
+  testITunes();
+  testLAME();
+  testPlayer();
+  testPlayerEncoded();
+  printf("player-gapless: ok\n");
+  return 0;
+}
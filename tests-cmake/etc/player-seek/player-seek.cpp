@@ -0,0 +1,389 @@
+#include <cassert>
+#include <cstdio>
+#include <vector>
+
+#include "AudioTools.h"
+#include "AudioTools/AudioCodecs/SeekIndexM4A.h"
+
+using namespace audio_tools;
+
+/// File in memory which supports seek() like a File
+class MemoryFile : public Stream {
+ public:
+  std::vector<uint8_t> data;
+  size_t pos = 0;
+  int available() override { return data.size() - pos; }
+  int read() override { return pos < data.size() ? data[pos++] : -1; }
+  int peek() override { return pos < data.size() ? data[pos] : -1; }
+  size_t readBytes(uint8_t *buffer, size_t len) override {
+    size_t n = min(len, (size_t)available());
+    memcpy(buffer, data.data() + pos, n);
+    pos += n;
+    return n;
+  }
+  size_t write(uint8_t ch) override {
+    data.push_back(ch);
+    return 1;
+  }
+  size_t write(const uint8_t *buffer, size_t len) override {
+    for (size_t j = 0; j < len; j++) write(buffer[j]);
+    return len;
+  }
+  bool seek(size_t p) {
+    if (p > data.size()) return false;
+    pos = p;
+    return true;
+  }
+  size_t size() { return data.size(); }
+};
+
+/// SeekableSource to test the SeekIndex classes directly
+class MemorySeekable : public SeekableSource {
+ public:
+  MemorySeekable(MemoryFile &file) : file(file) {}
+  bool seek(size_t pos) override { return file.seek(pos); }
+  size_t readBytes(uint8_t *data, size_t len) override {
+    return file.readBytes(data, len);
+  }
+  MemoryFile &file;
+};
+
+/// AudioSource with a single file
+class MemoryFileSource : public AudioSource {
+ public:
+  MemoryFileSource(MemoryFile &file) : file(file) {}
+  bool begin() override { return true; }
+  Stream *nextStream(int offset) override { return selectStream(0); }
+  Stream *selectStream(int index) override {
+    file.pos = 0;
+    return &file;
+  }
+  Stream *selectStream(const char *path) override { return selectStream(0); }
+  bool seek(size_t pos) override { return file.seek(pos); }
+  size_t streamSize() override { return file.size(); }
+  MemoryFile &file;
+};
+
+/// Records the samples which were played
+class SampleRecorder : public AudioOutput {
+ public:
+  Vector<int16_t> samples;
+  size_t write(const uint8_t *data, size_t len) override {
+    const int16_t *values = (const int16_t *)data;
+    for (size_t j = 0; j < len / 2; j++) {
+      int16_t value = values[j];
+      samples.push_back(value);
+    }
+    return len;
+  }
+};
+
+// wav with 8000 samples per second: each sample contains its time in ms
+static void testWAV() {
+  MemoryFile file;
+  AudioInfo info(8000, 1, 16);
+  WAVEncoder wav_encoder;
+  EncodedAudioOutput encoder(&file, &wav_encoder);
+  encoder.begin(info);
+  for (int j = 0; j < 8000 * 10; j++) {
+    int16_t sample = j / 8;
+    encoder.write((const uint8_t *)&sample, 2);
+  }
+  encoder.end();
+
+  MemoryFileSource source(file);
+  SampleRecorder out;
+  out.begin(info);
+  WAVDecoder decoder;
+  AudioPlayer player(source, out, decoder);
+  SeekIndexWAV index;
+  player.setSeekIndex(index);
+  player.setAutoFade(false);
+  player.begin();
+  for (int j = 0; j < 3; j++) player.copy();
+  assert(out.samples.size() > 0);
+
+  bool is_ok = player.seekMs(5000);
+  assert(is_ok);
+  out.samples.clear();
+  player.copy();
+  assert(out.samples.size() > 0);
+  assert(out.samples[0] == 5000);
+
+  // back to the beginning
+  is_ok = player.seekMs(20);
+  assert(is_ok);
+  out.samples.clear();
+  player.copy();
+  assert(out.samples[0] == 20);
+
+  // without SeekIndex seeking is not possible
+  AudioPlayer player1(source, out, decoder);
+  player1.begin();
+  is_ok = player1.seekMs(1000);
+  assert(!is_ok);
+}
+
+/// Adds a MPEG1 layer 3 frame with 44100 Hz mono
+static size_t addFrame(MemoryFile &file, int bitrateIndex,
+                       const char *tag = nullptr) {
+  size_t pos = file.size();
+  uint8_t header[4] = {0xFF, 0xFB, (uint8_t)(bitrateIndex << 4), 0xC0};
+  HeaderParserMP3::FrameHeader fh;
+  HeaderParserMP3::FrameHeader::decode(header, fh);
+  int len = fh.getFrameLength();
+  file.write(header, 4);
+  for (int j = 4; j < len; j++) file.write((uint8_t)0);
+  // optional Xing header after the side info
+  if (tag != nullptr) memcpy(file.data.data() + pos + 4 + 17, tag, 4);
+  return pos;
+}
+
+static void testMP3() {
+  const int kFrames = 1000;
+  // variable bit rate: frame index
+  MemoryFile vbr;
+  Vector<size_t> offsets;
+  for (int j = 0; j < kFrames; j++) {
+    offsets.push_back(addFrame(vbr, j % 3 == 0 ? 9 : 11));
+  }
+  MemorySeekable src(vbr);
+  SeekIndexMP3 index;
+  index.setFramesPerEntry(1);
+  size_t pos = 0;
+  // 1152 samples per frame at 44100 Hz: frame 500 starts at 13061 ms
+  uint32_t ms = 500 * 1152 * 1000 / 44100 + 1;
+  bool is_ok = index.findPosition(src, vbr.size(), ms, pos);
+  assert(is_ok);
+  assert(pos == offsets[500]);
+  is_ok = index.findPosition(src, vbr.size(), 0, pos);
+  assert(is_ok);
+  assert(pos == 0);
+  // beyond the end
+  is_ok = index.findPosition(src, vbr.size(), 10000000, pos);
+  assert(is_ok);
+  assert(pos == vbr.size());
+
+  // constant bit rate: 128 kbps
+  MemoryFile cbr;
+  for (int j = 0; j < kFrames; j++) addFrame(cbr, 9);
+  MemorySeekable src_cbr(cbr);
+  SeekIndexMP3 index_cbr;
+  is_ok = index_cbr.findPosition(src_cbr, cbr.size(), 10000, pos);
+  assert(is_ok);
+  assert(pos == 10000 * 128000 / 8000);
+
+  // Xing header with a linear toc
+  MemoryFile xing;
+  addFrame(xing, 9, "Xing");
+  uint8_t *p = xing.data.data() + 4 + 17 + 4;
+  p[3] = 0x5;  // frames and toc
+  p[4 + 2] = (kFrames >> 8) & 0xFF;
+  p[4 + 3] = kFrames & 0xFF;
+  for (int j = 0; j < 100; j++) p[8 + j] = j * 256 / 100;
+  for (int j = 1; j < kFrames; j++) addFrame(xing, j % 3 == 0 ? 9 : 11);
+  MemorySeekable src_xing(xing);
+  SeekIndexMP3 index_xing;
+  uint32_t total_ms = (uint64_t)kFrames * 1152 * 1000 / 44100;
+  is_ok = index_xing.findPosition(src_xing, xing.size(), total_ms / 2, pos);
+  assert(is_ok);
+  assert(pos > xing.size() * 49 / 100 && pos < xing.size() * 51 / 100);
+}
+
+/// Adds an ogg page with the indicated granule position and body size
+static size_t addPage(MemoryFile &file, uint64_t granule, const char *body,
+                      int bodyLen) {
+  size_t pos = file.size();
+  uint8_t header[28] = {'O', 'g', 'g', 'S', 0};
+  for (int j = 0; j < 8; j++) header[6 + j] = (granule >> (8 * j)) & 0xFF;
+  header[26] = 1;
+  header[27] = bodyLen;
+  file.write(header, sizeof(header));
+  for (int j = 0; j < bodyLen; j++) {
+    file.write(body != nullptr && j < (int)strlen(body) ? body[j] : 'x');
+  }
+  return pos;
+}
+
+static void testOgg() {
+  MemoryFile file;
+  const char opus_head[] = "OpusHead\x01\x01\x38\x01";  // pre skip 312
+  addPage(file, 0, opus_head, 19);
+  addPage(file, 0, "OpusTags", 20);
+  // 10 ms per page
+  Vector<size_t> pages;
+  for (int j = 1; j <= 2000; j++) {
+    pages.push_back(addPage(file, 312 + j * 480, nullptr, 200));
+  }
+  MemorySeekable src(file);
+  SeekIndexOgg index;
+  size_t pos = 0;
+  bool is_ok = index.findPosition(src, file.size(), 0, pos);
+  assert(is_ok);
+  assert(pos == pages[0]);
+  assert(index.headerSize() == pages[0]);
+  // page j ends at (j+1) * 10 ms
+  is_ok = index.findPosition(src, file.size(), 12345, pos);
+  assert(is_ok);
+  assert(pos == pages[1234]);
+  is_ok = index.findPosition(src, file.size(), 100000, pos);
+  assert(is_ok);
+  assert(pos == file.size());
+}
+
+static void appendU32(MemoryFile &file, uint32_t value) {
+  for (int j = 3; j >= 0; j--) file.write((uint8_t)(value >> (8 * j)));
+}
+
+/// Appends a box with the indicated payload
+static void appendBox(MemoryFile &file, const char *type,
+                      MemoryFile &payload) {
+  appendU32(file, 8 + payload.data.size());
+  file.write((const uint8_t *)type, 4);
+  file.write(payload.data.data(), payload.data.size());
+}
+
+/// Sample n of the M4A test file: all bytes contain n
+static uint32_t m4aSampleSize(uint32_t n) { return 200 + 2 * (n % 5); }
+
+/// Builds a fast start M4A with kSamples samples of 1024 frames at 44100 Hz
+/// in chunks of 5 samples: the mdat data starts at mdatStart
+static void buildM4A(MemoryFile &file, int samples, size_t &mdatStart) {
+  const uint32_t kPerChunk = 5;
+  uint32_t chunks = (samples + kPerChunk - 1) / kPerChunk;
+  MemoryFile hdlr, mdhd, stts, stsz, stsc, stco, stbl, minf, mdia, trak, moov;
+  appendU32(hdlr, 0);
+  appendU32(hdlr, 0);
+  hdlr.write((const uint8_t *)"soun", 4);
+  appendU32(mdhd, 0);
+  appendU32(mdhd, 0);
+  appendU32(mdhd, 0);
+  appendU32(mdhd, 44100);
+  appendU32(mdhd, 0);
+  appendU32(mdhd, 0);
+  appendU32(stts, 0);
+  appendU32(stts, 1);
+  appendU32(stts, samples);
+  appendU32(stts, 1024);
+  appendU32(stsz, 0);
+  appendU32(stsz, 0);
+  appendU32(stsz, samples);
+  for (int j = 0; j < samples; j++) appendU32(stsz, m4aSampleSize(j));
+  appendU32(stsc, 0);
+  appendU32(stsc, 1);
+  appendU32(stsc, 1);
+  appendU32(stsc, kPerChunk);
+  appendU32(stsc, 1);
+  // the chunk offsets are patched when the mdat position is known
+  appendU32(stco, 0);
+  appendU32(stco, chunks);
+  for (uint32_t j = 0; j < chunks; j++) appendU32(stco, 0);
+  appendBox(stbl, "stts", stts);
+  appendBox(stbl, "stsz", stsz);
+  appendBox(stbl, "stsc", stsc);
+  appendBox(stbl, "stco", stco);
+  appendBox(minf, "stbl", stbl);
+  appendBox(mdia, "hdlr", hdlr);
+  appendBox(mdia, "mdhd", mdhd);
+  appendBox(mdia, "minf", minf);
+  appendBox(trak, "mdia", mdia);
+  appendBox(moov, "trak", trak);
+
+  MemoryFile ftyp, mdat;
+  ftyp.write((const uint8_t *)"M4A ", 4);
+  appendU32(ftyp, 0);
+  appendBox(file, "ftyp", ftyp);
+  appendBox(file, "moov", moov);
+  mdatStart = file.size() + 8;
+  size_t pos = mdatStart;
+  for (int j = 0; j < samples; j++) {
+    if (j % kPerChunk == 0) {
+      // patch the stco entry
+      size_t entry = file.size() - 4 * chunks + 4 * (j / kPerChunk);
+      for (int b = 0; b < 4; b++)
+        file.data[entry + b] = (uint8_t)(pos >> (8 * (3 - b)));
+    }
+    for (uint32_t b = 0; b < m4aSampleSize(j); b++) mdat.write((uint8_t)j);
+    pos += m4aSampleSize(j);
+  }
+  appendBox(file, "mdat", mdat);
+}
+
+/// Records the bytes which were played
+class ByteRecorder : public AudioOutput {
+ public:
+  std::vector<uint8_t> data;
+  size_t write(const uint8_t *buffer, size_t len) override {
+    for (size_t j = 0; j < len; j++) data.push_back(buffer[j]);
+    return len;
+  }
+};
+
+static void testM4A() {
+  const int kSamples = 200;
+  MemoryFile file;
+  size_t mdat_start = 0;
+  buildM4A(file, kSamples, mdat_start);
+
+  // positions from the sample tables: findPosition() also defines the start
+  // sample of the container, so we use a separate one
+  ContainerM4A m4a_test;
+  SeekIndexM4A index_test(m4a_test);
+  MemorySeekable src(file);
+  size_t pos = 0;
+  bool is_ok = index_test.findPosition(src, file.size(), 0, pos);
+  assert(is_ok);
+  assert(pos == mdat_start);
+  assert(index_test.headerSize() == mdat_start);
+  // 1000 ms = 44100 ticks: sample 43
+  size_t expected = mdat_start;
+  for (int j = 0; j < 43; j++) expected += m4aSampleSize(j);
+  is_ok = index_test.findPosition(src, file.size(), 1000, pos);
+  assert(is_ok);
+  assert(pos == expected);
+  uint32_t duration = index_test.durationMs(src, file.size());
+  assert(duration == kSamples * 1024 * 1000 / 44100);
+  is_ok = index_test.findPosition(src, file.size(), 100000, pos);
+  assert(is_ok);
+  assert(pos == file.size());
+
+  // the container continues with the right sample sizes after a seek
+  ContainerM4A m4a;
+  SeekIndexM4A index(m4a);
+  MemoryFileSource source(file);
+  ByteRecorder out;
+  out.begin(AudioInfo(44100, 1, 16));
+  AudioPlayer player(source, out, m4a);
+  player.setSeekIndex(index);
+  player.setAutoFade(false);
+  player.begin();
+  // the first copies only provide the header
+  while (player.copy() > 0 && out.data.empty());
+  assert(out.data.size() > 0);
+  assert(out.data[0] == 0);
+
+  for (int sample : {43, 120, 7, 196}) {
+    uint32_t ms = sample * 1024 * 1000 / 44100 + 1;
+    is_ok = player.seekMs(ms);
+    assert(is_ok);
+    out.data.clear();
+    while (player.copy() > 0 && out.data.size() < 2000);
+    // complete samples in file order
+    size_t offset = 0;
+    for (int j = sample; offset < out.data.size(); j++) {
+      assert(out.data[offset] == (uint8_t)j);
+      assert(out.data[offset + m4aSampleSize(j) - 1] == (uint8_t)j);
+      offset += m4aSampleSize(j);
+    }
+  }
+}
+
+int main() {
+  AudioToolsLogger.begin(Serial, AudioToolsLogLevel::Warning);
+  testWAV();
+  testMP3();
+  testOgg();
+  testM4A();
+  printf("player-seek: ok\n");
+  return 0;
+}
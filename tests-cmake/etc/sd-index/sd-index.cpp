@@ -0,0 +1,233 @@
+/// Tests the SDIndex with an in-memory file system: the index is created,
+/// a missing offset table is rebuilt from idx.txt (also w/o setupIndex),
+/// update() rescans a changed directory and an interrupted update is
+/// repaired by begin(). A file system without rename() (like the classic
+/// Arduino SD library) is supported by copying the files.
+#include <assert.h>
+
+#include <map>
+#include <set>
+#include <string>
+
+#ifndef FILE_WRITE
+#define FILE_WRITE "w"
+#endif
+
+#include "AudioTools.h"
+#include "AudioTools/Disk/SDIndex.h"
+
+using namespace audio_tools;
+
+class MockFS;
+
+/// File or directory of the MockFS
+class MockFile : public Stream {
+ public:
+  MockFile() = default;
+  MockFile(MockFS *fs, const std::string &path, bool isDir)
+      : p_fs(fs), path(path), is_dir(isDir) {}
+  operator bool() { return p_fs != nullptr; }
+  const char *name() { return path.c_str(); }
+  bool isDirectory() { return is_dir; }
+  void rewindDirectory() { next_idx = 0; }
+  MockFile openNextFile();
+  void close() { p_fs = nullptr; }
+  size_t size() { return p_fs == nullptr || is_dir ? 0 : data().size(); }
+  bool seek(uint32_t newPos) {
+    if (newPos > size()) return false;
+    pos = newPos;
+    return true;
+  }
+  int available() override { return size() - pos; }
+  int read() override { return available() > 0 ? (uint8_t)data()[pos++] : -1; }
+  int peek() override { return available() > 0 ? (uint8_t)data()[pos] : -1; }
+  int read(uint8_t *buffer, size_t len) {
+    size_t n = min(len, (size_t)available());
+    memcpy(buffer, data().data() + pos, n);
+    pos += n;
+    return n;
+  }
+  size_t write(uint8_t ch) override { return write(&ch, 1); }
+  size_t write(const uint8_t *buffer, size_t len) override {
+    data().append((const char *)buffer, len);
+    return len;
+  }
+  String readStringUntil(char terminator) {
+    std::string result;
+    int ch;
+    while ((ch = read()) >= 0 && ch != terminator) result += (char)ch;
+    return String(result.c_str());
+  }
+  String readString() { return readStringUntil(0); }
+
+ protected:
+  MockFS *p_fs = nullptr;
+  std::string path;
+  bool is_dir = false;
+  size_t pos = 0;
+  int next_idx = 0;
+  std::string &data();
+};
+
+/// In-memory file system with the API of the Arduino SD library
+class MockFS {
+ public:
+  std::map<std::string, std::string> files;
+  std::set<std::string> dirs;
+
+  void mkdir(const char *path) { dirs.insert(path); }
+  void addFile(const char *path) { files[path] = "data"; }
+  bool exists(const char *path) {
+    return files.count(path) > 0 || dirs.count(path) > 0;
+  }
+  bool remove(const char *path) { return files.erase(path) > 0; }
+  bool rename(const char *from, const char *to) {
+    if (files.count(from) == 0) return false;
+    files[to] = files[from];
+    files.erase(from);
+    return true;
+  }
+  MockFile open(const char *path, const char *mode = "r") {
+    if (dirs.count(path) > 0) return MockFile(this, path, true);
+    if (mode[0] == 'w') {
+      files[path].clear();
+    } else if (files.count(path) == 0) {
+      return MockFile();
+    }
+    return MockFile(this, path, false);
+  }
+  /// Sorted entries of a directory
+  std::vector<std::string> list(const std::string &dir) {
+    std::vector<std::string> result;
+    std::string prefix = dir + "/";
+    for (auto &d : dirs)
+      if (isChild(prefix, d)) result.push_back(d);
+    for (auto &f : files)
+      if (isChild(prefix, f.first)) result.push_back(f.first);
+    std::sort(result.begin(), result.end());
+    return result;
+  }
+
+ protected:
+  bool isChild(const std::string &prefix, const std::string &path) {
+    return path.size() > prefix.size() && path.compare(0, prefix.size(), prefix) == 0 &&
+           path.find('/', prefix.size()) == std::string::npos;
+  }
+};
+
+/// File system without rename() like the classic Arduino SD library
+class MockFSNoRename : public MockFS {
+ public:
+  bool rename(const char *from, const char *to) = delete;
+};
+
+MockFile MockFile::openNextFile() {
+  std::vector<std::string> entries = p_fs->list(path);
+  if (next_idx >= (int)entries.size()) return MockFile();
+  std::string next = entries[next_idx++];
+  return MockFile(p_fs, next, p_fs->dirs.count(next) > 0);
+}
+
+std::string &MockFile::data() { return p_fs->files[path]; }
+
+/// Provides all entries of the index
+template <class SDT>
+static std::vector<std::string> entries(SDIndex<SDT, MockFile> &idx) {
+  std::vector<std::string> result;
+  for (int j = 0; j < idx.size(); j++) {
+    const char *name = idx[j];
+    assert(name != nullptr);
+    result.push_back(name);
+  }
+  return result;
+}
+
+void setup() {
+  AudioToolsLogger.begin(Serial, AudioToolsLogLevel::Warning);
+  MockFS sd;
+  sd.mkdir("/music");
+  sd.mkdir("/music/a");
+  sd.mkdir("/music/b");
+  sd.addFile("/music/a/1.mp3");
+  sd.addFile("/music/a/2.mp3");
+  sd.addFile("/music/a/cover.jpg");
+  sd.addFile("/music/b/3.mp3");
+
+  // create the index
+  std::vector<std::string> expected = {"/music/a/1.mp3", "/music/a/2.mp3",
+                                       "/music/b/3.mp3"};
+  {
+    SDIndex<MockFS, MockFile> idx(sd);
+    idx.begin("/music", "mp3", "*");
+    assert(entries(idx) == expected);
+  }
+
+  // a missing offset table is rebuilt from idx.txt, also w/o setupIndex
+  std::string old_offsets = sd.files["/music/idx.off"];
+  sd.remove("/music/idx.off");
+  {
+    SDIndex<MockFS, MockFile> idx(sd);
+    idx.begin("/music", "mp3", "*", false);
+    assert(sd.files["/music/idx.off"] == old_offsets);
+    assert(entries(idx) == expected);
+  }
+
+  // only the changed directory is rescanned: the files are replaced
+  sd.addFile("/music/b/4.mp3");
+  {
+    SDIndex<MockFS, MockFile> idx(sd);
+    idx.begin("/music", "mp3", "*");
+    int changed = idx.update();
+    assert(changed == 1);
+    expected.push_back("/music/b/4.mp3");
+    assert(entries(idx) == expected);
+    assert(!sd.exists("/music/idx-tmp.txt"));
+    assert(!sd.exists("/music/idx-tmp.off"));
+    assert(!sd.exists("/music/idx-dir-tmp.txt"));
+  }
+
+  // update interrupted after the offset table was removed: rebuilt
+  sd.addFile("/music/a/5.mp3");
+  sd.remove("/music/idx.off");
+  sd.files["/music/idx-tmp.off"] = "SDIX";
+  {
+    SDIndex<MockFS, MockFile> idx(sd);
+    idx.begin("/music", "mp3", "*");
+    expected.insert(expected.begin() + 2, "/music/a/5.mp3");
+    assert(entries(idx) == expected);
+    assert(!sd.exists("/music/idx-tmp.off"));
+    // no directory has changed since the rebuild
+    int rescanned = idx.update();
+    assert(rescanned == 0);
+  }
+
+  // update() copies the files if rename() is not available
+  MockFSNoRename sd_no_rename;
+  sd_no_rename.files = sd.files;
+  sd_no_rename.dirs = sd.dirs;
+  sd_no_rename.addFile("/music/b/6.mp3");
+  {
+    SDIndex<MockFSNoRename, MockFile> idx(sd_no_rename);
+    idx.begin("/music", "mp3", "*");
+    int changed = idx.update();
+    assert(changed == 1);
+    expected.push_back("/music/b/6.mp3");
+    assert(entries(idx) == expected);
+    assert(!sd_no_rename.exists("/music/idx-tmp.txt"));
+    assert(!sd_no_rename.exists("/music/idx-tmp.off"));
+    assert(!sd_no_rename.exists("/music/idx-dir-tmp.txt"));
+  }
+  {
+    // the copied index is valid
+    SDIndex<MockFSNoRename, MockFile> idx(sd_no_rename);
+    idx.begin("/music", "mp3", "*", false);
+    assert(entries(idx) == expected);
+    int rescanned = idx.update();
+    assert(rescanned == 0);
+  }
+
+  Serial.println("ok");
+  stop();
+}
+
+void loop() {}
@@ -0,0 +1,276 @@
+#include <cassert>
+#include <cstdio>
+#include <vector>
+
+#include "AudioTools.h"
+
+using namespace audio_tools;
+
+/// File in memory which supports seek() like a File
+class MemoryFile : public Stream {
+ public:
+  std::vector<uint8_t> data;
+  size_t pos = 0;
+  int read_count = 0;
+  int available() override { return data.size() - pos; }
+  int read() override { return pos < data.size() ? data[pos++] : -1; }
+  int peek() override { return pos < data.size() ? data[pos] : -1; }
+  size_t readBytes(uint8_t *buffer, size_t len) override {
+    size_t n = min(len, (size_t)available());
+    memcpy(buffer, data.data() + pos, n);
+    pos += n;
+    read_count++;
+    return n;
+  }
+  size_t write(uint8_t ch) override {
+    data.push_back(ch);
+    return 1;
+  }
+  size_t write(const uint8_t *buffer, size_t len) override {
+    data.insert(data.end(), buffer, buffer + len);
+    return len;
+  }
+  bool seek(size_t p) {
+    if (p > data.size()) return false;
+    pos = p;
+    return true;
+  }
+  size_t size() { return data.size(); }
+};
+
+/// SeekableSource to test the SeekIndex classes directly
+class MemorySeekable : public SeekableSource {
+ public:
+  MemorySeekable(MemoryFile &file) : file(file) {}
+  bool seek(size_t pos) override { return file.seek(pos); }
+  size_t readBytes(uint8_t *data, size_t len) override {
+    return file.readBytes(data, len);
+  }
+  MemoryFile &file;
+};
+
+/// AudioSource with a single file
+class MemoryFileSource : public AudioSource {
+ public:
+  MemoryFileSource(MemoryFile &file) : file(file) {}
+  bool begin() override { return true; }
+  Stream *nextStream(int offset) override { return selectStream(0); }
+  Stream *selectStream(int index) override {
+    file.pos = 0;
+    return &file;
+  }
+  Stream *selectStream(const char *path) override { return selectStream(0); }
+  const char *toStr() override { return "/music/test.mp3"; }
+  bool seek(size_t pos) override { return file.seek(pos); }
+  size_t streamSize() override { return file.size(); }
+  MemoryFile &file;
+};
+
+/// Adds a MPEG1 layer 3 frame with 44100 Hz mono
+static size_t addFrameMP3(MemoryFile &file, int bitrateIndex) {
+  size_t pos = file.size();
+  uint8_t header[4] = {0xFF, 0xFB, (uint8_t)(bitrateIndex << 4), 0xC0};
+  HeaderParserMP3::FrameHeader fh;
+  HeaderParserMP3::FrameHeader::decode(header, fh);
+  int len = fh.getFrameLength();
+  file.write(header, 4);
+  for (int j = 4; j < len; j++) file.write((uint8_t)0);
+  return pos;
+}
+
+/// Adds an ADTS frame with 44100 Hz
+static size_t addFrameAAC(MemoryFile &file, int len) {
+  size_t pos = file.size();
+  uint8_t header[7] = {0xFF, 0xF1, (4 << 2) | 0x1, 0x80, 0, 0x1F, 0xFC};
+  header[3] |= (len >> 11) & 0x3;
+  header[4] = (len >> 3) & 0xFF;
+  header[5] |= (len & 0x7) << 5;
+  file.write(header, 7);
+  for (int j = 7; j < len; j++) file.write((uint8_t)0);
+  return pos;
+}
+
+/// Feeds the file in small chunks like the AudioPlayer
+static void feed(SeekIndex &index, MemoryFile &file, size_t chunk) {
+  for (size_t pos = 0; pos < file.size(); pos += chunk) {
+    size_t len = min(chunk, file.size() - pos);
+    index.addData(pos, file.data.data() + pos, len);
+  }
+}
+
+static void testAAC() {
+  MemoryFile file;
+  Vector<size_t> offsets;
+  for (int j = 0; j < 500; j++) {
+    offsets.push_back(addFrameAAC(file, j % 2 == 0 ? 300 : 500));
+  }
+  // incremental build with headers which are split between chunks
+  SeekIndexAAC index;
+  index.setFramesPerEntry(4);
+  index.setFileKey("/music/test.aac", file.size(), 1234);
+  feed(index, file, 101);
+  assert(index.isComplete());
+  assert(index.frameCount() == 500);
+  assert(index.bitRateMin() == 300 * 8 * 44100 / 1024);
+  assert(index.bitRateMax() == 500 * 8 * 44100 / 1024);
+
+  // the positions and the duration are available without reading
+  MemorySeekable src(file);
+  size_t pos = 0;
+  uint32_t ms = 100 * 1024 * 1000 / 44100 + 1;
+  bool is_ok = index.findPosition(src, file.size(), ms, pos);
+  assert(is_ok);
+  assert(pos == offsets[100]);
+  uint32_t duration = index.durationMs(src, file.size());
+  assert(duration == 500 * 1024 * 1000 / 44100);
+  assert(file.read_count == 0);
+
+  // central cache with 2 records
+  MemoryFile cache;
+  SeekIndexAAC other;
+  other.setFileKey("/music/other.aac", 100);
+  is_ok = other.save(cache);
+  assert(is_ok);
+  is_ok = index.save(cache);
+  assert(is_ok);
+
+  SeekIndexAAC loaded;
+  loaded.setFileKey("/music/test.aac", file.size(), 1234);
+  is_ok = loaded.load(cache);
+  assert(is_ok);
+  assert(loaded.isComplete());
+  assert(loaded.frameCount() == 500);
+  is_ok = loaded.findPosition(src, file.size(), ms, pos);
+  assert(is_ok);
+  assert(pos == offsets[100]);
+  assert(file.read_count == 0);
+
+  // modified file: no match
+  cache.pos = 0;
+  SeekIndexAAC modified;
+  modified.setFileKey("/music/test.aac", file.size(), 5678);
+  is_ok = modified.load(cache);
+  assert(!is_ok);
+
+  // different format: no match
+  cache.pos = 0;
+  SeekIndexMP3 mp3;
+  mp3.setFileKey("/music/test.aac", file.size(), 1234);
+  is_ok = mp3.load(cache);
+  assert(!is_ok);
+}
+
+static void testMP3() {
+  // ID3 tag followed by frames with variable bit rates
+  MemoryFile file;
+  uint8_t tag[10] = {'I', 'D', '3', 3, 0, 0, 0, 0, 1, 0};
+  file.write(tag, 10);
+  for (int j = 0; j < 128; j++) file.write((uint8_t)0xFF);
+  Vector<size_t> offsets;
+  for (int j = 0; j < 1000; j++) {
+    offsets.push_back(addFrameMP3(file, j % 3 == 0 ? 9 : 11));
+  }
+
+  // partially played: the rest is read from the file
+  SeekIndexMP3 index;
+  index.setFramesPerEntry(1);
+  index.setFileKey("/music/test.mp3", file.size());
+  MemoryFile part;
+  part.data.assign(file.data.begin(), file.data.begin() + offsets[300] + 2);
+  feed(index, part, 77);
+  assert(!index.isComplete());
+  assert(index.frameCount() == 300);
+  MemorySeekable src(file);
+  size_t pos = 0;
+  uint32_t ms = 700 * 1152 * 1000 / 44100 + 1;
+  bool is_ok = index.findPosition(src, file.size(), ms, pos);
+  assert(is_ok);
+  assert(pos == offsets[700]);
+
+  // estimated duration and exact duration after the full scan
+  uint32_t total_ms = (uint64_t)1000 * 1152 * 1000 / 44100;
+  uint32_t estimate = index.durationMs(src, file.size());
+  assert(estimate > total_ms * 95 / 100 && estimate < total_ms * 105 / 100);
+  is_ok = index.findPosition(src, file.size(), total_ms + 1000, pos);
+  assert(is_ok);
+  assert(index.isComplete());
+  uint32_t duration = index.durationMs(src, file.size());
+  assert(duration == total_ms);
+
+  // restore in the next session
+  MemoryFile cache;
+  is_ok = index.save(cache);
+  assert(is_ok);
+  SeekIndexMP3 loaded;
+  loaded.setFileKey("/music/test.mp3", file.size());
+  is_ok = loaded.load(cache);
+  assert(is_ok);
+  duration = loaded.durationMs(src, file.size());
+  assert(duration == total_ms);
+}
+
+static void testPlayer() {
+  MemoryFile file;
+  for (int j = 0; j < 200; j++) addFrameMP3(file, j % 3 == 0 ? 9 : 11);
+  MemoryFileSource source(file);
+  MemoryFile out;
+  CopyDecoder decoder;
+  AudioPlayer player(source, out, decoder);
+  SeekIndexMP3 index;
+  player.setSeekIndex(index);
+  player.setAutoFade(false);
+  player.begin();
+  // the index is built while playing
+  while (out.size() < file.size()) player.copy();
+  assert(index.isComplete());
+  assert(index.frameCount() == 200);
+  int reads = file.read_count;
+  uint32_t duration = player.durationMs();
+  assert(duration == 200 * 1152 * 1000 / 44100);
+  assert(file.read_count == reads);
+
+  // the cache is keyed by the path of the source
+  MemoryFile cache;
+  bool is_ok = index.save(cache);
+  assert(is_ok);
+  SeekIndexMP3 loaded;
+  loaded.setFileKey(source.toStr(), file.size());
+  is_ok = loaded.load(cache);
+  assert(is_ok);
+
+  // a key with a modification time is kept when the file is opened
+  SeekIndexMP3 index_mtime;
+  index_mtime.setFileKey(source.toStr(), file.size(), 4321);
+  AudioPlayer player_mtime(source, out, decoder);
+  player_mtime.setSeekIndex(index_mtime);
+  player_mtime.setAutoFade(false);
+  player_mtime.begin();
+  MemoryFile cache_mtime;
+  is_ok = index_mtime.save(cache_mtime);
+  assert(is_ok);
+  is_ok = loaded.load(cache_mtime);
+  assert(!is_ok);
+  cache_mtime.pos = 0;
+  SeekIndexMP3 loaded_mtime;
+  loaded_mtime.setFileKey(source.toStr(), file.size(), 4321);
+  is_ok = loaded_mtime.load(cache_mtime);
+  assert(is_ok);
+
+  // the key of the player is replaced for a different file
+  index_mtime.setFileKey("/music/other.mp3", 100, 4321);
+  player_mtime.setPath(source.toStr());
+  MemoryFile cache_other;
+  is_ok = index_mtime.save(cache_other);
+  assert(is_ok);
+  is_ok = loaded.load(cache_other);
+  assert(is_ok);
+}
+
+int main() {
+  AudioToolsLogger.begin(Serial, AudioToolsLogLevel::Warning);
+  testAAC();
+  testMP3();
+  testPlayer();
+  printf("seek-index-cache: ok\n");
+  return 0;
+}
@@ -0,0 +1,107 @@
+/// Tests the SegmentStoreFile with an in-memory file system which appends
+/// to existing files on FILE_WRITE (like SdFat): a segment which is written
+/// again (e.g. after a restart of the recording) must not contain the data
+/// of the old file.
+#include <assert.h>
+
+#include <map>
+#include <string>
+
+#ifndef FILE_WRITE
+#define FILE_WRITE "w"
+#endif
+
+#include "AudioTools.h"
+#include "AudioTools/Disk/SegmentStoreFile.h"
+
+using namespace audio_tools;
+
+class MockFS;
+
+/// File of the MockFS
+class MockFile {
+ public:
+  MockFile() = default;
+  MockFile(MockFS *fs, const std::string &path, size_t pos)
+      : p_fs(fs), path(path), pos(pos) {}
+  operator bool() { return p_fs != nullptr; }
+  void close() { p_fs = nullptr; }
+  bool seek(uint32_t newPos) {
+    if (newPos > data().size()) return false;
+    pos = newPos;
+    return true;
+  }
+  int read(uint8_t *buffer, size_t len) {
+    size_t n = min(len, data().size() - pos);
+    memcpy(buffer, data().data() + pos, n);
+    pos += n;
+    return n;
+  }
+  size_t write(const uint8_t *buffer, size_t len) {
+    data().replace(pos, min(len, data().size() - pos), (const char *)buffer,
+                   len);
+    pos += len;
+    return len;
+  }
+
+ protected:
+  MockFS *p_fs = nullptr;
+  std::string path;
+  size_t pos = 0;
+  std::string &data();
+};
+
+/// In-memory file system: FILE_WRITE opens at the end of an existing file
+class MockFS {
+ public:
+  std::map<std::string, std::string> files;
+
+  bool exists(const char *path) { return files.count(path) > 0; }
+  bool remove(const char *path) { return files.erase(path) > 0; }
+  MockFile open(const char *path, const char *mode = "r") {
+    if (mode[0] == 'w') {
+      return MockFile(this, path, files[path].size());
+    }
+    if (files.count(path) == 0) return MockFile();
+    return MockFile(this, path, 0);
+  }
+};
+
+std::string &MockFile::data() { return p_fs->files[path]; }
+
+static void write(SegmentStore &store, const char *name, const char *text) {
+  bool is_open = store.open(name);
+  assert(is_open);
+  size_t len = store.write((const uint8_t *)text, strlen(text));
+  assert(len == strlen(text));
+  store.close();
+}
+
+void setup() {
+  MockFS fs;
+  SegmentStoreFile<MockFS, MockFile> store(fs, "/hls");
+
+  // segment of a previous recording
+  fs.files["/hls/seg0.m4s"] = "old segment data";
+  write(store, "seg0.m4s", "new");
+  assert(fs.files["/hls/seg0.m4s"] == "new");
+
+  // read from a position
+  write(store, "seg1.m4s", "segment 1");
+  uint8_t data[16] = {0};
+  size_t len = store.read("seg1.m4s", 8, data, sizeof(data));
+  assert(len == 1);
+  assert(data[0] == '1');
+  len = store.read("seg9.m4s", 0, data, sizeof(data));
+  assert(len == 0);
+
+  // dropped segments are removed
+  store.remove("seg0.m4s");
+  assert(!fs.exists("/hls/seg0.m4s"));
+  assert(fs.exists("/hls/seg1.m4s"));
+
+  Serial.println("SegmentStoreFile test passed");
+  exit(0);
+}
+
+void loop() {}
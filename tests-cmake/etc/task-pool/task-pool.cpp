@@ -0,0 +1,151 @@
+#include <cassert>
+#include <cstdio>
+
+#include "AudioTools.h"
+#include "AudioTools/Concurrency/Desktop.h"
+
+using namespace audio_tools;
+
+static void testJobs() {
+  TaskPool pool(4);
+  bool is_ok = pool.begin();
+  assert(is_ok);
+  assert(pool.size() == 4);
+  std::atomic<int> sum{0};
+  for (int j = 1; j <= 10000; j++) {
+    pool.submit([&sum, j] { sum += j; });
+  }
+  pool.waitIdle();
+  assert(sum == 10000 * 10001 / 2);
+  assert(pool.executedCount() == 10000);
+  assert(pool.pendingCount() == 0);
+  pool.end();
+}
+
+static void testStealing() {
+  TaskPool pool(4);
+  pool.begin();
+  std::atomic<int> count{0};
+  // all jobs are queued on the worker which submits them
+  pool.submit([&pool, &count] {
+    for (int j = 0; j < 100; j++) {
+      pool.submit([&count] {
+        std::this_thread::sleep_for(std::chrono::microseconds(200));
+        count++;
+      });
+    }
+  });
+  pool.waitIdle();
+  assert(count == 100);
+  assert(pool.stolenCount() > 0);
+  pool.end();
+}
+
+static void testDeadlineOrder() {
+  TaskPool pool(1);
+  pool.begin();
+  std::atomic<bool> blocked{true};
+  Vector<int> order;
+  // block the single worker until all jobs are submitted
+  pool.submit([&blocked] {
+    while (blocked) std::this_thread::yield();
+  });
+  pool.submit([&order] { order.push_back(3); }, 30000);
+  pool.submit([&order] { order.push_back(0); });
+  pool.submit([&order] { order.push_back(1); }, 10000);
+  pool.submit([&order] { order.push_back(2); }, 20000);
+  blocked = false;
+  pool.waitIdle();
+  assert(order.size() == 4);
+  for (int j = 0; j < 4; j++) assert(order[j] == (j + 1) % 4);
+  pool.end();
+}
+
+static void testPooledTasks() {
+  TaskPool pool(2);
+  pool.begin();
+  const int n = 100;
+  PooledTask *tasks[n];
+  std::atomic<int> counts[n];
+  for (int j = 0; j < n; j++) {
+    counts[j] = 0;
+    tasks[j] = new PooledTask(pool, 1000);
+    std::atomic<int> *count = &counts[j];
+    bool is_ok = tasks[j]->begin([count] { (*count)++; });
+    assert(is_ok);
+  }
+  std::this_thread::sleep_for(std::chrono::milliseconds(50));
+  // all tasks are making progress
+  for (int j = 0; j < n; j++) assert(counts[j] > 0);
+
+  tasks[0]->suspend();
+  std::this_thread::sleep_for(std::chrono::milliseconds(5));
+  int suspended = counts[0];
+  std::this_thread::sleep_for(std::chrono::milliseconds(20));
+  assert(counts[0] == suspended);
+  assert(tasks[0]->isSuspended());
+  tasks[0]->resume();
+  std::this_thread::sleep_for(std::chrono::milliseconds(20));
+  assert(counts[0] > suspended);
+
+  for (int j = 0; j < n; j++) {
+    tasks[j]->end();
+    assert(tasks[j]->isEnded());
+    delete tasks[j];
+  }
+  pool.end();
+}
+
+// submit() from an other thread while the pool is starting
+static void testSubmitOnBegin() {
+  for (int run = 0; run < 20; run++) {
+    TaskPool pool(4);
+    std::atomic<int> count{0};
+    std::thread submitter([&pool, &count] {
+      int submitted = 0;
+      while (submitted < 100) {
+        if (pool.submit([&count] { count++; })) submitted++;
+      }
+    });
+    bool is_ok = pool.begin();
+    assert(is_ok);
+    submitter.join();
+    pool.waitIdle();
+    assert(count == 100);
+    pool.end();
+  }
+}
+
+// a PooledTask can be started again after the pool was restarted
+static void testPooledTaskRestart() {
+  TaskPool pool(2);
+  pool.begin();
+  std::atomic<int> count{0};
+  PooledTask task(pool);
+  bool is_ok = task.begin([&count] { count++; });
+  assert(is_ok);
+  std::this_thread::sleep_for(std::chrono::milliseconds(10));
+  pool.end();
+  task.end();
+  assert(task.isEnded());
+
+  pool.begin();
+  count = 0;
+  is_ok = task.begin([&count] { count++; });
+  assert(is_ok);
+  std::this_thread::sleep_for(std::chrono::milliseconds(10));
+  assert(count > 0);
+  task.end();
+  pool.end();
+}
+
+int main() {
+  testJobs();
+  testStealing();
+  testDeadlineOrder();
+  testPooledTasks();
+  testSubmitOnBegin();
+  testPooledTaskRestart();
+  printf("task-pool: ok\n");
+  return 0;
+}
@@ -0,0 +1,121 @@
+#include <cassert>
+#include <cstdint>
+#include <cstdlib>
+
+#include "AudioTools.h"
+
+using namespace audio_tools;
+
+// Records the data of all writes
+class CapturePrint : public Print {
+ public:
+  size_t write(uint8_t ch) override { return 0; }
+  size_t write(const uint8_t *data, size_t len) override {
+    for (size_t j = 0; j < len; j++) {
+      uint8_t value = data[j];
+      bytes.push_back(value);
+    }
+    return len;
+  }
+  template <typename T>
+  T sample(int idx) {
+    return ((T *)bytes.data())[idx];
+  }
+  Vector<uint8_t> bytes;
+};
+
+template <typename T>
+static void writeConstant(VolumeStream &volume, int channels, int frames,
+                          T value) {
+  Vector<T> data;
+  data.resize(frames * channels);
+  for (int j = 0; j < data.size(); j++) data[j] = value;
+  volume.write((uint8_t *)data.data(), data.size() * sizeof(T));
+}
+
+static VolumeStreamConfig config(int channels, int bits) {
+  VolumeStreamConfig cfg;
+  cfg.sample_rate = 44100;
+  cfg.channels = channels;
+  cfg.bits_per_sample = bits;
+  cfg.allow_boost = true;  // linear volume control
+  cfg.volume = 0.5f;
+  return cfg;
+}
+
+static void test_ramp() {
+  CapturePrint out;
+  VolumeStream volume(out);
+  volume.begin(config(2, 16));
+  // the volume before the first write is applied immediately
+  writeConstant<int16_t>(volume, 2, 100, 10000);
+  for (int j = 0; j < 200; j++) {
+    assert(abs(out.sample<int16_t>(j) - 5000) <= 1);
+  }
+
+  // the right channel is faded to 0.25 within 10 ms (441 frames)
+  out.bytes.clear();
+  volume.setVolume(0.25f, 1);
+  writeConstant<int16_t>(volume, 2, 600, 10000);
+  int last = out.sample<int16_t>(1);
+  assert(last > 4800);
+  for (int frame = 0; frame < 600; frame++) {
+    assert(abs(out.sample<int16_t>(frame * 2) - 5000) <= 1);
+    int right = out.sample<int16_t>(frame * 2 + 1);
+    assert(right <= last && last - right < 200);
+    last = right;
+  }
+  assert(abs(last - 2500) <= 1);
+}
+
+static void test_saturation() {
+  CapturePrint out;
+  VolumeStream volume(out);
+  VolumeStreamConfig cfg = config(1, 16);
+  cfg.volume = 1.5f;
+  volume.begin(cfg);
+  writeConstant<int16_t>(volume, 1, 10, 30000);
+  writeConstant<int16_t>(volume, 1, 10, -30000);
+  writeConstant<int16_t>(volume, 1, 10, 1000);
+  for (int j = 0; j < 10; j++) {
+    assert(out.sample<int16_t>(j) == 32767);
+    assert(out.sample<int16_t>(j + 10) == -32767);
+    assert(abs(out.sample<int16_t>(j + 20) - 1500) <= 1);
+  }
+}
+
+static void test_32_bits_3_channels() {
+  CapturePrint out;
+  VolumeStream volume(out);
+  volume.begin(config(3, 32));
+  volume.setVolume(1.0f, 1);
+  volume.setVolume(0.0f, 2);
+  writeConstant<int32_t>(volume, 3, 50, 1000000000);
+  for (int frame = 0; frame < 50; frame++) {
+    assert(abs(out.sample<int32_t>(frame * 3) - 500000000) <= 128);
+    assert(out.sample<int32_t>(frame * 3 + 1) == 1000000000);
+    assert(out.sample<int32_t>(frame * 3 + 2) == 0);
+  }
+}
+
+static void test_24_bits() {
+  CapturePrint out;
+  VolumeStream volume(out);
+  volume.begin(config(2, 24));
+  // fill via SampleFormat: copying int24_3bytes_t is not byte order safe
+  float values[100];
+  int24_t data[100];
+  for (int j = 0; j < 100; j++) values[j] = -4000000.0f;
+  SampleFormat<int24_t>::fromFloat(values, data, 100);
+  volume.write((uint8_t *)data, sizeof(data));
+  SampleFormat<int24_t>::toFloat((int24_t *)out.bytes.data(), values, 100);
+  for (int j = 0; j < 100; j++) assert(fabs(values[j] + 2000000) <= 1);
+}
+
+int main() {
+  test_ramp();
+  test_saturation();
+  test_32_bits_3_channels();
+  test_24_bits();
+  return 0;
+}
@@ -0,0 +1,188 @@
+#include <cassert>
+#include <cstdint>
+
+#include "AudioTools.h"
+#include "AudioTools/Concurrency/LockFree/RingBufferSPSC.h"
+
+using namespace audio_tools;
+
+// Records all writes and whether the data was provided from the indicated
+// memory area
+class CapturePrint : public Print {
+ public:
+  size_t write(uint8_t ch) override { return write(&ch, 1); }
+  size_t write(const uint8_t *data, size_t len) override {
+    if (p_start != nullptr && data >= p_start && data < p_end) in_place++;
+    calls++;
+    if (limit >= 0) {
+      if ((int)len > limit) len = limit;
+      limit -= len;
+    }
+    for (size_t j = 0; j < len; j++) {
+      uint8_t value = data[j];
+      bytes.push_back(value);
+    }
+    return len;
+  }
+  void setMemory(uint8_t *start, size_t len) {
+    p_start = start;
+    p_end = start + len;
+  }
+  Vector<uint8_t> bytes;
+  int calls = 0;
+  int in_place = 0;
+  // max number of bytes that are accepted (-1 unlimited)
+  int limit = -1;
+
+ protected:
+  uint8_t *p_start = nullptr;
+  uint8_t *p_end = nullptr;
+};
+
+static void fill(BaseBuffer<uint8_t> &buffer, int from, int len) {
+  for (int j = from; j < from + len; j++) {
+    bool is_ok = buffer.write(j & 0xFF);
+    assert(is_ok);
+  }
+}
+
+static void test_spans(BaseBuffer<uint8_t> &buffer) {
+  int len = 0;
+  uint8_t *data = buffer.peekWriteSpan(len);
+  assert(data != nullptr && len >= 10);
+  for (int j = 0; j < 10; j++) data[j] = j;
+  int committed = buffer.commitWrite(10);
+  assert(committed == 10);
+  buffer.flush();  // NBuffer: submit the partially filled block
+  assert(buffer.available() == 10);
+  data = buffer.peekReadSpan(len);
+  assert(data != nullptr && len == 10);
+  for (int j = 0; j < 10; j++) assert(data[j] == j);
+  committed = buffer.commitRead(4);
+  assert(committed == 4);
+  uint8_t value = 0;
+  bool is_ok = buffer.read(value);
+  assert(is_ok && value == 4);
+  buffer.reset();
+}
+
+static void test_buffer_spans() {
+  RingBuffer<uint8_t> ring(100);
+  test_spans(ring);
+  RingBufferSPSC<uint8_t> spsc(100);
+  test_spans(spsc);
+  SingleBuffer<uint8_t> single(100);
+  test_spans(single);
+  NBuffer<uint8_t> nbuffer(50, 3);
+  test_spans(nbuffer);
+
+  // the spans end at the wrap around
+  RingBuffer<uint8_t> wrap(100);
+  fill(wrap, 0, 80);
+  int cleared = wrap.clearArray(70);
+  assert(cleared == 70);
+  int len = 0;
+  wrap.peekWriteSpan(len);
+  assert(len == 20);
+  int committed = wrap.commitWrite(20);
+  assert(committed == 20);
+  wrap.peekWriteSpan(len);
+  assert(len == 70);
+  wrap.peekReadSpan(len);
+  assert(len == 30);
+}
+
+static void test_copy_from_buffer() {
+  // source with data wrapping around the end of the physical buffer
+  RingBuffer<uint8_t> ring(100);
+  fill(ring, 0, 60);
+  ring.clearArray(60);
+  fill(ring, 0, 90);
+
+  CapturePrint out;
+  out.setMemory(ring.address(), ring.size());
+  StreamCopy copier(32);
+  copier.setDelayOnNoData(0);
+  copier.begin(out, ring);
+  size_t total = 0;
+  while (ring.available() > 0) total += copier.copy();
+  assert(total == 90);
+  assert(out.bytes.size() == 90);
+  for (int j = 0; j < 90; j++) assert(out.bytes[j] == j);
+  // all writes were done from the ring buffer memory
+  assert(out.in_place == out.calls);
+  size_t copied = copier.copy();
+  assert(copied == 0);
+}
+
+static void test_copy_partial_write() {
+  // the output accepts only part of the data: the rest stays in the buffer
+  RingBuffer<uint8_t> ring(100);
+  fill(ring, 0, 50);
+  CapturePrint out;
+  out.limit = 20;
+  StreamCopy copier(32);
+  copier.setDelayOnNoData(0);
+  copier.setRetry(0);
+  copier.begin(out, ring);
+  size_t written = copier.copy();
+  assert(written == 20);
+  assert(ring.available() == 30);
+  out.limit = -1;
+  while (ring.available() > 0) written += copier.copy();
+  assert(written == 50);
+  for (int j = 0; j < 50; j++) assert(out.bytes[j] == j);
+}
+
+static void test_copy_with_frames() {
+  // a 4 byte frame is split at the wrap around: we copy via the buffer
+  RingBuffer<uint8_t> ring(10);
+  fill(ring, 0, 6);
+  ring.clearArray(6);
+  fill(ring, 0, 8);
+
+  CapturePrint out;
+  out.setMemory(ring.address(), ring.size());
+  StreamCopy copier(64);
+  copier.setDelayOnNoData(0);
+  copier.setMinCopySize(3);
+  copier.begin(out, ring);
+  size_t copied = copier.copy();
+  assert(copied == 3);
+  copied = copier.copy();  // frame split at the wrap around
+  assert(copied == 3);
+  assert(ring.available() == 2);
+  assert(out.in_place == 1);
+  for (int j = 0; j < 6; j++) assert(out.bytes[j] == j);
+}
+
+static void test_copy_to_buffer() {
+  uint8_t data[200];
+  for (int j = 0; j < 200; j++) data[j] = j;
+  MemoryStream in(data, sizeof(data));
+  in.begin();
+
+  RingBufferSPSC<uint8_t> spsc(128);
+  StreamCopy copier(48);
+  copier.setDelayOnNoData(0);
+  copier.begin(spsc, in);
+  uint8_t result[200];
+  int total = 0;
+  while (total < 200) {
+    size_t copied = copier.copy();
+    assert(copied > 0);
+    total += spsc.readArray(result + total, 200 - total);
+  }
+  for (int j = 0; j < 200; j++) assert(result[j] == j);
+  size_t copied = copier.copy();
+  assert(copied == 0);
+}
+
+int main() {
+  test_buffer_spans();
+  test_copy_from_buffer();
+  test_copy_partial_write();
+  test_copy_with_frames();
+  test_copy_to_buffer();
+  return 0;
+}
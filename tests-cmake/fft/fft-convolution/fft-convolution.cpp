@@ -0,0 +1,44 @@
+// Compares the FFTConvolutionFilter with a direct convolution
+#include "AudioTools.h"
+#include "AudioTools/FFT/AudioRealFFT.h"
+#include "AudioTools/FFT/FFTConvolution.h"
+
+const int ir_len = 3000;
+const int sample_count = 20000;
+float ir[ir_len];
+float input[sample_count];
+float output[sample_count];
+FFTDriverRealFFT driver;
+FFTConvolutionFilter convolution(driver);
+
+float randomValue() { return (rand() % 2000 - 1000) / 1000.0f; }
+
+void setup() {
+  AudioToolsLogger.begin(Serial, AudioToolsLogLevel::Info);
+
+  // decaying noise as impulse response
+  for (int j = 0; j < ir_len; j++) ir[j] = randomValue() * exp(-j / 800.0f);
+  for (int j = 0; j < sample_count; j++) input[j] = randomValue();
+  bool is_ok = convolution.begin(ir, ir_len, 256);
+  assert(is_ok);
+
+  // mix single sample and block processing
+  for (int j = 0; j < 100; j++) output[j] = convolution.process(input[j]);
+  convolution.process(input + 100, output + 100, sample_count - 100);
+
+  // the output is delayed by one partition
+  int latency = convolution.latency();
+  float max_error = 0;
+  for (int j = 0; j < sample_count - latency; j++) {
+    float expected = 0;
+    for (int k = 0; k < ir_len && k <= j; k++) expected += ir[k] * input[j - k];
+    max_error = max(max_error, fabsf(output[j + latency] - expected));
+  }
+  Serial.print("max error: ");
+  Serial.println(max_error);
+  assert(max_error < 0.001f);
+  Serial.println("ok");
+  stop();
+}
+
+void loop() {}
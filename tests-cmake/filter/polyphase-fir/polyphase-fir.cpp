@@ -0,0 +1,119 @@
+#include <cassert>
+#include <cmath>
+#include <cstdint>
+
+#include "AudioTools.h"
+
+using namespace audio_tools;
+
+static const int kLen = 240;
+
+static void fillSignal(float *data, int len) {
+  for (int j = 0; j < len; j++) {
+    data[j] = 0.5f * sinf(0.05f * j) + 0.3f * sinf(1.3f * j) +
+              ((j * 7919) % 13 - 6) * 0.01f;
+  }
+}
+
+static void designLowPass(Vector<float> &coef, int taps, int factor) {
+  coef.resize(taps);
+  calculateLowPassFIRCoeffs(coef.data(), taps, 0.45f / factor);
+}
+
+/// decimating output j must be the scalar FIR output at input (j+1)*factor-1
+static void test_decimating_fir_matches_fir() {
+  const int factor = 3;
+  Vector<float> coef;
+  designLowPass(coef, factor * 8 + 1, factor);
+  float in[kLen], expected[kLen], out[kLen];
+  fillSignal(in, kLen);
+  FIR<float> fir(coef);
+  fir.process(in, expected, kLen);
+
+  DecimatingFIR<float> dec(factor, coef.data(), coef.size());
+  // process in uneven blocks to check the phase across calls
+  size_t result = 0;
+  int pos = 0;
+  const int blocks[] = {7, 1, 50, 100, 82};
+  for (int block : blocks) {
+    result += dec.process(in + pos, out + result, block);
+    pos += block;
+  }
+  assert(pos == kLen);
+  assert(result == (size_t)(kLen / factor));
+  for (size_t j = 0; j < result; j++) {
+    assert(fabsf(out[j] - expected[(j + 1) * factor - 1]) < 1e-5f);
+  }
+}
+
+/// interpolating output must be the scalar FIR (gain * factor) applied to
+/// the zero stuffed input
+static void test_interpolating_fir_matches_fir() {
+  const int factor = 4;
+  Vector<float> coef;
+  designLowPass(coef, factor * 8, factor);
+  Vector<float> scaled;
+  scaled.resize(coef.size());
+  for (int j = 0; j < coef.size(); j++) scaled[j] = coef[j] * factor;
+
+  const int len = kLen / factor;
+  float in[kLen], stuffed[kLen], expected[kLen], out[kLen];
+  fillSignal(in, len);
+  for (int j = 0; j < kLen; j++) {
+    stuffed[j] = j % factor == 0 ? in[j / factor] : 0.0f;
+  }
+  FIR<float> fir(scaled);
+  fir.process(stuffed, expected, kLen);
+
+  InterpolatingFIR<float> interp(factor, coef.data(), coef.size());
+  size_t result = interp.process(in, out, 13);
+  result += interp.process(in + 13, out + result, len - 13);
+  assert(result == (size_t)kLen);
+  for (int j = 0; j < kLen; j++) {
+    assert(fabsf(out[j] - expected[j]) < 1e-5f);
+  }
+}
+
+/// DecimateFIRT filters each channel of interleaved data independently
+static void test_decimate_fir_converter_matches_fir() {
+  const int factor = 2;
+  const int channels = 2;
+  const int taps_per_factor = 8;
+  Vector<float> coef;
+  designLowPass(coef, factor * taps_per_factor + 1, factor);
+
+  const int frames = 120;
+  float signal[frames];
+  fillSignal(signal, frames);
+  int16_t data[frames * channels];
+  float ch_in[channels][frames], ch_expected[channels][frames];
+  for (int j = 0; j < frames; j++) {
+    data[j * channels] = (int16_t)(signal[j] * 20000);
+    data[j * channels + 1] = (int16_t)(-signal[j] * 10000);
+    for (int ch = 0; ch < channels; ch++) {
+      ch_in[ch][j] = data[j * channels + ch];
+    }
+  }
+  for (int ch = 0; ch < channels; ch++) {
+    FIR<float> fir(coef);
+    fir.process(ch_in[ch], ch_expected[ch], frames);
+  }
+
+  DecimateFIRT<int16_t> decimate(factor, channels, taps_per_factor);
+  size_t bytes = decimate.convert((uint8_t *)data, sizeof(data));
+  assert(bytes == sizeof(data) / factor);
+  int out_frames = bytes / (channels * sizeof(int16_t));
+  for (int j = 0; j < out_frames; j++) {
+    for (int ch = 0; ch < channels; ch++) {
+      float expected = ch_expected[ch][(j + 1) * factor - 1];
+      assert(fabsf(data[j * channels + ch] - expected) <= 1.0f);
+    }
+  }
+}
+
+int main() {
+  test_decimating_fir_matches_fir();
+  test_interpolating_fir_matches_fir();
+  test_decimate_fir_converter_matches_fir();
+  return 0;
+}
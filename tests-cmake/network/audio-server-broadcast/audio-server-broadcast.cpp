@@ -0,0 +1,191 @@
+/// Tests the broadcast mode of the AudioServerT with in-memory clients: a
+/// fast client, a slow client which accepts only a few bytes per loop, a
+/// client which disconnects before sending a complete request, a client
+/// which sends its request in pieces and a client which sends nothing. The
+/// writes to the slow client must never exceed its availableForWrite() and
+/// the incomplete requests must not block the others.
+#include <assert.h>
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "AudioTools.h"
+#include "AudioTools/Communication/HTTP/AudioServerT.h"
+
+using namespace audio_tools;
+
+/// State of one connection which is shared by the client copies
+struct Connection {
+  std::string request;
+  size_t request_pos = 0;
+  std::string response;
+  bool is_connected = true;
+  int stop_count = 0;
+  // -1: availableForWrite() is not supported (always 0)
+  int budget = -1;
+};
+
+class MockClient : public Print {
+ public:
+  MockClient() = default;
+  MockClient(std::shared_ptr<Connection> con) : con(con) {}
+  operator bool() { return con != nullptr; }
+  bool connected() { return con != nullptr && con->is_connected; }
+  int available() { return con->request.size() - con->request_pos; }
+  int read() { return con->request[con->request_pos++]; }
+  void stop() {
+    if (con == nullptr) return;
+    con->is_connected = false;
+    con->stop_count++;
+  }
+  int availableForWrite() override {
+    return con->budget < 0 ? 0 : con->budget;
+  }
+  size_t write(uint8_t ch) override { return write(&ch, 1); }
+  size_t write(const uint8_t* data, size_t len) override {
+    if (con->budget >= 0) {
+      // a real client would block here
+      assert(len <= (size_t)con->budget);
+      con->budget -= len;
+    }
+    con->response.append((const char*)data, len);
+    return len;
+  }
+  std::shared_ptr<Connection> con;
+};
+
+class MockServer {
+ public:
+  MockServer(int port = 80) {}
+  void begin() {}
+  MockClient accept() { return available(); }
+  MockClient available() {
+    if (pending.empty()) return MockClient();
+    MockClient result(pending[0]);
+    pending.erase(pending.begin());
+    return result;
+  }
+  static std::vector<std::shared_ptr<Connection>> pending;
+};
+std::vector<std::shared_ptr<Connection>> MockServer::pending;
+
+/// Provides the bytes 0,1,2...255,0,1...
+class CounterStream : public Stream {
+ public:
+  int available() override { return 512; }
+  size_t readBytes(uint8_t* data, size_t len) override {
+    for (size_t j = 0; j < len; j++) data[j] = value++;
+    return len;
+  }
+  int read() override { return -1; }
+  int peek() override { return -1; }
+  size_t write(uint8_t) override { return 0; }
+  uint8_t value = 0;
+};
+
+static std::shared_ptr<Connection> connect(const char* request) {
+  auto con = std::make_shared<Connection>();
+  con->request = request;
+  MockServer::pending.push_back(con);
+  return con;
+}
+
+/// Decodes the chunked content after the header
+static std::string body(Connection& con) {
+  size_t pos = con.response.find("\r\n\r\n");
+  size_t len = 4;
+  if (pos == std::string::npos) {
+    pos = con.response.find("\n\n");
+    len = 2;
+  }
+  assert(pos != std::string::npos);
+  std::string result;
+  pos += len;
+  while (pos < con.response.size()) {
+    size_t end = con.response.find("\r\n", pos);
+    assert(end != std::string::npos);
+    size_t size = strtoul(con.response.substr(pos, end - pos).c_str(), 0, 16);
+    result.append(con.response, end + 2, size);
+    pos = end + 2 + size + 2;
+  }
+  return result;
+}
+
+/// The received bytes must be consecutive counter values
+static void checkSequence(const std::string& data) {
+  for (size_t j = 1; j < data.size(); j++) {
+    assert((uint8_t)data[j] == (uint8_t)(data[j - 1] + 1));
+  }
+}
+
+void setup() {
+  AudioToolsLogger.begin(Serial, AudioToolsLogLevel::Warning);
+  const char* get = "GET / HTTP/1.1\r\nHost: localhost\r\n\r\n";
+
+  CounterStream in;
+  AudioServerT<MockClient, MockServer> server;
+  server.setBroadcast(true, 4096);
+  server.setCopyBufferSize(256);
+  server.setRequestTimeout(500);
+  bool is_ok = server.begin(in, "application/octet-stream");
+  assert(is_ok);
+
+  auto fast = connect(get);
+  // a new connection has an empty send buffer for the reply header
+  auto slow = connect(get);
+  slow->budget = 1024;
+  // disconnects in the middle of the request
+  auto broken = connect("GET / HTTP/1.1\r\n");
+  broken->is_connected = false;
+  // sends the rest of the request later
+  auto trickle = connect("GET / HT");
+  // does not send any request
+  auto idle = connect("");
+
+  for (int j = 0; j < 100; j++) {
+    server.doLoop();
+    // after the accept the slow client drains only 40 bytes per loop
+    if (slow->request_pos > 0) slow->budget = 40;
+    if (j == 50) trickle->request += "TP/1.1\r\nHost: localhost\r\n\r\n";
+  }
+
+  // the incomplete request was rejected and the client was stopped
+  assert(broken->stop_count == 1);
+  assert(server.clientCount() == 3);
+  std::string trickle_data = body(*trickle);
+  assert(trickle_data.size() > 0);
+  checkSequence(trickle_data);
+  // the idle client is waiting for its request
+  assert(idle->stop_count == 0);
+  assert(idle->response.empty());
+
+  std::string fast_data = body(*fast);
+  std::string slow_data = body(*slow);
+  Serial.print("fast: ");
+  Serial.println((int)fast_data.size());
+  Serial.print("slow: ");
+  Serial.println((int)slow_data.size());
+  // the fast client got a block in each loop
+  assert(fast_data.size() >= 90 * 200);
+  checkSequence(fast_data);
+  // the slow client got only what fits without blocking
+  assert(slow_data.size() > 0);
+  assert(slow_data.size() < 100 * 40);
+  // the slow client is behind but did not block the others
+  assert(slow_data.size() < fast_data.size());
+
+  // the idle client is disconnected after the request timeout
+  delay(600);
+  server.doLoop();
+  assert(idle->stop_count == 1);
+  assert(idle->response.empty());
+
+  server.end();
+  assert(fast->stop_count == 1);
+  assert(slow->stop_count == 1);
+  Serial.println("ok");
+  stop();
+}
+
+void loop() {}
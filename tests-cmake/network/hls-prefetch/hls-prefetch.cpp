@@ -0,0 +1,101 @@
+// Simple wrapper for Arduino sketch to compilable with cpp in cmake
+#include "AudioTools.h"
+#include "AudioTools/Communication/HLSStream.h"
+
+using namespace audio_tools_hls;
+
+const int segment_size = 10000;
+const int request_latency_ms = 30;
+const int bytes_per_ms = 500;
+
+/// Local stand-in for the http server: each segment has a request latency
+/// and a limited download rate. The content depends on the url and position.
+class SegmentServerStream {
+ public:
+  bool begin(const char* url) {
+    delay(request_latency_ms);
+    id = url[strlen(url) - 1];
+    total = 0;
+    start_ms = millis();
+    active = true;
+    return true;
+  }
+  void end() { active = false; }
+  int available() {
+    if (!active) return 0;
+    long allowed = (millis() - start_ms) * bytes_per_ms;
+    if (allowed > segment_size) allowed = segment_size;
+    return allowed - total;
+  }
+  size_t readBytes(uint8_t* data, size_t len) {
+    int avail = available();
+    if ((int)len > avail) len = avail;
+    for (size_t j = 0; j < len; j++) data[j] = id + total + j;
+    total += len;
+    return len;
+  }
+  size_t totalRead() { return total; }
+  int contentLength() { return segment_size; }
+  void setConnectionClose(bool flag) {}
+  void setTimeout(int ms) {}
+  void setCACert(const char* cert) {}
+  HttpRequest& httpRequest() { return request; }
+  operator bool() { return active; }
+
+ protected:
+  HttpRequest request;
+  char id = 0;
+  size_t total = 0;
+  uint32_t start_ms = 0;
+  bool active = false;
+};
+
+URLLoaderHLS<SegmentServerStream> loader;
+
+// Arduino Setup
+void setup(void) {
+  // Open Serial
+  Serial.begin(115200);
+  AudioToolsLogger.begin(Serial, AudioToolsLogLevel::Warning);
+
+  loader.setPrefetchCount(2);
+  loader.setBufferSize(1024, 4);
+  loader.addUrl("http://localhost/segment1");
+  loader.addUrl("http://localhost/segment2");
+  loader.addUrl("http://localhost/segment3");
+  loader.addUrl("http://localhost/segment4");
+  bool is_ok = loader.begin();
+  assert(is_ok);
+
+  // the segments must be provided completely and in sequence
+  uint8_t data[512];
+  char id = '1';
+  int pos = 0;
+  long total = 0;
+  uint32_t start = millis();
+  while (total < 4 * segment_size && millis() - start < 5000) {
+    if (loader.available() == 0) continue;
+    size_t len = loader.readBytes(data, sizeof(data));
+    for (size_t j = 0; j < len; j++) {
+      assert(data[j] == (uint8_t)(id + pos));
+      if (++pos == segment_size) {
+        pos = 0;
+        id++;
+      }
+    }
+    total += len;
+  }
+  assert(total == 4 * segment_size);
+
+  HLSDownloadStatistics& stats = loader.statistics();
+  LOGW("segments: %u, bytes/s: %d, underflows: %u", (unsigned)stats.segments,
+       (int)stats.bytes_per_second, (unsigned)stats.underflows);
+  assert(stats.segments == 4);
+  assert(stats.bytes == 4 * segment_size);
+  assert(loader.urlCount() == 0);
+  loader.end();
+  Serial.println("Test OK");
+}
+
+// Arduino loop - repeated processing
+void loop() {}
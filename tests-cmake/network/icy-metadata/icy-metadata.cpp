@@ -0,0 +1,102 @@
+#include <cassert>
+#include <cstdlib>
+
+#include "AudioTools.h"
+
+using namespace audio_tools;
+
+const int metaint = 100;
+static int title_count = 0;
+static char last_title[80];
+
+static void metadataCallback(MetaDataType type, const char *str, int len) {
+  if (type == Title) {
+    title_count++;
+    snprintf(last_title, sizeof(last_title), "%.*s", len, str);
+  }
+}
+
+/// Creates an ICY stream: audio bytes with increasing values interleaved with
+/// metadata blocks (size byte + size * 16 bytes)
+static void createStream(Vector<uint8_t> &stream, Vector<uint8_t> &audio,
+                         int blocks) {
+  uint8_t value = 0;
+  for (int block = 0; block < blocks; block++) {
+    for (int j = 0; j < metaint; j++) {
+      stream.push_back(value);
+      audio.push_back(value);
+      value++;
+    }
+    // every second block has no metadata
+    if (block % 2 == 1) {
+      uint8_t zero = 0;
+      stream.push_back(zero);
+      continue;
+    }
+    char meta[48] = {0};
+    snprintf(meta, sizeof(meta), "StreamTitle='Song %d';StreamUrl='';", block);
+    uint8_t size = sizeof(meta) / 16;
+    stream.push_back(size);
+    for (int j = 0; j < size * 16; j++) {
+      uint8_t ch = meta[j];
+      stream.push_back(ch);
+    }
+  }
+}
+
+static void test_char_and_block_processing() {
+  Vector<uint8_t> stream, audio;
+  createStream(stream, audio, 10);
+
+  // reference: character based state engine
+  MetaDataICY reference(metaint);
+  reference.setCallback(metadataCallback);
+  reference.begin();
+  Vector<uint8_t> expected;
+  for (int j = 0; j < stream.size(); j++) {
+    reference.processChar(stream[j]);
+    if (reference.isData()) expected.push_back(stream[j]);
+  }
+  assert(expected.size() == audio.size());
+  assert(title_count == 5);
+
+  // block based in place stripping with random chunk sizes
+  for (int run = 0; run < 20; run++) {
+    title_count = 0;
+    MetaDataICY icy(metaint);
+    icy.setCallback(metadataCallback);
+    icy.begin();
+    Vector<uint8_t> data = stream;
+    Vector<uint8_t> result;
+    int pos = 0;
+    while (pos < data.size()) {
+      int len = 1 + rand() % 150;
+      if (pos + len > data.size()) len = data.size() - pos;
+      int n = icy.processBlock(data.data() + pos, data.data() + pos, len);
+      for (int j = 0; j < n; j++) result.push_back(data[pos + j]);
+      pos += len;
+    }
+    assert(result.size() == audio.size());
+    for (int j = 0; j < audio.size(); j++) assert(result[j] == audio[j]);
+    assert(title_count == 5);
+    assert(strcmp(last_title, "Song 8") == 0);
+  }
+}
+
+static void test_write() {
+  Vector<uint8_t> stream, audio;
+  createStream(stream, audio, 4);
+  title_count = 0;
+  MetaDataICY icy(metaint);
+  icy.setCallback(metadataCallback);
+  icy.begin();
+  assert(icy.write(stream.data(), stream.size()) == stream.size());
+  assert(title_count == 2);
+  assert(strcmp(last_title, "Song 2") == 0);
+}
+
+int main() {
+  test_char_and_block_processing();
+  test_write();
+  return 0;
+}
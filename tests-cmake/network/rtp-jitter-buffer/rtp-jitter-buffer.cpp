@@ -0,0 +1,95 @@
+// Simple wrapper for Arduino sketch to compilable with cpp in cmake
+#include "AudioTools.h"
+#include "AudioTools/Communication/RTSP/RTPJitterBuffer.h"
+
+RTPJitterBuffer jitter;
+uint8_t payload[4];
+uint8_t out[4];
+
+void writePacket(uint16_t seq, uint32_t now) {
+  memset(payload, seq & 0xFF, sizeof(payload));
+  jitter.write(seq, seq * 160, payload, sizeof(payload), now);
+}
+
+// Arduino Setup
+void setup(void) {
+  // Open Serial
+  Serial.begin(115200);
+  AudioToolsLogger.begin(Serial, AudioToolsLogLevel::Info);
+
+  jitter.begin(8);
+  jitter.setTargetLatencyMs(40);
+  jitter.setAdaptive(false);
+
+  // 65535 and 0 swapped, 2 duplicated, 3 lost
+  writePacket(65534, 0);
+  writePacket(0, 5);
+  writePacket(65535, 6);
+  writePacket(1, 10);
+  writePacket(2, 15);
+  writePacket(2, 16);
+  writePacket(4, 20);
+
+  size_t len = 0;
+  // nothing is due before the target latency
+  RTPJitterResult rc = jitter.read(out, sizeof(out), len, 20);
+  assert(rc == RTP_JITTER_EMPTY);
+
+  uint16_t expected[] = {65534, 65535, 0, 1, 2};
+  for (uint16_t seq : expected) {
+    rc = jitter.read(out, sizeof(out), len, 100);
+    assert(rc == RTP_JITTER_PACKET);
+    assert(len == sizeof(out) && out[0] == (seq & 0xFF));
+  }
+  rc = jitter.read(out, sizeof(out), len, 100);
+  assert(rc == RTP_JITTER_LOST);
+  rc = jitter.read(out, sizeof(out), len, 100);
+  assert(rc == RTP_JITTER_PACKET);
+  assert(out[0] == 4);
+  rc = jitter.read(out, sizeof(out), len, 100);
+  assert(rc == RTP_JITTER_EMPTY);
+
+  // too late: 3 has already been concealed
+  writePacket(3, 110);
+
+  RTPJitterStatistics stats = jitter.statistics();
+  LOGI("received: %u, played: %u, late: %u, lost: %u, reordered: %u, "
+       "duplicates: %u",
+       (unsigned)stats.received, (unsigned)stats.played,
+       (unsigned)stats.late, (unsigned)stats.lost,
+       (unsigned)stats.reordered, (unsigned)stats.duplicates);
+  assert(stats.received == 6);
+  assert(stats.played == 6);
+  assert(stats.late == 1);
+  assert(stats.lost == 1);
+  assert(stats.reordered == 1);
+  assert(stats.duplicates == 1);
+
+  // the capacity is rounded up to a power of 2, so that the slots do not
+  // collide when the sequence number wraps around
+  jitter.begin(10);
+  jitter.clearStatistics();
+  assert(jitter.capacity() == 16);
+  uint16_t seq = 65530;
+  uint32_t now = 1000;
+  for (int j = 0; j < 20; j++) {
+    // bursts of 8 packets with 2 pairs swapped
+    uint16_t order[] = {0, 2, 1, 3, 4, 6, 5, 7};
+    for (uint16_t k : order) writePacket(seq + k, now);
+    seq += 8;
+    now += 100;
+    for (int k = 0; k < 8; k++) {
+      rc = jitter.read(out, sizeof(out), len, now);
+      assert(rc == RTP_JITTER_PACKET);
+    }
+  }
+  stats = jitter.statistics();
+  assert(stats.played == 160);
+  assert(stats.lost == 0);
+  assert(stats.overflows == 0);
+  assert(jitter.size() == 0);
+  Serial.println("Test OK");
+}
+
+// Arduino loop - repeated processing
+void loop() {}
@@ -0,0 +1,102 @@
+// Checks the ResampleStreamSinc: frame count and tone of a 44100 -> 48000
+// conversion and identical results for split writes with partial frames
+#include <cassert>
+#include <cmath>
+#include <cstdint>
+#include <vector>
+
+#include "AudioTools.h"
+
+using namespace audio_tools;
+
+/// Collects the output
+class VectorPrint : public Print {
+ public:
+  std::vector<int16_t> samples;
+  std::vector<uint8_t> bytes;
+  size_t write(uint8_t ch) override { return write(&ch, 1); }
+  size_t write(const uint8_t *data, size_t len) override {
+    bytes.insert(bytes.end(), data, data + len);
+    samples.resize(bytes.size() / 2);
+    memcpy(samples.data(), bytes.data(), samples.size() * 2);
+    return len;
+  }
+};
+
+static const int kFrames = 4410;
+static const float kFreq = 1000.0f;
+
+/// stereo: the right channel is the inverted left channel
+static std::vector<int16_t> createSignal() {
+  std::vector<int16_t> result(kFrames * 2);
+  for (int j = 0; j < kFrames; j++) {
+    int16_t value = (int16_t)(10000 * sinf(2.0f * PI * kFreq * j / 44100));
+    result[j * 2] = value;
+    result[j * 2 + 1] = -value;
+  }
+  return result;
+}
+
+static void resample(const std::vector<int16_t> &in, VectorPrint &out,
+                     const int *blocks, int block_count) {
+  ResampleStreamSinc sinc(out);
+  sinc.begin(AudioInfo(44100, 2, 16), 48000);
+  const uint8_t *data = (const uint8_t *)in.data();
+  size_t size = in.size() * sizeof(int16_t);
+  size_t pos = 0;
+  int j = 0;
+  while (pos < size) {
+    size_t len = min((size_t)blocks[j++ % block_count], size - pos);
+    size_t written = sinc.write(data + pos, len);
+    assert(written == len);
+    pos += len;
+  }
+}
+
+static void test_frame_count_and_tone() {
+  std::vector<int16_t> in = createSignal();
+  VectorPrint out;
+  const int blocks[] = {1024};
+  resample(in, out, blocks, 1);
+
+  int frames = out.samples.size() / 2;
+  int expected = kFrames * 48000 / 44100;
+  assert(abs(frames - expected) < 64);
+
+  // skip the filter latency at the beginning
+  int zero_crossings = 0;
+  double power = 0;
+  int start = 200;
+  for (int j = start; j < frames; j++) {
+    int16_t left = out.samples[j * 2];
+    int16_t right = out.samples[j * 2 + 1];
+    assert(abs(left + right) <= 1);
+    power += (double)left * left;
+    if (j > start && (out.samples[(j - 1) * 2] < 0) != (left < 0))
+      zero_crossings++;
+  }
+  double rms = sqrt(power / (frames - start));
+  assert(fabs(rms - 10000 / sqrt(2.0)) < 300);
+  // 2 crossings per period at 48000 Hz
+  double expected_crossings = 2.0 * kFreq * (frames - start) / 48000;
+  assert(fabs(zero_crossings - expected_crossings) <= 2);
+}
+
+static void test_split_writes() {
+  std::vector<int16_t> in = createSignal();
+  VectorPrint reference;
+  const int one_block[] = {1 << 20};
+  resample(in, reference, one_block, 1);
+
+  // partial frames must be carried over to the next write
+  VectorPrint split;
+  const int blocks[] = {3, 1, 250, 7, 4000, 2};
+  resample(in, split, blocks, 6);
+  assert(split.bytes == reference.bytes);
+}
+
+int main() {
+  test_frame_count_and_tone();
+  test_split_writes();
+  return 0;
+}